@@ -0,0 +1,31 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <time.h>
+
+/*
+  Small helpers shared by the benchmarks.
+*/
+
+//current time in nanoseconds from a monotonic-enough clock (C11 timespec_get)
+static inline uint64_t bench_now_ns(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+//xorshift random number generator so that every run uses the same data
+static inline uint64_t bench_rand(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  *state = x;
+  return x;
+}
+
+//written to by benchmarks so the compiler cannot remove the work being measured
+extern volatile uint64_t bench_sink;
+
+#endif// BENCH_H
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "recs.h"
+#include "bench.h"
+
+// Measures how long recs_entity_remove() takes per entity when despawning every entity
+// of a world in random order. The cost per entity should stay flat as the world grows.
+
+#define NUM_SIZES 3
+
+volatile uint64_t bench_sink;
+
+RECS_INIT_COMP_IDS(bench_comp, POSITION, VELOCITY, NUM_COMPS);
+
+struct vec3 {
+  float x, y, z;
+};
+
+static double time_despawn(uint32_t num_entities, uint64_t *seed) {
+  struct recs_init_config_component comps[NUM_COMPS] = {
+    {.type = POSITION, .comp_size = sizeof(struct vec3), .max_components = num_entities},
+    {.type = VELOCITY, .comp_size = sizeof(struct vec3), .max_components = num_entities},
+  };
+
+  struct recs_init_config config = {
+    .max_entities = num_entities,
+    .max_component_types = NUM_COMPS,
+    .max_tags = 1,
+    .max_systems = 0,
+    .max_system_groups = 0,
+    .max_queries = 0,
+    .components = comps,
+    .systems = NULL,
+  };
+
+  recs ecs = recs_init(config);
+  recs_entity *entities = malloc(sizeof(recs_entity) * num_entities);
+
+  struct vec3 v = {0, 0, 0};
+  for(uint32_t i = 0; i < num_entities; i++) {
+    entities[i] = recs_entity_add(ecs);
+    recs_entity_add_component(ecs, entities[i], POSITION, &v);
+    if(i & 1) recs_entity_add_component(ecs, entities[i], VELOCITY, &v);
+  }
+
+  //despawn in random order, so that entities are not always removed from the end of the active pool
+  for(uint32_t i = num_entities - 1; i > 0; i--) {
+    uint32_t j = (uint32_t)(bench_rand(seed) % (i + 1));
+    recs_entity tmp = entities[i];
+    entities[i] = entities[j];
+    entities[j] = tmp;
+  }
+
+  uint64_t start = bench_now_ns();
+  for(uint32_t i = 0; i < num_entities; i++) {
+    recs_entity_remove(ecs, entities[i]);
+  }
+  uint64_t end = bench_now_ns();
+
+  bench_sink += recs_num_active_entities(ecs);
+  recs_free(ecs);
+  free(entities);
+  return (double)(end - start) / (double)num_entities;
+}
+
+int main(void) {
+  const uint32_t sizes[NUM_SIZES] = {10000, 100000, 1000000};
+  uint64_t seed = 0x9E3779B97F4A7C15ull;
+
+  for(uint32_t i = 0; i < NUM_SIZES; i++) {
+    printf("despawn %8u entities  %7.2f ns/entity\n", sizes[i], time_despawn(sizes[i], &seed));
+  }
+  return 0;
+}
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "recs.h"
+#include "bitmask.h"
+#include "bench.h"
+
+// Compares the mask matching kernels against the original byte-by-byte
+// comparison for worlds with 8, 64 and 256 component and tag types.
+
+#define NUM_ROWS 4096
+#define NUM_PASSES 2000
+
+volatile uint64_t bench_sink;
+
+//the matching loop RECS used before masks were padded to 64-bit words.
+//Kept out of line, just like the kernels, so that every variant pays for one call per match.
+static __attribute__((noinline)) int match_bytewise(const uint8_t *entity_mask, const uint8_t *mask, uint32_t num_bits, uint32_t bitmask_size, enum recs_ent_match_op match_op) {
+  for(uint32_t i = 0; i < bitmask_size - 1; i++) {
+    uint8_t res = entity_mask[i] & mask[i];
+    switch(match_op) {
+      case RECS_ENT_MATCH_ALL: {
+        if(res != mask[i]) {
+          return 0;
+        }
+        break;
+      }
+      case RECS_ENT_MATCH_ANY: {
+        if(res != 0) {
+          return 1;
+        }
+        break;
+      }
+    }
+  }
+
+  const uint8_t num_unused_bits = (num_bits & 7) == 0 ? 0 : 8 - (num_bits & 7);
+  uint8_t last_byte1 = entity_mask[bitmask_size-1] & ((uint8_t)0xFF >> num_unused_bits);
+  uint8_t last_byte2 = mask[bitmask_size-1] & ((uint8_t)0xFF >> num_unused_bits);
+
+  switch(match_op) {
+    case RECS_ENT_MATCH_ALL: return (last_byte1 & last_byte2) == last_byte2;
+    case RECS_ENT_MATCH_ANY: return (last_byte1 & last_byte2) != 0;
+  }
+  return 0;
+}
+
+static double time_bytewise(const uint8_t *rows, const uint8_t *mask, uint32_t num_bits, enum recs_ent_match_op op) {
+  //the original code used unpadded masks
+  uint32_t byte_size = (num_bits + 7) / 8;
+  uint32_t row_size = RECS_GET_BITMASK_SIZE(num_bits, 0);
+  uint64_t matches = 0;
+
+  uint64_t start = bench_now_ns();
+  for(uint32_t pass = 0; pass < NUM_PASSES; pass++) {
+    for(uint32_t i = 0; i < NUM_ROWS; i++) {
+      matches += match_bytewise(rows + i * row_size, mask, num_bits, byte_size, op);
+    }
+  }
+  uint64_t end = bench_now_ns();
+
+  bench_sink += matches;
+  return (double)(end - start) / ((double)NUM_PASSES * NUM_ROWS);
+}
+
+static double time_kernel(bitmask_match_func func, const uint8_t *rows, const uint8_t *mask, uint32_t num_bits) {
+  uint32_t row_size = RECS_GET_BITMASK_SIZE(num_bits, 0);
+  uint32_t num_words = row_size / sizeof(uint64_t);
+  uint64_t matches = 0;
+
+  uint64_t start = bench_now_ns();
+  for(uint32_t pass = 0; pass < NUM_PASSES; pass++) {
+    for(uint32_t i = 0; i < NUM_ROWS; i++) {
+      matches += func(rows + i * row_size, mask, num_words);
+    }
+  }
+  uint64_t end = bench_now_ns();
+
+  bench_sink += matches;
+  return (double)(end - start) / ((double)NUM_PASSES * NUM_ROWS);
+}
+
+//recs_entity_matches_component_mask() compares single word masks inline instead of calling a kernel
+static double time_single_word(const uint8_t *rows, const uint8_t *mask, enum recs_ent_match_op op) {
+  uint32_t row_size = sizeof(uint64_t);
+  uint64_t mask_word = bitmask_load_word(mask, 0);
+  uint64_t matches = 0;
+
+  uint64_t start = bench_now_ns();
+  for(uint32_t pass = 0; pass < NUM_PASSES; pass++) {
+    for(uint32_t i = 0; i < NUM_ROWS; i++) {
+      uint64_t w = bitmask_load_word(rows + i * row_size, 0);
+      matches += op == RECS_ENT_MATCH_ALL ? (w & mask_word) == mask_word : (w & mask_word) != 0;
+    }
+  }
+  uint64_t end = bench_now_ns();
+
+  bench_sink += matches;
+  return (double)(end - start) / ((double)NUM_PASSES * NUM_ROWS);
+}
+
+static void report(const char *name, uint32_t num_bits, const char *op, double ns, double baseline) {
+  printf("%-10s %5u types  %-3s  %7.2f ns/match  %5.2fx\n", name, num_bits, op, ns, baseline / ns);
+}
+
+static void run(uint32_t num_bits) {
+  uint32_t row_size = RECS_GET_BITMASK_SIZE(num_bits, 0);
+  uint8_t *rows = calloc(NUM_ROWS, row_size);
+  uint8_t *mask = calloc(1, row_size);
+  uint64_t seed = 0x9E3779B97F4A7C15ull;
+
+  //every entity has roughly half of all components, while the query asks for 3 of them
+  for(uint32_t i = 0; i < NUM_ROWS; i++) {
+    for(uint32_t b = 0; b < num_bits; b++) {
+      bitmask_set(rows + i * row_size, b, bench_rand(&seed) & 1);
+    }
+  }
+  bitmask_set(mask, num_bits - 1, 1);
+  bitmask_set(mask, num_bits / 2, 1);
+  bitmask_set(mask, num_bits / 3, 1);
+
+  const char *op_names[2] = {"ALL", "ANY"};
+  enum recs_ent_match_op ops[2] = {RECS_ENT_MATCH_ALL, RECS_ENT_MATCH_ANY};
+
+  for(int o = 0; o < 2; o++) {
+    double base = time_bytewise(rows, mask, num_bits, ops[o]);
+    report("bytewise", num_bits, op_names[o], base, base);
+
+    bitmask_match_func u64 = ops[o] == RECS_ENT_MATCH_ALL ? bitmask_match_all_u64 : bitmask_match_any_u64;
+    report("u64", num_bits, op_names[o], time_kernel(u64, rows, mask, num_bits), base);
+
+#ifdef BITMASK_HAS_X86_KERNELS
+    bitmask_match_func sse2 = ops[o] == RECS_ENT_MATCH_ALL ? bitmask_match_all_sse2 : bitmask_match_any_sse2;
+    report("sse2", num_bits, op_names[o], time_kernel(sse2, rows, mask, num_bits), base);
+
+    if(__builtin_cpu_supports("avx2")) {
+      bitmask_match_func avx2 = ops[o] == RECS_ENT_MATCH_ALL ? bitmask_match_all_avx2 : bitmask_match_any_avx2;
+      report("avx2", num_bits, op_names[o], time_kernel(avx2, rows, mask, num_bits), base);
+    }
+#endif
+
+    if(row_size == sizeof(uint64_t)) {
+      report("inline", num_bits, op_names[o], time_single_word(rows, mask, ops[o]), base);
+      continue;
+    }
+
+    struct bitmask_kernels k = bitmask_kernels_select(row_size);
+    report("selected", num_bits, op_names[o], time_kernel(ops[o] == RECS_ENT_MATCH_ALL ? k.match_all : k.match_any, rows, mask, num_bits), base);
+  }
+
+  free(rows);
+  free(mask);
+}
+
+int main(void) {
+  run(8);
+  run(64);
+  run(256);
+  return 0;
+}
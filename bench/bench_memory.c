@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "recs.h"
+#include "bench.h"
+
+// Reports how much memory the entity->component maps use, compared to the layout they replaced,
+// which stored one uint32_t per entity for every component type no matter how many entities had it.
+//
+// Each component type is given to max_components entities, either as one block of neighbouring
+// entity IDs (clustered), or spread evenly across every entity ID (scattered, the worst case for pages).
+
+#define NUM_CONFIGS 4
+#define NUM_TYPES 200
+
+volatile uint64_t bench_sink;
+
+struct memory_config {
+  uint32_t num_entities;
+  uint32_t max_components;
+};
+
+static void report(const struct memory_config *mc, uint8_t scattered) {
+  static struct recs_init_config_component comps[NUM_TYPES];
+  for(uint32_t c = 0; c < NUM_TYPES; c++) {
+    comps[c] = (struct recs_init_config_component){.type = c, .comp_size = sizeof(uint32_t), .max_components = mc->max_components};
+  }
+
+  struct recs_init_config config = {
+    .max_entities = mc->num_entities,
+    .max_component_types = NUM_TYPES,
+    .max_tags = 1,
+    .max_systems = 0,
+    .max_system_groups = 0,
+    .max_queries = 0,
+    .components = comps,
+    .systems = NULL,
+  };
+
+  recs ecs = recs_init(config);
+  recs_entity *entities = malloc(sizeof(recs_entity) * mc->num_entities);
+  for(uint32_t i = 0; i < mc->num_entities; i++) {
+    entities[i] = recs_entity_add(ecs);
+  }
+
+  uint32_t spacing = mc->num_entities / mc->max_components;
+  for(uint32_t c = 0; c < NUM_TYPES; c++) {
+    //every component type starts at a different entity, so that the types do not all use the same pages
+    uint32_t first = (uint32_t)(((uint64_t)c * mc->num_entities) / NUM_TYPES);
+    for(uint32_t i = 0; i < mc->max_components; i++) {
+      uint32_t index = scattered ? (first % spacing) + (i * spacing) : (first + i) % mc->num_entities;
+      recs_entity_add_component(ecs, entities[index], c, &i);
+    }
+  }
+
+  struct recs_memory_usage usage;
+  recs_memory_usage(ecs, &usage);
+  double mb = 1024.0 * 1024.0;
+  double old_bytes = (double)sizeof(uint32_t) * mc->num_entities * NUM_TYPES;
+
+  printf("%8u entities  %3u types  %8u max_components  %-9s  old %8.2f MB  reserved %8.2f MB  used %8.2f MB  total %8.2f MB\n",
+    mc->num_entities, NUM_TYPES, mc->max_components, scattered ? "scattered" : "clustered",
+    old_bytes / mb, (double)usage.entity_to_comp_bytes / mb, (double)usage.entity_to_comp_used_bytes / mb, (double)usage.total_bytes / mb);
+
+  bench_sink += usage.total_bytes;
+  recs_free(ecs);
+  free(entities);
+}
+
+int main(void) {
+  const struct memory_config configs[NUM_CONFIGS] = {
+    {1000000, 1000},
+    {1000000, 10000},
+    {100000, 10000},
+    {100000, 100000}
+  };
+
+  for(uint32_t i = 0; i < NUM_CONFIGS; i++) {
+    report(configs + i, 0);
+    report(configs + i, 1);
+  }
+  return 0;
+}
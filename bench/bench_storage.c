@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "recs.h"
+#include "bench.h"
+
+// Compares RECS_STORAGE_SPARSE_SET against RECS_STORAGE_ARCHETYPE when iterating
+// over entities with Position, Velocity, and Mass, and when adding/removing components.
+
+#define NUM_ENTITIES 100000
+#define NUM_ITER_PASSES 50
+#define NUM_CHURN_OPS 1000000
+#define BATCH_SIZE 256
+
+volatile uint64_t bench_sink;
+
+RECS_INIT_COMP_IDS(bench_comp, POSITION, VELOCITY, MASS, NOISE_A, NOISE_B, NOISE_C, NOISE_D, NUM_COMPS);
+
+struct vec3 {
+  float x, y, z;
+};
+
+static recs create_world(enum recs_storage_type storage, recs_entity *out_entities, uint64_t *seed) {
+  struct recs_init_config_component comps[NUM_COMPS] = {
+    {.type = POSITION, .comp_size = sizeof(struct vec3), .max_components = NUM_ENTITIES},
+    {.type = VELOCITY, .comp_size = sizeof(struct vec3), .max_components = NUM_ENTITIES},
+    {.type = MASS, .comp_size = sizeof(float), .max_components = NUM_ENTITIES},
+    {.type = NOISE_A, .comp_size = 32, .max_components = NUM_ENTITIES},
+    {.type = NOISE_B, .comp_size = 16, .max_components = NUM_ENTITIES},
+    {.type = NOISE_C, .comp_size = 8, .max_components = NUM_ENTITIES},
+    {.type = NOISE_D, .comp_size = 64, .max_components = NUM_ENTITIES},
+  };
+
+  struct recs_init_config config = {
+    .max_entities = NUM_ENTITIES,
+    .max_component_types = NUM_COMPS,
+    .max_tags = 0,
+    .max_systems = 0,
+    .max_system_groups = 0,
+    .max_queries = 0,
+    .storage = storage,
+    .components = comps,
+    .systems = NULL,
+  };
+
+  recs ecs = recs_init(config);
+
+  //entities get a random mix of components, so each component pool ends up in a different order
+  uint8_t noise[64] = {0};
+  for(uint32_t i = 0; i < NUM_ENTITIES; i++) {
+    recs_entity e = recs_entity_add(ecs);
+    out_entities[i] = e;
+    struct vec3 v = {(float)i, 1.0f, 2.0f};
+    float mass = 1.0f + (float)(i & 7);
+
+    for(recs_component c = NOISE_A; c < NUM_COMPS; c++) {
+      if(bench_rand(seed) & 1) recs_entity_add_component(ecs, e, c, noise);
+    }
+    recs_entity_add_component(ecs, e, POSITION, &v);
+    if(bench_rand(seed) % 4 != 0) recs_entity_add_component(ecs, e, VELOCITY, &v);
+    if(bench_rand(seed) % 4 != 0) recs_entity_add_component(ecs, e, MASS, &mass);
+  }
+
+  //a world that has been running for a while no longer stores its components in the order entities
+  //were created, so re-add the components of random entities to shuffle each pool.
+  const size_t sizes[3] = {sizeof(struct vec3), sizeof(struct vec3), sizeof(float)};
+  for(uint32_t i = 0; i < NUM_ENTITIES; i++) {
+    recs_entity e = out_entities[bench_rand(seed) % NUM_ENTITIES];
+    for(recs_component c = POSITION; c <= MASS; c++) {
+      if(!recs_entity_has_component(ecs, e, c)) continue;
+
+      uint8_t data[sizeof(struct vec3)];
+      memcpy(data, recs_entity_get_component(ecs, e, c), sizes[c]);
+      recs_entity_remove_component(ecs, e, c);
+      recs_entity_add_component(ecs, e, c, data);
+    }
+  }
+
+  return ecs;
+}
+
+//one entity at a time using recs_ent_iter_next() and recs_entity_get_component()
+static double time_iter(recs ecs, uint8_t *mask) {
+  uint64_t visited = 0;
+
+  uint64_t start = bench_now_ns();
+  for(uint32_t pass = 0; pass < NUM_ITER_PASSES; pass++) {
+    recs_ent_iter iter = recs_ent_iter_init(ecs, mask);
+    while(recs_ent_iter_has_next(&iter)) {
+      recs_entity e = recs_ent_iter_next(ecs, &iter);
+      struct vec3 *p = recs_entity_get_component(ecs, e, POSITION);
+      struct vec3 *v = recs_entity_get_component(ecs, e, VELOCITY);
+      float *m = recs_entity_get_component(ecs, e, MASS);
+      p->x += v->x / *m;
+      p->y += v->y / *m;
+      p->z += v->z / *m;
+      visited++;
+    }
+  }
+  uint64_t end = bench_now_ns();
+
+  bench_sink += visited;
+  return (double)(end - start) / (double)visited;
+}
+
+//many entities at a time using recs_ent_iter_next_batch()
+static double time_batch(recs ecs, uint8_t *mask) {
+  const recs_component comps[3] = {POSITION, VELOCITY, MASS};
+  recs_entity entities[BATCH_SIZE];
+  void *columns[3 * BATCH_SIZE];
+  uint64_t visited = 0;
+
+  uint64_t start = bench_now_ns();
+  for(uint32_t pass = 0; pass < NUM_ITER_PASSES; pass++) {
+    recs_ent_iter iter = recs_ent_iter_init(ecs, mask);
+    uint32_t count;
+    while((count = recs_ent_iter_next_batch(ecs, &iter, entities, BATCH_SIZE, comps, 3, columns)) > 0) {
+      for(uint32_t i = 0; i < count; i++) {
+        struct vec3 *p = columns[i];
+        struct vec3 *v = columns[BATCH_SIZE + i];
+        float *m = columns[2 * BATCH_SIZE + i];
+        p->x += v->x / *m;
+        p->y += v->y / *m;
+        p->z += v->z / *m;
+      }
+      visited += count;
+    }
+  }
+  uint64_t end = bench_now_ns();
+
+  bench_sink += visited;
+  return (double)(end - start) / (double)visited;
+}
+
+//add and remove a noise component on random entities
+static double time_churn(recs ecs, recs_entity *entities, uint64_t *seed) {
+  uint8_t noise[64] = {0};
+
+  uint64_t start = bench_now_ns();
+  for(uint32_t i = 0; i < NUM_CHURN_OPS; i++) {
+    recs_entity e = entities[bench_rand(seed) % NUM_ENTITIES];
+    if(recs_entity_has_component(ecs, e, NOISE_B)) {
+      recs_entity_remove_component(ecs, e, NOISE_B);
+    } else {
+      recs_entity_add_component(ecs, e, NOISE_B, noise);
+    }
+  }
+  uint64_t end = bench_now_ns();
+
+  return (double)(end - start) / (double)NUM_CHURN_OPS;
+}
+
+static void run(const char *name, enum recs_storage_type storage) {
+  uint64_t seed = 0x9E3779B97F4A7C15ull;
+  recs_entity *entities = malloc(sizeof(recs_entity) * NUM_ENTITIES);
+  recs ecs = create_world(storage, entities, &seed);
+
+  uint8_t mask[RECS_GET_BITMASK_SIZE(NUM_COMPS, 0)];
+  const recs_component required[3] = {POSITION, VELOCITY, MASS};
+  recs_bitmask_create(ecs, mask, 3, required, 0, NULL);
+
+  printf("%-10s iter   %7.2f ns/entity\n", name, time_iter(ecs, mask));
+  printf("%-10s batch  %7.2f ns/entity\n", name, time_batch(ecs, mask));
+  printf("%-10s churn  %7.2f ns/op\n", name, time_churn(ecs, entities, &seed));
+
+  recs_free(ecs);
+  free(entities);
+}
+
+int main(void) {
+  run("sparse", RECS_STORAGE_SPARSE_SET);
+  run("archetype", RECS_STORAGE_ARCHETYPE);
+  return 0;
+}
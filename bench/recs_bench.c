@@ -0,0 +1,1105 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "recs.h"
+#include "bench.h"
+
+// Benchmark suite used to track regressions over time. Every scenario runs with worlds of
+// 1k, 10k, 100k, and 1M entities, using both storage backends, and results are printed as CSV or JSON.
+//
+// Usage: recs_bench [--format csv|json] [--max-entities N] [--storage sparse|archetype] [--scenario NAME]
+
+#define NUM_SIZES 4
+#define NUM_SYSTEMS 4
+
+//roughly how many entities each timed scenario processes, so that small worlds are measured over many passes
+#define WORK_PER_SCENARIO 4000000u
+#define MIN_PASSES 3u
+#define MAX_PASSES 2000u
+
+#define NUM_CHURN_OPS 200000u
+#define NUM_TAG_OPS 1000000u
+
+//1 in SNAPSHOT_CHANGE_RATE entities are changed between incremental snapshots
+#define SNAPSHOT_CHANGE_RATE 100u
+#define SNAPSHOT_CHUNK_SIZE 4096u
+
+//1 in BIG_COMP_RATE entities have a big component (such as animation state), used to compare removal policies
+#define BIG_COMP_RATE 10u
+#define BIG_COMP_SIZE 1024u
+
+//1 in RARE_TAG_RATE entities have the tag searched for by query_rare_tag
+#define RARE_TAG_RATE 10000u
+#define NUM_QUEUED_REMOVALS 100u
+
+//transforms sorted by the pool_sort scenarios lie on a grid of SORT_GRID_SIZE x SORT_GRID_SIZE cells
+#define SORT_GRID_SIZE 1024u
+
+volatile uint64_t bench_sink;
+
+RECS_INIT_COMP_IDS(bench_comp, POSITION, VELOCITY, HEALTH, ARMOR, NUM_COMPS);
+RECS_INIT_TAG_IDS(bench_tag, TAG_FROZEN, TAG_HIDDEN, TAG_DEAD, NUM_TAGS);
+RECS_INIT_SYS_GRP_IDS(bench_group, GROUP_UPDATE, NUM_GROUPS);
+
+#define MASK_SIZE RECS_GET_BITMASK_SIZE(NUM_COMPS, NUM_TAGS)
+
+struct vec3 {
+  float x, y, z;
+};
+
+//a 96 byte component, of which the field_layout scenarios only update the position and read the velocity
+struct rigid_body {
+  float x, y, z;
+  float vx, vy, vz;
+  float rest[18];
+};
+
+struct big_component {
+  uint32_t value;
+  uint8_t data[BIG_COMP_SIZE - sizeof(uint32_t)];
+};
+
+struct result {
+  const char *scenario;
+  const char *storage;
+  uint32_t num_entities;
+
+  //what counts as one operation depends on the scenario (a query pass, a spawn/despawn, a copy, ...)
+  uint64_t ops;
+
+  //number of entities processed by every operation combined
+  uint64_t entities;
+  uint64_t total_ns;
+};
+
+enum output_format {
+  OUTPUT_CSV,
+  OUTPUT_JSON
+};
+
+struct bench_options {
+  enum output_format format;
+  uint32_t max_entities;
+  const char *storage;
+  const char *scenario;
+};
+
+//shared with the systems through the RECS context
+struct bench_context {
+  recs_query moving;
+  recs_query alive;
+  uint64_t visited;
+};
+
+static uint32_t num_results = 0;
+static uint32_t max_results = 0;
+static struct result *results = NULL;
+
+
+static void record(const char *scenario, const char *storage, uint32_t num_entities, uint64_t ops, uint64_t entities, uint64_t total_ns) {
+  if(num_results == max_results) {
+    max_results = max_results == 0 ? 64 : max_results * 2;
+    results = realloc(results, sizeof(struct result) * max_results);
+  }
+  results[num_results++] = (struct result){scenario, storage, num_entities, ops, entities, total_ns == 0 ? 1 : total_ns};
+}
+
+static uint32_t num_passes(uint32_t num_entities) {
+  uint32_t passes = WORK_PER_SCENARIO / num_entities;
+  if(passes < MIN_PASSES) return MIN_PASSES;
+  if(passes > MAX_PASSES) return MAX_PASSES;
+  return passes;
+}
+
+
+static void system_move(struct recs *ecs) {
+  struct bench_context *ctx = recs_system_get_context(ecs);
+  recs_entity *entities = recs_query_entities(ecs, ctx->moving);
+  uint32_t count = recs_query_num_entities(ecs, ctx->moving);
+  for(uint32_t i = 0; i < count; i++) {
+    struct vec3 *p = recs_entity_get_component(ecs, entities[i], POSITION);
+    struct vec3 *v = recs_entity_get_component(ecs, entities[i], VELOCITY);
+    p->x += v->x;
+    p->y += v->y;
+    p->z += v->z;
+  }
+  ctx->visited += count;
+}
+
+static void system_damage(struct recs *ecs) {
+  struct bench_context *ctx = recs_system_get_context(ecs);
+  recs_entity *entities = recs_query_entities(ecs, ctx->alive);
+  uint32_t count = recs_query_num_entities(ecs, ctx->alive);
+  for(uint32_t i = 0; i < count; i++) {
+    int *health = recs_entity_get_component(ecs, entities[i], HEALTH);
+    *health -= 1;
+  }
+  ctx->visited += count;
+}
+
+//if track_all is set, every component type tracks changes rather than only positions
+static recs create_world(enum recs_storage_type storage, uint32_t num_entities, uint32_t snapshot_chunk_size, uint8_t track_all, struct bench_context *ctx, recs_entity *out_entities, uint64_t *seed) {
+  //positions track changes for the query_changed_1pct scenario, and health keeps events for the health_removed_events
+  //scenario (the archetype tables do not keep ticks or events)
+  uint8_t sparse = storage == RECS_STORAGE_SPARSE_SET;
+  uint8_t track = sparse && track_all;
+  struct recs_init_config_component comps[NUM_COMPS] = {
+    {.type = POSITION, .comp_size = sizeof(struct vec3), .max_components = num_entities, .track_changes = sparse},
+    {.type = VELOCITY, .comp_size = sizeof(struct vec3), .max_components = num_entities, .track_changes = track},
+    {.type = HEALTH, .comp_size = sizeof(int), .max_components = num_entities, .track_changes = track, .max_events = sparse ? (num_entities / SNAPSHOT_CHANGE_RATE) * 2 + 2 : 0},
+    {.type = ARMOR, .comp_size = sizeof(int), .max_components = num_entities, .track_changes = track},
+  };
+
+  struct recs_init_config_system systems[NUM_SYSTEMS] = {
+    {.func = system_move, .group = GROUP_UPDATE},
+    {.func = system_damage, .group = GROUP_UPDATE},
+    {.func = system_move, .group = GROUP_UPDATE},
+    {.func = system_damage, .group = GROUP_UPDATE},
+  };
+
+  struct recs_init_config config = {
+    .max_entities = num_entities,
+    .max_component_types = NUM_COMPS,
+    .max_tags = NUM_TAGS,
+    .max_systems = NUM_SYSTEMS,
+    .max_system_groups = NUM_GROUPS,
+    .max_queries = 2,
+    .storage = storage,
+    .snapshot_chunk_size = snapshot_chunk_size,
+    .context = ctx,
+    .components = comps,
+    .systems = systems,
+  };
+
+  recs ecs = recs_init(config);
+  if(ecs == NULL) {
+    return NULL;
+  }
+
+  //every entity has a position, half have a velocity, 1 in 10 have health, and 1 in 100 have armor.
+  //This gives queries with a wide range of selectivity.
+  struct vec3 v = {1, 2, 3};
+  int stat = 100;
+  for(uint32_t i = 0; i < num_entities; i++) {
+    recs_entity e = recs_entity_add(ecs);
+    out_entities[i] = e;
+
+    recs_entity_add_component(ecs, e, POSITION, &v);
+    uint64_t r = bench_rand(seed);
+    if(r % 2 == 0) recs_entity_add_component(ecs, e, VELOCITY, &v);
+    if(r % 10 == 0) recs_entity_add_component(ecs, e, HEALTH, &stat);
+    if(r % 100 == 0) recs_entity_add_component(ecs, e, ARMOR, &stat);
+    if((r >> 8) % 4 == 0) recs_entity_add_tag(ecs, e, TAG_FROZEN);
+    if((r >> 16) % 8 == 0) recs_entity_add_tag(ecs, e, TAG_HIDDEN);
+  }
+
+  uint8_t mask[MASK_SIZE];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(2, POSITION, VELOCITY), 0, NULL);
+  ctx->moving = recs_query_register(ecs, mask, RECS_ENT_MATCH_ALL, NULL, RECS_ENT_MATCH_ANY);
+
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(1, HEALTH), 0, NULL);
+  uint8_t exclude_mask[MASK_SIZE];
+  recs_bitmask_create(ecs, exclude_mask, 0, NULL, RECS_BITMASK_CREATE_TAG_ARG(1, TAG_DEAD));
+  ctx->alive = recs_query_register(ecs, mask, RECS_ENT_MATCH_ALL, exclude_mask, RECS_ENT_MATCH_ANY);
+
+  return ecs;
+}
+
+
+//iterate through the world with an uncached iterator, returning the time taken
+static uint64_t time_query(recs ecs, uint8_t *mask, uint8_t *exclude_mask, uint32_t passes) {
+  uint64_t visited = 0;
+
+  uint64_t start = bench_now_ns();
+  for(uint32_t pass = 0; pass < passes; pass++) {
+    recs_ent_iter iter = recs_ent_iter_init_with_exclude(ecs, mask, exclude_mask);
+    while(recs_ent_iter_has_next(&iter)) {
+      recs_entity e = recs_ent_iter_next(ecs, &iter);
+      struct vec3 *p = recs_entity_get_component(ecs, e, POSITION);
+      p->x += 1.0f;
+      visited++;
+    }
+  }
+  uint64_t end = bench_now_ns();
+
+  bench_sink += visited;
+  return end - start;
+}
+
+static void run_queries(const struct bench_options *opts, recs ecs, const char *storage, uint32_t num_entities) {
+  //name, components required, and tags excluded
+  static const struct {
+    const char *name;
+    uint32_t num_comps;
+    recs_component comps[3];
+    uint32_t num_excluded;
+    recs_tag excluded[3];
+  } queries[] = {
+    {"query_1comp_100pct", 1, {POSITION}, 0, {0}},
+    {"query_2comp_50pct", 2, {POSITION, VELOCITY}, 0, {0}},
+    {"query_2comp_10pct", 2, {POSITION, HEALTH}, 0, {0}},
+    {"query_2comp_1pct", 2, {POSITION, ARMOR}, 0, {0}},
+    {"query_3comp_5pct", 3, {POSITION, VELOCITY, HEALTH}, 0, {0}},
+    {"query_exclude_3tags", 2, {POSITION, VELOCITY}, 3, {TAG_FROZEN, TAG_HIDDEN, TAG_DEAD}},
+  };
+
+  uint32_t passes = num_passes(num_entities);
+  for(uint32_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+    if(opts->scenario != NULL && strcmp(opts->scenario, queries[q].name) != 0) continue;
+
+    uint8_t mask[MASK_SIZE];
+    uint8_t exclude_mask[MASK_SIZE];
+    recs_bitmask_create(ecs, mask, queries[q].num_comps, queries[q].comps, 0, NULL);
+    recs_bitmask_create(ecs, exclude_mask, 0, NULL, queries[q].num_excluded, queries[q].excluded);
+
+    uint64_t ns = time_query(ecs, mask, exclude_mask, passes);
+    record(queries[q].name, storage, num_entities, passes, (uint64_t)passes * num_entities, ns);
+  }
+}
+
+//despawn a random entity, then spawn a new one with a position and velocity in its place
+static void run_churn(recs ecs, const char *storage, uint32_t num_entities, recs_entity *entities, uint64_t *seed) {
+  struct vec3 v = {1, 2, 3};
+
+  uint64_t start = bench_now_ns();
+  for(uint32_t i = 0; i < NUM_CHURN_OPS; i++) {
+    uint32_t slot = (uint32_t)(bench_rand(seed) % num_entities);
+    recs_entity_remove(ecs, entities[slot]);
+
+    recs_entity e = recs_entity_add(ecs);
+    recs_entity_add_component(ecs, e, POSITION, &v);
+    recs_entity_add_component(ecs, e, VELOCITY, &v);
+    entities[slot] = e;
+  }
+  uint64_t end = bench_now_ns();
+
+  record("spawn_despawn_churn", storage, num_entities, NUM_CHURN_OPS, NUM_CHURN_OPS, end - start);
+}
+
+static void run_tag_toggle(recs ecs, const char *storage, uint32_t num_entities, recs_entity *entities, uint64_t *seed) {
+  uint64_t start = bench_now_ns();
+  for(uint32_t i = 0; i < NUM_TAG_OPS; i++) {
+    recs_entity e = entities[bench_rand(seed) % num_entities];
+    if(recs_entity_has_tag(ecs, e, TAG_DEAD)) {
+      recs_entity_remove_tag(ecs, e, TAG_DEAD);
+    } else {
+      recs_entity_add_tag(ecs, e, TAG_DEAD);
+    }
+  }
+  uint64_t end = bench_now_ns();
+
+  record("tag_toggle", storage, num_entities, NUM_TAG_OPS, NUM_TAG_OPS, end - start);
+}
+
+static void run_systems(recs ecs, const char *storage, uint32_t num_entities, struct bench_context *ctx) {
+  uint32_t passes = num_passes(num_entities);
+  ctx->visited = 0;
+
+  uint64_t start = bench_now_ns();
+  for(uint32_t pass = 0; pass < passes; pass++) {
+    recs_system_run(ecs, GROUP_UPDATE);
+  }
+  uint64_t end = bench_now_ns();
+
+  record("system_group_dispatch", storage, num_entities, passes, ctx->visited, end - start);
+}
+
+static void run_snapshot(recs ecs, const char *storage, uint32_t num_entities) {
+  uint32_t copies = num_passes(num_entities) / 10;
+  if(copies < MIN_PASSES) copies = MIN_PASSES;
+
+  uint64_t total = 0;
+  for(uint32_t i = 0; i < copies; i++) {
+    uint64_t start = bench_now_ns();
+    recs copy = recs_copy(ecs);
+    uint64_t end = bench_now_ns();
+
+    total += end - start;
+    bench_sink += recs_num_active_entities(copy);
+    recs_free(copy);
+  }
+
+  record("world_snapshot", storage, num_entities, copies, (uint64_t)copies * num_entities, total);
+}
+
+//same as world_snapshot, but copying into a RECS instance that already exists, so nothing is allocated
+static void run_copy_into(recs ecs, const char *storage, uint32_t num_entities) {
+  recs copy = recs_copy(ecs);
+  if(copy == NULL) {
+    fprintf(stderr, "Failed to copy a world with %u entities\n", num_entities);
+    return;
+  }
+
+  uint32_t copies = num_passes(num_entities) / 10;
+  if(copies < MIN_PASSES) copies = MIN_PASSES;
+
+  uint64_t start = bench_now_ns();
+  for(uint32_t i = 0; i < copies; i++) {
+    recs_copy_into(copy, ecs);
+    bench_sink += recs_num_active_entities(copy);
+  }
+  uint64_t end = bench_now_ns();
+
+  record("world_copy_into", storage, num_entities, copies, (uint64_t)copies * num_entities, end - start);
+  recs_free(copy);
+}
+
+//load a saved world into an existing one, as a server would when starting up from a save
+static void run_load(recs ecs, const char *storage, uint32_t num_entities) {
+  size_t size = recs_save_size(ecs);
+  uint8_t *save = malloc(size);
+  recs copy = recs_copy(ecs);
+  if(save == NULL || copy == NULL || recs_save(ecs, save, size) != size) {
+    fprintf(stderr, "Failed to save a world with %u entities\n", num_entities);
+    free(save);
+    recs_free(copy);
+    return;
+  }
+
+  uint32_t loads = num_passes(num_entities) / 10;
+  if(loads < MIN_PASSES) loads = MIN_PASSES;
+
+  uint64_t start = bench_now_ns();
+  for(uint32_t i = 0; i < loads; i++) {
+    bench_sink += (uint64_t)recs_load(copy, save, size);
+  }
+  uint64_t end = bench_now_ns();
+
+  record("world_load", storage, num_entities, loads, (uint64_t)loads * num_entities, end - start);
+  free(save);
+  recs_free(copy);
+}
+
+//move 1 in SNAPSHOT_CHANGE_RATE entities, then iterate through the positions that changed, as a render-sync system would each frame
+static void run_query_changed(recs ecs, const char *storage, uint32_t num_entities, recs_entity *entities, uint64_t *seed) {
+  uint32_t passes = num_passes(num_entities);
+  uint32_t num_changes = num_entities / SNAPSHOT_CHANGE_RATE;
+  uint64_t visited = 0;
+
+  uint64_t total = 0;
+  for(uint32_t pass = 0; pass < passes; pass++) {
+    uint32_t tick = recs_next_change_tick(ecs);
+    for(uint32_t c = 0; c < num_changes; c++) {
+      struct vec3 *p = recs_entity_get_component_mut(ecs, entities[bench_rand(seed) % num_entities], POSITION);
+      p->x += 1.0f;
+    }
+
+    uint64_t start = bench_now_ns();
+    recs_ent_iter iter = recs_ent_iter_init_changed(ecs, NULL, NULL, POSITION, RECS_CHANGE_CHANGED, tick);
+    while(recs_ent_iter_has_next(&iter)) {
+      recs_entity e = recs_ent_iter_next(ecs, &iter);
+      struct vec3 *p = recs_entity_get_component(ecs, e, POSITION);
+      bench_sink += (uint64_t)p->x;
+      visited++;
+    }
+    total += bench_now_ns() - start;
+  }
+
+  bench_sink += visited;
+  record("query_changed_1pct", storage, num_entities, passes, (uint64_t)passes * num_entities, total);
+}
+
+//remove the health of 1 in SNAPSHOT_CHANGE_RATE entities (then give it back), and react to every removal by draining
+//the health events, as a cleanup system would each frame. Compare with query_2comp_10pct, which finds every entity with health.
+static void run_removed_events(recs ecs, const char *storage, uint32_t num_entities, recs_entity *entities, uint64_t *seed) {
+  uint32_t passes = num_passes(num_entities);
+  uint32_t num_changes = num_entities / SNAPSHOT_CHANGE_RATE;
+  uint64_t removed = 0;
+
+  //start from an empty queue
+  struct recs_component_event events[256];
+  while(recs_component_events_drain(ecs, HEALTH, events, 256) > 0);
+
+  uint64_t total = 0;
+  for(uint32_t pass = 0; pass < passes; pass++) {
+    for(uint32_t c = 0; c < num_changes; c++) {
+      recs_entity e = entities[bench_rand(seed) % num_entities];
+      int *health = recs_entity_get_component(ecs, e, HEALTH);
+      if(health == NULL) continue;
+
+      int stat = *health;
+      recs_entity_remove_component(ecs, e, HEALTH);
+      recs_entity_add_component(ecs, e, HEALTH, &stat);
+    }
+
+    uint64_t start = bench_now_ns();
+    uint32_t n;
+    while((n = recs_component_events_drain(ecs, HEALTH, events, 256)) > 0) {
+      for(uint32_t i = 0; i < n; i++) {
+        if(events[i].type != RECS_COMPONENT_REMOVED) continue;
+        bench_sink += (uint64_t)*(const int*)events[i].component;
+        removed++;
+      }
+    }
+    total += bench_now_ns() - start;
+  }
+
+  bench_sink += removed;
+  record("health_removed_events", storage, num_entities, passes, (uint64_t)passes * num_entities, total);
+}
+
+//counts the bytes of a diff without storing them
+static int count_diff_bytes(void *userdata, const void *data, size_t size) {
+  (void)data;
+  *(size_t*)userdata += size;
+  return 1;
+}
+
+//move 1 in SNAPSHOT_CHANGE_RATE entities, then write a diff of the changes, as a server would each network tick.
+//Uses its own world where every component type tracks changes, so that only the changed entities are compared.
+static void run_diff(enum recs_storage_type storage, const char *storage_name, uint32_t num_entities, uint64_t *seed) {
+  struct bench_context ctx = {0};
+  recs_entity *entities = malloc(sizeof(recs_entity) * num_entities);
+  recs ecs = entities == NULL ? NULL : create_world(storage, num_entities, 0, 1, &ctx, entities, seed);
+  recs old = ecs == NULL ? NULL : recs_copy(ecs);
+  if(old == NULL) {
+    fprintf(stderr, "Failed to copy a world with %u entities\n", num_entities);
+    if(ecs != NULL) recs_free(ecs);
+    free(entities);
+    return;
+  }
+
+  uint32_t diffs = num_passes(num_entities) / 10;
+  if(diffs < MIN_PASSES) diffs = MIN_PASSES;
+  uint32_t num_changes = num_entities / SNAPSHOT_CHANGE_RATE;
+
+  //the first diff compares every component added while creating the world, as when sending it to a new client
+  size_t first_size = 0;
+  recs_diff(old, ecs, count_diff_bytes, &first_size);
+  recs_copy_into(old, ecs);
+
+  uint64_t total = 0;
+  for(uint32_t i = 0; i < diffs; i++) {
+    for(uint32_t c = 0; c < num_changes; c++) {
+      struct vec3 *p = recs_entity_get_component_mut(ecs, entities[bench_rand(seed) % num_entities], POSITION);
+      p->x += 1.0f;
+    }
+
+    size_t size = 0;
+    uint64_t start = bench_now_ns();
+    recs_diff(old, ecs, count_diff_bytes, &size);
+    uint64_t end = bench_now_ns();
+
+    total += end - start;
+    bench_sink += size;
+    recs_copy_into(old, ecs);
+  }
+
+  record("world_diff", storage_name, num_entities, diffs, (uint64_t)diffs * num_entities, total);
+  recs_free(old);
+  recs_free(ecs);
+  free(entities);
+}
+
+//move 1 in SNAPSHOT_CHANGE_RATE entities, then bring a snapshot up to date with the changes.
+//Uses its own world, since tracking changes slows down every other scenario a little.
+static void run_snapshot_incremental(enum recs_storage_type storage, const char *storage_name, uint32_t num_entities, uint64_t *seed) {
+  struct bench_context ctx = {0};
+  recs_entity *entities = malloc(sizeof(recs_entity) * num_entities);
+  recs ecs = entities == NULL ? NULL : create_world(storage, num_entities, SNAPSHOT_CHUNK_SIZE, 0, &ctx, entities, seed);
+  recs_snapshot snapshot = ecs == NULL ? NULL : recs_snapshot_create(ecs);
+  if(snapshot == NULL) {
+    fprintf(stderr, "Failed to create a snapshot of a world with %u entities\n", num_entities);
+    if(ecs != NULL) recs_free(ecs);
+    free(entities);
+    return;
+  }
+
+  uint32_t takes = num_passes(num_entities) / 10;
+  if(takes < MIN_PASSES) takes = MIN_PASSES;
+  uint32_t num_changes = num_entities / SNAPSHOT_CHANGE_RATE;
+
+  uint64_t total = 0;
+  for(uint32_t i = 0; i < takes; i++) {
+    for(uint32_t c = 0; c < num_changes; c++) {
+      struct vec3 *p = recs_entity_get_component_mut(ecs, entities[bench_rand(seed) % num_entities], POSITION);
+      p->x += 1.0f;
+    }
+
+    uint64_t start = bench_now_ns();
+    recs_snapshot_take(ecs, snapshot);
+    uint64_t end = bench_now_ns();
+
+    total += end - start;
+    bench_sink += recs_snapshot_copy_size(snapshot);
+  }
+
+  record("world_snapshot_incremental", storage_name, num_entities, takes, (uint64_t)takes * num_entities, total);
+  recs_snapshot_free(snapshot);
+  recs_free(ecs);
+  free(entities);
+}
+
+static int selected(const struct bench_options *opts, const char *scenario) {
+  return opts->scenario == NULL || strcmp(opts->scenario, scenario) == 0;
+}
+
+//a query that no component pool can drive, which used to check every active entity, counting matches without iterating,
+//and a tag so rare that most ranges of entity IDs hold no match
+static void run_column_queries(const struct bench_options *opts, recs ecs, const char *storage, uint32_t num_entities, recs_entity *entities) {
+  uint32_t passes = num_passes(num_entities);
+  uint8_t mask[MASK_SIZE];
+
+  if(selected(opts, "query_any_1pct")) {
+    recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(1, ARMOR), 0, NULL);
+    uint64_t visited = 0;
+
+    uint64_t start = bench_now_ns();
+    for(uint32_t pass = 0; pass < passes; pass++) {
+      recs_ent_iter iter = recs_ent_iter_init_with_match(ecs, mask, RECS_ENT_MATCH_ANY);
+      while(recs_ent_iter_has_next(&iter)) {
+        recs_ent_iter_next(ecs, &iter);
+        visited++;
+      }
+    }
+    uint64_t end = bench_now_ns();
+
+    bench_sink += visited;
+    record("query_any_1pct", storage, num_entities, passes, (uint64_t)passes * num_entities, end - start);
+  }
+
+  if(selected(opts, "count_2comp_10pct")) {
+    recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(2, POSITION, HEALTH), 0, NULL);
+
+    uint64_t start = bench_now_ns();
+    for(uint32_t pass = 0; pass < passes; pass++) {
+      bench_sink += recs_num_matching_entities(ecs, mask, RECS_ENT_MATCH_ALL, NULL, RECS_ENT_MATCH_ANY);
+    }
+    uint64_t end = bench_now_ns();
+
+    record("count_2comp_10pct", storage, num_entities, passes, (uint64_t)passes * num_entities, end - start);
+  }
+
+  if(selected(opts, "query_rare_tag")) {
+    for(uint32_t i = 0; i < num_entities; i += RARE_TAG_RATE) {
+      recs_entity_add_tag(ecs, entities[i], TAG_DEAD);
+    }
+    recs_bitmask_create(ecs, mask, 0, NULL, RECS_BITMASK_CREATE_TAG_ARG(1, TAG_DEAD));
+    uint64_t visited = 0;
+
+    uint64_t start = bench_now_ns();
+    for(uint32_t pass = 0; pass < passes; pass++) {
+      recs_ent_iter iter = recs_ent_iter_init(ecs, mask);
+      while(recs_ent_iter_has_next(&iter)) {
+        recs_ent_iter_next(ecs, &iter);
+        visited++;
+      }
+    }
+    uint64_t end = bench_now_ns();
+
+    for(uint32_t i = 0; i < num_entities; i += RARE_TAG_RATE) {
+      recs_entity_remove_tag(ecs, entities[i], TAG_DEAD);
+    }
+    bench_sink += visited;
+    record("query_rare_tag", storage, num_entities, passes, (uint64_t)passes * num_entities, end - start);
+  }
+}
+
+//queue a few random entities for removal and remove them, then spawn replacements. Only the removal is timed.
+static void run_remove_queued(recs ecs, const char *storage, uint32_t num_entities, recs_entity *entities, uint64_t *seed) {
+  uint32_t passes = num_passes(num_entities);
+  uint32_t slots[NUM_QUEUED_REMOVALS];
+  struct vec3 v = {1, 2, 3};
+  uint64_t total = 0;
+
+  for(uint32_t pass = 0; pass < passes; pass++) {
+    for(uint32_t i = 0; i < NUM_QUEUED_REMOVALS; i++) {
+      slots[i] = (uint32_t)(bench_rand(seed) % num_entities);
+      recs_entity_queue_remove(ecs, entities[slots[i]]);
+    }
+
+    uint64_t start = bench_now_ns();
+    recs_entity_remove_queued(ecs);
+    total += bench_now_ns() - start;
+
+    for(uint32_t i = 0; i < NUM_QUEUED_REMOVALS; i++) {
+      if(recs_entity_active(ecs, entities[slots[i]])) continue;
+      recs_entity e = recs_entity_add(ecs);
+      recs_entity_add_component(ecs, e, POSITION, &v);
+      recs_entity_add_component(ecs, e, VELOCITY, &v);
+      entities[slots[i]] = e;
+    }
+  }
+
+  record("remove_queued_100", storage, num_entities, passes, (uint64_t)passes * NUM_QUEUED_REMOVALS, total);
+}
+
+//move every entity that has a position and a velocity, first through a cached query (looking up both components of each entity),
+//then through a group owning both pools (walking both pools by index). velocity_toggle_* removes the velocity of a random entity,
+//then gives it back, which shows what keeping the group packed costs.
+static void run_groups(const struct bench_options *opts, const char *storage, uint32_t num_entities, uint64_t *seed) {
+  if(!selected(opts, "move_query_2comp") && !selected(opts, "move_group_2comp") && !selected(opts, "velocity_toggle") && !selected(opts, "velocity_toggle_group")) return;
+
+  struct recs_init_config_component comps[2] = {
+    {.type = POSITION, .comp_size = sizeof(struct vec3), .max_components = num_entities},
+    {.type = VELOCITY, .comp_size = sizeof(struct vec3), .max_components = num_entities},
+  };
+  struct recs_init_config config = {
+    .max_entities = num_entities,
+    .max_component_types = 2,
+    .max_tags = 0,
+    .max_systems = 0,
+    .max_system_groups = 1,
+    .max_queries = 1,
+    .max_groups = 1,
+    .components = comps,
+  };
+  recs ecs = recs_init(config);
+  recs_entity *entities = malloc(sizeof(recs_entity) * num_entities);
+  if(ecs == NULL || entities == NULL) {
+    if(ecs != NULL) recs_free(ecs);
+    free(entities);
+    return;
+  }
+
+  //every entity has a position and half have a velocity. Velocities are then shuffled, so the 2 pools are in a different order.
+  struct vec3 v = {1, 2, 3};
+  for(uint32_t i = 0; i < num_entities; i++) {
+    entities[i] = recs_entity_add(ecs);
+    recs_entity_add_component(ecs, entities[i], POSITION, &v);
+    if(bench_rand(seed) % 2 == 0) recs_entity_add_component(ecs, entities[i], VELOCITY, &v);
+  }
+  for(uint32_t i = 0; i < num_entities; i++) {
+    recs_entity e = entities[bench_rand(seed) % num_entities];
+    if(!recs_entity_has_component(ecs, e, VELOCITY)) continue;
+    recs_entity_remove_component(ecs, e, VELOCITY);
+    recs_entity_add_component(ecs, e, VELOCITY, &v);
+  }
+
+  uint32_t passes = num_passes(num_entities);
+  uint8_t mask[RECS_GET_BITMASK_SIZE(2, 0)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(2, POSITION, VELOCITY), 0, NULL);
+  recs_query moving = recs_query_register(ecs, mask, RECS_ENT_MATCH_ALL, NULL, RECS_ENT_MATCH_ANY);
+
+  for(uint32_t grouped = 0; grouped < 2; grouped++) {
+    const char *move_name = grouped ? "move_group_2comp" : "move_query_2comp";
+    const char *toggle_name = grouped ? "velocity_toggle_group" : "velocity_toggle";
+    recs_group group = 0;
+    if(grouped) {
+      recs_component owned[2] = {POSITION, VELOCITY};
+      group = recs_group_register(ecs, owned, 2);
+    }
+
+    if(selected(opts, move_name)) {
+      uint64_t visited = 0;
+      uint64_t start = bench_now_ns();
+      for(uint32_t pass = 0; pass < passes; pass++) {
+        if(grouped) {
+          uint32_t count = 0;
+          struct vec3 *p = recs_group_components(ecs, group, POSITION, 0, &count);
+          struct vec3 *vel = recs_group_components(ecs, group, VELOCITY, 0, NULL);
+          for(uint32_t i = 0; i < count; i++) {
+            p[i].x += vel[i].x;
+            p[i].y += vel[i].y;
+            p[i].z += vel[i].z;
+          }
+          visited += count;
+        } else {
+          recs_entity *moving_entities = recs_query_entities(ecs, moving);
+          uint32_t count = recs_query_num_entities(ecs, moving);
+          for(uint32_t i = 0; i < count; i++) {
+            struct vec3 *p = recs_entity_get_component(ecs, moving_entities[i], POSITION);
+            struct vec3 *vel = recs_entity_get_component(ecs, moving_entities[i], VELOCITY);
+            p->x += vel->x;
+            p->y += vel->y;
+            p->z += vel->z;
+          }
+          visited += count;
+        }
+      }
+      uint64_t end = bench_now_ns();
+
+      bench_sink += visited;
+      record(move_name, storage, num_entities, passes, visited, end - start);
+    }
+
+    if(selected(opts, toggle_name)) {
+      uint64_t start = bench_now_ns();
+      for(uint32_t i = 0; i < NUM_CHURN_OPS; i++) {
+        recs_entity e = entities[bench_rand(seed) % num_entities];
+        if(recs_entity_has_component(ecs, e, VELOCITY)) {
+          recs_entity_remove_component(ecs, e, VELOCITY);
+          recs_entity_add_component(ecs, e, VELOCITY, &v);
+        } else {
+          recs_entity_add_component(ecs, e, VELOCITY, &v);
+          recs_entity_remove_component(ecs, e, VELOCITY);
+        }
+      }
+      uint64_t end = bench_now_ns();
+
+      record(toggle_name, storage, num_entities, NUM_CHURN_OPS, NUM_CHURN_OPS, end - start);
+    }
+  }
+
+  recs_free(ecs);
+  free(entities);
+}
+
+static uint64_t transform_cell_key(const void *component, recs_entity e, void *userdata) {
+  const struct vec3 *t = (const struct vec3*)component;
+  (void)e;
+  (void)userdata;
+  return ((uint64_t)t->y * SORT_GRID_SIZE) + (uint64_t)t->x;
+}
+
+//add every transform to the count of its cell of a SORT_GRID_SIZE x SORT_GRID_SIZE grid, in pool order
+static uint64_t time_cell_scatter(recs ecs, uint32_t *cells, uint32_t passes) {
+  uint32_t count = recs_component_num_instances(ecs, POSITION);
+  uint64_t start = bench_now_ns();
+  for(uint32_t pass = 0; pass < passes; pass++) {
+    for(uint32_t i = 0; i < count; i++) {
+      cells[transform_cell_key(recs_component_get(ecs, POSITION, i), RECS_NO_ENTITY, NULL)]++;
+    }
+  }
+  return bench_now_ns() - start;
+}
+
+//transforms spread over a grid, visited in pool order before and after sorting them by cell. pool_sort_incremental_1pct
+//moves 1 in 100 transforms into a neighbouring cell, then sorts them again.
+static void run_pool_sort(const struct bench_options *opts, const char *storage, uint32_t num_entities, uint64_t *seed) {
+  if(!selected(opts, "cell_scatter_unsorted") && !selected(opts, "pool_sort") && !selected(opts, "cell_scatter_sorted") && !selected(opts, "pool_sort_incremental_1pct")) return;
+
+  struct recs_init_config_component comps[1] = {
+    {.type = POSITION, .comp_size = sizeof(struct vec3), .max_components = num_entities},
+  };
+  struct recs_init_config config = {
+    .max_entities = num_entities,
+    .max_component_types = 1,
+    .max_tags = 0,
+    .max_systems = 0,
+    .max_system_groups = 1,
+    .components = comps,
+  };
+  recs ecs = recs_init(config);
+  uint32_t *cells = calloc((size_t)SORT_GRID_SIZE * SORT_GRID_SIZE, sizeof(uint32_t));
+  if(ecs == NULL || cells == NULL) {
+    if(ecs != NULL) recs_free(ecs);
+    free(cells);
+    return;
+  }
+
+  for(uint32_t i = 0; i < num_entities; i++) {
+    struct vec3 t = {(float)(bench_rand(seed) % SORT_GRID_SIZE), (float)(bench_rand(seed) % SORT_GRID_SIZE), 0};
+    recs_entity_add_component(ecs, recs_entity_add(ecs), POSITION, &t);
+  }
+
+  uint32_t passes = num_passes(num_entities);
+  if(selected(opts, "cell_scatter_unsorted")) {
+    record("cell_scatter_unsorted", storage, num_entities, passes, (uint64_t)passes * num_entities, time_cell_scatter(ecs, cells, passes));
+  }
+
+  uint64_t start = bench_now_ns();
+  recs_component_pool_sort(ecs, POSITION, transform_cell_key, NULL);
+  uint64_t end = bench_now_ns();
+  if(selected(opts, "pool_sort")) {
+    record("pool_sort", storage, num_entities, 1, num_entities, end - start);
+  }
+
+  if(selected(opts, "cell_scatter_sorted")) {
+    record("cell_scatter_sorted", storage, num_entities, passes, (uint64_t)passes * num_entities, time_cell_scatter(ecs, cells, passes));
+  }
+
+  if(selected(opts, "pool_sort_incremental_1pct")) {
+    uint64_t total = 0;
+    for(uint32_t pass = 0; pass < passes; pass++) {
+      for(uint32_t i = 0; i < num_entities / 100; i++) {
+        struct vec3 *t = recs_component_get(ecs, POSITION, (uint32_t)(bench_rand(seed) % num_entities));
+        t->x = t->x + 1 < SORT_GRID_SIZE ? t->x + 1 : 0;
+      }
+
+      start = bench_now_ns();
+      recs_component_pool_sort_incremental(ecs, POSITION, transform_cell_key, NULL);
+      total += bench_now_ns() - start;
+    }
+    record("pool_sort_incremental_1pct", storage, num_entities, passes, (uint64_t)passes * num_entities, total);
+  }
+
+  bench_sink += cells[0];
+  recs_free(ecs);
+  free(cells);
+}
+
+//move rigid bodies along their velocity, storing them as whole components (aos), as one column per field (soa),
+//or as columns inside blocks of 16 components (aosoa16)
+static void run_field_layouts(const struct bench_options *opts, const char *storage, uint32_t num_entities) {
+  static const char *names[3] = {"rigid_body_move_aos", "rigid_body_move_soa", "rigid_body_move_aosoa16"};
+  static const struct recs_component_field fields[7] = {
+    {offsetof(struct rigid_body, x), sizeof(float)},
+    {offsetof(struct rigid_body, y), sizeof(float)},
+    {offsetof(struct rigid_body, z), sizeof(float)},
+    {offsetof(struct rigid_body, vx), sizeof(float)},
+    {offsetof(struct rigid_body, vy), sizeof(float)},
+    {offsetof(struct rigid_body, vz), sizeof(float)},
+    {offsetof(struct rigid_body, rest), sizeof(float) * 18},
+  };
+
+  for(uint32_t layout = 0; layout < 3; layout++) {
+    if(!selected(opts, names[layout])) continue;
+
+    struct recs_init_config_component comps[1] = {
+      {.type = POSITION, .comp_size = sizeof(struct rigid_body), .max_components = num_entities,
+        .fields = layout == 0 ? NULL : fields, .num_fields = layout == 0 ? 0 : 7, .field_block_size = layout == 2 ? 16 : 0},
+    };
+    struct recs_init_config config = {
+      .max_entities = num_entities,
+      .max_component_types = 1,
+      .max_tags = 0,
+      .max_systems = 0,
+      .max_system_groups = 1,
+      .components = comps,
+    };
+    recs ecs = recs_init(config);
+    if(ecs == NULL) continue;
+
+    struct rigid_body body = {0, 0, 0, 1, 2, 3, {0}};
+    recs_entity first = RECS_NO_ENTITY;
+    for(uint32_t i = 0; i < num_entities; i++) {
+      recs_entity e = recs_entity_add(ecs);
+      recs_entity_add_component(ecs, e, POSITION, &body);
+      first = i == 0 ? e : first;
+    }
+
+    uint32_t passes = num_passes(num_entities);
+    uint64_t start = bench_now_ns();
+    for(uint32_t pass = 0; pass < passes; pass++) {
+      //fixed-size RECS instances keep every component of a type inside a single page
+      if(layout == 0) {
+        struct rigid_body *bodies = recs_component_get(ecs, POSITION, 0);
+        for(uint32_t i = 0; i < num_entities; i++) {
+          bodies[i].x += bodies[i].vx;
+          bodies[i].y += bodies[i].vy;
+          bodies[i].z += bodies[i].vz;
+        }
+        continue;
+      }
+
+      for(uint32_t i = 0; i < num_entities;) {
+        uint32_t count = 0;
+        float *x = recs_component_field(ecs, POSITION, 0, i, &count);
+        float *y = recs_component_field(ecs, POSITION, 1, i, NULL);
+        float *z = recs_component_field(ecs, POSITION, 2, i, NULL);
+        const float *vx = recs_component_field(ecs, POSITION, 3, i, NULL);
+        const float *vy = recs_component_field(ecs, POSITION, 4, i, NULL);
+        const float *vz = recs_component_field(ecs, POSITION, 5, i, NULL);
+        for(uint32_t j = 0; j < count; j++) {
+          x[j] += vx[j];
+          y[j] += vy[j];
+          z[j] += vz[j];
+        }
+        i += count;
+      }
+    }
+    uint64_t end = bench_now_ns();
+    record(names[layout], storage, num_entities, passes, (uint64_t)passes * num_entities, end - start);
+
+    recs_entity_gather_component(ecs, first, POSITION, &body);
+    bench_sink += (uint64_t)body.x;
+    recs_free(ecs);
+  }
+}
+
+//compare removal policies using a world where 1 in BIG_COMP_RATE entities have a BIG_COMP_SIZE byte component.
+//big_comp_churn_* removes the component of a random entity, then gives it back. big_comp_iter_* removes half of the components
+//at random, then iterates over the rest, which shows what the free slots left by RECS_REMOVAL_STABLE cost.
+
+static void run_removal_policy(const struct bench_options *opts, enum recs_removal_policy policy, const char *storage, uint32_t num_entities, uint64_t *seed) {
+  const char *churn_name = policy == RECS_REMOVAL_STABLE ? "big_comp_churn_stable" : "big_comp_churn_swap";
+  const char *iter_name = policy == RECS_REMOVAL_STABLE ? "big_comp_iter_stable" : "big_comp_iter_swap";
+  if(!selected(opts, churn_name) && !selected(opts, iter_name)) return;
+
+  uint32_t num_big = num_entities / BIG_COMP_RATE;
+  if(num_big == 0) num_big = 1;
+
+  struct recs_init_config_component comps[1] = {
+    {.type = 0, .comp_size = sizeof(struct big_component), .max_components = num_big, .removal_policy = policy},
+  };
+  struct recs_init_config config = {
+    .max_entities = num_big,
+    .max_component_types = 1,
+    .max_tags = 1,
+    .max_systems = 0,
+    .max_system_groups = 1,
+    .components = comps,
+  };
+
+  recs_entity *entities = malloc(sizeof(recs_entity) * num_big);
+  recs ecs = entities == NULL ? NULL : recs_init(config);
+  if(ecs == NULL) {
+    fprintf(stderr, "Failed to create a world with %u big components\n", num_big);
+    free(entities);
+    return;
+  }
+
+  struct big_component big = {0};
+  for(uint32_t i = 0; i < num_big; i++) {
+    entities[i] = recs_entity_add(ecs);
+    big.value = i;
+    recs_entity_add_component(ecs, entities[i], 0, &big);
+  }
+
+  if(selected(opts, churn_name)) {
+    uint64_t start = bench_now_ns();
+    for(uint32_t i = 0; i < NUM_CHURN_OPS; i++) {
+      recs_entity e = entities[bench_rand(seed) % num_big];
+      recs_entity_remove_component(ecs, e, 0);
+      recs_entity_add_component(ecs, e, 0, &big);
+    }
+    uint64_t end = bench_now_ns();
+    record(churn_name, storage, num_entities, NUM_CHURN_OPS, NUM_CHURN_OPS, end - start);
+  }
+
+  if(selected(opts, iter_name)) {
+    for(uint32_t i = 0; i < num_big; i++) {
+      if(bench_rand(seed) % 2 == 0) recs_entity_remove_component(ecs, entities[i], 0);
+    }
+
+    uint8_t mask[RECS_GET_BITMASK_SIZE(1, 1)];
+    recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(1, 0), 0, NULL);
+    uint32_t passes = num_passes(num_big);
+
+    uint64_t start = bench_now_ns();
+    for(uint32_t pass = 0; pass < passes; pass++) {
+      recs_ent_iter iter = recs_ent_iter_init(ecs, mask);
+      while(recs_ent_iter_has_next(&iter)) {
+        recs_entity e = recs_ent_iter_next(ecs, &iter);
+        bench_sink += ((struct big_component*)recs_entity_get_component(ecs, e, 0))->value;
+      }
+    }
+    uint64_t end = bench_now_ns();
+    record(iter_name, storage, num_entities, passes, (uint64_t)passes * num_big, end - start);
+  }
+
+  recs_free(ecs);
+  free(entities);
+}
+
+static int run(const struct bench_options *opts, enum recs_storage_type storage, const char *storage_name, uint32_t num_entities) {
+  uint64_t seed = 0x9E3779B97F4A7C15ull;
+  struct bench_context ctx = {0};
+  recs_entity *entities = malloc(sizeof(recs_entity) * num_entities);
+  recs ecs = create_world(storage, num_entities, 0, 0, &ctx, entities, &seed);
+  if(ecs == NULL || entities == NULL) {
+    fprintf(stderr, "Failed to create a world with %u entities\n", num_entities);
+    free(entities);
+    return 1;
+  }
+
+  run_queries(opts, ecs, storage_name, num_entities);
+  run_column_queries(opts, ecs, storage_name, num_entities, entities);
+  if(selected(opts, "query_changed_1pct") && storage == RECS_STORAGE_SPARSE_SET) run_query_changed(ecs, storage_name, num_entities, entities, &seed);
+  if(selected(opts, "health_removed_events") && storage == RECS_STORAGE_SPARSE_SET) run_removed_events(ecs, storage_name, num_entities, entities, &seed);
+  if(selected(opts, "system_group_dispatch")) run_systems(ecs, storage_name, num_entities, &ctx);
+  if(selected(opts, "world_snapshot")) run_snapshot(ecs, storage_name, num_entities);
+  if(selected(opts, "world_copy_into")) run_copy_into(ecs, storage_name, num_entities);
+  if(selected(opts, "world_load")) run_load(ecs, storage_name, num_entities);
+  if(selected(opts, "world_snapshot_incremental")) run_snapshot_incremental(storage, storage_name, num_entities, &seed);
+  if(selected(opts, "world_diff")) run_diff(storage, storage_name, num_entities, &seed);
+  if(storage == RECS_STORAGE_SPARSE_SET) {
+    run_removal_policy(opts, RECS_REMOVAL_SWAP, storage_name, num_entities, &seed);
+    run_removal_policy(opts, RECS_REMOVAL_STABLE, storage_name, num_entities, &seed);
+    run_groups(opts, storage_name, num_entities, &seed);
+    run_pool_sort(opts, storage_name, num_entities, &seed);
+    run_field_layouts(opts, storage_name, num_entities);
+  }
+  if(selected(opts, "remove_queued_100")) run_remove_queued(ecs, storage_name, num_entities, entities, &seed);
+  if(selected(opts, "tag_toggle")) run_tag_toggle(ecs, storage_name, num_entities, entities, &seed);
+  if(selected(opts, "spawn_despawn_churn")) run_churn(ecs, storage_name, num_entities, entities, &seed);
+
+  recs_free(ecs);
+  free(entities);
+  return 0;
+}
+
+
+static void print_results(enum output_format format) {
+  if(format == OUTPUT_CSV) {
+    printf("scenario,storage,entities,ops,total_ns,ns_per_op,entities_per_sec\n");
+  } else {
+    printf("[\n");
+  }
+
+  for(uint32_t i = 0; i < num_results; i++) {
+    const struct result *r = results + i;
+    double ns_per_op = (double)r->total_ns / (double)r->ops;
+    double entities_per_sec = (double)r->entities * 1e9 / (double)r->total_ns;
+
+    if(format == OUTPUT_CSV) {
+      printf("%s,%s,%u,%llu,%llu,%.2f,%.0f\n", r->scenario, r->storage, r->num_entities,
+        (unsigned long long)r->ops, (unsigned long long)r->total_ns, ns_per_op, entities_per_sec);
+    } else {
+      printf("  {\"scenario\": \"%s\", \"storage\": \"%s\", \"entities\": %u, \"ops\": %llu, \"total_ns\": %llu, "
+        "\"ns_per_op\": %.2f, \"entities_per_sec\": %.0f}%s\n", r->scenario, r->storage, r->num_entities,
+        (unsigned long long)r->ops, (unsigned long long)r->total_ns, ns_per_op, entities_per_sec,
+        i + 1 < num_results ? "," : "");
+    }
+  }
+
+  if(format == OUTPUT_JSON) {
+    printf("]\n");
+  }
+}
+
+static int parse_options(int argc, char **argv, struct bench_options *opts) {
+  for(int i = 1; i < argc; i++) {
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if(strcmp(argv[i], "--format") == 0 && value != NULL) {
+      if(strcmp(value, "csv") == 0) {
+        opts->format = OUTPUT_CSV;
+      } else if(strcmp(value, "json") == 0) {
+        opts->format = OUTPUT_JSON;
+      } else {
+        return 0;
+      }
+    } else if(strcmp(argv[i], "--max-entities") == 0 && value != NULL) {
+      opts->max_entities = (uint32_t)strtoul(value, NULL, 10);
+    } else if(strcmp(argv[i], "--storage") == 0 && value != NULL) {
+      opts->storage = value;
+    } else if(strcmp(argv[i], "--scenario") == 0 && value != NULL) {
+      opts->scenario = value;
+    } else {
+      return 0;
+    }
+    i++;
+  }
+  return 1;
+}
+
+int main(int argc, char **argv) {
+  struct bench_options opts = {
+    .format = OUTPUT_CSV,
+    .max_entities = 1000000,
+    .storage = NULL,
+    .scenario = NULL
+  };
+
+  if(!parse_options(argc, argv, &opts)) {
+    fprintf(stderr, "Usage: %s [--format csv|json] [--max-entities N] [--storage sparse|archetype] [--scenario NAME]\n", argv[0]);
+    return 1;
+  }
+
+  const uint32_t sizes[NUM_SIZES] = {1000, 10000, 100000, 1000000};
+  const struct {
+    enum recs_storage_type type;
+    const char *name;
+  } storages[2] = {
+    {RECS_STORAGE_SPARSE_SET, "sparse"},
+    {RECS_STORAGE_ARCHETYPE, "archetype"}
+  };
+
+  for(uint32_t s = 0; s < 2; s++) {
+    if(opts.storage != NULL && strcmp(opts.storage, storages[s].name) != 0) continue;
+
+    for(uint32_t i = 0; i < NUM_SIZES && sizes[i] <= opts.max_entities; i++) {
+      if(run(&opts, storages[s].type, storages[s].name, sizes[i]) != 0) {
+        free(results);
+        return 1;
+      }
+    }
+  }
+
+  print_results(opts.format);
+  free(results);
+  return 0;
+}
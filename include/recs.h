@@ -28,11 +28,15 @@
 // uint32_t when you want to specify that there is no entity.
 #define RECS_NO_ENTITY_ID 0xFFFFFFFF
 
+//the maximum number of fields a component type can be split into (see recs_init_config_component)
+#define RECS_MAX_COMPONENT_FIELDS 16
+
 
 
 
 //get the size (in bytes) of the bitmask being used to check tags and components.
-#define RECS_GET_BITMASK_SIZE(max_components, max_tags) (((max_components) + (max_tags) + 8 - 1) / 8)
+//Bitmasks are padded to a multiple of 8 bytes so that they can be compared 64 bits at a time.
+#define RECS_GET_BITMASK_SIZE(max_components, max_tags) ((((max_components) + (max_tags) + 64 - 1) / 64) * 8)
 
 #define RECS_ENT_FROM(id, version) ((recs_entity) (((uint64_t)(id)) | ((uint64_t)(version) << 32)))
 #define RECS_ENT_VERSION(ent) ((uint32_t)((ent) >> 32))
@@ -53,16 +57,70 @@ enum recs_ent_match_op {
 
 };
 
+//filters used to only find entities whose component changed since a specific tick (see recs_ent_iter_init_changed())
+enum recs_change_filter {
+  RECS_CHANGE_NONE,    //do not filter entities by changes
+  RECS_CHANGE_ADDED,   //the component was added after the tick
+  RECS_CHANGE_CHANGED, //the component was added, or written to through recs_entity_get_component_mut(), after the tick
+};
+
+// kinds of events kept by component event queues (see recs_component_events_drain())
+enum recs_component_event_type {
+  RECS_COMPONENT_ADDED,   //the component was added to the entity
+  RECS_COMPONENT_REMOVED, //the component was removed from the entity, or the entity was removed
+};
+
+// what a component pool does with the slot of a removed component
+enum recs_removal_policy {
+  RECS_REMOVAL_SWAP,   //move the last component into the slot, keeping components densely packed (default)
+  RECS_REMOVAL_STABLE, //leave the slot free for a later component, so components never move until recs_component_pool_compact()
+};
+
 typedef uint32_t recs_component;
 typedef uint64_t recs_entity;
 typedef uint32_t recs_tag;
 typedef uint32_t recs_system_group;
+typedef uint32_t recs_query;
+typedef uint32_t recs_group;
+
+// how the data of each component is stored
+enum recs_storage_type {
+  //every component type has its own pool, mapping entity IDs to components (the default).
+  RECS_STORAGE_SPARSE_SET,
+
+  //entities with the same set of components are stored together inside tables, with one
+  //column per component. This makes iterating over entities with several components faster, at the
+  //cost of slower adding/removing of components, since the entity's row needs to move to another table.
+  //Since rows move around, avoid adding/removing components of matching entities while iterating (queue them instead).
+  //Component pointers are only valid until the entity's components change.
+  RECS_STORAGE_ARCHETYPE,
+};
 
 
 
 typedef struct recs_entity_iterator {
   recs_entity next_entity;
   uint32_t index;
+
+  //the component pool whose entities are being iterated through. When an iterator
+  //must have ALL of several components, we only need to look at the entities inside
+  //the smallest of those component pools. 
+  //If RECS_NO_ENTITY_ID, the iterator goes through the entire active entity list.
+  recs_component driving_component;
+
+  //the archetype and chunk being searched when using RECS_STORAGE_ARCHETYPE, where index
+  //is the row within that chunk. If archetype is RECS_NO_ENTITY_ID, the iterator goes through
+  //the active entity list instead.
+  uint32_t archetype;
+  uint32_t chunk;
+
+  //set when the tags of each entity in the current archetype still need to be checked.
+  uint8_t check_each_row;
+
+  //when not RECS_CHANGE_NONE, only entities whose driving_component was added or changed after change_since are found.
+  enum recs_change_filter change_filter;
+  uint32_t change_since;
+
   uint8_t *include_bitmask;
 
   // default operation is an ALL
@@ -80,26 +138,85 @@ typedef struct recs_entity_iterator {
   //even if the active entity list grows.
   uint32_t max_entity_index;
 
-
+  //set when the iterator scans the bitset of each component and tag instead (see recs_num_matching_entities()).
+  //index is then the next word of 64 entity IDs to check, and column_bits holds the matches not yet returned from the word before it,
+  //which are matched again if the bitsets changed since column_changes.
+  uint8_t use_columns;
+  uint32_t column_changes;
+  uint64_t column_bits;
 } recs_ent_iter;
 
 
 typedef struct recs *recs;
 
+//a pool of threads used to run systems in parallel
+typedef struct recs_workers *recs_workers;
+
 
 typedef void (*recs_system_func)(struct recs *ecs);
 
+//called on each entity by recs_query_par_each(). thread_index is unique to the thread making the call, 
+//and is less than recs_workers_num_threads(), so it can be used to pick per-thread scratch memory.
+typedef void (*recs_query_each_func)(struct recs *ecs, recs_entity e, void *userdata, uint32_t thread_index);
+
 //configuration struct
 
+//a field of a component, usually filled in using offsetof() and sizeof()
+struct recs_component_field {
+  size_t offset;
+  size_t size;
+};
+
 struct recs_init_config_component {
     recs_component type;
     size_t comp_size;
     uint32_t max_components;
+
+    //if non-zero, remember the tick at which each component was added and last changed, so that systems can
+    //only look at the components that changed since they last ran (see recs_ent_iter_init_changed()).
+    //Only supported by RECS_STORAGE_SPARSE_SET.
+    uint8_t track_changes;
+
+    //if non-zero, keep a queue of up to max_events events for each time a component of this type is added or removed,
+    //so that systems can react to them without scanning every entity (see recs_component_events_drain()).
+    //Once the queue is full, the oldest events are dropped. Only supported by RECS_STORAGE_SPARSE_SET.
+    uint32_t max_events;
+
+    //RECS_REMOVAL_STABLE avoids copying the last component into every removed one, which is worth it for
+    //big components, and keeps component indexes stable. Only supported by RECS_STORAGE_SPARSE_SET.
+    enum recs_removal_policy removal_policy;
+
+    //if num_fields is non-zero, the pool stores each of these fields inside a column of its own instead of storing whole
+    //components one after the other, so systems that only use a few fields of a big component only load those fields
+    //(see recs_component_field()). Fields must be listed in order of offset and cannot overlap. Bytes outside of every field are not stored.
+    //Since the pool holds no whole components, read and write them using recs_entity_gather_component() and recs_entity_scatter_component()
+    //rather than through component pointers: recs_entity_get_component(), recs_entity_get_component_mut(), recs_component_get(), and
+    //recs_ent_iter_next_batch() give NULL for them. Only supported by RECS_STORAGE_SPARSE_SET, and not by groups or recs_component_pool_sort().
+    const struct recs_component_field *fields;
+    uint32_t num_fields;
+
+    //number of components in each block of field columns, which must be a power of 2 (such as 8 or 16, to match the width of
+    //vector registers). Each block stores the fields of its components one column after the other. If 0, every page of
+    //components is a single block, so each column runs across the whole page.
+    uint32_t field_block_size;
 };
 
 struct recs_init_config_system {
   recs_system_func func;
   recs_system_group group;
+
+  //the components and tags this system reads and writes, used by recs_system_run_parallel() to decide which
+  //systems can run at the same time. Systems that write to something another system reads or writes run one after 
+  //the other, in the order they were registered in.
+  //If a system does not list anything, it is assumed to access everything and never runs alongside other systems.
+  const recs_component *read_comps;
+  uint32_t num_read_comps;
+  const recs_component *write_comps;
+  uint32_t num_write_comps;
+  const recs_tag *read_tags;
+  uint32_t num_read_tags;
+  const recs_tag *write_tags;
+  uint32_t num_write_tags;
 };
 
 
@@ -109,8 +226,44 @@ struct recs_init_config {
   uint32_t max_tags;
   uint32_t max_systems;
   uint32_t max_system_groups;
+
+  //maximum number of queries that can be registered using recs_query_register()
+  uint32_t max_queries;
+
+  //maximum number of groups that can be registered using recs_group_register()
+  uint32_t max_groups;
   void *context;
 
+  //defaults to RECS_STORAGE_SPARSE_SET.
+  enum recs_storage_type storage;
+
+  //the following are only used by RECS_STORAGE_ARCHETYPE. Leave any of them as 0 to use a default value.
+
+  //maximum number of unique component combinations. Defaults to 256.
+  uint32_t max_archetypes;
+
+  //size (in bytes) of each block of memory that stores rows of an archetype. Defaults to 16 KiB,
+  //but is raised if a row containing every component type does not fit.
+  uint32_t archetype_chunk_size;
+
+  //number of chunks shared by every archetype. Defaults to enough chunks to store max_components of 
+  //each component type, no matter how they are spread among archetypes.
+  uint32_t max_archetype_chunks;
+
+  //if non-zero, max_entities and the max_components of each component type are only the starting capacity,
+  //and the RECS instance grows whenever it runs out of room (only supported by RECS_STORAGE_SPARSE_SET).
+  //Buffers indexed by entity ID double in size when full, while component data is stored inside pages that
+  //are never moved, so component pointers stay valid while the RECS instance grows (but not after the component is removed).
+  //If 0, everything is stored inside one allocation made by recs_init(), and going over any limit asserts.
+  uint8_t growable;
+
+  //size (in bytes) of each page of component data when growable is set. Defaults to 16 KiB.
+  uint32_t component_page_size;
+
+  //if non-zero, the RECS instance remembers which chunks of this many bytes (rounded up to a power of 2) it wrote to,
+  //so that snapshots only copy the chunks that changed (see recs_snapshot_take()). Not supported when growable is set.
+  uint32_t snapshot_chunk_size;
+
   struct recs_init_config_component *components;
   struct recs_init_config_system *systems;
 
@@ -118,6 +271,19 @@ struct recs_init_config {
 
 };
 
+//memory used by a RECS instance, filled in by recs_memory_usage()
+struct recs_memory_usage {
+  //every byte allocated by the RECS instance, including memory allocated while growing
+  size_t total_bytes;
+
+  //bytes reserved for mapping entity IDs to component indexes (summed over every component type).
+  //Each map only writes to the pages of entity IDs that have its component, so the OS usually only backs those with memory.
+  size_t entity_to_comp_bytes;
+
+  //bytes of those maps that are in use
+  size_t entity_to_comp_used_bytes;
+};
+
 //convienence macros for initializing enums for component ids, tags, and system groups.
 //this reduces the chance of a user making the mistake of defining custom values in their enum definition,
 //which would prevent the ECS from working correctly.
@@ -146,19 +312,67 @@ recs recs_init(const struct recs_init_config config);
 //performs a deep copy of the ECS and returns a pointer to the new copy, or NULL if it fails.
 recs recs_copy(recs ecs);
 
+//overwrite dst with the state of src without allocating any memory, so that rolling back to a copy made by recs_copy()
+//keeps every pointer to dst valid. Both RECS instances must have been created with the same config (or be copies of one another),
+//and cannot be growable. Only the components and entities in use are copied. dst keeps its own system context.
+void recs_copy_into(recs dst, recs src);
+
 //free RECS instance from memory, destroying all entities, components, and systems
 void recs_free(struct recs *recs);
 
+//get how much memory a RECS instance uses
+void recs_memory_usage(struct recs *recs, struct recs_memory_usage *usage);
+
 
-//get a component directly from the component pool's raw buffer.
+//get a component directly from the component pool's raw buffer. Returns NULL if its component type is split into fields.
+//When using RECS_STORAGE_ARCHETYPE, components are spread across several tables, so this 
+//needs to walk through every table containing the component.
 void* recs_component_get(struct recs *recs, recs_component c, uint32_t index);
 
 //get the number of active instances of a component
 uint32_t recs_component_num_instances(struct recs *recs, recs_component c);
 
+//get the number of component indexes in use, including free slots left by RECS_REMOVAL_STABLE. recs_component_get() 
+//returns NULL (and recs_component_get_entity() returns RECS_NO_ENTITY) for free slots.
+uint32_t recs_component_num_slots(struct recs *recs, recs_component c);
+
+//move the last components of a RECS_REMOVAL_STABLE component type into its free slots, so that its components are densely
+//packed again. This changes the indexes of the moved components. Does nothing for RECS_REMOVAL_SWAP component types.
+void recs_component_pool_compact(struct recs *recs, recs_component c);
+
+//get the key a component is sorted by (see recs_component_pool_sort()), such as its spatial cell or material.
+//e is the entity the component belongs to.
+typedef uint64_t (*recs_component_key_func)(const void *component, recs_entity e, void *userdata);
+
+//reorder the components of a type by key, smallest first, so that recs_component_get() (and iterators going through
+//its pool) visit them in that order. Components with equal keys keep their order. This changes the indexes of the moved
+//components, so do not call this while iterating. RECS_REMOVAL_STABLE component types are compacted first.
+//If a group owns the pool, the group's entities are sorted among themselves and moved the same way in every pool of
+//the group, while the rest of the pool is sorted on its own. Keys are computed once per component, inside memory allocated
+//for the call (24 bytes per component). Returns 0 if the allocation failed, in which case nothing moved.
+//Does nothing for RECS_STORAGE_ARCHETYPE.
+int recs_component_pool_sort(struct recs *recs, recs_component c, recs_component_key_func key, void *userdata);
+
+//same as recs_component_pool_sort(), but using an insertion sort that does not allocate any memory and only moves
+//the components that are out of order. This is meant for keeping components sorted from frame to frame, when only a few
+//moved since the last sort, and gets slow for components that are far from sorted. Keys are computed again for every comparison.
+void recs_component_pool_sort_incremental(struct recs *recs, recs_component c, recs_component_key_func key, void *userdata);
+
+//get the column of a field (the field-th of the fields given when creating the component type) starting at the component
+//at index, or NULL if index is past the last slot. If count is not NULL, it is set to the number of components whose field is
+//stored one after the other from there on, up to the end of the block (see field_block_size). Like recs_component_get(),
+//columns of RECS_REMOVAL_STABLE component types include free slots. Writes through the column are not seen as changes or by snapshots.
+void *recs_component_field(struct recs *recs, recs_component c, uint32_t field, uint32_t index, uint32_t *count);
+
 //get the entity associated with the component at the component index to the raw component buffer.
 recs_entity recs_component_get_entity(struct recs *recs, recs_component c, uint32_t comp_index);
 
+//get the size (in bytes) of a component type
+size_t recs_component_size(struct recs *recs, recs_component c);
+
+//get the number of component types this RECS instance was created with
+uint32_t recs_num_component_types(struct recs *recs);
+
 
 
 
@@ -174,27 +388,81 @@ void* recs_system_get_context(struct recs *recs);
 //same order as the order were registered in.
 void recs_system_run(struct recs *recs, recs_system_group group);
 
+//get the tick at which the running system last ran (0 if it never ran), to pass to recs_ent_iter_init_changed().
+//Only meaningful when called from inside a system. Systems running in parallel get the earliest tick at which
+//any system in their group last ran, so they may see a few of their own changes again.
+uint32_t recs_system_last_run_tick(struct recs *recs);
+
+//start a new tick, returning the tick that just ended. Components added or changed after this call are stamped with a later tick,
+//so code outside of systems can keep the returned tick, then later pass it to recs_ent_iter_init_changed() to find them.
+//Each system run gets a new tick as well.
+uint32_t recs_next_change_tick(struct recs *recs);
+
+//a component added to or removed from an entity
+struct recs_component_event {
+  recs_entity entity;
+  enum recs_component_event_type type;
+
+  //a copy of the component that was removed, so that anything it refers to can still be released (NULL for added components).
+  //It points inside the event queue, and stays valid until a component of the same type is added or removed.
+  const void *component;
+};
+
+//move up to max_events of the oldest events of a component type into events, oldest first. Returns the number of events moved.
+//The component type must have been registered with max_events set.
+uint32_t recs_component_events_drain(struct recs *recs, recs_component c, struct recs_component_event *events, uint32_t max_events);
+
+//get the number of events of a component type waiting to be drained
+uint32_t recs_component_events_count(struct recs *recs, recs_component c);
+
+//get the number of events of a component type dropped because its queue was full. If this grows,
+//the queue was not drained often enough, and anything relying on the events should fall back to a full scan.
+uint32_t recs_component_events_num_dropped(struct recs *recs, recs_component c);
+
+//run a set of systems within a system group using a pool of threads. Systems whose declared read/write access 
+//does not conflict may run at the same time, while conflicting systems still run in the order they were registered in.
+//Systems running in parallel must not add or remove entities, components, or tags. 
+//If workers is NULL, this is the same as recs_system_run().
+void recs_system_run_parallel(struct recs *recs, recs_workers workers, recs_system_group group);
+
+
+//create a pool of threads. num_threads includes the thread that will be running the systems,
+//so a pool of 1 thread does not create any new threads. Returns NULL if the threads could not be created.
+//A pool can be shared between several RECS instances, but can only run one group of systems at a time.
+recs_workers recs_workers_create(uint32_t num_threads);
+
+//stop and free every thread within the pool
+void recs_workers_free(recs_workers workers);
+
+uint32_t recs_workers_num_threads(recs_workers workers);
+
 
 
 //check the number of active entities
 uint32_t recs_num_active_entities(struct recs *recs);
 
+//count the active entities matching an include and exclude mask (either of which may be NULL), without iterating over them.
+//Each component and tag keeps a bitset over entity IDs, so this checks 64 entities at a time.
+uint32_t recs_num_matching_entities(struct recs *ecs, uint8_t *include_mask, enum recs_ent_match_op include_op, uint8_t *exclude_mask, enum recs_ent_match_op exclude_op);
+
 
 //add an entity without components
 recs_entity recs_entity_add(struct recs *recs);
 
-/* TODO: Allow the following to be done
-  1. Immediately remove entity from being processed in a system
-  2. Immediately add entity that can be processed as soon as it spawns
-  3. Queue an entity to be removed, but still allow it to be processed while finishing iteration.
-  4. Queue an entity to be added, but not allowing it to process until iteration is done.
-
-  We currently only natively support options 1 and 2. While users of this library can 
-  technically achieve options 3 and 4 using tags and a custom system, I would like this
-  to not be necessary.
-
-  This could be accomplished by adding booleans to the entity iterators, which can choose
-  to skip entities being added or locking the "num_entities" limit when queuing newly added entities.
+//add n entities that all have the components and tags inside signature_mask, writing the new entities into out_entities.
+//component_arrays is indexed by component type, where component_arrays[c] points to n contiguous instances of
+//component c (the i-th instance goes to the i-th entity). Entries for components not inside signature_mask are ignored,
+//so component_arrays only needs to be as long as the largest component type inside the mask.
+//signature_mask can be NULL to add entities without components or tags.
+void recs_entity_add_bulk(struct recs *recs, uint32_t n, recs_entity *out_entities, uint8_t *signature_mask, const void * const *component_arrays);
+
+/* Adding and removing entities while systems run
+  1. Immediately remove an entity from being processed in a system: recs_entity_remove() or recs_entity_queue_remove().
+  2. Immediately add an entity that can be processed as soon as it spawns: recs_entity_add().
+  3. Queue an entity to be removed, but still allow it to be processed while finishing iteration: record the removal
+     inside a command buffer (see recs_cmd_buffer below), then play it back once iteration is done.
+  4. Queue an entity to be added, but not allow it to be processed until iteration is done: record the entity inside
+     a command buffer, which only creates it during playback.
 */
 
 //queue an entity to be removed and disable it from being found in recs_ent_iter iterators.
@@ -211,6 +479,10 @@ void recs_entity_remove_queued(struct recs *ecs);
 //If calling this while iterating, entities may be skipped.
 void recs_entity_remove(struct recs *ecs, recs_entity e);
 
+//immediately remove n entities from the active entity pool. Entities that are not active are skipped.
+//NOTE: This should only be called when NOT ITERATING OVER ENTITIES using recs_ent_iter.
+void recs_entity_remove_bulk(struct recs *ecs, uint32_t n, const recs_entity *entities);
+
 
 //add a component to a specific entity.
 void recs_entity_add_component(struct recs *recs, recs_entity e, recs_component comp_type, void *component);
@@ -244,9 +516,29 @@ int recs_entity_has_excluded_components(struct recs *ecs, recs_entity e, uint8_t
 // check if entity's component mask matches the provided mask based on the matching operator
 int recs_entity_matches_component_mask(struct recs *ecs, recs_entity e, uint8_t *mask, enum recs_ent_match_op match_op);
 
-//retrieve the component of a specific entity.
+//retrieve the component of a specific entity. Returns NULL if the entity does not have the component,
+//or if its component type is split into fields (see recs_entity_gather_component()).
+//NOTE: writes through the returned pointer are not seen by snapshots. Use recs_entity_get_component_mut()
+//for components you are going to modify if you use recs_snapshot_take().
 void* recs_entity_get_component(struct recs *recs, recs_entity e, recs_component c);
 
+//retrieve the component of a specific entity, marking it as modified for snapshots, and as changed
+//at the current tick if its component type tracks changes. Returns NULL without marking anything if the entity
+//does not have the component, or if its component type is split into fields (see recs_entity_scatter_component()).
+void* recs_entity_get_component_mut(struct recs *recs, recs_entity e, recs_component c);
+
+//copy an entity's component into component, putting its fields back together if its component type is split into fields.
+//Returns 0 if the entity does not have the component.
+int recs_entity_gather_component(struct recs *recs, recs_entity e, recs_component c, void *component);
+
+//overwrite an entity's component with a copy of component, splitting it into fields if its component type is split into fields.
+//Like recs_entity_get_component_mut(), this marks the component as changed. Returns 0 if the entity does not have the component.
+int recs_entity_scatter_component(struct recs *recs, recs_entity e, recs_component c, const void *component);
+
+//check if an entity's component was added (RECS_CHANGE_ADDED) or changed (RECS_CHANGE_CHANGED) after since_tick.
+//Returns 0 if the entity does not have the component. The component type must track changes.
+int recs_entity_component_changed(struct recs *ecs, recs_entity e, recs_component c, enum recs_change_filter filter, uint32_t since_tick);
+
 //check if an entity is active, or has been removed
 uint8_t recs_entity_active(struct recs *ecs, recs_entity e);
 
@@ -266,6 +558,12 @@ recs_ent_iter recs_ent_iter_init_with_exclude(struct recs *ecs, uint8_t *include
 
 recs_ent_iter recs_ent_iter_init_with_exclude_and_match_op(struct recs *ecs, uint8_t *include_mask, enum recs_ent_match_op include_match_op, uint8_t *exclude_mask, enum recs_ent_match_op exclude_match_op);
 
+//initialize an iterator that only goes through entities whose component c was added or changed after since_tick
+//(see recs_system_last_run_tick()), and that have every component and tag inside include_mask and none inside exclude_mask.
+//Either mask may be NULL. The component type must track changes. Only c's pool is searched, and blocks of its
+//components that did not change are skipped as a whole, so this costs about as much as the number of changes.
+recs_ent_iter recs_ent_iter_init_changed(struct recs *ecs, uint8_t *include_mask, uint8_t *exclude_mask, recs_component c, enum recs_change_filter filter, uint32_t since_tick);
+
 
 //check if there are any more active entities left to process that have 
 //the specified components and tags
@@ -275,7 +573,228 @@ uint8_t recs_ent_iter_has_next(recs_ent_iter *iter);
 //if no entities are left to check. Returns 1 if an entity was found.
 recs_entity recs_ent_iter_next(struct recs *ecs, recs_ent_iter *iter);
 
+//retrieve up to max_entities of the next entities at once, storing them inside out_entities.
+//Returns the number of entities retrieved, which is 0 once no entities are left.
+//
+//For each of the num_comps components listed in comps, the component pointers for the
+//retrieved entities are also stored in out_comps, one column per component. out_comps must
+//hold at least (num_comps * max_entities) pointers, and the pointer to component comps[c]
+//of entity out_entities[i] is stored at out_comps[c * max_entities + i]. If an entity
+//does not have that component, its pointer is NULL. Pointers to components whose type is split
+//into fields are always NULL, since those pools hold no whole components (see recs_component_field()).
+uint32_t recs_ent_iter_next_batch(struct recs *ecs, recs_ent_iter *iter, recs_entity *out_entities, uint32_t max_entities, const recs_component *comps, uint32_t num_comps, void **out_comps);
+
+
+
+
+//functions for cached queries
+
+//register a query that keeps a list of every entity matching it. The list is updated
+//whenever components or tags are added to or removed from an entity, and when entities are added
+//or removed, so iterating through a query never needs to check any bitmasks.
+//Either mask may be NULL, but not both. The masks are copied, so they do not need to outlive this call.
+recs_query recs_query_register(struct recs *ecs, uint8_t *include_mask, enum recs_ent_match_op include_op, uint8_t *exclude_mask, enum recs_ent_match_op exclude_op);
+
+//get the number of entities that currently match the query
+uint32_t recs_query_num_entities(struct recs *ecs, recs_query query);
+
+//get the list of entities that currently match the query. The list contains
+//recs_query_num_entities() entities.
+//NOTE: Adding or removing components, tags, or entities may reorder this list, so
+//do not make these changes while walking through it.
+recs_entity *recs_query_entities(struct recs *ecs, recs_query query);
+
+//call the callback on every entity matching the query, spread across every thread inside the worker pool.
+//Entities are handed out grain at a time (pick 0 for a default grain), and threads that run out of entities
+//steal half of the entities left by another thread. Returns once every entity has been visited.
+//If workers is NULL, every entity is visited on the calling thread.
+//NOTE: The callback must not add or remove components, tags, or entities. Each entity is
+//only visited by one thread, so it is safe to modify the components of the entity being visited.
+void recs_query_par_each(struct recs *ecs, recs_workers workers, recs_query query, recs_query_each_func callback, void *userdata, uint32_t grain);
+
+
+
+//functions for groups
+
+//register a group owning the pools of num_comps component types. Every entity having all of these components is kept inside
+//the first recs_group_num_entities() slots of each owned pool, in the same order, so the i-th component of each pool belongs
+//to the same entity (recs_component_get_entity() returns it), and the group can be walked by index without any lookups.
+//Adding or removing an owned component swaps the entity's components in and out of the group, which moves other components
+//of the owned pools. A pool can only be owned by one group, and must use RECS_REMOVAL_SWAP. Only supported by RECS_STORAGE_SPARSE_SET.
+//Like the pools themselves, groups hold entities queued for removal until recs_entity_remove_queued() is called.
+recs_group recs_group_register(struct recs *ecs, const recs_component *comps, uint32_t num_comps);
+
+//get the number of entities inside a group
+uint32_t recs_group_num_entities(struct recs *ecs, recs_group group);
+
+//get the component of type c (which the group must own) of the index-th entity inside a group, or NULL if index is past the
+//end of the group. If count is not NULL, it is set to the number of components stored one after the other from there on
+//that are still inside the group. This is every component left for fixed-size RECS instances, while growable ones
+//store components inside pages, so their components need to be fetched again at the start of each page.
+void *recs_group_components(struct recs *ecs, recs_group group, recs_component c, uint32_t index, uint32_t *count);
+
+
+
+/*
+  Command Buffers
+
+  Records entity creation/removal and component/tag changes so that they can be applied later, all at once.
+  This allows these changes to be made while iterating over entities, or from several threads at once
+  (as long as each thread records into its own command buffer).
+
+  Entities created by a command buffer are returned as placeholders, which can be used by later commands
+  within the same command buffer. Placeholders are replaced by real entities during playback.
+*/
+
+typedef struct recs_cmd_buffer *recs_cmd_buffer;
+
+//entities returned by recs_cmd_entity_add() use this version until the command buffer is played back.
+#define RECS_CMD_PLACEHOLDER_VERSION 0xFFFFFFFF
+#define RECS_ENTITY_IS_PLACEHOLDER(ent) (RECS_ENT_VERSION(ent) == RECS_CMD_PLACEHOLDER_VERSION)
+
+//create a command buffer able to hold arena_size bytes of commands. Returns NULL if the allocation failed.
+//The command buffer can be played back into the RECS instance it was created with, or any copy of it.
+recs_cmd_buffer recs_cmd_buffer_create(struct recs *ecs, size_t arena_size);
+
+void recs_cmd_buffer_free(recs_cmd_buffer cmd);
+
+//discard every recorded command
+void recs_cmd_buffer_clear(recs_cmd_buffer cmd);
+
+//get the number of bytes of the arena used by the recorded commands
+size_t recs_cmd_buffer_size(recs_cmd_buffer cmd);
+
+//record a new entity, returning a placeholder that can be used by later commands within this command buffer.
+recs_entity recs_cmd_entity_add(recs_cmd_buffer cmd);
+
+//record removing an entity. The entity will still be found by iterators until played back.
+void recs_cmd_entity_remove(recs_cmd_buffer cmd, recs_entity e);
+
+//record adding a component. The component's data is copied into the command buffer.
+//If the entity already has this component when played back, the component's data is replaced instead.
+void recs_cmd_entity_add_component(recs_cmd_buffer cmd, recs_entity e, recs_component comp_type, const void *component);
+
+void recs_cmd_entity_remove_component(recs_cmd_buffer cmd, recs_entity e, recs_component comp_type);
+
+void recs_cmd_entity_add_tag(recs_cmd_buffer cmd, recs_entity e, recs_tag tag);
+
+void recs_cmd_entity_remove_tag(recs_cmd_buffer cmd, recs_entity e, recs_tag tag);
+
+//apply every recorded command in the order they were recorded, then clear the command buffer.
+//Commands on entities that were removed before playback are skipped.
+//NOTE: This should only be called when NOT ITERATING OVER ENTITIES.
+void recs_cmd_buffer_playback(struct recs *ecs, recs_cmd_buffer cmd);
+
+
+
+/*
+  Snapshots
+
+  Stores the state of a RECS instance so that it can be rolled back to later, such as for rollback netcode.
+  The RECS instance must be created with snapshot_chunk_size set. It then remembers which chunks of its memory
+  were written to since each snapshot was last taken or restored, so taking or restoring a snapshot only copies
+  those chunks, and costs about as much as what changed. RECS_STORAGE_ARCHETYPE does not track its writes,
+  so its snapshots copy everything.
+
+  Components modified through pointers are only tracked when the pointer came from recs_entity_get_component_mut().
+*/
+
+typedef struct recs_snapshot *recs_snapshot;
+
+//allocate a snapshot holding a full copy of the RECS instance's state. Returns NULL if the allocation failed.
+//The snapshot can only be used with the RECS instance it was created with.
+recs_snapshot recs_snapshot_create(struct recs *ecs);
+
+void recs_snapshot_free(recs_snapshot snapshot);
+
+//update the snapshot to the current state of the RECS instance
+void recs_snapshot_take(struct recs *ecs, recs_snapshot snapshot);
+
+//roll the RECS instance back to the state stored inside the snapshot. Entity handles, component pointers,
+//and queries are restored as well. The system context is left as is.
+void recs_snapshot_restore(struct recs *ecs, recs_snapshot snapshot);
+
+//get the number of bytes copied by the last call to recs_snapshot_take() or recs_snapshot_restore() (or recs_snapshot_create())
+size_t recs_snapshot_copy_size(recs_snapshot snapshot);
+
+
+
+/*
+  Saving and Loading
+
+  Saves the state of a RECS instance (every entity, component, tag, and query) in a versioned binary format, which can be loaded
+  into another RECS instance created with the same config, without adding entities one at a time. A save holds a header describing
+  the layout of the RECS instance and each component type, followed by the ranges of its memory in use, so loading is mostly one
+  memcpy per range. Pointers are stored relative to the address of the saved RECS instance, and fixed up once loaded.
+
+  Systems and the system context are not saved, and come from the config of the RECS instance being loaded into.
+  Saves can only be loaded by the same version of RECS, on a machine with the same byte order and pointer size.
+  Growable RECS instances cannot be saved or loaded. Only load saves you trust, since they are not fully validated.
+*/
+
+#define RECS_SAVE_VERSION 7
+
+//get the number of bytes needed to save a RECS instance
+size_t recs_save_size(struct recs *ecs);
+
+//save a RECS instance into buffer. Returns the number of bytes written, or 0 if buffer_size was too small.
+size_t recs_save(struct recs *ecs, void *buffer, size_t buffer_size);
+
+//save a RECS instance into a file, replacing it if it exists. Returns 1 on success, or 0 if writing failed.
+int recs_save_file(struct recs *ecs, const char *path);
+
+//replace the state of a RECS instance with a save. Returns 1 on success, or 0 if the save is invalid or was made
+//with a different version or config, in which case the RECS instance is left untouched.
+int recs_load(struct recs *ecs, const void *data, size_t size);
+
+//same as recs_load(), but memory-maps the file so that only the parts being loaded are read into memory
+int recs_load_file(struct recs *ecs, const char *path);
+
+
+
+/*
+  Diffs
+
+  Describes the changes between 2 states of a RECS instance as a stream of bytes, such as for replicating a server's
+  RECS instance to its clients. A diff holds the entities that were added or removed (keeping their handles), the components
+  and tags that were added or removed, and only the bytes of each component that changed, so its size grows with the
+  number of changes rather than the number of entities.
+
+  Diffs refer to entities by handle rather than by where their components are stored, so a diff can be applied to any
+  RECS instance holding the same entities, components, and tags as the old state, even if it got there another way
+  (such as by applying earlier diffs). Both RECS instances must be created with the same component types and tags.
+  Queries are not part of a diff, and are updated as each change is applied.
+*/
 
+#define RECS_DIFF_VERSION 1
+
+//called with the next bytes of a diff being written. Returns 0 if writing failed.
+typedef int (*recs_stream_write_func)(void *userdata, const void *data, size_t size);
+
+//called to read exactly size bytes of a diff. Returns 0 if fewer bytes were available.
+typedef int (*recs_stream_read_func)(void *userdata, void *data, size_t size);
+
+//write the changes that turn old_ecs into new_ecs. The diff is written in blocks of a few kilobytes.
+//old_ecs must be an earlier state of new_ecs, such as a copy made with recs_copy() or recs_copy_into(), since only the entities that
+//may have changed are compared:
+//  - entities added or removed, and components or tags added or removed, are found 64 entity IDs at a time through the
+//    bitsets of each component and tag, which are skipped when none of their bits changed.
+//  - components written to since old_ecs's tick are found through the ticks of component types that track changes,
+//    skipping each block of 64 components that was not written to. Writes through recs_entity_get_component() are not seen.
+//  - every entity having a component of a type that does not track changes (or stored with RECS_STORAGE_ARCHETYPE) is compared.
+//If old_ecs's tick is ahead of new_ecs's, it is not an earlier state, and every entity is compared.
+//Otherwise, a diff costs about as much as the changes it holds. new_ecs then starts a new tick (see recs_next_change_tick()),
+//so the next diff against a copy made after this one skips the components written before it.
+//Allocates one bit per entity ID, and twice the size of the biggest component type, for the call.
+//Returns the number of bytes written, or 0 if a call to write or the allocation failed.
+size_t recs_diff(struct recs *old_ecs, struct recs *new_ecs, recs_stream_write_func write, void *userdata);
+
+//apply a diff written by recs_diff() to a RECS instance holding the same entities, components, and tags as its old state.
+//Only the bytes making up the diff are read. Returns 1 on success, or 0 if the diff is invalid, was made with a different
+//version or different component types, or does not match the RECS instance (such as by adding a component to a full pool
+//that can not grow). Changes applied before an invalid part of the diff is found are kept.
+//NOTE: This should only be called when NOT ITERATING OVER ENTITIES.
+int recs_patch(struct recs *ecs, recs_stream_read_func read, void *userdata);
 
 #endif
 
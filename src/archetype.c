@@ -0,0 +1,400 @@
+#include "archetype.h"
+#include "bitmask.h"
+
+//used when the config does not provide a chunk size or max number of archetypes
+#define ARCHETYPE_DEFAULT_CHUNK_SIZE (16 * 1024)
+#define ARCHETYPE_DEFAULT_MAX_ARCHETYPES 256
+
+
+void archetype_storage_dimensions(const struct recs_init_config *config, uint32_t *out_chunk_size, uint32_t *out_num_chunks, uint32_t *out_max_archetypes) {
+  uint32_t max_archetypes = config->max_archetypes != 0 ? config->max_archetypes : ARCHETYPE_DEFAULT_MAX_ARCHETYPES;
+
+  //the most bytes that can be lost to aligning each column of a chunk
+  size_t max_padding = (size_t)MEMORY_ALIGNMENT * (config->max_component_types + 1);
+
+  //a chunk must be able to store at least one row of an archetype containing every component
+  size_t min_chunk_size = memory_align(sizeof(uint32_t));
+  size_t max_bytes = sizeof(uint32_t) * (size_t)config->max_entities;
+  for(uint32_t i = 0; i < config->max_component_types; i++) {
+    min_chunk_size += memory_align(config->components[i].comp_size);
+    max_bytes += config->components[i].comp_size * config->components[i].max_components;
+  }
+
+  size_t chunk_size = memory_align(config->archetype_chunk_size != 0 ? config->archetype_chunk_size : ARCHETYPE_DEFAULT_CHUNK_SIZE);
+  if(chunk_size < min_chunk_size) {
+    chunk_size = min_chunk_size;
+  }
+  //make sure that padding never takes up more than half of a chunk
+  if(chunk_size < max_padding * 2) {
+    chunk_size = max_padding * 2;
+  }
+  RECS_ASSERT(chunk_size < UINT32_MAX);
+
+  size_t num_chunks = config->max_archetype_chunks;
+  if(num_chunks == 0) {
+    //every chunk besides the last chunk of an archetype is at least half full, so we need
+    //at most twice the number of chunks needed to store every component, plus one partially
+    //filled chunk for each archetype.
+    size_t usable_chunk_size = chunk_size - max_padding;
+    num_chunks = 2 * ((max_bytes + usable_chunk_size - 1) / usable_chunk_size) + max_archetypes;
+  }
+  RECS_ASSERT(num_chunks < NO_CHUNK);
+
+  *out_chunk_size = (uint32_t)chunk_size;
+  *out_num_chunks = (uint32_t)num_chunks;
+  *out_max_archetypes = max_archetypes;
+}
+
+size_t archetype_storage_buffer_size(uint32_t max_entities, uint32_t num_component_types, uint32_t bitmask_size, uint32_t max_archetypes, uint32_t chunk_size, uint32_t num_chunks) {
+  size_t size = 0;
+  size += memory_align(sizeof(struct archetype) * max_archetypes);
+  size += memory_align(sizeof(uint32_t) * num_component_types);
+  size += memory_align(bitmask_size);
+  size += memory_align((size_t)bitmask_size * (max_archetypes + 1));
+  size += memory_align(sizeof(uint32_t) * 3 * (size_t)num_component_types * max_archetypes);
+  size += memory_align(sizeof(uint32_t) * num_chunks) * 3;
+  size += memory_align(sizeof(struct archetype_location) * max_entities);
+  size += (size_t)chunk_size * num_chunks;
+  return size;
+}
+
+
+//get the number of bytes a chunk needs to store the given number of rows for a signature,
+//optionally storing the offset of each column.
+static size_t archetype_layout(struct archetype_storage *s, uint8_t *signature, uint32_t rows, uint32_t *out_column_offset) {
+  //the entity ID column is always first
+  size_t offset = memory_align(sizeof(uint32_t) * (size_t)rows);
+
+  for(recs_component c = 0; c < s->num_component_types; c++) {
+    if(!bitmask_test(signature, c)) {
+      if(out_column_offset != NULL) out_column_offset[c] = NO_COLUMN;
+      continue;
+    }
+
+    if(out_column_offset != NULL) out_column_offset[c] = (uint32_t)offset;
+    offset += memory_align((size_t)s->component_sizes[c] * rows);
+  }
+
+  return offset;
+}
+
+static uint32_t archetype_create(struct archetype_storage *s, uint8_t *signature) {
+  RECS_ASSERT(s->num_archetypes < s->max_archetypes);
+
+  uint32_t index = s->num_archetypes;
+  struct archetype *a = s->archetypes + index;
+
+  a->signature = s->signature_buffer + ((size_t)index * s->bitmask_size);
+  memcpy(a->signature, signature, s->bitmask_size);
+
+  uint32_t *table = s->table_buffer + ((size_t)index * 3 * s->num_component_types);
+  a->column_offset = table;
+  a->add_edge = table + s->num_component_types;
+  a->remove_edge = table + (2 * s->num_component_types);
+
+  for(recs_component c = 0; c < s->num_component_types; c++) {
+    a->add_edge[c] = NO_ARCHETYPE;
+    a->remove_edge[c] = NO_ARCHETYPE;
+  }
+
+  //fit as many rows as possible inside a chunk
+  size_t row_size = sizeof(uint32_t);
+  for(recs_component c = 0; c < s->num_component_types; c++) {
+    if(bitmask_test(signature, c)) row_size += s->component_sizes[c];
+  }
+
+  uint32_t rows = (uint32_t)(s->chunk_size / row_size);
+  while(rows > 1 && archetype_layout(s, signature, rows, NULL) > s->chunk_size) {
+    rows--;
+  }
+  RECS_ASSERT(rows > 0 && archetype_layout(s, signature, rows, NULL) <= s->chunk_size);
+
+  archetype_layout(s, signature, rows, a->column_offset);
+  a->rows_per_chunk = rows;
+  a->num_rows = 0;
+  a->first_chunk = NO_CHUNK;
+  a->last_chunk = NO_CHUNK;
+
+  s->num_archetypes++;
+  return index;
+}
+
+static uint32_t archetype_find(struct archetype_storage *s, uint8_t *signature) {
+  for(uint32_t i = 0; i < s->num_archetypes; i++) {
+    if(memcmp(s->archetypes[i].signature, signature, s->bitmask_size) == 0) {
+      return i;
+    }
+  }
+  return archetype_create(s, signature);
+}
+
+//find the archetype an entity moves to when a component is added or removed,
+//caching the result so that future moves are cheap.
+static uint32_t archetype_follow_edge(struct archetype_storage *s, uint32_t src, recs_component c, uint8_t add) {
+  struct archetype *a = s->archetypes + src;
+  uint32_t *edges = add ? a->add_edge : a->remove_edge;
+
+  if(edges[c] != NO_ARCHETYPE) {
+    return edges[c];
+  }
+
+  uint8_t *signature = s->signature_buffer + ((size_t)s->max_archetypes * s->bitmask_size);
+  memcpy(signature, a->signature, s->bitmask_size);
+  bitmask_set(signature, c, add);
+
+  uint32_t dst = archetype_find(s, signature);
+
+  //the edge going back is always the opposite operation
+  edges[c] = dst;
+  if(add) {
+    s->archetypes[dst].remove_edge[c] = src;
+  } else {
+    s->archetypes[dst].add_edge[c] = src;
+  }
+
+  return dst;
+}
+
+
+
+void archetype_storage_init(struct archetype_storage *s, uint8_t *buffer, uint32_t max_entities, uint32_t num_component_types, uint32_t bitmask_size, uint32_t max_archetypes, uint32_t chunk_size, uint32_t num_chunks, const struct recs_init_config_component *components) {
+  s->num_archetypes = 0;
+  s->max_archetypes = max_archetypes;
+  s->num_component_types = num_component_types;
+  s->bitmask_size = bitmask_size;
+  s->chunk_size = chunk_size;
+  s->num_chunks = num_chunks;
+
+  uint8_t *next_buffer = buffer;
+
+  s->archetypes = (struct archetype*)next_buffer;
+  next_buffer += memory_align(sizeof(struct archetype) * max_archetypes);
+
+  s->component_sizes = (uint32_t*)next_buffer;
+  next_buffer += memory_align(sizeof(uint32_t) * num_component_types);
+
+  s->component_bits = next_buffer;
+  next_buffer += memory_align(bitmask_size);
+
+  s->signature_buffer = next_buffer;
+  next_buffer += memory_align((size_t)bitmask_size * (max_archetypes + 1));
+
+  s->table_buffer = (uint32_t*)next_buffer;
+  next_buffer += memory_align(sizeof(uint32_t) * 3 * (size_t)num_component_types * max_archetypes);
+
+  s->chunk_next = (uint32_t*)next_buffer;
+  next_buffer += memory_align(sizeof(uint32_t) * num_chunks);
+  s->chunk_prev = (uint32_t*)next_buffer;
+  next_buffer += memory_align(sizeof(uint32_t) * num_chunks);
+  s->chunk_count = (uint32_t*)next_buffer;
+  next_buffer += memory_align(sizeof(uint32_t) * num_chunks);
+
+  s->locations = (struct archetype_location*)next_buffer;
+  next_buffer += memory_align(sizeof(struct archetype_location) * max_entities);
+
+  s->chunk_memory = next_buffer;
+
+
+  bitmask_clear(s->component_bits, 0, bitmask_size);
+  for(uint32_t i = 0; i < num_component_types; i++) {
+    RECS_ASSERT(components[i].comp_size < UINT32_MAX);
+    s->component_sizes[components[i].type] = (uint32_t)components[i].comp_size;
+    bitmask_set(s->component_bits, components[i].type, 1);
+  }
+
+  //link every chunk together inside the free list
+  for(uint32_t i = 0; i < num_chunks; i++) {
+    s->chunk_next[i] = i + 1 < num_chunks ? i + 1 : NO_CHUNK;
+    s->chunk_prev[i] = NO_CHUNK;
+    s->chunk_count[i] = 0;
+  }
+  s->free_chunk = num_chunks > 0 ? 0 : NO_CHUNK;
+
+  for(uint32_t i = 0; i < max_entities; i++) {
+    s->locations[i].archetype = 0;
+    s->locations[i].chunk = NO_CHUNK;
+    s->locations[i].row = 0;
+  }
+
+  //create the empty archetype using the spare signature
+  uint8_t *empty_signature = s->signature_buffer + ((size_t)max_archetypes * bitmask_size);
+  bitmask_clear(empty_signature, 0, bitmask_size);
+  archetype_create(s, empty_signature);
+}
+
+void archetype_storage_relocate(struct archetype_storage *s, const void *old_base, void *new_base) {
+  s->archetypes = memory_relocate(s->archetypes, old_base, new_base);
+  s->component_sizes = memory_relocate(s->component_sizes, old_base, new_base);
+  s->component_bits = memory_relocate(s->component_bits, old_base, new_base);
+  s->signature_buffer = memory_relocate(s->signature_buffer, old_base, new_base);
+  s->table_buffer = memory_relocate(s->table_buffer, old_base, new_base);
+  s->chunk_next = memory_relocate(s->chunk_next, old_base, new_base);
+  s->chunk_prev = memory_relocate(s->chunk_prev, old_base, new_base);
+  s->chunk_count = memory_relocate(s->chunk_count, old_base, new_base);
+  s->locations = memory_relocate(s->locations, old_base, new_base);
+  s->chunk_memory = memory_relocate(s->chunk_memory, old_base, new_base);
+
+  for(uint32_t i = 0; i < s->num_archetypes; i++) {
+    struct archetype *a = s->archetypes + i;
+    a->signature = memory_relocate(a->signature, old_base, new_base);
+    a->column_offset = memory_relocate(a->column_offset, old_base, new_base);
+    a->add_edge = memory_relocate(a->add_edge, old_base, new_base);
+    a->remove_edge = memory_relocate(a->remove_edge, old_base, new_base);
+  }
+}
+
+
+//append a chunk to the end of an archetype's chunk list
+static uint32_t archetype_chunk_alloc(struct archetype_storage *s, struct archetype *a) {
+  //ran out of chunks, increase max_archetype_chunks inside the config
+  RECS_ASSERT(s->free_chunk != NO_CHUNK);
+
+  uint32_t chunk = s->free_chunk;
+  s->free_chunk = s->chunk_next[chunk];
+
+  s->chunk_next[chunk] = NO_CHUNK;
+  s->chunk_prev[chunk] = a->last_chunk;
+  s->chunk_count[chunk] = 0;
+
+  if(a->last_chunk != NO_CHUNK) {
+    s->chunk_next[a->last_chunk] = chunk;
+  } else {
+    a->first_chunk = chunk;
+  }
+  a->last_chunk = chunk;
+
+  return chunk;
+}
+
+//return the (now empty) last chunk of an archetype to the free list
+static void archetype_chunk_free(struct archetype_storage *s, struct archetype *a) {
+  uint32_t chunk = a->last_chunk;
+  uint32_t prev = s->chunk_prev[chunk];
+
+  a->last_chunk = prev;
+  if(prev != NO_CHUNK) {
+    s->chunk_next[prev] = NO_CHUNK;
+  } else {
+    a->first_chunk = NO_CHUNK;
+  }
+
+  s->chunk_next[chunk] = s->free_chunk;
+  s->chunk_prev[chunk] = NO_CHUNK;
+  s->chunk_count[chunk] = 0;
+  s->free_chunk = chunk;
+}
+
+static inline uint8_t *archetype_cell(struct archetype_storage *s, struct archetype *a, uint32_t chunk, uint32_t row, recs_component c) {
+  return archetype_storage_chunk(s, chunk) + a->column_offset[c] + ((size_t)row * s->component_sizes[c]);
+}
+
+//move an entity's row into another archetype, keeping the components both archetypes have in common
+static void archetype_move(struct archetype_storage *s, uint32_t id, uint32_t dst_index) {
+  struct archetype_location *loc = s->locations + id;
+  struct archetype *src = s->archetypes + loc->archetype;
+  struct archetype *dst = s->archetypes + dst_index;
+
+  uint32_t dst_chunk = NO_CHUNK;
+  uint32_t dst_row = 0;
+
+  //the empty archetype does not store any rows
+  if(dst_index != 0) {
+    if(dst->last_chunk == NO_CHUNK || s->chunk_count[dst->last_chunk] == dst->rows_per_chunk) {
+      archetype_chunk_alloc(s, dst);
+    }
+    dst_chunk = dst->last_chunk;
+    dst_row = s->chunk_count[dst_chunk]++;
+    dst->num_rows++;
+
+    archetype_storage_chunk_ids(s, dst_chunk)[dst_row] = id;
+
+    if(loc->archetype != 0) {
+      for(recs_component c = 0; c < s->num_component_types; c++) {
+        if(src->column_offset[c] == NO_COLUMN || dst->column_offset[c] == NO_COLUMN) continue;
+        memcpy(archetype_cell(s, dst, dst_chunk, dst_row, c), archetype_cell(s, src, loc->chunk, loc->row, c), s->component_sizes[c]);
+      }
+    }
+  }
+
+  if(loc->archetype != 0) {
+    //move the last row into the hole to keep the archetype's rows contiguous
+    uint32_t last_chunk = src->last_chunk;
+    uint32_t last_row = s->chunk_count[last_chunk] - 1;
+
+    if(last_chunk != loc->chunk || last_row != loc->row) {
+      uint32_t last_id = archetype_storage_chunk_ids(s, last_chunk)[last_row];
+
+      for(recs_component c = 0; c < s->num_component_types; c++) {
+        if(src->column_offset[c] == NO_COLUMN) continue;
+        memcpy(archetype_cell(s, src, loc->chunk, loc->row, c), archetype_cell(s, src, last_chunk, last_row, c), s->component_sizes[c]);
+      }
+      archetype_storage_chunk_ids(s, loc->chunk)[loc->row] = last_id;
+
+      s->locations[last_id].chunk = loc->chunk;
+      s->locations[last_id].row = loc->row;
+    }
+
+    s->chunk_count[last_chunk]--;
+    src->num_rows--;
+    if(s->chunk_count[last_chunk] == 0) {
+      archetype_chunk_free(s, src);
+    }
+  }
+
+  loc->archetype = dst_index;
+  loc->chunk = dst_chunk;
+  loc->row = dst_row;
+}
+
+
+void archetype_storage_add_component(struct archetype_storage *s, uint32_t id, recs_component c, const void *component) {
+  uint32_t src = s->locations[id].archetype;
+
+  if(s->archetypes[src].column_offset[c] == NO_COLUMN) {
+    archetype_move(s, id, archetype_follow_edge(s, src, c, 1));
+  }
+
+  memcpy(archetype_storage_get(s, id, c), component, s->component_sizes[c]);
+}
+
+void archetype_storage_remove_component(struct archetype_storage *s, uint32_t id, recs_component c) {
+  uint32_t src = s->locations[id].archetype;
+
+  if(s->archetypes[src].column_offset[c] == NO_COLUMN) {
+    return;
+  }
+
+  archetype_move(s, id, archetype_follow_edge(s, src, c, 0));
+}
+
+void archetype_storage_clear(struct archetype_storage *s, uint32_t id) {
+  if(s->locations[id].archetype != 0) {
+    archetype_move(s, id, 0);
+  }
+}
+
+void *archetype_storage_get_instance(struct archetype_storage *s, recs_component c, uint32_t index, uint32_t *out_id) {
+  for(uint32_t i = 1; i < s->num_archetypes; i++) {
+    struct archetype *a = s->archetypes + i;
+    if(a->column_offset[c] == NO_COLUMN) continue;
+
+    if(index >= a->num_rows) {
+      index -= a->num_rows;
+      continue;
+    }
+
+    //every chunk besides the last one is full
+    uint32_t chunk = a->first_chunk;
+    while(index >= a->rows_per_chunk) {
+      index -= a->rows_per_chunk;
+      chunk = s->chunk_next[chunk];
+    }
+
+    if(out_id != NULL) {
+      *out_id = archetype_storage_chunk_ids(s, chunk)[index];
+    }
+    return archetype_cell(s, a, chunk, index, c);
+  }
+
+  return NULL;
+}
@@ -0,0 +1,134 @@
+#ifndef ARCHETYPE_H
+#define ARCHETYPE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "recs.h"
+#include "memory.h"
+
+#define NO_ARCHETYPE RECS_NO_ENTITY_ID
+#define NO_CHUNK RECS_NO_ENTITY_ID
+#define NO_COLUMN RECS_NO_ENTITY_ID
+
+/*
+  Archetype Storage Section
+
+  An alternative to component pools where every entity with the exact same set of components
+  (its archetype) is stored inside the same table. Each table is split into fixed-size chunks,
+  and each chunk stores one column per component, so iterating through entities that share
+  several components walks through memory linearly.
+
+  Archetype 0 is always the empty archetype. Entities without any components belong to it,
+  but since it has no columns, it never stores any rows or chunks.
+  Tags do not affect which archetype an entity belongs to.
+
+  All chunks are allocated up front and shared between every archetype. Chunks are handed out
+  to archetypes when their last chunk is full, and returned once they become empty.
+*/
+
+struct archetype {
+  //the components stored in this archetype (tags are never set)
+  uint8_t *signature;
+
+  //byte offset of each component's column inside a chunk, or NO_COLUMN
+  //if this archetype does not have the component. Indexed by component type.
+  uint32_t *column_offset;
+
+  //cached archetypes that an entity moves to when adding or removing a component.
+  //Indexed by component type, NO_ARCHETYPE if not found yet.
+  uint32_t *add_edge;
+  uint32_t *remove_edge;
+
+  uint32_t rows_per_chunk;
+  uint32_t num_rows;
+
+  //chunks are stored in a doubly linked list. Every chunk except the last one is full.
+  uint32_t first_chunk;
+  uint32_t last_chunk;
+};
+
+//where an entity is stored
+struct archetype_location {
+  uint32_t archetype;
+  uint32_t chunk;
+  uint32_t row;
+};
+
+struct archetype_storage {
+  uint32_t num_archetypes;
+  uint32_t max_archetypes;
+  uint32_t num_component_types;
+  uint32_t bitmask_size;
+
+  struct archetype *archetypes;
+  uint32_t *component_sizes;
+
+  //every bit that belongs to a component (rather than a tag) is set
+  uint8_t *component_bits;
+
+  uint32_t chunk_size;
+  uint32_t num_chunks;
+  uint8_t *chunk_memory;
+
+  //the linked list of each chunk. Free chunks are linked together using chunk_next.
+  uint32_t *chunk_next;
+  uint32_t *chunk_prev;
+  uint32_t *chunk_count;
+  uint32_t free_chunk;
+
+  struct archetype_location *locations;
+
+  //space reserved for the signatures and tables of archetypes created later on.
+  //One extra signature is reserved at the end to build signatures while searching for archetypes.
+  uint8_t *signature_buffer;
+  uint32_t *table_buffer;
+};
+
+
+//pick the chunk size, number of chunks, and max archetypes used for a RECS instance, filling in
+//defaults for any value left as 0 inside of the config.
+void archetype_storage_dimensions(const struct recs_init_config *config, uint32_t *out_chunk_size, uint32_t *out_num_chunks, uint32_t *out_max_archetypes);
+
+size_t archetype_storage_buffer_size(uint32_t max_entities, uint32_t num_component_types, uint32_t bitmask_size, uint32_t max_archetypes, uint32_t chunk_size, uint32_t num_chunks);
+
+void archetype_storage_init(struct archetype_storage *s, uint8_t *buffer, uint32_t max_entities, uint32_t num_component_types, uint32_t bitmask_size, uint32_t max_archetypes, uint32_t chunk_size, uint32_t num_chunks, const struct recs_init_config_component *components);
+
+//move all of the storage's pointers from one copy of the RECS buffer to another
+void archetype_storage_relocate(struct archetype_storage *s, const void *old_base, void *new_base);
+
+//place a new entity inside the empty archetype
+void archetype_storage_insert(struct archetype_storage *s, uint32_t id);
+
+//move an entity to the archetype with the extra component, copying the component's data into it.
+//If the entity already has the component, its data is overwritten.
+void archetype_storage_add_component(struct archetype_storage *s, uint32_t id, recs_component c, const void *component);
+
+void archetype_storage_remove_component(struct archetype_storage *s, uint32_t id, recs_component c);
+
+//move an entity back to the empty archetype, removing all of its components
+void archetype_storage_clear(struct archetype_storage *s, uint32_t id);
+
+//find the component stored at the given index when every instance of a component is
+//placed one after the other (in archetype and chunk order). Returns NULL if the index is out of range.
+void *archetype_storage_get_instance(struct archetype_storage *s, recs_component c, uint32_t index, uint32_t *out_id);
+
+
+static inline uint8_t *archetype_storage_chunk(struct archetype_storage *s, uint32_t chunk) {
+  return s->chunk_memory + ((size_t)chunk * s->chunk_size);
+}
+
+//the entity IDs of a chunk are stored in the first column
+static inline uint32_t *archetype_storage_chunk_ids(struct archetype_storage *s, uint32_t chunk) {
+  return (uint32_t*)archetype_storage_chunk(s, chunk);
+}
+
+static inline void *archetype_storage_get(struct archetype_storage *s, uint32_t id, recs_component c) {
+  struct archetype_location *loc = s->locations + id;
+  uint32_t offset = s->archetypes[loc->archetype].column_offset[c];
+  if(offset == NO_COLUMN) {
+    return NULL;
+  }
+  return archetype_storage_chunk(s, loc->chunk) + offset + ((size_t)loc->row * s->component_sizes[c]);
+}
+
+#endif// ARCHETYPE_H
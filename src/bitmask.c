@@ -1,6 +1,8 @@
 #include "bitmask.h"
 
-#define BYTE_INDEX(bit_index) ((bit_index) >> 3)
+#ifdef BITMASK_HAS_X86_KERNELS
+  #include <immintrin.h>
+#endif
 
 
 
@@ -44,3 +46,119 @@ void bitmask_and(uint8_t *dest, uint8_t *op1, uint8_t *op2, uint32_t bitmask_siz
 }
 
 
+int bitmask_match_all_u64(const uint8_t *entity_mask, const uint8_t *mask, uint32_t num_words) {
+  for(uint32_t i = 0; i < num_words; i++) {
+    uint64_t m = bitmask_load_word(mask, i);
+    if((bitmask_load_word(entity_mask, i) & m) != m) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int bitmask_match_any_u64(const uint8_t *entity_mask, const uint8_t *mask, uint32_t num_words) {
+  for(uint32_t i = 0; i < num_words; i++) {
+    if((bitmask_load_word(entity_mask, i) & bitmask_load_word(mask, i)) != 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+
+#ifdef BITMASK_HAS_X86_KERNELS
+
+//SSE2 does not have PTEST, so compare the result of the AND with a byte-wise compare instead.
+__attribute__((target("sse2")))
+int bitmask_match_all_sse2(const uint8_t *entity_mask, const uint8_t *mask, uint32_t num_words) {
+  uint32_t i = 0;
+  for(; i + 2 <= num_words; i += 2) {
+    __m128i m = _mm_loadu_si128((const __m128i*)(mask + i * sizeof(uint64_t)));
+    __m128i e = _mm_loadu_si128((const __m128i*)(entity_mask + i * sizeof(uint64_t)));
+    if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(e, m), m)) != 0xFFFF) {
+      return 0;
+    }
+  }
+  return bitmask_match_all_u64(entity_mask + i * sizeof(uint64_t), mask + i * sizeof(uint64_t), num_words - i);
+}
+
+__attribute__((target("sse2")))
+int bitmask_match_any_sse2(const uint8_t *entity_mask, const uint8_t *mask, uint32_t num_words) {
+  uint32_t i = 0;
+  for(; i + 2 <= num_words; i += 2) {
+    __m128i m = _mm_loadu_si128((const __m128i*)(mask + i * sizeof(uint64_t)));
+    __m128i e = _mm_loadu_si128((const __m128i*)(entity_mask + i * sizeof(uint64_t)));
+    if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(e, m), _mm_setzero_si128())) != 0xFFFF) {
+      return 1;
+    }
+  }
+  return bitmask_match_any_u64(entity_mask + i * sizeof(uint64_t), mask + i * sizeof(uint64_t), num_words - i);
+}
+
+//the leftover words are compared here rather than calling the SSE2 kernel, since mixing
+//AVX and non-AVX encoded instructions can stall the CPU.
+__attribute__((target("avx2")))
+int bitmask_match_all_avx2(const uint8_t *entity_mask, const uint8_t *mask, uint32_t num_words) {
+  uint32_t i = 0;
+  for(; i + 4 <= num_words; i += 4) {
+    __m256i m = _mm256_loadu_si256((const __m256i*)(mask + i * sizeof(uint64_t)));
+    __m256i e = _mm256_loadu_si256((const __m256i*)(entity_mask + i * sizeof(uint64_t)));
+    //testc returns 1 when (~e & m) == 0, meaning every bit in m is also set in e
+    if(!_mm256_testc_si256(e, m)) {
+      return 0;
+    }
+  }
+  for(; i < num_words; i++) {
+    uint64_t m = bitmask_load_word(mask, i);
+    if((bitmask_load_word(entity_mask, i) & m) != m) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+__attribute__((target("avx2")))
+int bitmask_match_any_avx2(const uint8_t *entity_mask, const uint8_t *mask, uint32_t num_words) {
+  uint32_t i = 0;
+  for(; i + 4 <= num_words; i += 4) {
+    __m256i m = _mm256_loadu_si256((const __m256i*)(mask + i * sizeof(uint64_t)));
+    __m256i e = _mm256_loadu_si256((const __m256i*)(entity_mask + i * sizeof(uint64_t)));
+    //testz returns 1 when (e & m) == 0
+    if(!_mm256_testz_si256(e, m)) {
+      return 1;
+    }
+  }
+  for(; i < num_words; i++) {
+    if((bitmask_load_word(entity_mask, i) & bitmask_load_word(mask, i)) != 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+#endif
+
+
+struct bitmask_kernels bitmask_kernels_select(uint32_t bitmask_size) {
+  struct bitmask_kernels k = {
+    .match_all = bitmask_match_all_u64,
+    .match_any = bitmask_match_any_u64
+  };
+
+#ifdef BITMASK_HAS_X86_KERNELS
+  __builtin_cpu_init();
+
+  //wider registers only help when a mask fills at least one of them
+  if(bitmask_size >= 32 && __builtin_cpu_supports("avx2")) {
+    k.match_all = bitmask_match_all_avx2;
+    k.match_any = bitmask_match_any_avx2;
+  } else if(bitmask_size >= 16 && __builtin_cpu_supports("sse2")) {
+    k.match_all = bitmask_match_all_sse2;
+    k.match_any = bitmask_match_any_sse2;
+  }
+#else
+  (void)bitmask_size;
+#endif
+
+  return k;
+}
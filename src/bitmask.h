@@ -22,4 +22,73 @@ uint8_t bitmask_test(uint8_t *mask, uint64_t bit_index);
 void bitmask_and(uint8_t *dest, uint8_t *op1, uint8_t *op2, uint32_t bitmask_size);
 
 
+/*
+  Mask Matching Kernels.
+
+  Every bitmask is padded to a whole number of 64-bit words (see RECS_GET_BITMASK_SIZE), 
+  so matching a mask never needs to handle a partial byte. The kernels below compare 
+  one entity's mask against a query mask one word (or one SSE2/AVX2 register) at a time.
+
+  The fastest kernel supported by the CPU is picked once at runtime by bitmask_kernels_select().
+*/
+
+//returns non-zero if the entity mask matches the query mask. num_words is the number of 64-bit words in each mask.
+typedef int (*bitmask_match_func)(const uint8_t *entity_mask, const uint8_t *mask, uint32_t num_words);
+
+struct bitmask_kernels {
+  bitmask_match_func match_all;
+  bitmask_match_func match_any;
+};
+
+//portable fallback that compares 64 bits at a time
+int bitmask_match_all_u64(const uint8_t *entity_mask, const uint8_t *mask, uint32_t num_words);
+int bitmask_match_any_u64(const uint8_t *entity_mask, const uint8_t *mask, uint32_t num_words);
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #define BITMASK_HAS_X86_KERNELS 1
+
+  int bitmask_match_all_sse2(const uint8_t *entity_mask, const uint8_t *mask, uint32_t num_words);
+  int bitmask_match_any_sse2(const uint8_t *entity_mask, const uint8_t *mask, uint32_t num_words);
+
+  int bitmask_match_all_avx2(const uint8_t *entity_mask, const uint8_t *mask, uint32_t num_words);
+  int bitmask_match_any_avx2(const uint8_t *entity_mask, const uint8_t *mask, uint32_t num_words);
+#endif
+
+//pick the fastest kernels that the CPU supports for masks of the given size (in bytes).
+struct bitmask_kernels bitmask_kernels_select(uint32_t bitmask_size);
+
+
+static inline uint64_t bitmask_load_word(const uint8_t *mask, uint32_t word_index) {
+  //masks supplied by users only have byte alignment, so memcpy is used to perform an unaligned load
+  uint64_t w;
+  memcpy(&w, mask + (word_index * sizeof(uint64_t)), sizeof(uint64_t));
+  return w;
+}
+
+//index of the lowest set bit of a non-zero word
+static inline uint32_t bitmask_ctz64(uint64_t w) {
+#if defined(__GNUC__)
+  return (uint32_t)__builtin_ctzll(w);
+#else
+  uint32_t n = 0;
+  while((w & 1) == 0) {
+    w >>= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+
+static inline uint32_t bitmask_popcount64(uint64_t w) {
+#if defined(__GNUC__)
+  return (uint32_t)__builtin_popcountll(w);
+#else
+  w = w - ((w >> 1) & 0x5555555555555555ULL);
+  w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+  w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return (uint32_t)((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+
 #endif// BITMASK_H
@@ -0,0 +1,203 @@
+#include <string.h>
+#include "recs.h"
+#include "memory.h"
+
+/*
+  Command Buffer Section
+
+  Commands are packed one after the other inside a fixed-size arena, each starting with a header
+  and followed by the component's data for commands that add components.
+  A placeholder entity stores the arena offset of the command that creates it, so that playback
+  can find the real entity without building a separate lookup table.
+*/
+
+enum cmd_type {
+  CMD_ENTITY_ADD,
+  CMD_ENTITY_REMOVE,
+  CMD_ADD_COMPONENT,
+  CMD_REMOVE_COMPONENT,
+  CMD_ADD_TAG,
+  CMD_REMOVE_TAG,
+};
+
+struct cmd_header {
+  uint32_t type;
+
+  //the component or tag being added/removed
+  uint32_t id;
+
+  //the entity being changed. For CMD_ENTITY_ADD, this stores the created entity once played back.
+  recs_entity entity;
+};
+
+struct recs_cmd_buffer {
+  uint8_t *arena;
+  size_t arena_size;
+  size_t used;
+
+  //size of each component type, copied from the RECS instance
+  uint32_t num_component_types;
+  size_t *component_sizes;
+};
+
+
+recs_cmd_buffer recs_cmd_buffer_create(struct recs *ecs, size_t arena_size) {
+  uint32_t num_component_types = recs_num_component_types(ecs);
+
+  //store the component sizes and arena right after the struct inside the same allocation
+  size_t struct_size = memory_align(sizeof(struct recs_cmd_buffer));
+  size_t sizes_size = memory_align(sizeof(size_t) * num_component_types);
+  arena_size = memory_align(arena_size);
+
+  uint8_t *buffer = (uint8_t*)RECS_MALLOC(struct_size + sizes_size + arena_size);
+  if(buffer == NULL) {
+    return NULL;
+  }
+
+  struct recs_cmd_buffer *cmd = (struct recs_cmd_buffer*)buffer;
+  cmd->component_sizes = (size_t*)(buffer + struct_size);
+  cmd->arena = buffer + struct_size + sizes_size;
+  cmd->arena_size = arena_size;
+  cmd->used = 0;
+  cmd->num_component_types = num_component_types;
+
+  for(recs_component c = 0; c < num_component_types; c++) {
+    cmd->component_sizes[c] = recs_component_size(ecs, c);
+  }
+
+  return cmd;
+}
+
+void recs_cmd_buffer_free(recs_cmd_buffer cmd) {
+  if(cmd == NULL) {
+    return;
+  }
+  RECS_FREE(cmd);
+}
+
+void recs_cmd_buffer_clear(recs_cmd_buffer cmd) {
+  cmd->used = 0;
+}
+
+size_t recs_cmd_buffer_size(recs_cmd_buffer cmd) {
+  return cmd->used;
+}
+
+
+//reserve space for a command and its data, returning the command's header
+static struct cmd_header *cmd_buffer_push(struct recs_cmd_buffer *cmd, enum cmd_type type, recs_entity e, uint32_t id, size_t data_size) {
+  size_t size = memory_align(sizeof(struct cmd_header)) + memory_align(data_size);
+
+  //ran out of space, create the command buffer with a bigger arena
+  RECS_ASSERT(cmd->arena_size - cmd->used >= size);
+
+  struct cmd_header *header = (struct cmd_header*)(cmd->arena + cmd->used);
+  header->type = type;
+  header->id = id;
+  header->entity = e;
+
+  cmd->used += size;
+  return header;
+}
+
+recs_entity recs_cmd_entity_add(recs_cmd_buffer cmd) {
+  //placeholder IDs must not be mistaken for RECS_NO_ENTITY_ID
+  RECS_ASSERT(cmd->used < RECS_NO_ENTITY_ID);
+
+  uint32_t offset = (uint32_t)cmd->used;
+  cmd_buffer_push(cmd, CMD_ENTITY_ADD, RECS_NO_ENTITY, 0, 0);
+  return RECS_ENT_FROM(offset, RECS_CMD_PLACEHOLDER_VERSION);
+}
+
+void recs_cmd_entity_remove(recs_cmd_buffer cmd, recs_entity e) {
+  cmd_buffer_push(cmd, CMD_ENTITY_REMOVE, e, 0, 0);
+}
+
+void recs_cmd_entity_add_component(recs_cmd_buffer cmd, recs_entity e, recs_component comp_type, const void *component) {
+  RECS_ASSERT(comp_type < cmd->num_component_types);
+
+  size_t size = cmd->component_sizes[comp_type];
+  struct cmd_header *header = cmd_buffer_push(cmd, CMD_ADD_COMPONENT, e, comp_type, size);
+  memcpy((uint8_t*)header + memory_align(sizeof(struct cmd_header)), component, size);
+}
+
+void recs_cmd_entity_remove_component(recs_cmd_buffer cmd, recs_entity e, recs_component comp_type) {
+  cmd_buffer_push(cmd, CMD_REMOVE_COMPONENT, e, comp_type, 0);
+}
+
+void recs_cmd_entity_add_tag(recs_cmd_buffer cmd, recs_entity e, recs_tag tag) {
+  cmd_buffer_push(cmd, CMD_ADD_TAG, e, tag, 0);
+}
+
+void recs_cmd_entity_remove_tag(recs_cmd_buffer cmd, recs_entity e, recs_tag tag) {
+  cmd_buffer_push(cmd, CMD_REMOVE_TAG, e, tag, 0);
+}
+
+
+//swap a placeholder with the entity created while playing back its CMD_ENTITY_ADD command
+static recs_entity cmd_buffer_resolve(struct recs_cmd_buffer *cmd, recs_entity e) {
+  if(!RECS_ENTITY_IS_PLACEHOLDER(e)) {
+    return e;
+  }
+
+  //placeholders must come from the same command buffer
+  RECS_ASSERT(RECS_ENT_ID(e) < cmd->used);
+  struct cmd_header *create = (struct cmd_header*)(cmd->arena + RECS_ENT_ID(e));
+  RECS_ASSERT(create->type == CMD_ENTITY_ADD);
+
+  return create->entity;
+}
+
+void recs_cmd_buffer_playback(struct recs *ecs, recs_cmd_buffer cmd) {
+  size_t header_size = memory_align(sizeof(struct cmd_header));
+  size_t offset = 0;
+
+  while(offset < cmd->used) {
+    struct cmd_header *header = (struct cmd_header*)(cmd->arena + offset);
+    size_t data_size = header->type == CMD_ADD_COMPONENT ? memory_align(cmd->component_sizes[header->id]) : 0;
+    offset += header_size + data_size;
+
+    if(header->type == CMD_ENTITY_ADD) {
+      header->entity = recs_entity_add(ecs);
+      continue;
+    }
+
+    recs_entity e = cmd_buffer_resolve(cmd, header->entity);
+
+    //the entity was removed before this command could be played back
+    if(!recs_entity_active(ecs, e)) {
+      continue;
+    }
+
+    switch(header->type) {
+      case CMD_ENTITY_REMOVE: {
+        recs_entity_remove(ecs, e);
+        break;
+      }
+      case CMD_ADD_COMPONENT: {
+        void *data = (uint8_t*)header + header_size;
+        //overwriting goes through recs_entity_scatter_component(), since component types split into fields hold no whole components
+        if(recs_entity_has_component(ecs, e, header->id)) {
+          recs_entity_scatter_component(ecs, e, header->id, data);
+        } else {
+          recs_entity_add_component(ecs, e, header->id, data);
+        }
+        break;
+      }
+      case CMD_REMOVE_COMPONENT: {
+        recs_entity_remove_component(ecs, e, header->id);
+        break;
+      }
+      case CMD_ADD_TAG: {
+        recs_entity_add_tag(ecs, e, header->id);
+        break;
+      }
+      case CMD_REMOVE_TAG: {
+        recs_entity_remove_tag(ecs, e, header->id);
+        break;
+      }
+    }
+  }
+
+  cmd->used = 0;
+}
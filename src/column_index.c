@@ -0,0 +1,276 @@
+#include "column_index.h"
+
+
+//one summary bit for each word
+static inline uint32_t column_index_num_summaries(uint32_t num_words) {
+  return (num_words + (COLUMN_INDEX_BLOCK_WORDS - 1)) / COLUMN_INDEX_BLOCK_WORDS;
+}
+
+size_t column_index_buffer_size(uint32_t num_columns, uint32_t max_ids) {
+  uint32_t num_words = column_index_num_words(max_ids);
+  return memory_align(sizeof(uint64_t) * num_words * num_columns)
+    + memory_align(sizeof(uint64_t) * column_index_num_summaries(num_words) * num_columns);
+}
+
+//copy each of num_columns arrays of old_size words into arrays of new_size words, clearing the words past the copied ones
+static void column_index_copy_columns(uint64_t *dest, const uint64_t *src, uint32_t num_columns, uint32_t new_size, uint32_t old_size) {
+  for(uint32_t c = 0; c < num_columns; c++) {
+    uint64_t *column = dest + ((size_t)new_size * c);
+    if(src != NULL) {
+      memcpy(column, src + ((size_t)old_size * c), sizeof(uint64_t) * old_size);
+    }
+    memset(column + old_size, 0, sizeof(uint64_t) * (new_size - old_size));
+  }
+}
+
+void column_index_init(struct column_index *ci, uint8_t *buffer, uint32_t num_columns, uint32_t max_ids, const struct column_index *old) {
+  uint32_t words_per_column = column_index_num_words(max_ids);
+  uint32_t summaries_per_column = column_index_num_summaries(words_per_column);
+  uint64_t *words = (uint64_t*)buffer;
+  uint64_t *summaries = (uint64_t*)(buffer + memory_align(sizeof(uint64_t) * words_per_column * num_columns));
+
+  //each column keeps its own offset, so they are copied one at a time
+  column_index_copy_columns(words, old != NULL ? old->words : NULL, num_columns, words_per_column, old != NULL ? old->words_per_column : 0);
+  column_index_copy_columns(summaries, old != NULL ? old->summaries : NULL, num_columns, summaries_per_column, old != NULL ? old->summaries_per_column : 0);
+
+  ci->words = words;
+  ci->summaries = summaries;
+  ci->num_columns = num_columns;
+  ci->words_per_column = words_per_column;
+  ci->summaries_per_column = summaries_per_column;
+  ci->queued_column = num_columns - 2;
+  ci->active_column = num_columns - 1;
+  ci->num_changes = old != NULL ? old->num_changes + 1 : 0;
+}
+
+//add the column of each bit set inside mask to terms
+static uint8_t column_query_add_terms(uint32_t *terms, uint32_t *num_terms, const uint8_t *mask, uint32_t mask_size) {
+  for(uint32_t i = 0; i < mask_size; i++) {
+    if(mask[i] == 0) continue;
+
+    for(uint32_t bit = 0; bit < 8; bit++) {
+      if(!(mask[i] & (1 << bit))) continue;
+      if(*num_terms == COLUMN_INDEX_MAX_TERMS) {
+        return 0;
+      }
+      terms[(*num_terms)++] = (i * 8) + bit;
+    }
+  }
+  return 1;
+}
+
+uint8_t column_query_init(struct column_query *q, const uint8_t *include_mask, enum recs_ent_match_op include_op, const uint8_t *exclude_mask, enum recs_ent_match_op exclude_op, uint32_t mask_size) {
+  q->num_include = 0;
+  q->num_exclude = 0;
+
+  //a missing mask filters nothing, which is what an empty ALL include mask and an empty ANY exclude mask do
+  q->include_op = include_mask != NULL ? include_op : RECS_ENT_MATCH_ALL;
+  q->exclude_op = exclude_mask != NULL ? exclude_op : RECS_ENT_MATCH_ANY;
+
+  return (include_mask == NULL || column_query_add_terms(q->include, &q->num_include, include_mask, mask_size))
+    && (exclude_mask == NULL || column_query_add_terms(q->exclude, &q->num_exclude, exclude_mask, mask_size));
+}
+
+//combine the columns of terms into out one word at a time (AND for RECS_ENT_MATCH_ALL, OR for RECS_ENT_MATCH_ANY).
+//Each loop reads one column in order, which compilers turn into SIMD loops.
+static void column_index_combine(const struct column_index *ci, const uint32_t *terms, uint32_t num_terms, enum recs_ent_match_op op, uint32_t first_word, uint32_t num_words, uint64_t *out) {
+  uint64_t initial = op == RECS_ENT_MATCH_ALL ? ~(uint64_t)0 : 0;
+  for(uint32_t w = 0; w < num_words; w++) {
+    out[w] = initial;
+  }
+
+  for(uint32_t t = 0; t < num_terms; t++) {
+    const uint64_t *column = column_index_column(ci, terms[t]) + first_word;
+    if(op == RECS_ENT_MATCH_ALL) {
+      for(uint32_t w = 0; w < num_words; w++) {
+        out[w] &= column[w];
+      }
+    } else {
+      for(uint32_t w = 0; w < num_words; w++) {
+        out[w] |= column[w];
+      }
+    }
+  }
+}
+
+void column_index_match(const struct column_index *ci, const struct column_query *q, uint32_t first_word, uint32_t num_words, uint64_t *out) {
+  RECS_ASSERT(num_words <= COLUMN_INDEX_BLOCK_WORDS);
+
+  const uint64_t *active = column_index_column(ci, ci->active_column) + first_word;
+  uint64_t combined[COLUMN_INDEX_BLOCK_WORDS];
+
+  column_index_combine(ci, q->include, q->num_include, q->include_op, first_word, num_words, combined);
+  for(uint32_t w = 0; w < num_words; w++) {
+    out[w] = active[w] & combined[w];
+  }
+
+  //an empty ANY exclude mask excludes nothing
+  if(q->num_exclude == 0 && q->exclude_op == RECS_ENT_MATCH_ANY) {
+    return;
+  }
+  column_index_combine(ci, q->exclude, q->num_exclude, q->exclude_op, first_word, num_words, combined);
+  for(uint32_t w = 0; w < num_words; w++) {
+    out[w] &= ~combined[w];
+  }
+}
+
+uint64_t column_index_match_word(const struct column_index *ci, const struct column_query *q, uint32_t word) {
+  uint64_t result = column_index_column(ci, ci->active_column)[word];
+
+  if(q->include_op == RECS_ENT_MATCH_ALL) {
+    for(uint32_t t = 0; t < q->num_include; t++) {
+      result &= column_index_column(ci, q->include[t])[word];
+    }
+  } else {
+    uint64_t any = 0;
+    for(uint32_t t = 0; t < q->num_include; t++) {
+      any |= column_index_column(ci, q->include[t])[word];
+    }
+    result &= any;
+  }
+
+  if(q->exclude_op == RECS_ENT_MATCH_ANY) {
+    for(uint32_t t = 0; t < q->num_exclude; t++) {
+      result &= ~column_index_column(ci, q->exclude[t])[word];
+    }
+  } else {
+    uint64_t all = ~(uint64_t)0;
+    for(uint32_t t = 0; t < q->num_exclude; t++) {
+      all &= column_index_column(ci, q->exclude[t])[word];
+    }
+    result &= ~all;
+  }
+  return result;
+}
+
+uint64_t column_index_candidates(const struct column_index *ci, const struct column_query *q, uint32_t group) {
+  //a word can only match if it holds an active entity, along with each column it must have (or any of them)
+  uint64_t candidates = column_index_summary(ci, ci->active_column)[group];
+
+  if(q->include_op == RECS_ENT_MATCH_ALL) {
+    for(uint32_t t = 0; t < q->num_include && candidates != 0; t++) {
+      candidates &= column_index_summary(ci, q->include[t])[group];
+    }
+  } else {
+    uint64_t any = 0;
+    for(uint32_t t = 0; t < q->num_include; t++) {
+      any |= column_index_summary(ci, q->include[t])[group];
+    }
+    candidates &= any;
+  }
+
+  //summaries only tell us which words are empty, which says nothing about excluded columns
+  //(other than an empty ALL exclude mask, which excludes everything)
+  if(q->exclude_op == RECS_ENT_MATCH_ALL && q->num_exclude == 0) {
+    return 0;
+  }
+  return candidates;
+}
+
+uint32_t column_index_num_candidates(const struct column_index *ci, const struct column_query *q, uint32_t num_ids) {
+  uint32_t num_groups = column_index_num_summaries(column_index_num_words(num_ids));
+  uint32_t count = 0;
+  for(uint32_t g = 0; g < num_groups; g++) {
+    count += bitmask_popcount64(column_index_candidates(ci, q, g));
+  }
+  return count;
+}
+
+uint32_t column_index_count(const struct column_index *ci, const struct column_query *q, uint32_t num_ids) {
+  uint32_t num_words = column_index_num_words(num_ids);
+  uint64_t block[COLUMN_INDEX_BLOCK_WORDS];
+  uint32_t count = 0;
+
+  for(uint32_t first = 0; first < num_words; first += COLUMN_INDEX_BLOCK_WORDS) {
+    uint64_t candidates = column_index_candidates(ci, q, first / COLUMN_INDEX_BLOCK_WORDS);
+    if(candidates == 0) continue;
+
+    //match the whole block at once when most of its words need to be matched anyway
+    if(bitmask_popcount64(candidates) > COLUMN_INDEX_BLOCK_WORDS / 2) {
+      uint32_t n = num_words - first < COLUMN_INDEX_BLOCK_WORDS ? num_words - first : COLUMN_INDEX_BLOCK_WORDS;
+      column_index_match(ci, q, first, n, block);
+      for(uint32_t w = 0; w < n; w++) {
+        count += bitmask_popcount64(block[w]);
+      }
+      continue;
+    }
+
+    for(; candidates != 0; candidates &= candidates - 1) {
+      count += bitmask_popcount64(column_index_match_word(ci, q, first + bitmask_ctz64(candidates)));
+    }
+  }
+  return count;
+}
+
+uint32_t column_index_find(const struct column_index *ci, uint32_t column, uint32_t id, uint32_t end_id) {
+  const uint64_t *words = column_index_column(ci, column);
+  const uint64_t *summary = column_index_summary(ci, column);
+  uint32_t num_words = column_index_num_words(end_id);
+
+  for(uint32_t word = id >> 6; word < num_words;) {
+    uint32_t group = word / COLUMN_INDEX_BLOCK_WORDS;
+    uint64_t nonzero = summary[group] & (~(uint64_t)0 << (word % COLUMN_INDEX_BLOCK_WORDS));
+    if(nonzero == 0) {
+      word = (group + 1) * COLUMN_INDEX_BLOCK_WORDS;
+      continue;
+    }
+    word = (group * COLUMN_INDEX_BLOCK_WORDS) + bitmask_ctz64(nonzero);
+    if(word >= num_words) {
+      break;
+    }
+
+    //only bits from id onward count inside the first word
+    uint64_t bits = words[word];
+    if(word == id >> 6) {
+      bits &= ~(uint64_t)0 << (id & 63);
+    }
+    if(bits != 0) {
+      uint32_t found = (word << 6) + bitmask_ctz64(bits);
+      return found < end_id ? found : end_id;
+    }
+    word++;
+  }
+  return end_id;
+}
+
+void column_index_reset_ids(struct column_index *ci, uint32_t first_id, uint32_t end_id) {
+  if(first_id >= end_id) {
+    return;
+  }
+  for(uint32_t c = 0; c < ci->num_columns; c++) {
+    uint64_t *column = column_index_column(ci, c);
+    for(uint32_t id = first_id; id < end_id; id++) {
+      //clear whole words at once when possible
+      if((id & 63) == 0 && end_id - id >= 64) {
+        column[id >> 6] = 0;
+        id += 63;
+        continue;
+      }
+      column[id >> 6] &= ~((uint64_t)1 << (id & 63));
+    }
+
+    //the words that were cleared may now be empty
+    uint64_t *summary = column_index_summary(ci, c);
+    for(uint32_t w = first_id >> 6; w <= (end_id - 1) >> 6; w++) {
+      uint64_t summary_bit = (uint64_t)1 << (w % COLUMN_INDEX_BLOCK_WORDS);
+      uint64_t *s = summary + (w / COLUMN_INDEX_BLOCK_WORDS);
+      *s = column[w] != 0 ? (*s | summary_bit) : (*s & ~summary_bit);
+    }
+  }
+}
+
+void column_index_relocate(struct column_index *ci, const void *old_base, void *new_base) {
+  ci->words = memory_relocate(ci->words, old_base, new_base);
+  ci->summaries = memory_relocate(ci->summaries, old_base, new_base);
+}
+
+void column_index_ranges(const struct column_index *ci, uint32_t num_ids, memory_range_func func, void *userdata) {
+  uint32_t num_words = column_index_num_words(num_ids);
+  if(num_words == 0) {
+    return;
+  }
+  for(uint32_t c = 0; c < ci->num_columns; c++) {
+    func(userdata, column_index_column(ci, c), sizeof(uint64_t) * num_words);
+    func(userdata, column_index_summary(ci, c), sizeof(uint64_t) * column_index_num_summaries(num_words));
+  }
+}
@@ -0,0 +1,130 @@
+#ifndef COLUMN_INDEX_H
+#define COLUMN_INDEX_H
+
+#include <stdint.h>
+#include <string.h>
+#include "recs.h"
+#include "memory.h"
+#include "dirty.h"
+#include "bitmask.h"
+
+//number of words evaluated at once when matching a query, so that each column is read in long contiguous runs.
+//This is also the number of words covered by one summary word (4096 entity IDs).
+#define COLUMN_INDEX_BLOCK_WORDS 64
+
+//queries reading more columns than this are matched one entity at a time instead
+#define COLUMN_INDEX_MAX_TERMS 16
+
+//checking one entity's bitmask row costs about as much as reading this many column words, which is used
+//to decide whether an iterator scans the columns or goes through a list of entities
+#define COLUMN_INDEX_WORDS_PER_ROW 4
+
+/*
+  Column Index Section
+
+  Stores one bitset over entity IDs for each component and tag (the same bits as each entity's bitmask row,
+  turned sideways), plus one for the entities that are active and one for the entities queued for removal.
+  Matching a query against the columns checks 64 entities per word with AND/ANDNOT, and only the set bits
+  of the result need to be visited.
+
+  Each column also has a summary with one bit per word, which is set if the word has any bit set. One summary
+  word covers 4096 entity IDs, so ranges of IDs without any match are skipped without reading the columns.
+*/
+
+struct column_index {
+  //num_columns columns of words_per_column words each
+  uint64_t *words;
+
+  //num_columns summaries of summaries_per_column words each
+  uint64_t *summaries;
+
+  uint32_t num_columns;
+  uint32_t words_per_column;
+  uint32_t summaries_per_column;
+
+  //the columns of queued and active entities, which are always the last 2
+  uint32_t queued_column;
+  uint32_t active_column;
+
+  //incremented whenever a bit changes, so iterators know when the words they already matched are out of date
+  uint32_t num_changes;
+};
+
+//the columns a query reads, decoded from its masks
+struct column_query {
+  uint32_t include[COLUMN_INDEX_MAX_TERMS];
+  uint32_t exclude[COLUMN_INDEX_MAX_TERMS];
+  uint32_t num_include;
+  uint32_t num_exclude;
+  enum recs_ent_match_op include_op;
+  enum recs_ent_match_op exclude_op;
+};
+
+static inline uint32_t column_index_num_words(uint32_t num_ids) {
+  return (uint32_t)(((uint64_t)num_ids + 63) >> 6);
+}
+
+size_t column_index_buffer_size(uint32_t num_columns, uint32_t max_ids);
+
+//place the columns inside buffer. If old is not NULL, the columns are copied out of old (which is left untouched),
+//otherwise every bit starts out cleared.
+void column_index_init(struct column_index *ci, uint8_t *buffer, uint32_t num_columns, uint32_t max_ids, const struct column_index *old);
+
+static inline uint64_t *column_index_column(const struct column_index *ci, uint32_t column) {
+  return ci->words + ((size_t)ci->words_per_column * column);
+}
+
+static inline uint64_t *column_index_summary(const struct column_index *ci, uint32_t column) {
+  return ci->summaries + ((size_t)ci->summaries_per_column * column);
+}
+
+static inline void column_index_set(struct column_index *ci, uint32_t column, uint32_t id, uint8_t value, struct dirty_tracker *dirty) {
+  uint64_t *word = column_index_column(ci, column) + (id >> 6);
+  uint64_t bit = (uint64_t)1 << (id & 63);
+  *word = value ? (*word | bit) : (*word & ~bit);
+
+  uint64_t *summary = column_index_summary(ci, column) + (id >> 12);
+  uint64_t summary_bit = (uint64_t)1 << ((id >> 6) & 63);
+  *summary = *word != 0 ? (*summary | summary_bit) : (*summary & ~summary_bit);
+
+  ci->num_changes++;
+  dirty_mark(dirty, word, sizeof(uint64_t));
+  dirty_mark(dirty, summary, sizeof(uint64_t));
+}
+
+static inline uint8_t column_index_test(const struct column_index *ci, uint32_t column, uint32_t id) {
+  return (column_index_column(ci, column)[id >> 6] >> (id & 63)) & 1;
+}
+
+//decode the columns read by a query. Either mask may be NULL. Returns 0 if the query reads more than COLUMN_INDEX_MAX_TERMS columns.
+uint8_t column_query_init(struct column_query *q, const uint8_t *include_mask, enum recs_ent_match_op include_op, const uint8_t *exclude_mask, enum recs_ent_match_op exclude_op, uint32_t mask_size);
+
+//match num_words words (at most COLUMN_INDEX_BLOCK_WORDS) of active entities against a query, starting at first_word.
+//Bit i of out[w] is set if the entity with ID ((first_word + w) * 64 + i) matches.
+void column_index_match(const struct column_index *ci, const struct column_query *q, uint32_t first_word, uint32_t num_words, uint64_t *out);
+
+//match a single word of active entities against a query
+uint64_t column_index_match_word(const struct column_index *ci, const struct column_query *q, uint32_t word);
+
+//use the summaries to find which words of a group of COLUMN_INDEX_BLOCK_WORDS words may hold matches of a query.
+//Bit w is set if word ((group * COLUMN_INDEX_BLOCK_WORDS) + w) needs to be matched.
+uint64_t column_index_candidates(const struct column_index *ci, const struct column_query *q, uint32_t group);
+
+//count the words among the first num_ids entity IDs that may hold matches of a query
+uint32_t column_index_num_candidates(const struct column_index *ci, const struct column_query *q, uint32_t num_ids);
+
+//find the first entity ID from id up to end_id whose bit is set in a column. Returns end_id if there is none.
+uint32_t column_index_find(const struct column_index *ci, uint32_t column, uint32_t id, uint32_t end_id);
+
+//count the active entities among the first num_ids entity IDs that match a query
+uint32_t column_index_count(const struct column_index *ci, const struct column_query *q, uint32_t num_ids);
+
+//clear the bits of the entity IDs from first_id up to end_id
+void column_index_reset_ids(struct column_index *ci, uint32_t first_id, uint32_t end_id);
+
+void column_index_relocate(struct column_index *ci, const void *old_base, void *new_base);
+
+//report the words of each column holding the first num_ids entity IDs
+void column_index_ranges(const struct column_index *ci, uint32_t num_ids, memory_range_func func, void *userdata);
+
+#endif// COLUMN_INDEX_H
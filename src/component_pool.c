@@ -1,26 +1,150 @@
 #include "component_pool.h"
 
-#define NO_COMP_ID RECS_NO_ENTITY_ID
 
+//the smallest shift such that (1 << shift) >= count
+static uint32_t component_pool_shift_for(uint64_t count) {
+  uint32_t shift = 0;
+  while(((uint64_t)1 << shift) < count) {
+    shift++;
+  }
+  return shift;
+}
+
+//get the number of bytes taken up by the tick arrays of a pool with room for num_slots components
+static size_t component_pool_ticks_size(uint64_t num_slots) {
+  uint64_t num_blocks = (num_slots + COMPONENT_POOL_TICK_BLOCK_MASK) >> COMPONENT_POOL_TICK_BLOCK_SHIFT;
+  return (memory_align(sizeof(uint32_t) * num_slots) * 2) + memory_align(sizeof(uint32_t) * num_blocks);
+}
+
+//place the tick arrays of a pool with room for num_slots components inside buffer
+static void component_pool_place_ticks(struct component_pool *ca, uint8_t *buffer, uint64_t num_slots) {
+  size_t slot_ticks_size = memory_align(sizeof(uint32_t) * num_slots);
+  ca->added_ticks = (uint32_t*)buffer;
+  ca->changed_ticks = (uint32_t*)(buffer + slot_ticks_size);
+  ca->block_ticks = (uint32_t*)(buffer + (slot_ticks_size * 2));
+}
+
+//get the number of bytes taken up by the free slots and occupancy bitmap of a RECS_REMOVAL_STABLE pool with room for num_slots components
+static size_t component_pool_slots_size(uint64_t num_slots) {
+  return memory_align(sizeof(uint32_t) * num_slots) + memory_align(sizeof(uint64_t) * ((num_slots + 63) >> 6));
+}
+
+//place the free slots and occupancy bitmap of a pool with room for num_slots components inside buffer
+static void component_pool_place_slots(struct component_pool *ca, uint8_t *buffer, uint64_t num_slots) {
+  ca->free_slots = (uint32_t*)buffer;
+  ca->occupancy = (uint64_t*)(buffer + memory_align(sizeof(uint32_t) * num_slots));
+}
+
+//get the number of slots the buffer of a fixed-size pool has room for. Pools split into smaller blocks than max_components
+//round it up to whole blocks, so that the columns of the last block fit inside the buffer.
+static uint64_t component_pool_buffer_slots(const struct recs_init_config_component *config) {
+  uint64_t block_size = config->field_block_size;
+  if(config->num_fields == 0 || block_size == 0 || block_size >= config->max_components) {
+    return config->max_components;
+  }
+  return (config->max_components + block_size - 1) & ~(block_size - 1);
+}
+
+//set up the fields of a pool whose pages hold page_slots slots, after its page_shift is known
+static void component_pool_init_fields(struct component_pool *ca, const struct recs_init_config_component *config, uint32_t page_slots) {
+  ca->num_fields = 0;
+  ca->field_block_size = page_slots;
+  ca->field_block_mask = (uint32_t)(((uint64_t)1 << ca->page_shift) - 1);
+  if(config->num_fields == 0) {
+    return;
+  }
+
+  RECS_ASSERT(config->num_fields <= RECS_MAX_COMPONENT_FIELDS);
+  RECS_ASSERT((config->field_block_size & (config->field_block_size - 1)) == 0);
+  if(config->field_block_size != 0 && config->field_block_size < page_slots) {
+    ca->field_block_size = config->field_block_size;
+    ca->field_block_mask = config->field_block_size - 1;
+  }
+
+  //fields must be in order, so that their columns do not overlap either
+  size_t end = 0;
+  for(uint32_t i = 0; i < config->num_fields; i++) {
+    const struct recs_component_field *f = config->fields + i;
+    RECS_ASSERT(f->size > 0 && f->offset >= end && f->size <= config->comp_size - f->offset);
+    end = f->offset + f->size;
+
+    ca->fields[i].offset = (uint32_t)f->offset;
+    ca->fields[i].size = (uint32_t)f->size;
+  }
+  (void)end;
+  ca->num_fields = config->num_fields;
+}
+
+size_t component_pool_buffer_size(const struct recs_init_config_component *config, uint32_t max_entities) {
+  uint32_t max_components = config->max_components;
+  size_t comp_buffer_size = memory_align(config->comp_size * component_pool_buffer_slots(config));
+  //only allocate to max_components since that is usually equal to 
+  //or less than the max_entities, making memory storage slightly more efficient.
+  size_t comp_to_ent_buffer_size = memory_align(sizeof(uint32_t) * max_components);
+  size_t page_table_size = memory_align(sizeof(char*));
+  size_t entity_to_comp_size = sparse_map_buffer_size(max_entities, component_pool_sparse_pages(max_components, max_entities));
+
+  size_t ticks_size = config->track_changes ? component_pool_ticks_size(max_components) : 0;
+  size_t events_size = event_queue_buffer_size(config->max_events, (uint32_t)config->comp_size);
+  size_t slots_size = config->removal_policy == RECS_REMOVAL_STABLE ? component_pool_slots_size(max_components) : 0;
 
-void component_pool_init(struct component_pool *ca, unsigned char *buffer, uint32_t component_size, uint32_t max_components, uint32_t max_entities) {
+  return comp_buffer_size + comp_to_ent_buffer_size + page_table_size + entity_to_comp_size + ticks_size + events_size + slots_size;
+}
+
+void component_pool_init(struct component_pool *ca, unsigned char *buffer, const struct recs_init_config_component *config, uint32_t max_entities) {
+  uint32_t component_size = (uint32_t)config->comp_size;
+  uint32_t max_components = config->max_components;
   ca->num_components = 0;
+  ca->num_slots = 0;
   ca->component_size = component_size;
   ca->max_components = max_components;
+  ca->max_entities = max_entities;
+  ca->growable = 0;
+  ca->track_changes = config->track_changes;
+  ca->removal_policy = (uint8_t)config->removal_policy;
+  ca->group = NO_GROUP_ID;
 
-  size_t comp_buffer_size = component_size * max_components;
-  size_t ent_to_comp_buffer_size = sizeof(uint32_t) * max_entities;
+  size_t comp_buffer_size = memory_align((size_t)component_size * component_pool_buffer_slots(config));
+  size_t comp_to_ent_buffer_size = memory_align(sizeof(uint32_t) * max_components);
 
+  unsigned char *comp_buffer = buffer;
+  unsigned char *comp_to_ent_buffer = buffer + comp_buffer_size;
+  unsigned char *page_table_buffer = buffer + comp_buffer_size + comp_to_ent_buffer_size;
+  unsigned char *entity_to_comp_buffer = page_table_buffer + memory_align(sizeof(char*));
+  unsigned char *ticks_buffer = entity_to_comp_buffer + sparse_map_buffer_size(max_entities, component_pool_sparse_pages(max_components, max_entities));
+  unsigned char *events_buffer = ticks_buffer + (config->track_changes ? component_pool_ticks_size(max_components) : 0);
+  unsigned char *slots_buffer = events_buffer + event_queue_buffer_size(config->max_events, component_size);
 
+  //a single page holding every component
+  ca->pages = (char**)page_table_buffer;
+  ca->pages[0] = (char*)comp_buffer;
+  ca->num_pages = 1;
+  ca->max_pages = 1;
+  ca->page_shift = component_pool_shift_for(max_components);
+  component_pool_init_fields(ca, config, max_components);
 
+  ca->comp_to_entity = (uint32_t*)comp_to_ent_buffer;
+  sparse_map_init(&ca->entity_to_comp, entity_to_comp_buffer, max_entities, component_pool_sparse_pages(max_components, max_entities));
 
-  unsigned char *comp_buffer = buffer;
-  unsigned char *ent_to_comp_buffer = buffer + comp_buffer_size;
-  unsigned char *comp_to_ent_buffer = buffer + comp_buffer_size + ent_to_comp_buffer_size;
+  ca->added_ticks = NULL;
+  ca->changed_ticks = NULL;
+  ca->block_ticks = NULL;
+  if(config->track_changes) {
+    component_pool_place_ticks(ca, ticks_buffer, max_components);
 
-  ca->buffer = (char*)comp_buffer;
-  ca->comp_to_entity = (uint32_t*)comp_to_ent_buffer;
-  ca->entity_to_comp = (uint32_t*) ent_to_comp_buffer;
+    //slot ticks are written whenever a component is added, but blocks only ever take the highest tick
+    memset(ca->block_ticks, 0, sizeof(uint32_t) * ((max_components + COMPONENT_POOL_TICK_BLOCK_MASK) >> COMPONENT_POOL_TICK_BLOCK_SHIFT));
+  }
+
+  event_queue_init(&ca->events, events_buffer, config->max_events, component_size);
+
+  ca->free_slots = NULL;
+  ca->occupancy = NULL;
+  ca->num_free = 0;
+  if(config->removal_policy == RECS_REMOVAL_STABLE) {
+    component_pool_place_slots(ca, slots_buffer, max_components);
+    memset(ca->occupancy, 0, sizeof(uint64_t) * (((uint64_t)max_components + 63) >> 6));
+  }
 
   //mark all components as not belonging to any entity. 
   //Because this game will never get to a point where there are 65000 entities or
@@ -30,66 +154,598 @@ void component_pool_init(struct component_pool *ca, unsigned char *buffer, uint3
   for(uint32_t i = 0; i < ca->max_components; i++) {
     ca->comp_to_entity[i] = RECS_NO_ENTITY_ID;
   }
+  
+}
 
-  for(uint32_t i = 0; i < max_entities; i++) {
-    ca->entity_to_comp[i] = NO_COMP_ID;
+//get the number of bytes allocated for the page table of a growable pool, which also holds its comp_to_entity entries, ticks,
+//free slots and occupancy bitmap
+static size_t component_pool_page_table_size(const struct component_pool *ca, uint32_t max_pages) {
+  size_t num_slots = (size_t)max_pages << ca->page_shift;
+  size_t size = memory_align(sizeof(char*) * (size_t)max_pages) + memory_align(sizeof(uint32_t) * num_slots);
+  size += ca->track_changes ? component_pool_ticks_size(num_slots) : 0;
+  return size + (ca->removal_policy == RECS_REMOVAL_STABLE ? component_pool_slots_size(num_slots) : 0);
+}
+
+//replace the page table of a growable pool with one that fits max_pages pages
+static uint8_t component_pool_resize_page_table(struct component_pool *ca, uint32_t max_pages) {
+  size_t page_table_size = memory_align(sizeof(char*) * (size_t)max_pages);
+  size_t num_slots = (size_t)max_pages << ca->page_shift;
+
+  uint8_t *buffer = (uint8_t*)RECS_MALLOC(component_pool_page_table_size(ca, max_pages));
+  if(buffer == NULL) {
+    return 0;
   }
-  
+
+  char **pages = (char**)buffer;
+  uint32_t *comp_to_entity = (uint32_t*)(buffer + page_table_size);
+  size_t old_slots = (size_t)ca->num_pages << ca->page_shift;
+
+  uint32_t *old_added_ticks = ca->added_ticks;
+  uint32_t *old_changed_ticks = ca->changed_ticks;
+  uint32_t *old_block_ticks = ca->block_ticks;
+  uint8_t *ticks_buffer = buffer + page_table_size + memory_align(sizeof(uint32_t) * num_slots);
+  if(ca->track_changes) {
+    component_pool_place_ticks(ca, ticks_buffer, num_slots);
+    memset(ca->block_ticks, 0, sizeof(uint32_t) * ((num_slots + COMPONENT_POOL_TICK_BLOCK_MASK) >> COMPONENT_POOL_TICK_BLOCK_SHIFT));
+  }
+
+  uint32_t *old_free_slots = ca->free_slots;
+  uint64_t *old_occupancy = ca->occupancy;
+  if(ca->removal_policy == RECS_REMOVAL_STABLE) {
+    component_pool_place_slots(ca, ticks_buffer + (ca->track_changes ? component_pool_ticks_size(num_slots) : 0), num_slots);
+    memset(ca->occupancy, 0, sizeof(uint64_t) * ((num_slots + 63) >> 6));
+  }
+
+  //the comp_to_entity entries of the components that are not inside a page yet are set once their page is added
+  if(ca->pages != NULL) {
+    memcpy(pages, ca->pages, sizeof(char*) * ca->num_pages);
+    memcpy(comp_to_entity, ca->comp_to_entity, sizeof(uint32_t) * old_slots);
+    if(ca->track_changes) {
+      memcpy(ca->added_ticks, old_added_ticks, sizeof(uint32_t) * old_slots);
+      memcpy(ca->changed_ticks, old_changed_ticks, sizeof(uint32_t) * old_slots);
+      memcpy(ca->block_ticks, old_block_ticks, sizeof(uint32_t) * ((old_slots + COMPONENT_POOL_TICK_BLOCK_MASK) >> COMPONENT_POOL_TICK_BLOCK_SHIFT));
+    }
+    if(ca->removal_policy == RECS_REMOVAL_STABLE) {
+      memcpy(ca->free_slots, old_free_slots, sizeof(uint32_t) * ca->num_free);
+      memcpy(ca->occupancy, old_occupancy, sizeof(uint64_t) * ((old_slots + 63) >> 6));
+    }
+    RECS_FREE(ca->pages);
+  }
+
+  ca->pages = pages;
+  ca->comp_to_entity = comp_to_entity;
+  ca->max_pages = max_pages;
+  return 1;
 }
 
-void *component_pool_get(struct component_pool *ca, recs_entity e) {
-  
-  uint32_t component_index = ca->entity_to_comp[RECS_ENT_ID(e)];
+static uint8_t component_pool_add_page(struct component_pool *ca) {
+  size_t components_per_page = (size_t)1 << ca->page_shift;
 
-  if(component_index == NO_COMP_ID) {
-    return NULL;
+  //component indexes must stay below NO_COMP_ID
+  RECS_ASSERT(((uint64_t)ca->num_pages + 1) * components_per_page <= NO_COMP_ID);
+
+  if(ca->num_pages == ca->max_pages) {
+    //grow the page table geometrically, so adding pages stays cheap
+    uint32_t max_pages = ca->max_pages == 0 ? 4 : ca->max_pages * 2;
+    if(!component_pool_resize_page_table(ca, max_pages)) {
+      return 0;
+    }
+  }
+
+  char *page = (char*)RECS_MALLOC(ca->component_size * components_per_page);
+  if(page == NULL) {
+    return 0;
+  }
+
+  uint32_t *comp_to_entity = ca->comp_to_entity + ((size_t)ca->num_pages << ca->page_shift);
+  for(size_t i = 0; i < components_per_page; i++) {
+    comp_to_entity[i] = RECS_NO_ENTITY_ID;
+  }
+
+  ca->pages[ca->num_pages++] = page;
+  ca->max_components = (uint32_t)((size_t)ca->num_pages << ca->page_shift);
+  return 1;
+}
+
+uint8_t component_pool_init_growable(struct component_pool *ca, const struct recs_init_config_component *config, uint32_t page_size, uint32_t max_entities) {
+  uint32_t component_size = (uint32_t)config->comp_size;
+  ca->num_components = 0;
+  ca->num_slots = 0;
+  ca->component_size = component_size;
+  ca->max_components = 0;
+  ca->max_entities = max_entities;
+  ca->growable = 1;
+  ca->track_changes = config->track_changes;
+  ca->removal_policy = (uint8_t)config->removal_policy;
+  ca->group = NO_GROUP_ID;
+  ca->pages = NULL;
+  ca->comp_to_entity = NULL;
+  ca->added_ticks = NULL;
+  ca->changed_ticks = NULL;
+  ca->block_ticks = NULL;
+  ca->free_slots = NULL;
+  ca->occupancy = NULL;
+  ca->num_free = 0;
+  ca->num_pages = 0;
+  ca->max_pages = 0;
+
+  //round the number of components per page down to a power of 2, so finding a component's page only needs a shift
+  if(page_size == 0) {
+    page_size = COMPONENT_POOL_DEFAULT_PAGE_SIZE;
+  }
+  uint32_t components_per_page = page_size / component_size;
+  ca->page_shift = components_per_page <= 1 ? 0 : component_pool_shift_for(components_per_page + 1) - 1;
+  component_pool_init_fields(ca, config, (uint32_t)1 << ca->page_shift);
+
+  //the event queue never grows, so it is allocated once up front
+  event_queue_init(&ca->events, NULL, config->max_events, component_size);
+  if(config->max_events != 0) {
+    ca->events.slots = (uint8_t*)RECS_MALLOC(event_queue_buffer_size(config->max_events, component_size));
+    if(ca->events.slots == NULL) {
+      return 0;
+    }
+  }
+
+  while(ca->max_components < config->max_components) {
+    if(!component_pool_add_page(ca)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void component_pool_free_pages(struct component_pool *ca) {
+  if(!ca->growable) {
+    return;
+  }
+
+  if(ca->events.slots != NULL) {
+    RECS_FREE(ca->events.slots);
+    ca->events.slots = NULL;
+  }
+  if(ca->pages == NULL) {
+    return;
+  }
+
+  for(uint32_t i = 0; i < ca->num_pages; i++) {
+    RECS_FREE(ca->pages[i]);
+  }
+  RECS_FREE(ca->pages);
+  ca->pages = NULL;
+  ca->comp_to_entity = NULL;
+  ca->added_ticks = NULL;
+  ca->changed_ticks = NULL;
+  ca->block_ticks = NULL;
+  ca->free_slots = NULL;
+  ca->occupancy = NULL;
+  ca->num_pages = 0;
+  ca->max_pages = 0;
+  ca->max_components = 0;
+}
+
+size_t component_pool_pages_size(const struct component_pool *ca) {
+  if(!ca->growable) {
+    return 0;
+  }
+
+  size_t events_size = ca->events.slots != NULL ? event_queue_buffer_size(ca->events.capacity, ca->events.data_size) : 0;
+  if(ca->pages == NULL) {
+    return events_size;
+  }
+  return events_size + component_pool_page_table_size(ca, ca->max_pages) + ((size_t)ca->num_pages * ca->component_size << ca->page_shift);
+}
+
+uint8_t component_pool_copy_pages(struct component_pool *ca, const struct component_pool *og) {
+  ca->pages = NULL;
+  ca->comp_to_entity = NULL;
+  ca->added_ticks = NULL;
+  ca->changed_ticks = NULL;
+  ca->block_ticks = NULL;
+  ca->free_slots = NULL;
+  ca->occupancy = NULL;
+  ca->events.slots = NULL;
+  ca->num_pages = 0;
+  ca->max_pages = 0;
+  if(!og->growable) {
+    return 1;
+  }
+
+  if(og->events.slots != NULL) {
+    size_t events_size = event_queue_buffer_size(og->events.capacity, og->events.data_size);
+    ca->events.slots = (uint8_t*)RECS_MALLOC(events_size);
+    if(ca->events.slots == NULL) {
+      return 0;
+    }
+    memcpy(ca->events.slots, og->events.slots, events_size);
+  }
+  if(og->pages == NULL) {
+    return 1;
+  }
+
+  if(!component_pool_resize_page_table(ca, og->max_pages)) {
+    return 0;
+  }
+  size_t num_slots = (size_t)og->num_pages << og->page_shift;
+  memcpy(ca->comp_to_entity, og->comp_to_entity, sizeof(uint32_t) * num_slots);
+  if(og->track_changes) {
+    memcpy(ca->added_ticks, og->added_ticks, sizeof(uint32_t) * num_slots);
+    memcpy(ca->changed_ticks, og->changed_ticks, sizeof(uint32_t) * num_slots);
+    memcpy(ca->block_ticks, og->block_ticks, sizeof(uint32_t) * ((num_slots + COMPONENT_POOL_TICK_BLOCK_MASK) >> COMPONENT_POOL_TICK_BLOCK_SHIFT));
+  }
+  if(og->removal_policy == RECS_REMOVAL_STABLE) {
+    memcpy(ca->free_slots, og->free_slots, sizeof(uint32_t) * og->num_free);
+    memcpy(ca->occupancy, og->occupancy, sizeof(uint64_t) * ((num_slots + 63) >> 6));
+  }
+
+  size_t page_bytes = ca->component_size * ((size_t)1 << ca->page_shift);
+  for(uint32_t i = 0; i < og->num_pages; i++) {
+    char *page = (char*)RECS_MALLOC(page_bytes);
+    if(page == NULL) {
+      return 0;
+    }
+    memcpy(page, og->pages[i], page_bytes);
+    ca->pages[ca->num_pages++] = page;
+  }
+  return 1;
+}
+
+void component_pool_relocate(struct component_pool *ca, const void *old_base, void *new_base) {
+  //growable pools allocate their own pages, while pools used by RECS_STORAGE_ARCHETYPE have no pages
+  if(ca->growable || ca->pages == NULL) {
+    return;
+  }
+
+  ca->pages = memory_relocate(ca->pages, old_base, new_base);
+  ca->pages[0] = memory_relocate(ca->pages[0], old_base, new_base);
+  ca->comp_to_entity = memory_relocate(ca->comp_to_entity, old_base, new_base);
+  ca->added_ticks = memory_relocate(ca->added_ticks, old_base, new_base);
+  ca->changed_ticks = memory_relocate(ca->changed_ticks, old_base, new_base);
+  ca->block_ticks = memory_relocate(ca->block_ticks, old_base, new_base);
+  ca->free_slots = memory_relocate(ca->free_slots, old_base, new_base);
+  ca->occupancy = memory_relocate(ca->occupancy, old_base, new_base);
+  sparse_map_relocate(&ca->entity_to_comp, old_base, new_base);
+  event_queue_relocate(&ca->events, old_base, new_base);
+}
+
+void component_pool_ranges(const struct component_pool *ca, uint32_t num_ids, memory_range_func func, void *userdata) {
+  //pools used by RECS_STORAGE_ARCHETYPE only count their components
+  if(ca->pages == NULL) {
+    return;
+  }
+  RECS_ASSERT(!ca->growable);
+
+  //the page table holds a pointer to the pool's only page
+  func(userdata, ca->pages, sizeof(char*));
+  if(ca->num_fields == 0) {
+    func(userdata, ca->pages[0], (size_t)ca->component_size * ca->num_slots);
+  } else {
+    //every block before the last one in use is full, while only the start of each column of the last one is used
+    uint32_t last_block = ca->num_slots & ~ca->field_block_mask;
+    func(userdata, ca->pages[0], (size_t)ca->component_size * last_block);
+    for(uint32_t i = 0; i < ca->num_fields && last_block < ca->num_slots; i++) {
+      func(userdata, component_pool_field_at(ca, last_block, i), (size_t)ca->fields[i].size * (ca->num_slots - last_block));
+    }
+  }
+  func(userdata, ca->comp_to_entity, sizeof(uint32_t) * ca->num_slots);
+  sparse_map_ranges(&ca->entity_to_comp, num_ids, func, userdata);
+
+  if(ca->changed_ticks != NULL) {
+    func(userdata, ca->added_ticks, sizeof(uint32_t) * ca->num_slots);
+    func(userdata, ca->changed_ticks, sizeof(uint32_t) * ca->num_slots);
+    func(userdata, ca->block_ticks, sizeof(uint32_t) * ((ca->num_slots + COMPONENT_POOL_TICK_BLOCK_MASK) >> COMPONENT_POOL_TICK_BLOCK_SHIFT));
+  }
+
+  if(ca->occupancy != NULL) {
+    func(userdata, ca->free_slots, sizeof(uint32_t) * ca->num_free);
+    func(userdata, ca->occupancy, sizeof(uint64_t) * (((uint64_t)ca->num_slots + 63) >> 6));
+  }
+
+  event_queue_ranges(&ca->events, func, userdata);
+}
+
+void component_pool_reserve(struct component_pool *ca, uint32_t num_slots) {
+  while(ca->max_components < num_slots) {
+    //fixed-size pools cannot grow
+    RECS_ASSERT(ca->growable);
+
+    uint8_t added = component_pool_add_page(ca);
+    RECS_ASSERT(added);
+    (void)added;
   }
-  return ca->buffer + (ca->component_size * component_index);
 }
 
 
-void component_pool_add(struct component_pool *ca, recs_entity e, void *component) {
-  RECS_ASSERT(ca->num_components < ca->max_components);
+//pick the slot of a new component: a free slot if there is one, otherwise the slot after the last one in use
+static uint32_t component_pool_take_slot(struct component_pool *ca, struct dirty_tracker *dirty) {
+  uint32_t index;
+  if(ca->num_free > 0) {
+    index = ca->free_slots[--ca->num_free];
+  } else {
+    component_pool_reserve(ca, ca->num_slots + 1);
+    index = ca->num_slots++;
+  }
 
-  uint32_t component_index = ca->num_components;
+  if(ca->occupancy != NULL) {
+    ca->occupancy[index >> 6] |= (uint64_t)1 << (index & 63);
+    dirty_mark(dirty, ca->occupancy + (index >> 6), sizeof(uint64_t));
+  }
+  return index;
+}
 
-  memcpy(ca->buffer + (ca->component_size * component_index), component, ca->component_size);
+void component_pool_gather(const struct component_pool *ca, uint32_t index, void *component) {
+  if(ca->num_fields == 0) {
+    memcpy(component, component_pool_at((struct component_pool*)ca, index), ca->component_size);
+    return;
+  }
+
+  for(uint32_t i = 0; i < ca->num_fields; i++) {
+    memcpy((char*)component + ca->fields[i].offset, component_pool_field_at(ca, index, i), ca->fields[i].size);
+  }
+}
+
+void component_pool_scatter(struct component_pool *ca, uint32_t index, const void *component, struct dirty_tracker *dirty) {
+  if(ca->num_fields == 0) {
+    memcpy(component_pool_at(ca, index), component, ca->component_size);
+    dirty_mark(dirty, component_pool_at(ca, index), ca->component_size);
+    return;
+  }
+
+  for(uint32_t i = 0; i < ca->num_fields; i++) {
+    void *field = component_pool_field_at(ca, index, i);
+    memcpy(field, (const char*)component + ca->fields[i].offset, ca->fields[i].size);
+    dirty_mark(dirty, field, ca->fields[i].size);
+  }
+}
+
+void component_pool_add(struct component_pool *ca, recs_entity e, void *component, uint32_t tick, struct dirty_tracker *dirty) {
+  uint32_t component_index = component_pool_take_slot(ca, dirty);
+
+  component_pool_scatter(ca, component_index, component, dirty);
 
   ca->comp_to_entity[component_index] = RECS_ENT_ID(e);
-  ca->entity_to_comp[RECS_ENT_ID(e)] = component_index;
+  dirty_mark(dirty, ca->comp_to_entity + component_index, sizeof(uint32_t));
+  sparse_map_set(&ca->entity_to_comp, RECS_ENT_ID(e), component_index, dirty);
+
+  //a new component counts as a change as well
+  if(ca->changed_ticks != NULL) {
+    ca->added_ticks[component_index] = tick;
+    dirty_mark(dirty, ca->added_ticks + component_index, sizeof(uint32_t));
+    component_pool_touch(ca, component_index, tick, dirty);
+  }
+
+  event_queue_push(&ca->events, e, RECS_COMPONENT_ADDED, NULL, dirty);
 
   ca->num_components++;
 
 }
 
-void component_pool_remove(struct component_pool *ca, recs_entity e) {
-  uint32_t component_index = ca->entity_to_comp[RECS_ENT_ID(e)];
+void component_pool_add_bulk(struct component_pool *ca, const recs_entity *entities, uint32_t n, const void *components, uint32_t tick, struct dirty_tracker *dirty) {
+  //fill the free slots one at a time, then copy the rest into the end of the pool
+  while(ca->num_free > 0 && n > 0) {
+    component_pool_add(ca, *entities, (void*)components, tick, dirty);
+    entities++;
+    components = (const char*)components + ca->component_size;
+    n--;
+  }
+
+  RECS_ASSERT(n <= NO_COMP_ID - ca->num_slots);
+  component_pool_reserve(ca, ca->num_slots + n);
+
+  //copy one page at a time (a single memcpy for fixed-size pools), or one component at a time for pools split into fields
+  uint32_t first_index = ca->num_slots;
+  uint32_t copied = 0;
+  for(; ca->num_fields != 0 && copied < n; copied++) {
+    component_pool_scatter(ca, first_index + copied, (const char*)components + ((size_t)ca->component_size * copied), dirty);
+  }
+  while(copied < n) {
+    uint32_t index = first_index + copied;
+    uint64_t page_end = (((uint64_t)index >> ca->page_shift) + 1) << ca->page_shift;
+    uint32_t count = (uint32_t)(page_end - index < n - copied ? page_end - index : n - copied);
+
+    memcpy(component_pool_at(ca, index), (const char*)components + ((size_t)ca->component_size * copied), (size_t)ca->component_size * count);
+    dirty_mark(dirty, component_pool_at(ca, index), (size_t)ca->component_size * count);
+    copied += count;
+  }
+
+  for(uint32_t i = 0; i < n; i++) {
+    ca->comp_to_entity[first_index + i] = RECS_ENT_ID(entities[i]);
+    sparse_map_set(&ca->entity_to_comp, RECS_ENT_ID(entities[i]), first_index + i, dirty);
+  }
+  dirty_mark(dirty, ca->comp_to_entity + first_index, sizeof(uint32_t) * n);
+
+  if(ca->changed_ticks != NULL) {
+    for(uint32_t i = 0; i < n; i++) {
+      ca->added_ticks[first_index + i] = tick;
+      component_pool_touch(ca, first_index + i, tick, dirty);
+    }
+    dirty_mark(dirty, ca->added_ticks + first_index, sizeof(uint32_t) * n);
+  }
+
+  if(ca->occupancy != NULL && n > 0) {
+    for(uint32_t i = first_index; i < first_index + n; i++) {
+      ca->occupancy[i >> 6] |= (uint64_t)1 << (i & 63);
+    }
+    dirty_mark(dirty, ca->occupancy + (first_index >> 6), sizeof(uint64_t) * (((first_index + n - 1) >> 6) - (first_index >> 6) + 1));
+  }
+
+  if(ca->events.capacity != 0) {
+    for(uint32_t i = 0; i < n; i++) {
+      event_queue_push(&ca->events, entities[i], RECS_COMPONENT_ADDED, NULL, dirty);
+    }
+  }
+
+  ca->num_slots += n;
+  ca->num_components += n;
+}
+
+//move the component at index from into the slot at index to, along with its entity mappings and ticks
+static void component_pool_move(struct component_pool *ca, uint32_t from, uint32_t to, struct dirty_tracker *dirty) {
+  if(ca->num_fields == 0) {
+    memcpy(component_pool_at(ca, to), component_pool_at(ca, from), ca->component_size);
+    dirty_mark(dirty, component_pool_at(ca, to), ca->component_size);
+  }
+  for(uint32_t i = 0; i < ca->num_fields; i++) {
+    memcpy(component_pool_field_at(ca, to, i), component_pool_field_at(ca, from, i), ca->fields[i].size);
+    dirty_mark(dirty, component_pool_field_at(ca, to, i), ca->fields[i].size);
+  }
+
+  uint32_t id = ca->comp_to_entity[from];
+  ca->comp_to_entity[to] = id;
+  dirty_mark(dirty, ca->comp_to_entity + to, sizeof(uint32_t));
+  sparse_map_set(&ca->entity_to_comp, id, to, dirty);
+
+  //the moved component keeps its ticks
+  if(ca->changed_ticks != NULL) {
+    ca->added_ticks[to] = ca->added_ticks[from];
+    dirty_mark(dirty, ca->added_ticks + to, sizeof(uint32_t));
+    component_pool_touch(ca, to, ca->changed_ticks[from], dirty);
+  }
+}
+
+//mark the slot at index as no longer holding a component
+static void component_pool_clear_slot(struct component_pool *ca, uint32_t index, struct dirty_tracker *dirty) {
+  ca->comp_to_entity[index] = RECS_NO_ENTITY_ID;
+  dirty_mark(dirty, ca->comp_to_entity + index, sizeof(uint32_t));
+
+  if(ca->occupancy != NULL) {
+    ca->occupancy[index >> 6] &= ~((uint64_t)1 << (index & 63));
+    dirty_mark(dirty, ca->occupancy + (index >> 6), sizeof(uint64_t));
+  }
+}
+
+void component_pool_remove(struct component_pool *ca, recs_entity e, struct dirty_tracker *dirty) {
+  uint32_t component_index = sparse_map_get(&ca->entity_to_comp, RECS_ENT_ID(e));
 
   if(component_index == NO_COMP_ID) {
     return;
   }
-  uint32_t last_component_index = ca->num_components-1;
-  recs_entity entity_at_last_component = ca->comp_to_entity[last_component_index];
 
+  //keep a copy of the component before it gets overwritten. Pools split into fields put it back together inside the event.
+  if(ca->num_fields == 0) {
+    event_queue_push(&ca->events, e, RECS_COMPONENT_REMOVED, component_pool_at(ca, component_index), dirty);
+  } else {
+    void *removed = event_queue_push(&ca->events, e, RECS_COMPONENT_REMOVED, NULL, dirty);
+    if(removed != NULL) {
+      component_pool_gather(ca, component_index, removed);
+      dirty_mark(dirty, removed, ca->component_size);
+    }
+  }
+
+  sparse_map_remove(&ca->entity_to_comp, RECS_ENT_ID(e), dirty);
+  ca->num_components--;
+
+  uint32_t last_slot = ca->num_slots - 1;
+  if(ca->removal_policy == RECS_REMOVAL_STABLE) {
+    component_pool_clear_slot(ca, component_index, dirty);
+
+    //the last slot is handed back rather than kept as a free slot
+    if(component_index == last_slot) {
+      ca->num_slots--;
+    } else {
+      ca->free_slots[ca->num_free] = component_index;
+      dirty_mark(dirty, ca->free_slots + ca->num_free, sizeof(uint32_t));
+      ca->num_free++;
+    }
+    return;
+  }
 
   //move last element to component being removed.
-  //this keeps our list of components contiguous.
-  //NOTE: Whether this has any performance benefits over allowing
-  //our component pool buffer to be sparse is not tested.
-  memcpy(
-    ca->buffer + (ca->component_size * component_index),
-    ca->buffer + (ca->component_size * last_component_index),
-    ca->component_size
-  );
+  //this keeps our list of components contiguous, at the cost of a copy of the component (see RECS_REMOVAL_STABLE).
+  if(component_index != last_slot) {
+    component_pool_move(ca, last_slot, component_index, dirty);
+  }
+  component_pool_clear_slot(ca, last_slot, dirty);
+  ca->num_slots--;
+}
 
-  ca->comp_to_entity[component_index] = entity_at_last_component;
-  ca->entity_to_comp[entity_at_last_component] = component_index;
+//swap size bytes between a and b. Components can be of any size, so they are swapped through a small buffer, a piece at a time.
+static void component_pool_swap_bytes(void *a, void *b, size_t size, struct dirty_tracker *dirty) {
+  unsigned char *bytes_a = (unsigned char*)a;
+  unsigned char *bytes_b = (unsigned char*)b;
+  unsigned char tmp[64];
+  for(size_t offset = 0; offset < size; offset += sizeof(tmp)) {
+    size_t piece = size - offset < sizeof(tmp) ? size - offset : sizeof(tmp);
+    memcpy(tmp, bytes_a + offset, piece);
+    memcpy(bytes_a + offset, bytes_b + offset, piece);
+    memcpy(bytes_b + offset, tmp, piece);
+  }
+  dirty_mark(dirty, a, size);
+  dirty_mark(dirty, b, size);
+}
 
-  ca->comp_to_entity[last_component_index] = RECS_ENT_ID(e);
-  ca->entity_to_comp[RECS_ENT_ID(e)] = NO_COMP_ID;
+void component_pool_swap(struct component_pool *ca, uint32_t a, uint32_t b, struct dirty_tracker *dirty) {
+  RECS_ASSERT(component_pool_slot_used(ca, a) && component_pool_slot_used(ca, b));
+  if(a == b) {
+    return;
+  }
 
-  ca->num_components--;
+  if(ca->num_fields == 0) {
+    component_pool_swap_bytes(component_pool_at(ca, a), component_pool_at(ca, b), ca->component_size, dirty);
+  }
+  for(uint32_t i = 0; i < ca->num_fields; i++) {
+    component_pool_swap_bytes(component_pool_field_at(ca, a, i), component_pool_field_at(ca, b, i), ca->fields[i].size, dirty);
+  }
 
+  uint32_t id_a = ca->comp_to_entity[a];
+  uint32_t id_b = ca->comp_to_entity[b];
+  ca->comp_to_entity[a] = id_b;
+  ca->comp_to_entity[b] = id_a;
+  dirty_mark(dirty, ca->comp_to_entity + a, sizeof(uint32_t));
+  dirty_mark(dirty, ca->comp_to_entity + b, sizeof(uint32_t));
+  sparse_map_set(&ca->entity_to_comp, id_a, b, dirty);
+  sparse_map_set(&ca->entity_to_comp, id_b, a, dirty);
 
+  //both components keep their ticks
+  if(ca->changed_ticks != NULL) {
+    uint32_t added = ca->added_ticks[a];
+    uint32_t changed = ca->changed_ticks[a];
+    ca->added_ticks[a] = ca->added_ticks[b];
+    ca->added_ticks[b] = added;
+    dirty_mark(dirty, ca->added_ticks + a, sizeof(uint32_t));
+    dirty_mark(dirty, ca->added_ticks + b, sizeof(uint32_t));
+    component_pool_touch(ca, a, ca->changed_ticks[b], dirty);
+    component_pool_touch(ca, b, changed, dirty);
+  }
 }
 
+void component_pool_permute(struct component_pool *ca, uint32_t first, uint32_t n, uint32_t *order, struct dirty_tracker *dirty) {
+  //follow each cycle of the permutation, swapping the right component into each slot along it.
+  //Slots are marked as done by pointing order at themselves.
+  for(uint32_t start = 0; start < n; start++) {
+    uint32_t current = start;
+    while(order[current] != current) {
+      uint32_t next = order[current];
+      order[current] = current;
+      if(next == start) break;
+
+      component_pool_swap(ca, first + current, first + next, dirty);
+      current = next;
+    }
+  }
+}
+
+void component_pool_compact(struct component_pool *ca, struct dirty_tracker *dirty) {
+  if(ca->removal_policy != RECS_REMOVAL_STABLE) {
+    return;
+  }
+
+  //move the last component in use into the first free slot until they meet
+  uint32_t first_free = 0;
+  uint32_t end = ca->num_slots;
+  for(;;) {
+    while(first_free < end && component_pool_slot_used(ca, first_free)) first_free++;
+    while(end > first_free && !component_pool_slot_used(ca, end - 1)) end--;
+    if(first_free >= end) break;
+
+    end--;
+    component_pool_move(ca, end, first_free, dirty);
+    component_pool_clear_slot(ca, end, dirty);
+    ca->occupancy[first_free >> 6] |= (uint64_t)1 << (first_free & 63);
+    dirty_mark(dirty, ca->occupancy + (first_free >> 6), sizeof(uint64_t));
+    first_free++;
+  }
+
+  RECS_ASSERT(first_free == ca->num_components);
+  ca->num_slots = ca->num_components;
+  ca->num_free = 0;
+}
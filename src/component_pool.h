@@ -4,6 +4,23 @@
 #include <stdint.h>
 #include <string.h>
 #include "recs.h"
+#include "memory.h"
+#include "sparse_map.h"
+#include "event_queue.h"
+
+#define NO_COMP_ID RECS_NO_ENTITY_ID
+#define NO_GROUP_ID RECS_NO_ENTITY_ID
+#define COMPONENT_POOL_DEFAULT_PAGE_SIZE (16 * 1024)
+
+//pools that track changes keep the highest changed tick of each block of (1 << COMPONENT_POOL_TICK_BLOCK_SHIFT) components
+#define COMPONENT_POOL_TICK_BLOCK_SHIFT 6
+#define COMPONENT_POOL_TICK_BLOCK_MASK (((uint32_t)1 << COMPONENT_POOL_TICK_BLOCK_SHIFT) - 1)
+
+//a field of a component type that is split into fields (see recs_component_field)
+struct component_field {
+  uint32_t offset;
+  uint32_t size;
+};
 
 /* 
   Component Pool Section
@@ -13,16 +30,31 @@
 */
 
 struct component_pool {
-  char *buffer;
+  //component data is split into pages of (1 << page_shift) components. Pools inside a fixed-size RECS instance
+  //have a single page big enough for max_components, while growable pools add pages as they fill up, so
+  //growing a pool never moves the components already inside it.
+  char **pages;
+  uint32_t page_shift;
+  uint32_t num_pages;
+
+  //number of page pointers (and pages worth of comp_to_entity entries) that fit inside the page table of a growable pool.
+  uint32_t max_pages;
+  uint8_t growable;
+
   uint32_t component_size;
 
   uint32_t num_components;
   uint32_t max_components;
+
+  //number of slots in use, including the free slots left behind by RECS_REMOVAL_STABLE.
+  //Pools using RECS_REMOVAL_SWAP have no free slots, so this is always equal to num_components.
+  uint32_t num_slots;
   uint32_t max_entities;
 
-  //rather than implementing a hash map, we will use 
-  //arrays to map entity IDs to component indexes.
-  uint32_t *entity_to_comp;
+  //maps entity IDs to component indexes. Only pages of entity IDs that have the component use memory, so
+  //component types that few entities have stay small. Fixed-size pools store it inside their own buffer, while
+  //growable pools store it inside the RECS instance's entity buffer, since it grows along with the number of entities.
+  struct sparse_map entity_to_comp;
 
   //this is needed since when adding/removing components, we keep 
   //component data contiguous by moving the last component into the component
@@ -30,16 +62,180 @@ struct component_pool {
   //so that we can properly update our entity->comp mapping.
   uint32_t *comp_to_entity;
 
+  //the tick at which the component in each slot was added and last changed, and the highest changed tick of
+  //each block of slots, so that blocks without any changes can be skipped as a whole. Ticks move along with
+  //their components. All 3 are NULL unless the component type tracks changes.
+  uint32_t *added_ticks;
+  uint32_t *changed_ticks;
+  uint32_t *block_ticks;
+  uint8_t track_changes;
+
+  //events for every component added to or removed from the pool, if the component type keeps them.
+  //Fixed-size pools store the queue inside their own buffer, while growable pools allocate it separately.
+  struct event_queue events;
+
+  //pools using RECS_REMOVAL_STABLE never move their components. Removing a component pushes its slot onto
+  //free_slots, which later components reuse, and each bit of occupancy tells if a slot holds a component.
+  //Both are NULL for pools using RECS_REMOVAL_SWAP.
+  uint32_t *free_slots;
+  uint64_t *occupancy;
+  uint32_t num_free;
+  uint8_t removal_policy;
+
+  //the group owning this pool, which keeps its entities inside the first slots of each pool it owns,
+  //in the same order (see recs_group_register()). NO_GROUP_ID if no group owns the pool.
+  uint32_t group;
+
+  //pools of component types split into fields store each field inside a column of its own. Pages are split into blocks of
+  //field_block_size slots, and the column of each field starts (offset * field_block_size) bytes into its block, so blocks
+  //take up as much memory as the same number of whole components would. field_block_mask gets the index of a slot within its block.
+  //num_fields is 0 for pools storing whole components.
+  struct component_field fields[RECS_MAX_COMPONENT_FIELDS];
+  uint32_t num_fields;
+  uint32_t field_block_size;
+  uint32_t field_block_mask;
 };
 
 
-void component_pool_init(struct component_pool *ca, unsigned char *buffer, uint32_t component_size, uint32_t max_components, uint32_t max_entities);
-
-void *component_pool_get(struct component_pool *ca, recs_entity e);
-
-
-void component_pool_add(struct component_pool *ca, recs_entity e, void *component);
-void component_pool_remove(struct component_pool *ca, recs_entity e);
+//get the number of value pages entity_to_comp needs. A pool can never use more pages than it has components.
+static inline uint32_t component_pool_sparse_pages(uint32_t max_components, uint32_t max_entities) {
+  uint32_t id_pages = sparse_map_num_id_pages(max_entities);
+  return max_components < id_pages ? max_components : id_pages;
+}
+
+//get the number of bytes a fixed-size component pool needs for its buffers
+size_t component_pool_buffer_size(const struct recs_init_config_component *config, uint32_t max_entities);
+
+void component_pool_init(struct component_pool *ca, unsigned char *buffer, const struct recs_init_config_component *config, uint32_t max_entities);
+
+//initialize a pool that stores its components inside separately allocated pages of roughly page_size bytes
+//(COMPONENT_POOL_DEFAULT_PAGE_SIZE if 0), allocating enough pages for config->max_components. Returns 0 if an allocation failed.
+uint8_t component_pool_init_growable(struct component_pool *ca, const struct recs_init_config_component *config, uint32_t page_size, uint32_t max_entities);
+
+//free the pages (and event queue) of a growable pool
+void component_pool_free_pages(struct component_pool *ca);
+
+//get the number of bytes allocated for the pages (and event queue) of a growable pool (0 for fixed-size pools)
+size_t component_pool_pages_size(const struct component_pool *ca);
+
+//give ca (a copy of the growable pool og) its own copy of og's pages and event queue. Returns 0 if an allocation failed,
+//in which case ca only owns the memory copied so far.
+uint8_t component_pool_copy_pages(struct component_pool *ca, const struct component_pool *og);
+
+//move the pool's component buffers from one copy of the RECS buffer to another (fixed-size pools only)
+void component_pool_relocate(struct component_pool *ca, const void *old_base, void *new_base);
+
+//report the parts of a fixed-size pool's buffer in use: its page table, its slots, the entity->component
+//mappings of the first num_ids entity IDs, its free slots, and its pending events. The pool struct itself is not reported.
+void component_pool_ranges(const struct component_pool *ca, uint32_t num_ids, memory_range_func func, void *userdata);
+
+//get the address of the component stored at a specific index. Pools split into fields hold no whole components.
+static inline void *component_pool_at(struct component_pool *ca, uint32_t index) {
+  RECS_ASSERT(ca->num_fields == 0);
+  uint64_t page_mask = ((uint64_t)1 << ca->page_shift) - 1;
+  return ca->pages[(uint64_t)index >> ca->page_shift] + ((size_t)ca->component_size * (index & page_mask));
+}
+
+//get the address of a field of the component stored at a specific index, inside a pool split into fields
+static inline void *component_pool_field_at(const struct component_pool *ca, uint32_t index, uint32_t field) {
+  uint32_t page_index = (uint32_t)(index & (((uint64_t)1 << ca->page_shift) - 1));
+  uint32_t block_index = page_index & ca->field_block_mask;
+  const struct component_field *f = ca->fields + field;
+  return ca->pages[(uint64_t)index >> ca->page_shift] + ((size_t)(page_index - block_index) * ca->component_size) +
+    ((size_t)f->offset * ca->field_block_size) + ((size_t)block_index * f->size);
+}
+
+//check if the slot at index holds a component
+static inline uint8_t component_pool_slot_used(const struct component_pool *ca, uint32_t index) {
+  if(ca->occupancy == NULL) {
+    return index < ca->num_components;
+  }
+  return index < ca->num_slots && ((ca->occupancy[index >> 6] >> (index & 63)) & 1);
+}
+
+//get an entity's component, or NULL if it does not have one. Pools split into fields hold no whole components, so they always return NULL.
+static inline void *component_pool_get(struct component_pool *ca, recs_entity e) {
+  uint32_t component_index = sparse_map_get(&ca->entity_to_comp, RECS_ENT_ID(e));
+
+  if(component_index == NO_COMP_ID || ca->num_fields != 0) {
+    return NULL;
+  }
+  return component_pool_at(ca, component_index);
+}
+
+
+//stamp the component at index as changed at tick (does nothing if the pool does not track changes)
+static inline void component_pool_touch(struct component_pool *ca, uint32_t index, uint32_t tick, struct dirty_tracker *dirty) {
+  if(ca->changed_ticks == NULL) {
+    return;
+  }
+
+  ca->changed_ticks[index] = tick;
+  dirty_mark(dirty, ca->changed_ticks + index, sizeof(uint32_t));
+
+  uint32_t *block = ca->block_ticks + (index >> COMPONENT_POOL_TICK_BLOCK_SHIFT);
+  if(*block < tick) {
+    *block = tick;
+    dirty_mark(dirty, block, sizeof(uint32_t));
+  }
+}
+
+//get an entity's component before writing to it, marking it as changed at tick. Like component_pool_get(), this returns NULL
+//for pools split into fields, without marking anything.
+static inline void *component_pool_get_mut(struct component_pool *ca, recs_entity e, uint32_t tick, struct dirty_tracker *dirty) {
+  uint32_t component_index = sparse_map_get(&ca->entity_to_comp, RECS_ENT_ID(e));
+
+  if(component_index == NO_COMP_ID || ca->num_fields != 0) {
+    return NULL;
+  }
+  void *component = component_pool_at(ca, component_index);
+  dirty_mark(dirty, component, ca->component_size);
+  component_pool_touch(ca, component_index, tick, dirty);
+  return component;
+}
+
+//check if the component at index was added (or changed, if added_only is 0) after since_tick
+static inline uint8_t component_pool_changed_since(const struct component_pool *ca, uint32_t index, uint8_t added_only, uint32_t since_tick) {
+  return (added_only ? ca->added_ticks[index] : ca->changed_ticks[index]) > since_tick;
+}
+
+//check if any component inside the block holding index may have changed after since_tick
+static inline uint8_t component_pool_block_changed_since(const struct component_pool *ca, uint32_t index, uint32_t since_tick) {
+  return ca->block_ticks[index >> COMPONENT_POOL_TICK_BLOCK_SHIFT] > since_tick;
+}
+
+
+//make room for at least num_slots slots. Only growable pools can grow, others assert instead.
+void component_pool_reserve(struct component_pool *ca, uint32_t num_slots);
+
+//the following functions mark the memory they write to inside dirty (which may be NULL).
+//The pool struct itself is not marked.
+
+//tick is the tick the new components are stamped with, when the pool tracks changes.
+//Pools that keep events push one for every component added or removed.
+
+void component_pool_add(struct component_pool *ca, recs_entity e, void *component, uint32_t tick, struct dirty_tracker *dirty);
+
+//add components to n entities that do not have one yet. components points to n contiguous components,
+//which are copied into the end of the pool with a single memcpy (unless free slots need to be reused first).
+void component_pool_add_bulk(struct component_pool *ca, const recs_entity *entities, uint32_t n, const void *components, uint32_t tick, struct dirty_tracker *dirty);
+void component_pool_remove(struct component_pool *ca, recs_entity e, struct dirty_tracker *dirty);
+
+//copy the component at index into component, putting its fields back together if the pool is split into fields
+void component_pool_gather(const struct component_pool *ca, uint32_t index, void *component);
+
+//overwrite the component at index with component, splitting it into fields if the pool is split into fields
+void component_pool_scatter(struct component_pool *ca, uint32_t index, const void *component, struct dirty_tracker *dirty);
+
+//swap the components in slots a and b (which must both hold a component), along with their entity mappings and ticks
+void component_pool_swap(struct component_pool *ca, uint32_t a, uint32_t b, struct dirty_tracker *dirty);
+
+//reorder the n components starting at slot first, so that slot (first + i) ends up with the component that was in slot (first + order[i]).
+//order must be a permutation of 0 to n - 1, and is overwritten.
+void component_pool_permute(struct component_pool *ca, uint32_t first, uint32_t n, uint32_t *order, struct dirty_tracker *dirty);
+
+//move the components at the end of a RECS_REMOVAL_STABLE pool into its free slots, until no free slots are left
+void component_pool_compact(struct component_pool *ca, struct dirty_tracker *dirty);
 
 
 #endif// COMPONENT_POOL_H
@@ -0,0 +1,52 @@
+#include "dirty.h"
+
+
+void dirty_init(struct dirty_tracker *dt, uint8_t *base, size_t size, uint32_t *chunk_ticks, uint32_t chunk_shift) {
+  dt->base = base;
+  dt->size = size;
+  dt->chunk_ticks = chunk_ticks;
+  dt->chunk_shift = chunk_shift;
+  dt->num_chunks = dirty_num_chunks(size, chunk_shift);
+
+  //tick 0 is older than every copy, so every chunk starts out clean
+  memset(chunk_ticks, 0, sizeof(uint32_t) * dt->num_chunks);
+  dt->tick = 1;
+}
+
+size_t dirty_copy_since(struct dirty_tracker *dt, uint32_t since_tick, uint8_t *dst, const uint8_t *src, uint8_t mark) {
+  size_t copied = 0;
+  uint32_t i = 0;
+  while(i < dt->num_chunks) {
+    if(dt->chunk_ticks[i] <= since_tick) {
+      i++;
+      continue;
+    }
+
+    //copy each run of dirty chunks with a single memcpy
+    uint32_t end = i + 1;
+    while(end < dt->num_chunks && dt->chunk_ticks[end] > since_tick) {
+      end++;
+    }
+
+    size_t start_byte = (size_t)i << dt->chunk_shift;
+    size_t end_byte = (size_t)end << dt->chunk_shift;
+    if(end_byte > dt->size) {
+      end_byte = dt->size;
+    }
+    memcpy(dst + start_byte, src + start_byte, end_byte - start_byte);
+    copied += end_byte - start_byte;
+
+    if(mark) {
+      for(uint32_t j = i; j < end; j++) {
+        dt->chunk_ticks[j] = dt->tick;
+      }
+    }
+    i = end;
+  }
+  return copied;
+}
+
+uint32_t dirty_next_tick(struct dirty_tracker *dt) {
+  RECS_ASSERT(dt->tick != UINT32_MAX);
+  return dt->tick++;
+}
@@ -0,0 +1,59 @@
+#ifndef DIRTY_H
+#define DIRTY_H
+
+#include <stdint.h>
+#include <string.h>
+#include "recs.h"
+
+/*
+  Dirty Tracker Section
+
+  Splits a block of memory into chunks of (1 << chunk_shift) bytes, and remembers the tick at which
+  each chunk was last written to. Copies of the memory (such as snapshots) remember the tick they were
+  last synced at, so bringing them up to date only needs to copy the chunks written to since then.
+
+  Every function that writes to tracked memory takes a tracker, which can be NULL when nothing is tracked.
+*/
+
+struct dirty_tracker {
+  //start of the tracked memory
+  uint8_t *base;
+  size_t size;
+
+  //tick at which each chunk was last written to
+  uint32_t *chunk_ticks;
+  uint32_t num_chunks;
+  uint32_t chunk_shift;
+
+  //written into chunk_ticks by every write. Only moves forward when the memory is synced with a copy.
+  uint32_t tick;
+};
+
+//get the number of chunk ticks needed to track size bytes
+static inline uint32_t dirty_num_chunks(size_t size, uint32_t chunk_shift) {
+  return (uint32_t)((size + ((size_t)1 << chunk_shift) - 1) >> chunk_shift);
+}
+
+void dirty_init(struct dirty_tracker *dt, uint8_t *base, size_t size, uint32_t *chunk_ticks, uint32_t chunk_shift);
+
+static inline void dirty_mark(struct dirty_tracker *dt, const void *ptr, size_t size) {
+  if(dt == NULL || size == 0) {
+    return;
+  }
+
+  size_t first = (size_t)((const uint8_t*)ptr - dt->base) >> dt->chunk_shift;
+  size_t last = (size_t)((const uint8_t*)ptr + size - 1 - dt->base) >> dt->chunk_shift;
+  for(size_t i = first; i <= last; i++) {
+    dt->chunk_ticks[i] = dt->tick;
+  }
+}
+
+//copy every chunk written to after since_tick from src to dst, which are both laid out like the tracked memory.
+//If mark is non-zero, the copied chunks are marked as written to at the current tick.
+//Returns the number of bytes copied.
+size_t dirty_copy_since(struct dirty_tracker *dt, uint32_t since_tick, uint8_t *dst, const uint8_t *src, uint8_t mark);
+
+//start a new tick, returning the tick that just ended
+uint32_t dirty_next_tick(struct dirty_tracker *dt);
+
+#endif// DIRTY_H
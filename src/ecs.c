@@ -1,9 +1,29 @@
+#include <stdio.h>
 #include "entity_manager.h"
 #include "bitmask.h"
+#include "column_index.h"
 #include "component_pool.h"
+#include "archetype.h"
+#include "workers.h"
+#include "file_map.h"
 
 struct recs_system {
   recs_system_func func;
+
+  //the components and tags this system reads and writes. Both are NULL if the system
+  //did not declare what it accesses, meaning that it conflicts with every other system.
+  uint8_t *read_mask;
+  uint8_t *write_mask;
+
+  //number of earlier systems in the same group that must finish before this system can run
+  uint32_t num_dependencies;
+
+  //later systems in the same group that conflict with this system
+  uint32_t num_dependents;
+  uint32_t *dependents;
+
+  //the tick this system last ran at, so that it only sees the components that changed since
+  uint32_t last_run_tick;
 };
 
 struct bitmask_list {
@@ -17,9 +37,39 @@ struct system_group_mapper {
   uint32_t starting_index;
 };
 
+//a registered query that keeps a list of every entity that currently matches it.
+struct query_cache {
+  uint8_t *include_bitmask;
+  enum recs_ent_match_op include_op;
+
+  uint8_t *exclude_bitmask;
+  enum recs_ent_match_op exclude_op;
+
+  //dense list of every matching entity
+  uint32_t num_entities;
+  recs_entity *entities;
+
+  //maps entity IDs to their index within the entities list, or NO_COMP_ID
+  //if the entity does not match this query.
+  uint32_t *entity_to_index;
+};
+
+//a registered group, which owns the pools of its components. The entities having every one of them are kept inside
+//the first num_entities slots of each owned pool, in the same order, so the group is walked by index without any lookups.
+struct component_group {
+  recs_component *comps;
+  uint32_t num_comps;
+  uint32_t num_entities;
+};
+
 struct recs {
+  //when using RECS_STORAGE_ARCHETYPE, the component pools only count the number of instances of each
+  //component, and all component data is stored inside the archetype storage instead.
   struct component_pool *recs_component_stores;
 
+  enum recs_storage_type storage;
+  struct archetype_storage archetypes;
+
   uint32_t num_registered_systems;
 
   uint32_t max_registered_components;
@@ -33,6 +83,13 @@ struct recs {
   //used to know what components each entity has
   struct bitmask_list comp_bitmask_list;
 
+  //the same bits as comp_bitmask_list stored as one bitset per component and tag, followed by the sets of entities
+  //queued for removal and active entities
+  struct column_index columns;
+
+  //the fastest mask matching functions supported by this CPU
+  struct bitmask_kernels mask_kernels;
+
   //a user provided pointer that contains extra data about their app state that needs to be seen/modified by
   //an ECS system.
   void *system_context; 
@@ -40,8 +97,52 @@ struct recs {
   struct recs_system *systems;
   struct system_group_mapper *system_group_mappers;
 
+  //used by recs_system_run_parallel() to track how many dependencies of each system are left,
+  //and which systems are ready to run.
+  uint32_t *system_dependencies_left;
+  uint32_t *system_ready_queue;
+
   struct entity_manager ent_man;
 
+  uint32_t num_queries;
+  uint32_t max_queries;
+  struct query_cache *queries;
+
+  uint32_t num_groups;
+  uint32_t max_groups;
+  struct component_group *groups;
+
+  //the size of the one big allocation holding this RECS instance.
+  size_t buffer_size;
+
+  //every buffer indexed by entity ID (see recs_entity_buffer_init()). Inside fixed-size RECS instances, this lies
+  //at the end of the one big allocation. Growable RECS instances keep it inside its own allocation instead,
+  //which is replaced by a bigger one whenever we run out of entity IDs.
+  uint8_t *entity_buffer;
+  size_t entity_buffer_size;
+
+  uint8_t growable;
+
+  //added and changed components are stamped with this tick. It moves forward before and after each system runs,
+  //so every system run (and the writes made between them) gets its own tick.
+  uint32_t change_tick;
+
+  //the tick at which the running system last ran
+  uint32_t system_last_run_tick;
+
+  //tracks which chunks of the one big allocation changed since each snapshot was taken (see recs_snapshot_take()).
+  //chunk_ticks is NULL if snapshot_chunk_size was 0.
+  struct dirty_tracker dirty;
+};
+
+//a copy of the tracked part of a RECS instance's big allocation
+struct recs_snapshot {
+  const struct recs *ecs;
+
+  //the image matches the RECS instance for every chunk that was not written to after this tick
+  uint32_t tick;
+  size_t last_copy_size;
+  uint8_t *image;
 };
 
 
@@ -55,6 +156,35 @@ static inline uint8_t* bitmask_list_get(struct bitmask_list *list, uint32_t inde
   return (list->buffer + (index * list->bytes_per_mask));
 }
 
+//get the tracker that writes to the RECS instance need to be marked in, or NULL if snapshots are disabled
+static inline struct dirty_tracker *recs_dirty(struct recs *ecs) {
+  return ecs->dirty.chunk_ticks != NULL ? &ecs->dirty : NULL;
+}
+
+//get an entity's bitmask row before changing it
+static inline uint8_t *recs_entity_mask_for_write(struct recs *ecs, uint32_t id) {
+  uint8_t *mask = bitmask_list_get(&ecs->comp_bitmask_list, id);
+  dirty_mark(recs_dirty(ecs), mask, ecs->comp_bitmask_size);
+  return mask;
+}
+
+//set or clear one bit of an entity's bitmask row, along with the matching bit of the column index
+static inline void recs_entity_mask_set(struct recs *ecs, uint32_t id, uint32_t bit, uint8_t value) {
+  bitmask_set(recs_entity_mask_for_write(ecs, id), bit, value);
+  column_index_set(&ecs->columns, bit, id, value, recs_dirty(ecs));
+}
+
+//entities stop being active once their version changes, which happens when they are removed or queued for removal
+static inline void recs_entity_version_bump(struct recs *ecs, uint32_t id) {
+  ecs->ent_man.ent_versions_list[id]++;
+  dirty_mark(recs_dirty(ecs), ecs->ent_man.ent_versions_list + id, sizeof(uint32_t));
+  column_index_set(&ecs->columns, ecs->columns.active_column, id, 0, recs_dirty(ecs));
+}
+
+static inline void recs_entity_activate(struct recs *ecs, uint32_t id) {
+  column_index_set(&ecs->columns, ecs->columns.active_column, id, 1, recs_dirty(ecs));
+}
+
 
 //all tags appear AFTER the recs_components with data.
 static inline uint32_t recs_tag_id_to_comp_id(struct recs *ecs, recs_tag tag) {
@@ -64,7 +194,237 @@ static inline uint32_t recs_tag_id_to_comp_id(struct recs *ecs, recs_tag tag) {
 }
 
 
-static inline void recs_system_register(struct recs *ecs, recs_system_func func, recs_system_group group) {
+//check if the entity with this ID is in the active entity pool and was not queued for removal
+static inline uint8_t recs_entity_id_active(struct recs *ecs, uint32_t id) {
+  struct entity_manager *em = &ecs->ent_man;
+  return em->active_index[id] < em->num_active_entities && recs_entity_active(ecs, entity_manager_get(em, id));
+}
+
+static inline int recs_mask_matches(struct recs *ecs, uint8_t *mask_for_entity, uint8_t *mask, enum recs_ent_match_op match_op);
+static inline void* recs_component_lookup(struct recs *ecs, recs_entity e, recs_component c);
+
+//used when every bit of an entity's mask may have changed, such as when it is added or removed.
+#define QUERY_ALL_BITS_CHANGED RECS_NO_ENTITY_ID
+
+//add or remove an entity from a single query based on the entity's current mask
+static void query_cache_update(struct recs *ecs, struct query_cache *q, uint32_t id, uint8_t active, uint8_t *mask_for_entity) {
+  uint8_t matches = active 
+    && (q->include_bitmask == NULL || recs_mask_matches(ecs, mask_for_entity, q->include_bitmask, q->include_op))
+    && (q->exclude_bitmask == NULL || !recs_mask_matches(ecs, mask_for_entity, q->exclude_bitmask, q->exclude_op));
+
+  uint32_t index = q->entity_to_index[id];
+
+  if(matches && index == NO_COMP_ID) {
+    q->entities[q->num_entities] = entity_manager_get(&ecs->ent_man, id);
+    q->entity_to_index[id] = q->num_entities;
+    dirty_mark(recs_dirty(ecs), q->entities + q->num_entities, sizeof(recs_entity));
+    dirty_mark(recs_dirty(ecs), q->entity_to_index + id, sizeof(uint32_t));
+    q->num_entities++;
+  } 
+  else if(!matches && index != NO_COMP_ID) {
+    //move last entity into the hole to keep the list dense
+    recs_entity last = q->entities[q->num_entities-1];
+    q->entities[index] = last;
+    q->entity_to_index[RECS_ENT_ID(last)] = index;
+    q->entity_to_index[id] = NO_COMP_ID;
+    dirty_mark(recs_dirty(ecs), q->entities + index, sizeof(recs_entity));
+    dirty_mark(recs_dirty(ecs), q->entity_to_index + RECS_ENT_ID(last), sizeof(uint32_t));
+    dirty_mark(recs_dirty(ecs), q->entity_to_index + id, sizeof(uint32_t));
+    q->num_entities--;
+  }
+}
+
+//add or remove an entity from each query after one of its components or tags (or its active status) changes.
+static void recs_queries_update(struct recs *ecs, uint32_t id, uint32_t changed_bit) {
+  if(ecs->num_queries == 0) return;
+
+  uint8_t active = recs_entity_id_active(ecs, id);
+  uint8_t *mask_for_entity = bitmask_list_get(&ecs->comp_bitmask_list, id);
+
+  for(uint32_t i = 0; i < ecs->num_queries; i++) {
+    struct query_cache *q = ecs->queries + i;
+
+    //this query does not care about the bit that changed
+    if(changed_bit != QUERY_ALL_BITS_CHANGED 
+      && !(q->include_bitmask != NULL && bitmask_test(q->include_bitmask, changed_bit)) 
+      && !(q->exclude_bitmask != NULL && bitmask_test(q->exclude_bitmask, changed_bit))
+    ) {
+      continue;
+    }
+
+    query_cache_update(ecs, q, id, active, mask_for_entity);
+  }
+}
+
+//move an entity into the group owning c's pool after c was added, if the entity now has every component of the group
+static void recs_group_on_add(struct recs *ecs, uint32_t id, recs_component c) {
+  struct component_pool *pools = ecs->recs_component_stores;
+  if(pools[c].group == NO_GROUP_ID) return;
+
+  struct component_group *g = ecs->groups + pools[c].group;
+  if(sparse_map_get(&pools[c].entity_to_comp, id) < g->num_entities) return;
+  for(uint32_t i = 0; i < g->num_comps; i++) {
+    if(sparse_map_get(&pools[g->comps[i]].entity_to_comp, id) == NO_COMP_ID) return;
+  }
+
+  //swap the entity's components with the first ones after the group, in each pool
+  for(uint32_t i = 0; i < g->num_comps; i++) {
+    struct component_pool *p = pools + g->comps[i];
+    component_pool_swap(p, sparse_map_get(&p->entity_to_comp, id), g->num_entities, recs_dirty(ecs));
+  }
+  g->num_entities++;
+}
+
+//move an entity out of the group owning c's pool before c is removed
+static void recs_group_on_remove(struct recs *ecs, uint32_t id, recs_component c) {
+  struct component_pool *pools = ecs->recs_component_stores;
+  if(pools[c].group == NO_GROUP_ID) return;
+
+  struct component_group *g = ecs->groups + pools[c].group;
+  uint32_t index = sparse_map_get(&pools[c].entity_to_comp, id);
+  if(index == NO_COMP_ID || index >= g->num_entities) return;
+
+  //swap the entity's components with the last ones inside the group, in each pool
+  g->num_entities--;
+  for(uint32_t i = 0; i < g->num_comps; i++) {
+    struct component_pool *p = pools + g->comps[i];
+    component_pool_swap(p, sparse_map_get(&p->entity_to_comp, id), g->num_entities, recs_dirty(ecs));
+  }
+}
+
+
+//one column for each component and tag, plus the sets of queued and active entities
+static inline uint32_t recs_num_columns(struct recs *ecs) {
+  return ecs->max_registered_components + ecs->max_tags + 2;
+}
+
+//get the size of the buffer holding every array indexed by entity ID, when holding max_entities entities
+static size_t recs_entity_buffer_size(struct recs *ecs, uint32_t max_entities) {
+  size_t size = memory_align(sizeof(recs_entity) * max_entities);
+  size += memory_align(sizeof(uint32_t) * max_entities) * 2;
+  size += memory_align(ecs->comp_bitmask_size * max_entities);
+  size += column_index_buffer_size(recs_num_columns(ecs), max_entities);
+
+  //entity_to_comp of each growable component pool, which may end up with a component in every page of entity IDs
+  if(ecs->growable) {
+    size += sparse_map_buffer_size(max_entities, sparse_map_num_id_pages(max_entities)) * ecs->max_registered_components;
+  }
+
+  //the dense entity list and entity->index map of each query
+  size += (memory_align(sizeof(recs_entity) * max_entities) + memory_align(sizeof(uint32_t) * max_entities)) * ecs->max_queries;
+  return size;
+}
+
+//place every array indexed by entity ID inside buffer, which must be able to hold max_entities entities.
+//When growing, the arrays are copied out of the old buffer (which is left untouched), and the
+//entries of the new entity IDs are initialized.
+static void recs_entity_buffer_init(struct recs *ecs, uint8_t *buffer, uint32_t max_entities, uint8_t grow) {
+  uint32_t old_max = grow ? ecs->ent_man.max_entities : 0;
+  size_t ids_size = memory_align(sizeof(recs_entity) * max_entities);
+  size_t index_size = memory_align(sizeof(uint32_t) * max_entities);
+
+  uint8_t *entity_id_buffer = buffer;
+  uint8_t *entity_version_buffer = entity_id_buffer + ids_size;
+  uint8_t *entity_index_buffer = entity_version_buffer + index_size;
+  if(grow) {
+    entity_manager_grow(&ecs->ent_man, entity_id_buffer, entity_version_buffer, entity_index_buffer, max_entities);
+  } else {
+    entity_manager_init(&ecs->ent_man, entity_id_buffer, entity_version_buffer, entity_index_buffer, max_entities);
+  }
+  uint8_t *next_buffer = entity_index_buffer + index_size;
+
+  //entities that were never used have no components or tags
+  if(grow) {
+    memcpy(next_buffer, ecs->comp_bitmask_list.buffer, ecs->comp_bitmask_size * old_max);
+  }
+  memset(next_buffer + (ecs->comp_bitmask_size * old_max), 0, ecs->comp_bitmask_size * (max_entities - old_max));
+  bitmask_list_init(&ecs->comp_bitmask_list, ecs->comp_bitmask_size, next_buffer);
+  next_buffer += memory_align(ecs->comp_bitmask_size * max_entities);
+
+  struct column_index old_columns = ecs->columns;
+  column_index_init(&ecs->columns, next_buffer, recs_num_columns(ecs), max_entities, grow ? &old_columns : NULL);
+  next_buffer += column_index_buffer_size(recs_num_columns(ecs), max_entities);
+
+  for(uint32_t c = 0; c < ecs->max_registered_components && ecs->growable; c++) {
+    struct component_pool *p = ecs->recs_component_stores + c;
+    uint32_t max_pages = sparse_map_num_id_pages(max_entities);
+    if(grow) {
+      sparse_map_grow(&p->entity_to_comp, next_buffer, max_entities, max_pages);
+    } else {
+      sparse_map_init(&p->entity_to_comp, next_buffer, max_entities, max_pages);
+    }
+    p->max_entities = max_entities;
+    next_buffer += sparse_map_buffer_size(max_entities, max_pages);
+  }
+
+  for(uint32_t i = 0; i < ecs->max_queries; i++) {
+    struct query_cache *q = ecs->queries + i;
+    recs_entity *entities = (recs_entity*)next_buffer;
+    uint32_t *entity_to_index = (uint32_t*)(next_buffer + ids_size);
+    if(grow) {
+      memcpy(entities, q->entities, sizeof(recs_entity) * q->num_entities);
+      memcpy(entity_to_index, q->entity_to_index, sizeof(uint32_t) * old_max);
+    }
+    for(uint32_t j = old_max; j < max_entities; j++) {
+      entity_to_index[j] = NO_COMP_ID;
+    }
+    q->entities = entities;
+    q->entity_to_index = entity_to_index;
+    next_buffer += ids_size + index_size;
+  }
+}
+
+//move every array indexed by entity ID from one copy of the entity buffer to another
+static void recs_entity_buffer_relocate(struct recs *ecs, const void *old_base, void *new_base) {
+  entity_manager_relocate(&ecs->ent_man, old_base, new_base);
+  ecs->comp_bitmask_list.buffer = memory_relocate(ecs->comp_bitmask_list.buffer, old_base, new_base);
+  column_index_relocate(&ecs->columns, old_base, new_base);
+
+  for(uint32_t i = 0; i < ecs->max_registered_components && ecs->growable; i++) {
+    sparse_map_relocate(&ecs->recs_component_stores[i].entity_to_comp, old_base, new_base);
+  }
+
+  for(uint32_t i = 0; i < ecs->max_queries; i++) {
+    struct query_cache *q = ecs->queries + i;
+    q->entities = memory_relocate(q->entities, old_base, new_base);
+    q->entity_to_index = memory_relocate(q->entity_to_index, old_base, new_base);
+  }
+}
+
+//make sure there are enough unused entity IDs to add n entities. Growable RECS instances move their
+//entity buffer into an allocation at least twice as big, while fixed-size RECS instances assert instead.
+static void recs_entities_reserve(struct recs *ecs, uint32_t n) {
+  struct entity_manager *em = &ecs->ent_man;
+  if(n <= em->max_entities - em->num_active_entities) return;
+
+  RECS_ASSERT(ecs->growable);
+
+  //the largest 32-bit unsigned integer is used as a marker for something with no entities
+  uint64_t needed = (uint64_t)em->num_active_entities + n;
+  RECS_ASSERT(needed <= RECS_NO_ENTITY_ID);
+
+  uint64_t max_entities = em->max_entities;
+  while(max_entities < needed) {
+    max_entities *= 2;
+  }
+  if(max_entities > RECS_NO_ENTITY_ID) {
+    max_entities = RECS_NO_ENTITY_ID;
+  }
+
+  size_t size = recs_entity_buffer_size(ecs, (uint32_t)max_entities);
+  uint8_t *buffer = (uint8_t*)RECS_MALLOC(size);
+  RECS_ASSERT(buffer != NULL);
+
+  uint8_t *old_buffer = ecs->entity_buffer;
+  recs_entity_buffer_init(ecs, buffer, (uint32_t)max_entities, 1);
+  RECS_FREE(old_buffer);
+
+  ecs->entity_buffer = buffer;
+  ecs->entity_buffer_size = size;
+}
+
+
+static inline void recs_system_register(struct recs *ecs, struct recs_system system, recs_system_group group) {
   RECS_ASSERT(ecs->num_registered_systems < ecs->max_registered_systems);
 
 
@@ -77,8 +437,7 @@ static inline void recs_system_register(struct recs *ecs, recs_system_func func,
   if(m->num_systems == 0) {
     m->num_systems = 1;
     m->starting_index = ecs->num_registered_systems;
-    struct recs_system *s = ecs->systems + ecs->num_registered_systems;
-    s->func = func;
+    ecs->systems[ecs->num_registered_systems] = system;
 
 
   } else {
@@ -100,7 +459,7 @@ static inline void recs_system_register(struct recs *ecs, recs_system_func func,
 
 
     //place new system at correct index
-    ecs->systems[system_index].func = func;
+    ecs->systems[system_index] = system;
 
     //update mapper
     m->num_systems++;
@@ -112,10 +471,71 @@ static inline void recs_system_register(struct recs *ecs, recs_system_func func,
 }
 
 
+//check if 2 systems cannot run at the same time
+static uint8_t recs_systems_conflict(struct recs *ecs, struct recs_system *a, struct recs_system *b) {
+  if(a->read_mask == NULL || b->read_mask == NULL) {
+    return 1;
+  }
+
+  for(uint32_t i = 0; i < ecs->comp_bitmask_size; i++) {
+    if((a->write_mask[i] & (b->read_mask[i] | b->write_mask[i])) || (b->write_mask[i] & a->read_mask[i])) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+//connect each system to the later systems in its group that it conflicts with, so that
+//they keep running in registration order when run in parallel.
+static void recs_system_build_dependencies(struct recs *ecs, uint32_t *edge_buffer) {
+  for(uint32_t i = 0; i < ecs->num_registered_systems; i++) {
+    ecs->systems[i].num_dependencies = 0;
+  }
+
+  for(uint32_t g = 0; g < ecs->max_system_groups; g++) {
+    struct system_group_mapper *m = ecs->system_group_mappers + g;
+    uint32_t end = m->starting_index + m->num_systems;
+
+    for(uint32_t i = m->starting_index; i < end && m->num_systems != 0; i++) {
+      struct recs_system *s = ecs->systems + i;
+      s->dependents = edge_buffer;
+      s->num_dependents = 0;
+
+      for(uint32_t j = i + 1; j < end; j++) {
+        if(recs_systems_conflict(ecs, s, ecs->systems + j)) {
+          s->dependents[s->num_dependents++] = j;
+          ecs->systems[j].num_dependencies++;
+        }
+      }
+      edge_buffer += s->num_dependents;
+    }
+  }
+}
+
+
 uint32_t recs_num_active_entities(struct recs *recs) {
   return recs->ent_man.num_active_entities;
 }
 
+uint32_t recs_num_matching_entities(struct recs *ecs, uint8_t *include_mask, enum recs_ent_match_op include_op, uint8_t *exclude_mask, enum recs_ent_match_op exclude_op) {
+  struct column_query q;
+  if(column_query_init(&q, include_mask, include_op, exclude_mask, exclude_op, (uint32_t)ecs->comp_bitmask_size)) {
+    return column_index_count(&ecs->columns, &q, ecs->ent_man.num_used_ids);
+  }
+
+  //too many columns to combine, so check each entity's bitmask row instead
+  uint32_t count = 0;
+  for(uint32_t i = 0; i < ecs->ent_man.num_active_entities; i++) {
+    recs_entity e = ecs->ent_man.entity_pool[i];
+    if(!recs_entity_active(ecs, e)) continue;
+
+    uint8_t *mask_for_entity = bitmask_list_get(&ecs->comp_bitmask_list, RECS_ENT_ID(e));
+    count += (include_mask == NULL || recs_mask_matches(ecs, mask_for_entity, include_mask, include_op))
+      && (exclude_mask == NULL || !recs_mask_matches(ecs, mask_for_entity, exclude_mask, exclude_op));
+  }
+  return count;
+}
+
 
 // Initialize the ECS.
 // Note that you must provide all of the component types and systems you will use for this ECS into the configuration
@@ -130,6 +550,12 @@ recs recs_init(const struct recs_init_config config) {
   //integer is used as a marker for something with no entities
   RECS_ASSERT(config.max_entities-1 != RECS_NO_ENTITY_ID);
 
+  //the archetype tables are laid out for a fixed number of entities and chunks
+  RECS_ASSERT(!(config.growable && config.storage == RECS_STORAGE_ARCHETYPE));
+
+  //snapshots only track the one big allocation
+  RECS_ASSERT(!(config.growable && config.snapshot_chunk_size != 0));
+
   size_t bytes_per_bitmask = RECS_GET_BITMASK_SIZE(config.max_component_types, config.max_tags);
 
   struct recs ecs_static = {
@@ -138,13 +564,15 @@ recs recs_init(const struct recs_init_config config) {
     .max_system_groups = config.max_system_groups,
     .max_tags = config.max_tags,
     .comp_bitmask_size = bytes_per_bitmask,
+    .mask_kernels = bitmask_kernels_select(bytes_per_bitmask),
     .system_context = config.context,
     .num_registered_systems = 0,
     .ent_man = {
       .max_entities = config.max_entities,
       .num_active_entities = 0,
       .entity_pool = NULL,
-      .ent_versions_list = NULL
+      .ent_versions_list = NULL,
+      .active_index = NULL
     },
     .comp_bitmask_list = {
       .bytes_per_mask = bytes_per_bitmask,
@@ -152,41 +580,112 @@ recs recs_init(const struct recs_init_config config) {
     },
     .systems = NULL,
     .system_group_mappers = NULL,
-    .recs_component_stores = NULL
+    .system_dependencies_left = NULL,
+    .system_ready_queue = NULL,
+    .recs_component_stores = NULL,
+    .storage = config.storage,
+    .archetypes = {0},
+    .num_queries = 0,
+    .max_queries = config.max_queries,
+    .queries = NULL,
+    .num_groups = 0,
+    .max_groups = config.max_groups,
+    .groups = NULL,
+    .buffer_size = 0,
+    .entity_buffer = NULL,
+    .entity_buffer_size = 0,
+    .growable = config.growable,
+    .change_tick = 1,
+    .system_last_run_tick = 0
   };
 
 
 
-  //get sizes needed for each buffer needed in the RECS
-  size_t recs_buffer_size = sizeof(struct recs);
-  size_t entity_id_buffer_size = sizeof(recs_entity) * config.max_entities;
-  size_t entity_version_buffer_size = sizeof(uint32_t) * config.max_entities;
-  size_t bitmask_buffer_size = bytes_per_bitmask * config.max_entities;
-  size_t system_buffer_size = sizeof(struct recs_system) * config.max_systems;
-  size_t system_mapper_buffer_size = sizeof(struct system_group_mapper) * config.max_system_groups;
-  size_t component_pool_buffer_size = sizeof(struct component_pool) * config.max_component_types;
+  //get sizes needed for each buffer needed in the RECS.
+  //Each size is aligned so that every buffer starts at a properly aligned address.
+  size_t recs_buffer_size = memory_align(sizeof(struct recs));
+  size_t system_buffer_size = memory_align(sizeof(struct recs_system) * config.max_systems);
+  size_t system_mapper_buffer_size = memory_align(sizeof(struct system_group_mapper) * config.max_system_groups);
+  size_t component_pool_list_size = memory_align(sizeof(struct component_pool) * config.max_component_types);
+
+  //each query stores a copy of its 2 masks. Its dense list of entities and sparse entity->index map
+  //are stored inside the entity buffer.
+  size_t query_list_size = memory_align(sizeof(struct query_cache) * config.max_queries);
+  size_t query_inner_buffer_size = memory_align(bytes_per_bitmask * 2);
+
+  //each group stores the list of components it owns
+  size_t group_list_size = memory_align(sizeof(struct component_group) * config.max_groups);
+  size_t group_inner_buffer_size = memory_align(sizeof(recs_component) * config.max_component_types);
+
+  //each system stores a read and write mask. In the worst case, every system conflicts with 
+  //every later system inside its group.
+  size_t max_system_edges = 0;
+  for(uint32_t i = 0; i < config.max_systems; i++) {
+    for(uint32_t j = 0; j < i; j++) {
+      max_system_edges += config.systems[i].group == config.systems[j].group;
+    }
+  }
+  size_t system_access_buffer_size = memory_align(bytes_per_bitmask * 2 * config.max_systems);
+  size_t system_edge_buffer_size = memory_align(sizeof(uint32_t) * max_system_edges);
+  size_t system_schedule_buffer_size = memory_align(sizeof(uint32_t) * config.max_systems);
 
 
   //get size for each component_pool's buffer
   size_t final_size = 0;
-  final_size += recs_buffer_size + entity_id_buffer_size + entity_version_buffer_size + component_pool_buffer_size;
-  final_size += bitmask_buffer_size + system_buffer_size + system_mapper_buffer_size;
+  final_size += recs_buffer_size + component_pool_list_size;
+  final_size += system_buffer_size + system_mapper_buffer_size;
+  final_size += query_list_size + (query_inner_buffer_size * config.max_queries);
+  final_size += group_list_size + (group_inner_buffer_size * config.max_groups);
+  final_size += system_access_buffer_size + system_edge_buffer_size + (system_schedule_buffer_size * 2);
 
   size_t component_pool_inner_buffer_size = 0;
   for(uint32_t i = 0; i < config.max_component_types; i++) {
     RECS_ASSERT(config.components[i].max_components <= config.max_entities);
     RECS_ASSERT(config.components[i].comp_size > 0);
 
-    size_t comp_buffer_size = config.components[i].comp_size * config.components[i].max_components;
-    size_t ent_to_comp_buffer_size = sizeof(uint32_t) * config.max_entities;
-    size_t comp_to_ent_buffer_size = sizeof(uint32_t) * config.components[i].max_components;
+    //the archetype tables do not keep ticks or events
+    RECS_ASSERT(!(config.components[i].track_changes && config.storage == RECS_STORAGE_ARCHETYPE));
+    RECS_ASSERT(!(config.components[i].max_events && config.storage == RECS_STORAGE_ARCHETYPE));
+    RECS_ASSERT(!(config.components[i].removal_policy == RECS_REMOVAL_STABLE && config.storage == RECS_STORAGE_ARCHETYPE));
+    RECS_ASSERT(!(config.components[i].num_fields && config.storage == RECS_STORAGE_ARCHETYPE));
 
+    //the archetype tables store the component data instead, while growable pools allocate their own pages
+    if(config.storage == RECS_STORAGE_ARCHETYPE || config.growable) continue;
 
-    component_pool_inner_buffer_size += comp_buffer_size + ent_to_comp_buffer_size + comp_to_ent_buffer_size;
+    component_pool_inner_buffer_size += component_pool_buffer_size(config.components + i, config.max_entities);
   }
 
   final_size += component_pool_inner_buffer_size;
 
+  uint32_t archetype_chunk_size = 0;
+  uint32_t num_archetype_chunks = 0;
+  uint32_t max_archetypes = 0;
+  size_t archetype_buffer_size = 0;
+  if(config.storage == RECS_STORAGE_ARCHETYPE) {
+    archetype_storage_dimensions(&config, &archetype_chunk_size, &num_archetype_chunks, &max_archetypes);
+    archetype_buffer_size = archetype_storage_buffer_size(config.max_entities, config.max_component_types, bytes_per_bitmask, max_archetypes, archetype_chunk_size, num_archetype_chunks);
+  }
+
+  final_size += archetype_buffer_size;
+
+  //every buffer indexed by entity ID goes at the end of the big buffer, unless it needs to grow
+  size_t entity_buffer_size = recs_entity_buffer_size(&ecs_static, config.max_entities);
+  if(!config.growable) {
+    final_size += entity_buffer_size;
+  }
+
+  //the tick of each chunk goes after everything it tracks
+  size_t tracked_size = final_size;
+  uint32_t chunk_shift = 0;
+  size_t chunk_ticks_size = 0;
+  if(config.snapshot_chunk_size != 0) {
+    while(((size_t)1 << chunk_shift) < config.snapshot_chunk_size) {
+      chunk_shift++;
+    }
+    chunk_ticks_size = memory_align(sizeof(uint32_t) * dirty_num_chunks(tracked_size, chunk_shift));
+  }
+  final_size += chunk_ticks_size;
+
 
 
   //allocate one big buffer that will store ALL of the ECS data
@@ -199,22 +698,10 @@ recs recs_init(const struct recs_init_config config) {
 
   //copy static ecs to allocated ecs
   *ecs = ecs_static;
-
-  //init the entity manager
-  uint8_t *entity_id_buffer =      big_buffer + recs_buffer_size;
-  uint8_t *entity_version_buffer = entity_id_buffer + entity_id_buffer_size;
-  entity_manager_init(&ecs->ent_man, entity_id_buffer, entity_version_buffer, config.max_entities);
-
-  //init the entity-component bitmask list
-  uint8_t *bitmask_buffer =        entity_version_buffer + entity_version_buffer_size;
-  bitmask_list_init(&ecs->comp_bitmask_list, ecs->comp_bitmask_size, bitmask_buffer);
-  for(uint32_t i = 0; i < config.max_entities; i++) {
-    uint8_t *mask = bitmask_list_get(&ecs->comp_bitmask_list, i);
-    bitmask_clear(mask, 0, bytes_per_bitmask);
-  }
+  ecs->buffer_size = final_size;
 
   //init the system mappers and systems list
-  uint8_t *system_buffer =         bitmask_buffer + bitmask_buffer_size;
+  uint8_t *system_buffer =         big_buffer + recs_buffer_size;
   uint8_t *system_mapper_buffer =  system_buffer + system_buffer_size;
   ecs->systems = (struct recs_system*)system_buffer;
   ecs->system_group_mappers = (struct system_group_mapper*)system_mapper_buffer;
@@ -222,263 +709,1705 @@ recs recs_init(const struct recs_init_config config) {
   for(uint32_t i = 0; i < config.max_system_groups; i++) {
     ecs->system_group_mappers[i].num_systems = 0;
   }
-  //register each system
-  for(uint32_t i = 0; i < config.max_systems; i++) {
-    recs_system_register(ecs, config.systems[i].func, config.systems[i].group);
-  }
 
-
-  //init the component pool list
+  //init the component pool list. Pools start out zeroed so that recs_free() can be called if allocating pages fails.
   uint8_t *component_pool_buffer = system_mapper_buffer + system_mapper_buffer_size;
   ecs->recs_component_stores = (struct component_pool*) component_pool_buffer;
+  memset(ecs->recs_component_stores, 0, sizeof(struct component_pool) * config.max_component_types);
   
 
   //set up the buffer for each component pool
-  unsigned char *next_buffer = component_pool_buffer + component_pool_buffer_size;
+  unsigned char *next_buffer = component_pool_buffer + component_pool_list_size;
   for(uint32_t i = 0; i < config.max_component_types; i++) {
-    RECS_ASSERT(config.components[i].comp_size > 0);
-    
-    size_t comp_buffer_size = config.components[i].comp_size * config.components[i].max_components;
-    size_t ent_to_comp_buffer_size = sizeof(uint32_t) * config.max_entities;
-    //only allocate to max_components since that is usually equal to 
-    //or less than the max_entities, making memory storage slightly more efficient.
-    size_t comp_to_ent_buffer_size = sizeof(uint32_t) * config.components[i].max_components;
+    if(config.storage == RECS_STORAGE_ARCHETYPE) {
+      //the pool only keeps track of the number of instances
+      struct component_pool *p = ecs->recs_component_stores + config.components[i].type;
+      p->pages = NULL;
+      p->comp_to_entity = NULL;
+      p->component_size = config.components[i].comp_size;
+      p->num_components = 0;
+      p->max_components = config.components[i].max_components;
+      p->max_entities = config.max_entities;
+      p->group = NO_GROUP_ID;
+      continue;
+    }
 
+    if(config.growable) {
+      if(!component_pool_init_growable(ecs->recs_component_stores + config.components[i].type, config.components + i, config.component_page_size, config.max_entities)) {
+        recs_free(ecs);
+        return NULL;
+      }
+      continue;
+    }
 
-    component_pool_init(
-      ecs->recs_component_stores + config.components[i].type, 
-      next_buffer, 
-      config.components[i].comp_size, 
-      config.components[i].max_components,
-      config.max_entities
-    );
+    component_pool_init(ecs->recs_component_stores + config.components[i].type, next_buffer, config.components + i, config.max_entities);
 
-    next_buffer += comp_buffer_size + ent_to_comp_buffer_size + comp_to_ent_buffer_size;
+    next_buffer += component_pool_buffer_size(config.components + i, config.max_entities);
   }
 
+  //set up the buffers for each query. Queries are registered later using recs_query_register().
+  ecs->queries = (struct query_cache*) next_buffer;
+  next_buffer += query_list_size;
+  for(uint32_t i = 0; i < config.max_queries; i++) {
+    struct query_cache *q = ecs->queries + i;
+    q->include_bitmask = next_buffer;
+    q->exclude_bitmask = next_buffer + bytes_per_bitmask;
+    q->entities = NULL;
+    q->entity_to_index = NULL;
+    q->num_entities = 0;
+
+    next_buffer += query_inner_buffer_size;
+  }
 
-  return ecs;
-  
-}
-
-recs recs_copy(recs og) {
+  //set up the buffers for each group. Groups are registered later using recs_group_register().
+  ecs->groups = (struct component_group*) next_buffer;
+  next_buffer += group_list_size;
+  for(uint32_t i = 0; i < config.max_groups; i++) {
+    struct component_group *g = ecs->groups + i;
+    g->comps = (recs_component*)next_buffer;
+    g->num_comps = 0;
+    g->num_entities = 0;
 
+    next_buffer += group_inner_buffer_size;
+  }
 
-  //since the entire ECS lies inside a single contiguous block of memory,
-  //all we have to do is:
-  //1. Allocate another buffer with the same size
-  //2. Copy the contents of the old buffer to the new one
-  //3. Update all the pointers to point to addresses that lie inside the new buffer
+  //register each system along with what it reads and writes
+  uint8_t *system_access_buffer = next_buffer;
+  next_buffer += system_access_buffer_size;
+  for(uint32_t i = 0; i < config.max_systems; i++) {
+    const struct recs_init_config_system *cs = config.systems + i;
+    struct recs_system s = {
+      .func = cs->func,
+      .read_mask = NULL,
+      .write_mask = NULL,
+      .num_dependencies = 0,
+      .num_dependents = 0,
+      .dependents = NULL,
+      .last_run_tick = 0
+    };
+
+    if(cs->num_read_comps + cs->num_write_comps + cs->num_read_tags + cs->num_write_tags > 0) {
+      s.read_mask = system_access_buffer + (bytes_per_bitmask * 2 * i);
+      s.write_mask = s.read_mask + bytes_per_bitmask;
+      recs_bitmask_create(ecs, s.read_mask, cs->num_read_comps, cs->read_comps, cs->num_read_tags, cs->read_tags);
+      recs_bitmask_create(ecs, s.write_mask, cs->num_write_comps, cs->write_comps, cs->num_write_tags, cs->write_tags);
+    }
 
-  //The 3rd step is easier said than done though, since we need to set up this buffer
-  //the EXACT same way as we do in recs_init()
+    recs_system_register(ecs, s, cs->group);
+  }
 
+  recs_system_build_dependencies(ecs, (uint32_t*)next_buffer);
+  next_buffer += system_edge_buffer_size;
 
-  size_t bytes_per_bitmask = RECS_GET_BITMASK_SIZE(og->max_registered_components, og->max_tags);
+  ecs->system_dependencies_left = (uint32_t*)next_buffer;
+  next_buffer += system_schedule_buffer_size;
+  ecs->system_ready_queue = (uint32_t*)next_buffer;
+  next_buffer += system_schedule_buffer_size;
 
-  //perform shallow copy of original RECS to new instance.
-  struct recs ecs_static = *og;
+  if(config.storage == RECS_STORAGE_ARCHETYPE) {
+    archetype_storage_init(&ecs->archetypes, next_buffer, config.max_entities, config.max_component_types, bytes_per_bitmask, max_archetypes, archetype_chunk_size, num_archetype_chunks, config.components);
+  }
+  next_buffer += archetype_buffer_size;
+
+  //set up the entity manager, the entity-component bitmask list, and the entity arrays of each component pool and query
+  if(config.growable) {
+    next_buffer = (uint8_t*)RECS_MALLOC(entity_buffer_size);
+    if(next_buffer == NULL) {
+      recs_free(ecs);
+      return NULL;
+    }
+  }
+  ecs->entity_buffer = next_buffer;
+  ecs->entity_buffer_size = entity_buffer_size;
+  recs_entity_buffer_init(ecs, ecs->entity_buffer, config.max_entities, 0);
 
-  //we still need to allocate the new ECS as well as update the pointers to point to the newly allocated 
-  //buffer
+  if(config.snapshot_chunk_size != 0) {
+    dirty_init(&ecs->dirty, big_buffer, tracked_size, (uint32_t*)(big_buffer + tracked_size), chunk_shift);
+  }
 
+  return ecs;
+  
+}
 
-  //get sizes for each dynamically sized buffer in the RECS
-  size_t recs_buffer_size = sizeof(struct recs);
-  size_t entity_id_buffer_size = sizeof(recs_entity) * ecs_static.ent_man.max_entities;
-  size_t entity_version_buffer_size = sizeof(uint32_t) * ecs_static.ent_man.max_entities;
-  size_t bitmask_buffer_size = bytes_per_bitmask * ecs_static.ent_man.max_entities;
-  size_t system_buffer_size = sizeof(struct recs_system) * ecs_static.max_registered_systems;
-  size_t system_mapper_buffer_size = sizeof(struct system_group_mapper) * ecs_static.max_system_groups;
-  size_t component_pool_buffer_size = sizeof(struct component_pool) * ecs_static.max_registered_components;
+//every pointer inside a copy of a RECS instance's state still points into the original buffer. Since each buffer lies at the
+//same offset in both copies, we just need to move each pointer by the distance between the 2 buffers.
+//The systems are left alone, since they only depend on the config and are not part of the state (see recs_state_ranges()),
+//and so is the entity buffer of growable RECS instances, which lies outside of the big buffer.
+static void recs_relocate(struct recs *ecs, const void *og) {
+  ecs->systems = memory_relocate(ecs->systems, og, ecs);
+  ecs->system_group_mappers = memory_relocate(ecs->system_group_mappers, og, ecs);
+  ecs->system_dependencies_left = memory_relocate(ecs->system_dependencies_left, og, ecs);
+  ecs->system_ready_queue = memory_relocate(ecs->system_ready_queue, og, ecs);
+
+  ecs->recs_component_stores = memory_relocate(ecs->recs_component_stores, og, ecs);
+  for(uint32_t i = 0; i < ecs->max_registered_components; i++) {
+    component_pool_relocate(ecs->recs_component_stores + i, og, ecs);
+  }
 
+  ecs->queries = memory_relocate(ecs->queries, og, ecs);
+  for(uint32_t i = 0; i < ecs->max_queries; i++) {
+    struct query_cache *q = ecs->queries + i;
+    q->include_bitmask = memory_relocate(q->include_bitmask, og, ecs);
+    q->exclude_bitmask = memory_relocate(q->exclude_bitmask, og, ecs);
+  }
 
-  //get size for each component_pool's buffer
-  size_t final_size = 0;
-  final_size += recs_buffer_size + entity_id_buffer_size + entity_version_buffer_size + component_pool_buffer_size;
-  final_size += bitmask_buffer_size + system_buffer_size + system_mapper_buffer_size;
+  ecs->groups = memory_relocate(ecs->groups, og, ecs);
+  for(uint32_t i = 0; i < ecs->max_groups; i++) {
+    ecs->groups[i].comps = memory_relocate(ecs->groups[i].comps, og, ecs);
+  }
 
-  size_t component_pool_inner_buffer_size = 0;
-  for(uint32_t i = 0; i < ecs_static.max_registered_components; i++) {
+  archetype_storage_relocate(&ecs->archetypes, og, ecs);
 
-    size_t comp_buffer_size = og->recs_component_stores[i].component_size * og->recs_component_stores[i].max_components;
-    size_t ent_to_comp_buffer_size = sizeof(uint32_t) * og->ent_man.max_entities;
-    size_t comp_to_ent_buffer_size = sizeof(uint32_t) * og->recs_component_stores[i].max_components;
+  ecs->dirty.base = memory_relocate(ecs->dirty.base, og, ecs);
+  ecs->dirty.chunk_ticks = memory_relocate(ecs->dirty.chunk_ticks, og, ecs);
 
-    component_pool_inner_buffer_size += comp_buffer_size + ent_to_comp_buffer_size + comp_to_ent_buffer_size;
+  if(!ecs->growable) {
+    ecs->entity_buffer = memory_relocate(ecs->entity_buffer, og, ecs);
+    recs_entity_buffer_relocate(ecs, og, ecs);
   }
+}
 
-  final_size += component_pool_inner_buffer_size;
-
+recs recs_copy(recs og) {
 
+  //since the entire ECS lies inside a single contiguous block of memory,
+  //all we have to do is:
+  //1. Allocate another buffer with the same size
+  //2. Copy the contents of the old buffer to the new one
+  //3. Update all the pointers to point to addresses that lie inside the new buffer
 
   //allocate one big buffer that will store ALL of the ECS data
-  uint8_t *big_buffer = (uint8_t*)RECS_MALLOC(final_size);
+  uint8_t *big_buffer = (uint8_t*)RECS_MALLOC(og->buffer_size);
   if(big_buffer == NULL) {
     return NULL;
   }
 
+  memcpy(big_buffer, og, og->buffer_size);
+
   //set the returned RECS instance to the start of the buffer
   recs ecs = (recs) big_buffer;
+  recs_relocate(ecs, og);
+  for(uint32_t i = 0; i < ecs->num_registered_systems; i++) {
+    struct recs_system *s = ecs->systems + i;
+    s->read_mask = memory_relocate(s->read_mask, og, ecs);
+    s->write_mask = memory_relocate(s->write_mask, og, ecs);
+    s->dependents = memory_relocate(s->dependents, og, ecs);
+  }
 
-  //copy static shallow copy of ecs to our newly allocated ecs
-  *ecs = ecs_static;
-
-  //update pointers in entity manager
-  uint8_t *entity_id_buffer =      big_buffer + recs_buffer_size;
-  uint8_t *entity_version_buffer = entity_id_buffer + entity_id_buffer_size;
-  ecs->ent_man.entity_pool = (recs_entity*)entity_id_buffer;
-  ecs->ent_man.ent_versions_list = (uint32_t*)entity_version_buffer;
+  if(!ecs->growable) {
+    return ecs;
+  }
 
-  //copy values from old entity manager to the new one
-  memcpy(ecs->ent_man.entity_pool, og->ent_man.entity_pool, entity_id_buffer_size);
-  memcpy(ecs->ent_man.ent_versions_list, og->ent_man.ent_versions_list, entity_version_buffer_size);
+  //growable RECS instances also need their own copy of the entity buffer and component pages.
+  //Forget the original's allocations first, so that a failed copy can be freed without touching them.
+  ecs->entity_buffer = NULL;
+  for(uint32_t i = 0; i < ecs->max_registered_components; i++) {
+    ecs->recs_component_stores[i].pages = NULL;
+  }
 
-  //update pointers in entity-component bitmask list
-  uint8_t *bitmask_buffer =        entity_version_buffer + entity_version_buffer_size;
-  ecs->comp_bitmask_list.buffer = bitmask_buffer;
+  ecs->entity_buffer = (uint8_t*)RECS_MALLOC(og->entity_buffer_size);
+  if(ecs->entity_buffer == NULL) {
+    recs_free(ecs);
+    return NULL;
+  }
+  memcpy(ecs->entity_buffer, og->entity_buffer, og->entity_buffer_size);
+  recs_entity_buffer_relocate(ecs, og->entity_buffer, ecs->entity_buffer);
 
-  //copy from old bitmask list to new one
-  memcpy(ecs->comp_bitmask_list.buffer, og->comp_bitmask_list.buffer, bitmask_buffer_size);
+  for(uint32_t i = 0; i < ecs->max_registered_components; i++) {
+    if(!component_pool_copy_pages(ecs->recs_component_stores + i, og->recs_component_stores + i)) {
+      recs_free(ecs);
+      return NULL;
+    }
+  }
 
-  //update pointers to systems and system_mappers
-  uint8_t *system_buffer =         bitmask_buffer + bitmask_buffer_size;
-  uint8_t *system_mapper_buffer =  system_buffer + system_buffer_size;
-  ecs->systems = (struct recs_system*)system_buffer;
-  ecs->system_group_mappers = (struct system_group_mapper*)system_mapper_buffer;
+  return ecs;
+}
 
-  //copy systems and mappers from old list to new one
-  memcpy(ecs->systems, og->systems, system_buffer_size);
-  memcpy(ecs->system_group_mappers, og->system_group_mappers, system_mapper_buffer_size);
+//report every range of a fixed-size RECS instance's big buffer that holds part of its state, leaving out the systems (which only
+//depend on the config) and the parts of each buffer that are not in use. Entries of entity IDs from num_ids onward are left out,
+//so num_ids must be at least the number of entity IDs the RECS instance ever used.
+static void recs_state_ranges(struct recs *ecs, uint32_t num_ids, memory_range_func func, void *userdata) {
+  RECS_ASSERT(!ecs->growable && num_ids >= ecs->ent_man.num_used_ids);
 
-  //update the pointer to the component pool list
-  uint8_t *component_pool_buffer = system_mapper_buffer + system_mapper_buffer_size;
-  ecs->recs_component_stores = (struct component_pool*) component_pool_buffer;
-  
-  //copy the values from each of the old component pools to their respective new ones
-  uint8_t *next_buffer = component_pool_buffer + component_pool_buffer_size;
+  func(userdata, ecs, sizeof(struct recs));
+  func(userdata, ecs->recs_component_stores, sizeof(struct component_pool) * ecs->max_registered_components);
   for(uint32_t i = 0; i < ecs->max_registered_components; i++) {
-    
-    size_t comp_buffer_size = og->recs_component_stores[i].component_size * og->recs_component_stores[i].max_components;
-    size_t ent_to_comp_buffer_size = sizeof(uint32_t) * og->ent_man.max_entities;
-    size_t comp_to_ent_buffer_size = sizeof(uint32_t) * og->recs_component_stores[i].max_components;
+    component_pool_ranges(ecs->recs_component_stores + i, num_ids, func, userdata);
+  }
 
-    uint8_t *comp_buffer = next_buffer;
-    uint8_t *ent_to_comp_buffer = comp_buffer + comp_buffer_size;
-    uint8_t *comp_to_ent_buffer = ent_to_comp_buffer + ent_to_comp_buffer_size;
+  //the query list is followed by the masks of each query
+  size_t query_list_size = memory_align(sizeof(struct query_cache) * ecs->max_queries);
+  func(userdata, ecs->queries, query_list_size + (memory_align(ecs->comp_bitmask_size * 2) * ecs->max_queries));
 
-    //update the values and pointers in the component pool
-    ecs->recs_component_stores[i].num_components = og->recs_component_stores[i].num_components;
-    ecs->recs_component_stores[i].max_components = og->recs_component_stores[i].max_components;
-    ecs->recs_component_stores[i].max_entities = og->recs_component_stores[i].max_entities;
-    ecs->recs_component_stores[i].component_size = og->recs_component_stores[i].component_size;
-    ecs->recs_component_stores[i].buffer = (char*) comp_buffer;
-    ecs->recs_component_stores[i].entity_to_comp = (uint32_t*)ent_to_comp_buffer;
-    ecs->recs_component_stores[i].comp_to_entity = (uint32_t*)comp_to_ent_buffer;
+  //the group list is followed by the components of each group
+  size_t group_list_size = memory_align(sizeof(struct component_group) * ecs->max_groups);
+  func(userdata, ecs->groups, group_list_size + (memory_align(sizeof(recs_component) * ecs->max_registered_components) * ecs->max_groups));
 
-    size_t buffer_size = comp_buffer_size + ent_to_comp_buffer_size + comp_to_ent_buffer_size;
-    //copy buffer from old component pool to new one
-    memcpy(ecs->recs_component_stores[i].buffer, og->recs_component_stores[i].buffer, buffer_size);
+  //the archetype tables lie right before the entity buffer, and are copied whole
+  if(ecs->storage == RECS_STORAGE_ARCHETYPE) {
+    func(userdata, ecs->archetypes.archetypes, (size_t)(ecs->entity_buffer - (uint8_t*)ecs->archetypes.archetypes));
+  }
 
-    next_buffer += buffer_size;
+  entity_manager_ranges(&ecs->ent_man, num_ids, func, userdata);
+  func(userdata, ecs->comp_bitmask_list.buffer, ecs->comp_bitmask_size * num_ids);
+  column_index_ranges(&ecs->columns, num_ids, func, userdata);
+  for(uint32_t i = 0; i < ecs->max_queries; i++) {
+    struct query_cache *q = ecs->queries + i;
+    func(userdata, q->entities, sizeof(recs_entity) * q->num_entities);
+    func(userdata, q->entity_to_index, sizeof(uint32_t) * num_ids);
   }
+}
 
+//the parts of a RECS instance that belong to it rather than to its state, which are kept when overwriting its state
+struct recs_owned_fields {
+  struct dirty_tracker dirty;
+  void *system_context;
+  struct bitmask_kernels mask_kernels;
+  uint32_t change_tick;
+};
 
-  return ecs;
+static void recs_owned_fields_save(struct recs *ecs, struct recs_owned_fields *owned) {
+  owned->dirty = ecs->dirty;
+  owned->system_context = ecs->system_context;
+  owned->mask_kernels = ecs->mask_kernels;
+  owned->change_tick = ecs->change_tick;
 }
 
-void recs_free(struct recs *ecs) {
-  if(ecs == NULL) {
-    return;
-  }
+static void recs_owned_fields_restore(struct recs *ecs, const struct recs_owned_fields *owned) {
+  ecs->dirty = owned->dirty;
+  ecs->system_context = owned->system_context;
+  ecs->mask_kernels = owned->mask_kernels;
 
-  //remember that we made 1 BIG allocation to store all data, starting at where the struct recs is at
-  RECS_FREE(ecs);
+  //the systems keep the ticks they last ran at, so the tick must never move backwards, or they would miss later changes
+  if(ecs->change_tick < owned->change_tick) {
+    ecs->change_tick = owned->change_tick;
+  }
 }
 
+struct recs_range_copy {
+  struct recs *dst;
+  const struct recs *src;
+  struct dirty_tracker *dirty;
+};
 
-uint32_t recs_component_num_instances(struct recs *recs, recs_component c) {
-  struct component_pool *p = recs->recs_component_stores + c;
-  return p->num_components;
+static void recs_copy_range(void *userdata, const void *ptr, size_t size) {
+  struct recs_range_copy *copy = (struct recs_range_copy*)userdata;
+  uint8_t *dst = (uint8_t*)copy->dst + ((const uint8_t*)ptr - (const uint8_t*)copy->src);
+  memcpy(dst, ptr, size);
+  dirty_mark(copy->dirty, dst, size);
 }
 
-recs_entity recs_component_get_entity(struct recs *recs, recs_component c, uint32_t comp_index) {
-  struct component_pool *p = recs->recs_component_stores + c;
-  uint32_t id = p->comp_to_entity[comp_index];
-  if(id == RECS_NO_ENTITY_ID) {
-    return RECS_ENT_FROM(RECS_NO_ENTITY_ID, 0);
+void recs_copy_into(struct recs *dst, struct recs *src) {
+  //every buffer must lie at the same offset inside both RECS instances
+  RECS_ASSERT(!dst->growable && !src->growable);
+  RECS_ASSERT(dst->buffer_size == src->buffer_size && dst->storage == src->storage);
+  RECS_ASSERT(dst->ent_man.max_entities == src->ent_man.max_entities && dst->max_registered_components == src->max_registered_components && dst->max_queries == src->max_queries && dst->max_groups == src->max_groups);
+  if(dst == src) {
+    return;
   }
-  return RECS_ENT_FROM(id, recs->ent_man.ent_versions_list[id]);
-}
 
+  //IDs that neither RECS instance ever used still hold their initial values in both, so they can be skipped
+  uint32_t num_ids = dst->ent_man.num_used_ids > src->ent_man.num_used_ids ? dst->ent_man.num_used_ids : src->ent_man.num_used_ids;
+
+  //the struct recs gets overwritten along with the rest of the state, so the tracker is marked through a copy
+  struct recs_owned_fields owned;
+  recs_owned_fields_save(dst, &owned);
+  struct recs_range_copy copy = {
+    .dst = dst,
+    .src = src,
+    .dirty = owned.dirty.chunk_ticks == NULL ? NULL : &owned.dirty
+  };
 
+  recs_state_ranges(src, num_ids, recs_copy_range, &copy);
+  recs_relocate(dst, src);
+  recs_owned_fields_restore(dst, &owned);
+}
 
+//the RECS instance's own bookkeeping (such as the number of entities and components) changes with nearly
+//every write, but is small, so it is always copied rather than tracked.
+static void recs_snapshot_mark_bookkeeping(struct recs *ecs) {
+  struct dirty_tracker *dirty = &ecs->dirty;
+  dirty_mark(dirty, ecs, sizeof(struct recs));
+  dirty_mark(dirty, ecs->recs_component_stores, sizeof(struct component_pool) * ecs->max_registered_components);
+  dirty_mark(dirty, ecs->queries, sizeof(struct query_cache) * ecs->max_queries);
+  dirty_mark(dirty, ecs->groups, sizeof(struct component_group) * ecs->max_groups);
+
+  //the archetype tables do not track their writes
+  if(ecs->storage == RECS_STORAGE_ARCHETYPE) {
+    dirty_mark(dirty, dirty->base, dirty->size);
+  }
+}
 
+recs_snapshot recs_snapshot_create(struct recs *ecs) {
+  RECS_ASSERT(recs_dirty(ecs) != NULL);
 
+  //the snapshot's image is stored right after it
+  size_t header_size = memory_align(sizeof(struct recs_snapshot));
+  uint8_t *buffer = (uint8_t*)RECS_MALLOC(header_size + ecs->dirty.size);
+  if(buffer == NULL) {
+    return NULL;
+  }
 
-void recs_system_set_context(struct recs *ecs, void *context) {
-  ecs->system_context = context;
+  recs_snapshot snapshot = (recs_snapshot)buffer;
+  snapshot->ecs = ecs;
+  snapshot->image = buffer + header_size;
+  memcpy(snapshot->image, ecs, ecs->dirty.size);
+  snapshot->last_copy_size = ecs->dirty.size;
+  snapshot->tick = dirty_next_tick(&ecs->dirty);
+  return snapshot;
 }
 
-void* recs_system_get_context(struct recs *ecs) {
-  return ecs->system_context;
+void recs_snapshot_free(recs_snapshot snapshot) {
+  RECS_FREE(snapshot);
 }
 
+void recs_snapshot_take(struct recs *ecs, recs_snapshot snapshot) {
+  RECS_ASSERT(snapshot->ecs == ecs);
 
-void recs_system_run(struct recs *ecs, recs_system_group type) {
-  uint32_t system_group_start_index = ecs->system_group_mappers[type].starting_index;
-  uint32_t num_systems = ecs->system_group_mappers[type].num_systems;
-  for(uint32_t i = 0; i < num_systems; i++) {
-    ecs->systems[system_group_start_index + i].func(ecs);
-  }
+  recs_snapshot_mark_bookkeeping(ecs);
+  snapshot->last_copy_size = dirty_copy_since(&ecs->dirty, snapshot->tick, snapshot->image, (uint8_t*)ecs, 0);
+  snapshot->tick = dirty_next_tick(&ecs->dirty);
 }
 
+void recs_snapshot_restore(struct recs *ecs, recs_snapshot snapshot) {
+  RECS_ASSERT(snapshot->ecs == ecs);
 
-recs_entity recs_entity_add(struct recs *ecs) {
-  RECS_ASSERT(ecs->ent_man.num_active_entities < ecs->ent_man.max_entities);
+  recs_snapshot_mark_bookkeeping(ecs);
 
-  recs_entity e = entity_manager_add(&ecs->ent_man);
-  return e;
-  
+  //the struct recs gets overwritten by the copy, so keep the tracker, context, and change tick outside of it.
+  //The restored chunks are marked, since they changed for every other snapshot.
+  struct recs_owned_fields owned;
+  recs_owned_fields_save(ecs, &owned);
+  snapshot->last_copy_size = dirty_copy_since(&owned.dirty, snapshot->tick, (uint8_t*)ecs, snapshot->image, 1);
+  recs_owned_fields_restore(ecs, &owned);
+
+  snapshot->tick = dirty_next_tick(&ecs->dirty);
 }
 
-void recs_entity_remove(struct recs *ecs, recs_entity e) {
-  if(RECS_ENT_ID(e) == RECS_NO_ENTITY_ID) return;
+size_t recs_snapshot_copy_size(recs_snapshot snapshot) {
+  return snapshot->last_copy_size;
+}
 
-  //update version number
-  if(RECS_ENT_VERSION(e) == ecs->ent_man.ent_versions_list[RECS_ENT_ID(e)]) {
-    ecs->ent_man.ent_versions_list[RECS_ENT_ID(e)]++;
-  }
+#define RECS_SAVE_MAGIC "RECS"
+#define RECS_SAVE_BYTE_ORDER 0x01020304u
 
+//start of every save, followed by a struct recs_save_component for each component type, a struct recs_save_section
+//for each range of memory saved, and the contents of each range in the same order.
+struct recs_save_header {
+  char magic[4];
+  uint32_t version;
 
+  //saves are rejected by machines that lay out memory differently
+  uint32_t byte_order;
+  uint32_t pointer_size;
 
-  //delete components
+  //address of the saved RECS instance. Every pointer inside the save is relative to it.
+  uint64_t base;
+  uint64_t buffer_size;
+
+  uint32_t storage;
+  uint32_t max_entities;
+  uint32_t max_component_types;
+  uint32_t max_tags;
+  uint32_t max_systems;
+  uint32_t max_system_groups;
+  uint32_t max_queries;
+
+  //entries of entity IDs from num_used_ids onward are not saved, since they still hold their initial values
+  uint32_t num_used_ids;
+  uint32_t num_sections;
+  uint32_t max_groups;
+};
+
+struct recs_save_component {
+  uint32_t component_size;
+  uint32_t max_components;
+
+  //the layout of the pool's pages, for component types split into fields
+  uint32_t num_fields;
+  uint32_t field_block_size;
+};
+
+//a range of memory, starting at an offset from the start of the RECS instance
+struct recs_save_section {
+  uint64_t offset;
+  uint64_t size;
+};
+
+//writes a save into a buffer or a file, or only counts its size if given neither
+struct recs_save_writer {
+  uint8_t *buffer;
+  size_t buffer_size;
+  FILE *file;
+  size_t size;
+  uint8_t failed;
+};
+
+struct recs_save_walk {
+  struct recs_save_writer *writer;
+  const struct recs *ecs;
+  uint32_t num_sections;
+};
+
+static void recs_save_write(struct recs_save_writer *w, const void *data, size_t size) {
+  if(w->failed || size == 0) {
+    return;
+  }
+
+  if(w->buffer != NULL) {
+    if(size > w->buffer_size - w->size) {
+      w->failed = 1;
+      return;
+    }
+    memcpy(w->buffer + w->size, data, size);
+  } else if(w->file != NULL && fwrite(data, 1, size, w->file) != size) {
+    w->failed = 1;
+    return;
+  }
+  w->size += size;
+}
+
+static void recs_save_count_section(void *userdata, const void *ptr, size_t size) {
+  struct recs_save_walk *walk = (struct recs_save_walk*)userdata;
+  (void)ptr;
+  walk->num_sections += size != 0;
+}
+
+static void recs_save_write_section(void *userdata, const void *ptr, size_t size) {
+  struct recs_save_walk *walk = (struct recs_save_walk*)userdata;
+  if(size == 0) {
+    return;
+  }
+
+  struct recs_save_section section = {
+    .offset = (uint64_t)((const uint8_t*)ptr - (const uint8_t*)walk->ecs),
+    .size = size
+  };
+  recs_save_write(walk->writer, &section, sizeof(section));
+}
+
+static void recs_save_write_range(void *userdata, const void *ptr, size_t size) {
+  struct recs_save_walk *walk = (struct recs_save_walk*)userdata;
+  recs_save_write(walk->writer, ptr, size);
+}
+
+//fill in the header of a save of a RECS instance, except for the number of sections
+static void recs_save_header_init(struct recs *ecs, struct recs_save_header *header) {
+  memset(header, 0, sizeof(*header));
+  memcpy(header->magic, RECS_SAVE_MAGIC, sizeof(header->magic));
+  header->version = RECS_SAVE_VERSION;
+  header->byte_order = RECS_SAVE_BYTE_ORDER;
+  header->pointer_size = (uint32_t)sizeof(void*);
+  header->base = (uint64_t)(uintptr_t)ecs;
+  header->buffer_size = ecs->buffer_size;
+  header->storage = (uint32_t)ecs->storage;
+  header->max_entities = ecs->ent_man.max_entities;
+  header->max_component_types = ecs->max_registered_components;
+  header->max_tags = ecs->max_tags;
+  header->max_systems = ecs->max_registered_systems;
+  header->max_system_groups = ecs->max_system_groups;
+  header->max_queries = ecs->max_queries;
+  header->max_groups = ecs->max_groups;
+  header->num_used_ids = ecs->ent_man.num_used_ids;
+}
+
+static void recs_save_to(struct recs *ecs, struct recs_save_writer *w) {
+  RECS_ASSERT(!ecs->growable);
+
+  uint32_t num_ids = ecs->ent_man.num_used_ids;
+  struct recs_save_walk walk = {
+    .writer = w,
+    .ecs = ecs,
+    .num_sections = 0
+  };
+  recs_state_ranges(ecs, num_ids, recs_save_count_section, &walk);
+
+  struct recs_save_header header;
+  recs_save_header_init(ecs, &header);
+  header.num_sections = walk.num_sections;
+  recs_save_write(w, &header, sizeof(header));
+
+  for(uint32_t i = 0; i < ecs->max_registered_components; i++) {
+    struct recs_save_component comp = {
+      .component_size = ecs->recs_component_stores[i].component_size,
+      .max_components = ecs->recs_component_stores[i].max_components,
+      .num_fields = ecs->recs_component_stores[i].num_fields,
+      .field_block_size = ecs->recs_component_stores[i].field_block_size
+    };
+    recs_save_write(w, &comp, sizeof(comp));
+  }
+
+  recs_state_ranges(ecs, num_ids, recs_save_write_section, &walk);
+  recs_state_ranges(ecs, num_ids, recs_save_write_range, &walk);
+}
+
+size_t recs_save_size(struct recs *ecs) {
+  struct recs_save_writer w = {0};
+  recs_save_to(ecs, &w);
+  return w.size;
+}
+
+size_t recs_save(struct recs *ecs, void *buffer, size_t buffer_size) {
+  struct recs_save_writer w = {
+    .buffer = (uint8_t*)buffer,
+    .buffer_size = buffer_size,
+    .file = NULL,
+    .size = 0,
+    .failed = 0
+  };
+  recs_save_to(ecs, &w);
+  return w.failed ? 0 : w.size;
+}
+
+int recs_save_file(struct recs *ecs, const char *path) {
+  FILE *file = fopen(path, "wb");
+  if(file == NULL) {
+    return 0;
+  }
+
+  struct recs_save_writer w = {
+    .buffer = NULL,
+    .buffer_size = 0,
+    .file = file,
+    .size = 0,
+    .failed = 0
+  };
+  recs_save_to(ecs, &w);
+
+  int closed = fclose(file) == 0;
+  return !w.failed && closed;
+}
+
+//give the entity IDs from first_id up to end_id their initial entries in every array indexed by entity ID
+static void recs_entity_buffer_reset(struct recs *ecs, uint32_t first_id, uint32_t end_id) {
+  entity_manager_reset_ids(&ecs->ent_man, first_id, end_id);
+  memset(ecs->comp_bitmask_list.buffer + (ecs->comp_bitmask_size * first_id), 0, ecs->comp_bitmask_size * (end_id - first_id));
+  column_index_reset_ids(&ecs->columns, first_id, end_id);
+
+  for(uint32_t i = 0; i < ecs->max_registered_components && ecs->storage == RECS_STORAGE_SPARSE_SET; i++) {
+    sparse_map_reset_ids(&ecs->recs_component_stores[i].entity_to_comp, first_id, end_id);
+  }
+
+  for(uint32_t i = 0; i < ecs->max_queries; i++) {
+    uint32_t *entity_to_index = ecs->queries[i].entity_to_index;
+    for(uint32_t id = first_id; id < end_id; id++) {
+      entity_to_index[id] = NO_COMP_ID;
+    }
+  }
+}
+
+int recs_load(struct recs *ecs, const void *data, size_t size) {
+  RECS_ASSERT(!ecs->growable);
+  const uint8_t *bytes = (const uint8_t*)data;
+
+  //the save must have been made by this version of RECS, with the same config
+  struct recs_save_header header;
+  struct recs_save_header expected;
+  if(size < sizeof(header)) {
+    return 0;
+  }
+  memcpy(&header, bytes, sizeof(header));
+  recs_save_header_init(ecs, &expected);
+  expected.base = header.base;
+  expected.num_used_ids = header.num_used_ids;
+  expected.num_sections = header.num_sections;
+  if(memcmp(&header, &expected, sizeof(header)) != 0 || header.num_used_ids > header.max_entities) {
+    return 0;
+  }
+  size_t pos = sizeof(header);
+
+  if((size - pos) / sizeof(struct recs_save_component) < ecs->max_registered_components) {
+    return 0;
+  }
+  for(uint32_t i = 0; i < ecs->max_registered_components; i++) {
+    struct recs_save_component comp;
+    memcpy(&comp, bytes + pos, sizeof(comp));
+    pos += sizeof(comp);
+    const struct component_pool *p = ecs->recs_component_stores + i;
+    if(comp.component_size != p->component_size || comp.max_components != p->max_components ||
+      comp.num_fields != p->num_fields || comp.field_block_size != p->field_block_size) {
+      return 0;
+    }
+  }
+
+  //make sure every section fits inside both the save and the RECS instance before changing anything
+  if((size - pos) / sizeof(struct recs_save_section) < header.num_sections) {
+    return 0;
+  }
+  const uint8_t *sections = bytes + pos;
+  pos += sizeof(struct recs_save_section) * header.num_sections;
+  size_t data_size = 0;
+  for(uint32_t i = 0; i < header.num_sections; i++) {
+    struct recs_save_section section;
+    memcpy(&section, sections + (sizeof(section) * i), sizeof(section));
+    if(section.offset > ecs->buffer_size || section.size > ecs->buffer_size - section.offset || section.size > size - pos - data_size) {
+      return 0;
+    }
+    data_size += (size_t)section.size;
+  }
+
+  uint32_t num_ids_before = ecs->ent_man.num_used_ids;
+  struct recs_owned_fields owned;
+  recs_owned_fields_save(ecs, &owned);
+
+  for(uint32_t i = 0; i < header.num_sections; i++) {
+    struct recs_save_section section;
+    memcpy(&section, sections + (sizeof(section) * i), sizeof(section));
+    memcpy((uint8_t*)ecs + section.offset, bytes + pos, (size_t)section.size);
+    pos += (size_t)section.size;
+  }
+
+  recs_relocate(ecs, (const void*)(uintptr_t)header.base);
+  recs_owned_fields_restore(ecs, &owned);
+
+  //entity IDs this RECS instance used that the saved one did not are not inside the save
+  if(num_ids_before > header.num_used_ids) {
+    recs_entity_buffer_reset(ecs, header.num_used_ids, num_ids_before);
+  }
+
+  if(recs_dirty(ecs) != NULL) {
+    dirty_mark(&ecs->dirty, ecs->dirty.base, ecs->dirty.size);
+  }
+  return 1;
+}
+
+int recs_load_file(struct recs *ecs, const char *path) {
+  size_t size = 0;
+  const void *data = file_map_open(path, &size);
+  if(data == NULL) {
+    return 0;
+  }
+
+  int loaded = recs_load(ecs, data, size);
+  file_map_close(data, size);
+  return loaded;
+}
+
+#define RECS_DIFF_MAGIC "RDIF"
+
+//diffs are written and read in blocks of at most this many bytes, each following its size as a 16-bit little endian number
+#define RECS_DIFF_BLOCK_SIZE 4096
+
+//changed bytes of a component that are closer together than this are sent as one run, since starting
+//a new run costs about as much as the unchanged bytes in between
+#define RECS_DIFF_MIN_GAP 3
+
+//a diff starts with RECS_DIFF_MAGIC, RECS_DIFF_VERSION, the number of component types and tags, and the size of each
+//component type. It is followed by records, each starting with one of these ops. Every record except RECS_DIFF_END
+//is then followed by how far its entity ID is from the one of the previous record, since entities are visited in ID order.
+//Every number is written 7 bits at a time, with the top bit of each byte set when more bytes follow.
+enum recs_diff_op {
+  RECS_DIFF_END,
+  RECS_DIFF_DESPAWN,
+  RECS_DIFF_SPAWN,            //followed by the version of the entity
+  RECS_DIFF_REMOVE_COMPONENT, //followed by the component type
+  RECS_DIFF_SET_COMPONENT,    //followed by the component type and the whole component
+  RECS_DIFF_PATCH_COMPONENT,  //followed by the component type and the runs of bytes that changed (see recs_diff_runs())
+  RECS_DIFF_ADD_TAG,          //followed by the tag
+  RECS_DIFF_REMOVE_TAG        //followed by the tag
+};
+
+struct recs_diff_writer {
+  recs_stream_write_func write;
+  void *userdata;
+  size_t size;
+  uint8_t failed;
+  uint32_t last_id;
+
+  uint32_t block_size;
+  uint8_t block[RECS_DIFF_BLOCK_SIZE];
+
+  //the old and new copies of a component being compared, for component types split into fields, which hold no whole components
+  uint8_t *old_component;
+  uint8_t *new_component;
+};
+
+struct recs_diff_reader {
+  recs_stream_read_func read;
+  void *userdata;
+  uint32_t last_id;
+
+  uint32_t block_size;
+  uint32_t block_pos;
+  uint8_t block[RECS_DIFF_BLOCK_SIZE];
+};
+
+static void recs_diff_flush(struct recs_diff_writer *w) {
+  if(w->failed || w->block_size == 0) {
+    return;
+  }
+
+  uint8_t length[2] = {(uint8_t)w->block_size, (uint8_t)(w->block_size >> 8)};
+  if(!w->write(w->userdata, length, sizeof(length)) || !w->write(w->userdata, w->block, w->block_size)) {
+    w->failed = 1;
+    return;
+  }
+  w->size += sizeof(length) + w->block_size;
+  w->block_size = 0;
+}
+
+static void recs_diff_put(struct recs_diff_writer *w, const void *data, size_t size) {
+  const uint8_t *bytes = (const uint8_t*)data;
+  while(size > 0 && !w->failed) {
+    if(w->block_size == RECS_DIFF_BLOCK_SIZE) {
+      recs_diff_flush(w);
+      continue;
+    }
+
+    size_t n = RECS_DIFF_BLOCK_SIZE - w->block_size;
+    n = n < size ? n : size;
+    memcpy(w->block + w->block_size, bytes, n);
+    w->block_size += (uint32_t)n;
+    bytes += n;
+    size -= n;
+  }
+}
+
+static size_t recs_diff_number_size(uint64_t value) {
+  size_t size = 1;
+  while(value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+static void recs_diff_put_number(struct recs_diff_writer *w, uint64_t value) {
+  uint8_t bytes[10];
+  uint32_t n = 0;
+  while(value >= 0x80) {
+    bytes[n++] = (uint8_t)(value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  bytes[n++] = (uint8_t)value;
+  recs_diff_put(w, bytes, n);
+}
+
+static void recs_diff_put_op(struct recs_diff_writer *w, enum recs_diff_op op, uint32_t id) {
+  uint8_t byte = (uint8_t)op;
+  recs_diff_put(w, &byte, 1);
+  recs_diff_put_number(w, id - w->last_id);
+  w->last_id = id;
+}
+
+//the changed bytes of a component are sent as runs, each made of the number of unchanged bytes to skip, the number of
+//changed bytes, and the changed bytes themselves, ending with an empty run. Returns the number of bytes the runs take up,
+//and only writes them if w is not NULL.
+static size_t recs_diff_runs(struct recs_diff_writer *w, const uint8_t *old_bytes, const uint8_t *new_bytes, size_t size) {
+  size_t total = 2;
+  size_t run_end = 0;
+  size_t i = 0;
+  while(i < size) {
+    if(old_bytes[i] == new_bytes[i]) {
+      i++;
+      continue;
+    }
+
+    size_t start = i;
+    size_t end = i + 1;
+    for(size_t j = end; j < size && j - end < RECS_DIFF_MIN_GAP; j++) {
+      if(old_bytes[j] != new_bytes[j]) {
+        end = j + 1;
+      }
+    }
+
+    total += recs_diff_number_size(start - run_end) + recs_diff_number_size(end - start) + (end - start);
+    if(w != NULL) {
+      recs_diff_put_number(w, start - run_end);
+      recs_diff_put_number(w, end - start);
+      recs_diff_put(w, new_bytes + start, end - start);
+    }
+    run_end = end;
+    i = end;
+  }
+
+  if(w != NULL) {
+    recs_diff_put_number(w, 0);
+    recs_diff_put_number(w, 0);
+  }
+  return total;
+}
+
+//get the handle of the entity using an ID, or RECS_NO_ENTITY if the ID is not in use
+static recs_entity recs_diff_entity(struct recs *ecs, uint32_t id) {
+  if(id >= ecs->ent_man.num_used_ids || !recs_entity_id_active(ecs, id)) {
+    return RECS_NO_ENTITY;
+  }
+  return entity_manager_get(&ecs->ent_man, id);
+}
+
+//write the changes to a component that both the old and new entity have
+static void recs_diff_component(struct recs_diff_writer *w, struct recs *old_ecs, recs_entity old_e, struct recs *new_ecs, recs_entity new_e, recs_component c) {
+  size_t size = new_ecs->recs_component_stores[c].component_size;
+
+  const uint8_t *new_bytes;
+  const uint8_t *old_bytes;
+  if(new_ecs->recs_component_stores[c].num_fields == 0) {
+    new_bytes = (const uint8_t*)recs_component_lookup(new_ecs, new_e, c);
+    old_bytes = old_e == RECS_NO_ENTITY ? NULL : (const uint8_t*)recs_component_lookup(old_ecs, old_e, c);
+  } else {
+    //component types split into fields are gathered first. Bytes outside of every field are not stored, so they are compared as zeros.
+    memset(w->old_component, 0, size);
+    memset(w->new_component, 0, size);
+    recs_entity_gather_component(new_ecs, new_e, c, w->new_component);
+    new_bytes = w->new_component;
+    old_bytes = old_e != RECS_NO_ENTITY && recs_entity_gather_component(old_ecs, old_e, c, w->old_component) ? w->old_component : NULL;
+  }
+  if(old_bytes != NULL && memcmp(old_bytes, new_bytes, size) == 0) {
+    return;
+  }
+
+  //send the whole component when it is new, or when most of it changed
+  if(old_bytes == NULL || recs_diff_runs(NULL, old_bytes, new_bytes, size) >= size) {
+    recs_diff_put_op(w, RECS_DIFF_SET_COMPONENT, RECS_ENT_ID(new_e));
+    recs_diff_put_number(w, c);
+    recs_diff_put(w, new_bytes, size);
+    return;
+  }
+
+  recs_diff_put_op(w, RECS_DIFF_PATCH_COMPONENT, RECS_ENT_ID(new_e));
+  recs_diff_put_number(w, c);
+  recs_diff_runs(w, old_bytes, new_bytes, size);
+}
+
+//write the changes to the entity using an ID
+static void recs_diff_id(struct recs_diff_writer *w, struct recs *old_ecs, struct recs *new_ecs, uint32_t id) {
+  recs_entity old_e = recs_diff_entity(old_ecs, id);
+  recs_entity new_e = recs_diff_entity(new_ecs, id);
+
+  //a different handle means the entity was removed, and its ID was reused by a new entity
+  if(old_e != new_e) {
+    if(old_e != RECS_NO_ENTITY) {
+      recs_diff_put_op(w, RECS_DIFF_DESPAWN, id);
+    }
+    if(new_e == RECS_NO_ENTITY) {
+      return;
+    }
+    recs_diff_put_op(w, RECS_DIFF_SPAWN, id);
+    recs_diff_put_number(w, RECS_ENT_VERSION(new_e));
+    old_e = RECS_NO_ENTITY;
+  } else if(new_e == RECS_NO_ENTITY) {
+    return;
+  }
+
+  const uint8_t *old_mask = old_e == RECS_NO_ENTITY ? NULL : bitmask_list_get(&old_ecs->comp_bitmask_list, id);
+  const uint8_t *new_mask = bitmask_list_get(&new_ecs->comp_bitmask_list, id);
+
+  //go through every component and tag that either entity has, skipping over whole words (then bytes) that neither has
+  const uint32_t num_words = new_ecs->comp_bitmask_size / sizeof(uint64_t);
+  for(uint32_t word = 0; word < num_words; word++) {
+    if((old_mask == NULL || bitmask_load_word(old_mask, word) == 0) && bitmask_load_word(new_mask, word) == 0) continue;
+
+    for(uint32_t byte = word * sizeof(uint64_t); byte < (word + 1) * sizeof(uint64_t); byte++) {
+      uint8_t old_bits = old_mask == NULL ? 0 : old_mask[byte];
+      uint8_t new_bits = new_mask[byte];
+      if((old_bits | new_bits) == 0) continue;
+
+      for(uint32_t bit = byte * 8; bit < (byte + 1) * 8; bit++) {
+        uint8_t had = (old_bits >> (bit % 8)) & 1;
+        uint8_t has = (new_bits >> (bit % 8)) & 1;
+        if(!had && !has) continue;
+
+        if(bit < new_ecs->max_registered_components) {
+          if(has) {
+            recs_diff_component(w, old_ecs, had ? old_e : RECS_NO_ENTITY, new_ecs, new_e, bit);
+          } else {
+            recs_diff_put_op(w, RECS_DIFF_REMOVE_COMPONENT, id);
+            recs_diff_put_number(w, bit);
+          }
+        } else if(had != has) {
+          recs_diff_put_op(w, has ? RECS_DIFF_ADD_TAG : RECS_DIFF_REMOVE_TAG, id);
+          recs_diff_put_number(w, bit - new_ecs->max_registered_components);
+        }
+      }
+    }
+  }
+}
+
+//get a word of a column, which is 0 past the end of the column (the other RECS instance may hold more entity IDs)
+static inline uint64_t recs_diff_column_word(const struct column_index *ci, uint32_t column, uint32_t word) {
+  return word < ci->words_per_column ? column_index_column(ci, column)[word] : 0;
+}
+
+//set the bit of every entity ID whose entity, components, or tags may differ between old_ecs and new_ecs, so that only
+//those need to be compared. Everything else is found through the changes new_ecs already tracks, which only works
+//when old_ecs is an earlier state of new_ecs.
+static void recs_diff_candidates(struct recs *old_ecs, struct recs *new_ecs, uint64_t *candidates, uint32_t num_words) {
+  const struct column_index *old_ci = &old_ecs->columns;
+  const struct column_index *new_ci = &new_ecs->columns;
+
+  //the tick of an earlier state can not be ahead, so old_ecs is not one and every entity ID is compared
+  if(old_ecs->change_tick > new_ecs->change_tick) {
+    memset(candidates, 0xFF, sizeof(uint64_t) * num_words);
+    return;
+  }
+  memset(candidates, 0, sizeof(uint64_t) * num_words);
+
+  //entities that were added or removed. An ID reused by a new entity is active in both, but with a different version.
+  uint32_t num_versions = old_ecs->ent_man.max_entities < new_ecs->ent_man.max_entities ? old_ecs->ent_man.max_entities : new_ecs->ent_man.max_entities;
+  const uint32_t *old_versions = old_ecs->ent_man.ent_versions_list;
+  const uint32_t *new_versions = new_ecs->ent_man.ent_versions_list;
+  for(uint32_t word = 0; word < num_words; word++) {
+    uint64_t old_active = recs_diff_column_word(old_ci, old_ci->active_column, word);
+    uint64_t new_active = recs_diff_column_word(new_ci, new_ci->active_column, word);
+    uint64_t both = old_active & new_active;
+    candidates[word] |= old_active ^ new_active;
+    if(both == 0) continue;
+
+    uint32_t first = word * 64;
+    uint32_t n = num_versions - first < 64 ? num_versions - first : 64;
+    if(memcmp(old_versions + first, new_versions + first, sizeof(uint32_t) * n) == 0) continue;
+    for(uint64_t bits = both; bits != 0; bits &= bits - 1) {
+      uint32_t id = first + bitmask_ctz64(bits);
+      if(old_versions[id] != new_versions[id]) {
+        candidates[word] |= (uint64_t)1 << (id & 63);
+      }
+    }
+  }
+
+  //components and tags that were added or removed, 64 entity IDs at a time. Every write to a column is counted,
+  //so none of them changed if both counts match.
+  if(old_ci->num_changes != new_ci->num_changes) {
+    for(uint32_t column = 0; column < new_ecs->max_registered_components + new_ecs->max_tags; column++) {
+      for(uint32_t word = 0; word < num_words; word++) {
+        candidates[word] |= recs_diff_column_word(old_ci, column, word) ^ recs_diff_column_word(new_ci, column, word);
+      }
+    }
+  }
+
+  //components written to since old_ecs's tick (including the writes made during it), skipping each block of
+  //components whose highest tick is older. Every entity having a component without ticks is compared instead.
+  uint32_t since_tick = old_ecs->change_tick - 1;
+  for(recs_component c = 0; c < new_ecs->max_registered_components; c++) {
+    struct component_pool *p = new_ecs->recs_component_stores + c;
+    if(new_ecs->storage == RECS_STORAGE_ARCHETYPE || p->changed_ticks == NULL) {
+      for(uint32_t word = 0; word < num_words; word++) {
+        candidates[word] |= recs_diff_column_word(old_ci, c, word) | recs_diff_column_word(new_ci, c, word);
+      }
+      continue;
+    }
+
+    for(uint32_t block = 0; block < p->num_slots; block += COMPONENT_POOL_TICK_BLOCK_MASK + 1) {
+      if(!component_pool_block_changed_since(p, block, since_tick)) continue;
+
+      uint32_t end = p->num_slots - block > COMPONENT_POOL_TICK_BLOCK_MASK ? block + COMPONENT_POOL_TICK_BLOCK_MASK + 1 : p->num_slots;
+      for(uint32_t slot = block; slot < end; slot++) {
+        if(component_pool_slot_used(p, slot) && component_pool_changed_since(p, slot, 0, since_tick)) {
+          uint32_t id = p->comp_to_entity[slot];
+          candidates[id >> 6] |= (uint64_t)1 << (id & 63);
+        }
+      }
+    }
+  }
+}
+
+size_t recs_diff(struct recs *old_ecs, struct recs *new_ecs, recs_stream_write_func write, void *userdata) {
+  RECS_ASSERT(old_ecs->max_registered_components == new_ecs->max_registered_components && old_ecs->max_tags == new_ecs->max_tags);
+  for(uint32_t i = 0; i < new_ecs->max_registered_components; i++) {
+    RECS_ASSERT(old_ecs->recs_component_stores[i].component_size == new_ecs->recs_component_stores[i].component_size);
+  }
+
+  struct recs_diff_writer w;
+  w.write = write;
+  w.userdata = userdata;
+  w.size = 0;
+  w.failed = 0;
+  w.last_id = 0;
+  w.block_size = 0;
+
+  size_t max_size = 1;
+  for(uint32_t i = 0; i < new_ecs->max_registered_components; i++) {
+    size_t size = new_ecs->recs_component_stores[i].component_size;
+    max_size = size > max_size ? size : max_size;
+  }
+
+  //one bit for each entity ID that needs to be compared, followed by the copies of the component being compared
+  uint32_t num_ids = old_ecs->ent_man.num_used_ids > new_ecs->ent_man.num_used_ids ? old_ecs->ent_man.num_used_ids : new_ecs->ent_man.num_used_ids;
+  uint32_t num_words = column_index_num_words(num_ids);
+  size_t candidates_size = memory_align(sizeof(uint64_t) * num_words);
+  uint8_t *buffer = (uint8_t*)RECS_MALLOC(candidates_size + (max_size * 2));
+  if(buffer == NULL) {
+    return 0;
+  }
+  uint64_t *candidates = (uint64_t*)buffer;
+  w.old_component = buffer + candidates_size;
+  w.new_component = w.old_component + max_size;
+  recs_diff_candidates(old_ecs, new_ecs, candidates, num_words);
+
+  recs_diff_put(&w, RECS_DIFF_MAGIC, 4);
+  recs_diff_put_number(&w, RECS_DIFF_VERSION);
+  recs_diff_put_number(&w, new_ecs->max_registered_components);
+  recs_diff_put_number(&w, new_ecs->max_tags);
+  for(uint32_t i = 0; i < new_ecs->max_registered_components; i++) {
+    recs_diff_put_number(&w, new_ecs->recs_component_stores[i].component_size);
+  }
+
+  for(uint32_t word = 0; word < num_words && !w.failed; word++) {
+    for(uint64_t bits = candidates[word]; bits != 0; bits &= bits - 1) {
+      uint32_t id = word * 64 + bitmask_ctz64(bits);
+      if(id >= num_ids) break;
+      recs_diff_id(&w, old_ecs, new_ecs, id);
+    }
+  }
+
+  uint8_t end = RECS_DIFF_END;
+  recs_diff_put(&w, &end, 1);
+  recs_diff_flush(&w);
+  RECS_FREE(buffer);
+
+  //components written to after this are stamped with a newer tick, so a diff against a copy of new_ecs made
+  //after this one does not need to compare the components written before it
+  recs_next_change_tick(new_ecs);
+  return w.failed ? 0 : w.size;
+}
+
+static int recs_diff_get(struct recs_diff_reader *r, void *data, size_t size) {
+  uint8_t *bytes = (uint8_t*)data;
+  while(size > 0) {
+    if(r->block_pos == r->block_size) {
+      uint8_t length[2];
+      if(!r->read(r->userdata, length, sizeof(length))) {
+        return 0;
+      }
+      uint32_t block_size = length[0] | ((uint32_t)length[1] << 8);
+      if(block_size == 0 || block_size > RECS_DIFF_BLOCK_SIZE || !r->read(r->userdata, r->block, block_size)) {
+        return 0;
+      }
+      r->block_size = block_size;
+      r->block_pos = 0;
+    }
+
+    size_t n = r->block_size - r->block_pos;
+    n = n < size ? n : size;
+    memcpy(bytes, r->block + r->block_pos, n);
+    r->block_pos += (uint32_t)n;
+    bytes += n;
+    size -= n;
+  }
+  return 1;
+}
+
+//read a number, which must be less than limit
+static int recs_diff_get_number(struct recs_diff_reader *r, uint64_t limit, uint64_t *value) {
+  uint64_t result = 0;
+  for(uint32_t shift = 0; shift < 64; shift += 7) {
+    uint8_t byte;
+    if(!recs_diff_get(r, &byte, 1)) {
+      return 0;
+    }
+    result |= (uint64_t)(byte & 0x7F) << shift;
+    if((byte & 0x80) == 0) {
+      *value = result;
+      return result < limit;
+    }
+  }
+  return 0;
+}
+
+//add an entity with a specific handle, such as one created by another RECS instance
+static int recs_patch_spawn(struct recs *ecs, uint32_t id, uint32_t version) {
+  struct entity_manager *em = &ecs->ent_man;
+  if(id >= em->max_entities) {
+    if(!ecs->growable) {
+      return 0;
+    }
+    recs_entities_reserve(ecs, id + 1 - em->num_active_entities);
+  }
+
+  //an entity queued for removal still holds onto its ID
+  if(em->active_index[id] < em->num_active_entities) {
+    recs_entity_remove(ecs, entity_manager_get(em, id));
+  }
+
+  entity_manager_add_id(em, id, version, recs_dirty(ecs));
+  recs_entity_activate(ecs, id);
+  recs_queries_update(ecs, id, QUERY_ALL_BITS_CHANGED);
+  return 1;
+}
+
+//check if a component of type c can be added, since pools that can not grow must have a slot left for it
+static uint8_t recs_patch_has_room(struct recs *ecs, recs_component c) {
+  struct component_pool *p = ecs->recs_component_stores + c;
+  if(ecs->storage == RECS_STORAGE_ARCHETYPE) {
+    return p->num_components < p->max_components;
+  }
+  return p->growable || p->num_free > 0 || p->num_slots < p->max_components;
+}
+
+//apply the records of a diff until RECS_DIFF_END. component is big enough to hold any component.
+static int recs_patch_records(struct recs *ecs, struct recs_diff_reader *r, uint8_t *component) {
+  for(;;) {
+    uint8_t op;
+    uint64_t delta, value;
+    if(!recs_diff_get(r, &op, 1)) {
+      return 0;
+    }
+    if(op == RECS_DIFF_END) {
+      return 1;
+    }
+
+    if(!recs_diff_get_number(r, RECS_NO_ENTITY_ID - r->last_id, &delta)) {
+      return 0;
+    }
+    uint32_t id = r->last_id + (uint32_t)delta;
+    r->last_id = id;
+    recs_entity e = recs_diff_entity(ecs, id);
+
+    switch(op) {
+      case RECS_DIFF_DESPAWN:
+        if(e == RECS_NO_ENTITY) return 0;
+        recs_entity_remove(ecs, e);
+        break;
+      case RECS_DIFF_SPAWN:
+        if(e != RECS_NO_ENTITY || !recs_diff_get_number(r, (uint64_t)UINT32_MAX + 1, &value) || !recs_patch_spawn(ecs, id, (uint32_t)value)) return 0;
+        break;
+      case RECS_DIFF_REMOVE_COMPONENT:
+        if(e == RECS_NO_ENTITY || !recs_diff_get_number(r, ecs->max_registered_components, &value) || !recs_entity_has_component(ecs, e, (recs_component)value)) return 0;
+        recs_entity_remove_component(ecs, e, (recs_component)value);
+        break;
+      case RECS_DIFF_SET_COMPONENT: {
+        if(e == RECS_NO_ENTITY || !recs_diff_get_number(r, ecs->max_registered_components, &value)) return 0;
+        recs_component c = (recs_component)value;
+        size_t size = ecs->recs_component_stores[c].component_size;
+        if(!recs_diff_get(r, component, size)) return 0;
+        if(recs_entity_has_component(ecs, e, c)) {
+          recs_entity_scatter_component(ecs, e, c, component);
+        } else {
+          if(!recs_patch_has_room(ecs, c)) return 0;
+          recs_entity_add_component(ecs, e, c, component);
+        }
+        break;
+      }
+      case RECS_DIFF_PATCH_COMPONENT: {
+        if(e == RECS_NO_ENTITY || !recs_diff_get_number(r, ecs->max_registered_components, &value) || !recs_entity_has_component(ecs, e, (recs_component)value)) return 0;
+        recs_component c = (recs_component)value;
+        size_t size = ecs->recs_component_stores[c].component_size;
+
+        //the component is patched whole, then written back field by field if its type is split into fields
+        uint8_t *bytes = component;
+        if(ecs->recs_component_stores[c].num_fields != 0) {
+          memset(bytes, 0, size);
+        }
+        recs_entity_gather_component(ecs, e, c, bytes);
+        size_t pos = 0;
+        uint64_t skip, length;
+        do {
+          if(!recs_diff_get_number(r, size - pos + 1, &skip) || !recs_diff_get_number(r, size - pos - skip + 1, &length)) return 0;
+          pos += (size_t)skip;
+          if(!recs_diff_get(r, bytes + pos, (size_t)length)) return 0;
+          pos += (size_t)length;
+        } while(length != 0);
+        recs_entity_scatter_component(ecs, e, c, bytes);
+        break;
+      }
+      case RECS_DIFF_ADD_TAG:
+      case RECS_DIFF_REMOVE_TAG:
+        if(e == RECS_NO_ENTITY || !recs_diff_get_number(r, ecs->max_tags, &value)) return 0;
+        if(op == RECS_DIFF_ADD_TAG) {
+          recs_entity_add_tag(ecs, e, (recs_tag)value);
+        } else {
+          recs_entity_remove_tag(ecs, e, (recs_tag)value);
+        }
+        break;
+      default:
+        return 0;
+    }
+  }
+}
+
+int recs_patch(struct recs *ecs, recs_stream_read_func read, void *userdata) {
+  struct recs_diff_reader r;
+  r.read = read;
+  r.userdata = userdata;
+  r.last_id = 0;
+  r.block_size = 0;
+  r.block_pos = 0;
+
+  //the diff must have been made by this version of RECS, with the same component types and tags
+  char magic[4];
+  uint64_t value;
+  if(!recs_diff_get(&r, magic, sizeof(magic)) || memcmp(magic, RECS_DIFF_MAGIC, sizeof(magic)) != 0 ||
+    !recs_diff_get_number(&r, UINT64_MAX, &value) || value != RECS_DIFF_VERSION ||
+    !recs_diff_get_number(&r, UINT64_MAX, &value) || value != ecs->max_registered_components ||
+    !recs_diff_get_number(&r, UINT64_MAX, &value) || value != ecs->max_tags) {
+    return 0;
+  }
+
+  size_t max_size = 1;
+  for(uint32_t i = 0; i < ecs->max_registered_components; i++) {
+    size_t size = ecs->recs_component_stores[i].component_size;
+    if(!recs_diff_get_number(&r, UINT64_MAX, &value) || value != size) {
+      return 0;
+    }
+    max_size = size > max_size ? size : max_size;
+  }
+
+  //holds components added to entities that did not have them yet
+  uint8_t *component = (uint8_t*)RECS_MALLOC(max_size);
+  if(component == NULL) {
+    return 0;
+  }
+  int patched = recs_patch_records(ecs, &r, component);
+  RECS_FREE(component);
+  return patched;
+}
+
+void recs_free(struct recs *ecs) {
+  if(ecs == NULL) {
+    return;
+  }
+
+  //growable RECS instances also allocate their entity buffer and component pages separately
+  if(ecs->growable) {
+    for(uint32_t i = 0; i < ecs->max_registered_components; i++) {
+      component_pool_free_pages(ecs->recs_component_stores + i);
+    }
+    if(ecs->entity_buffer != NULL) {
+      RECS_FREE(ecs->entity_buffer);
+    }
+  }
+
+  //remember that we made 1 BIG allocation to store all data, starting at where the struct recs is at
+  RECS_FREE(ecs);
+}
+
+void recs_memory_usage(struct recs *ecs, struct recs_memory_usage *usage) {
+  usage->total_bytes = ecs->buffer_size + (ecs->growable ? ecs->entity_buffer_size : 0);
+  usage->entity_to_comp_bytes = 0;
+  usage->entity_to_comp_used_bytes = 0;
+
+  for(uint32_t i = 0; i < ecs->max_registered_components && ecs->storage == RECS_STORAGE_SPARSE_SET; i++) {
+    struct component_pool *p = ecs->recs_component_stores + i;
+    usage->total_bytes += component_pool_pages_size(p);
+    usage->entity_to_comp_bytes += sparse_map_buffer_size(p->entity_to_comp.max_ids, p->entity_to_comp.max_pages);
+    usage->entity_to_comp_used_bytes += sparse_map_used_size(&p->entity_to_comp);
+  }
+}
+
+
+uint32_t recs_component_num_instances(struct recs *recs, recs_component c) {
+  struct component_pool *p = recs->recs_component_stores + c;
+  return p->num_components;
+}
+
+uint32_t recs_component_num_slots(struct recs *recs, recs_component c) {
+  struct component_pool *p = recs->recs_component_stores + c;
+  return recs->storage == RECS_STORAGE_ARCHETYPE ? p->num_components : p->num_slots;
+}
+
+void recs_component_pool_compact(struct recs *recs, recs_component c) {
+  if(recs->storage == RECS_STORAGE_ARCHETYPE) {
+    return;
+  }
+  component_pool_compact(recs->recs_component_stores + c, recs_dirty(recs));
+}
+
+//a component's sort key, along with the slot it came from so that components with equal keys keep their order
+struct pool_sort_entry {
+  uint64_t key;
+  uint32_t slot;
+};
+
+static int pool_sort_entry_compare(const void *a, const void *b) {
+  const struct pool_sort_entry *x = (const struct pool_sort_entry*)a;
+  const struct pool_sort_entry *y = (const struct pool_sort_entry*)b;
+  if(x->key != y->key) return x->key < y->key ? -1 : 1;
+  return x->slot < y->slot ? -1 : (x->slot > y->slot);
+}
+
+static uint64_t recs_component_key(struct recs *ecs, struct component_pool *p, uint32_t slot, recs_component_key_func key, void *userdata) {
+  uint32_t id = p->comp_to_entity[slot];
+  return key(component_pool_at(p, slot), RECS_ENT_FROM(id, ecs->ent_man.ent_versions_list[id]), userdata);
+}
+
+//get the group owning c's pool, or NULL. The group's entities are sorted among themselves, and moved the same way
+//in each pool of the group, while the rest of c's pool is sorted on its own.
+static struct component_group *recs_component_group(struct recs *ecs, recs_component c) {
+  uint32_t group = ecs->recs_component_stores[c].group;
+  return group == NO_GROUP_ID ? NULL : ecs->groups + group;
+}
+
+int recs_component_pool_sort(struct recs *recs, recs_component c, recs_component_key_func key, void *userdata) {
+  if(recs->storage == RECS_STORAGE_ARCHETYPE) {
+    return 1;
+  }
+  struct component_pool *p = recs->recs_component_stores + c;
+
+  //keys are computed from whole components
+  RECS_ASSERT(p->num_fields == 0);
+  if(p->num_components < 2) {
+    return 1;
+  }
+
+  //the keys are computed once up front, then each pool is permuted into place
+  size_t entries_size = memory_align(sizeof(struct pool_sort_entry) * p->num_components);
+  uint8_t *scratch = (uint8_t*)RECS_MALLOC(entries_size + (sizeof(uint32_t) * p->num_components * 2));
+  if(scratch == NULL) {
+    return 0;
+  }
+  struct pool_sort_entry *entries = (struct pool_sort_entry*)scratch;
+  uint32_t *order = (uint32_t*)(scratch + entries_size);
+  uint32_t *work = order + p->num_components;
+
+  component_pool_compact(p, recs_dirty(recs));
+
+  struct component_group *g = recs_component_group(recs, c);
+  uint32_t group_end = g != NULL ? g->num_entities : 0;
+  for(uint32_t range = 0; range < 2; range++) {
+    uint32_t first = range == 0 ? 0 : group_end;
+    uint32_t end = range == 0 ? group_end : p->num_slots;
+    uint32_t n = end - first;
+    if(n < 2) continue;
+
+    for(uint32_t i = 0; i < n; i++) {
+      entries[i].key = recs_component_key(recs, p, first + i, key, userdata);
+      entries[i].slot = i;
+    }
+    qsort(entries, n, sizeof(struct pool_sort_entry), pool_sort_entry_compare);
+    for(uint32_t i = 0; i < n; i++) {
+      order[i] = entries[i].slot;
+    }
+
+    if(range == 1) {
+      component_pool_permute(p, first, n, order, recs_dirty(recs));
+      continue;
+    }
+    for(uint32_t i = 0; i < g->num_comps; i++) {
+      memcpy(work, order, sizeof(uint32_t) * n);
+      component_pool_permute(recs->recs_component_stores + g->comps[i], first, n, work, recs_dirty(recs));
+    }
+  }
+
+  RECS_FREE(scratch);
+  return 1;
+}
+
+void recs_component_pool_sort_incremental(struct recs *recs, recs_component c, recs_component_key_func key, void *userdata) {
+  if(recs->storage == RECS_STORAGE_ARCHETYPE) {
+    return;
+  }
+  struct component_pool *p = recs->recs_component_stores + c;
+  RECS_ASSERT(p->num_fields == 0);
+  component_pool_compact(p, recs_dirty(recs));
+
+  struct component_group *g = recs_component_group(recs, c);
+  uint32_t group_end = g != NULL ? g->num_entities : 0;
+
+  //insertion sort, which only moves the components that are out of order
+  for(uint32_t range = 0; range < 2; range++) {
+    uint32_t first = range == 0 ? 0 : group_end;
+    uint32_t end = range == 0 ? group_end : p->num_slots;
+
+    for(uint32_t i = first + 1; i < end; i++) {
+      uint64_t k = recs_component_key(recs, p, i, key, userdata);
+      for(uint32_t j = i; j > first && recs_component_key(recs, p, j - 1, key, userdata) > k; j--) {
+        if(range == 1) {
+          component_pool_swap(p, j - 1, j, recs_dirty(recs));
+          continue;
+        }
+        for(uint32_t pool = 0; pool < g->num_comps; pool++) {
+          component_pool_swap(recs->recs_component_stores + g->comps[pool], j - 1, j, recs_dirty(recs));
+        }
+      }
+    }
+  }
+}
+
+void *recs_component_field(struct recs *recs, recs_component c, uint32_t field, uint32_t index, uint32_t *count) {
+  struct component_pool *p = recs->recs_component_stores + c;
+  RECS_ASSERT(field < p->num_fields);
+  if(index >= p->num_slots) {
+    return NULL;
+  }
+
+  //a column only runs until the end of its block
+  if(count != NULL) {
+    uint64_t block_end = (uint64_t)(index & ~p->field_block_mask) + p->field_block_size;
+    *count = (uint32_t)((block_end < p->num_slots ? block_end : p->num_slots) - index);
+  }
+  return component_pool_field_at(p, index, field);
+}
+
+recs_entity recs_component_get_entity(struct recs *recs, recs_component c, uint32_t comp_index) {
+  uint32_t id = RECS_NO_ENTITY_ID;
+  if(recs->storage == RECS_STORAGE_ARCHETYPE) {
+    archetype_storage_get_instance(&recs->archetypes, c, comp_index, &id);
+  } else {
+    id = recs->recs_component_stores[c].comp_to_entity[comp_index];
+  }
+
+  if(id == RECS_NO_ENTITY_ID) {
+    return RECS_ENT_FROM(RECS_NO_ENTITY_ID, 0);
+  }
+  return RECS_ENT_FROM(id, recs->ent_man.ent_versions_list[id]);
+}
+
+
+
+
+
+
+size_t recs_component_size(struct recs *recs, recs_component c) {
+  return recs->recs_component_stores[c].component_size;
+}
+
+uint32_t recs_num_component_types(struct recs *recs) {
+  return recs->max_registered_components;
+}
+
+
+void recs_system_set_context(struct recs *ecs, void *context) {
+  ecs->system_context = context;
+}
+
+void* recs_system_get_context(struct recs *ecs) {
+  return ecs->system_context;
+}
+
+
+uint32_t recs_system_last_run_tick(struct recs *ecs) {
+  return ecs->system_last_run_tick;
+}
+
+uint32_t recs_next_change_tick(struct recs *ecs) {
+  return ecs->change_tick++;
+}
+
+uint32_t recs_component_events_drain(struct recs *ecs, recs_component c, struct recs_component_event *events, uint32_t max_events) {
+  struct event_queue *q = &ecs->recs_component_stores[c].events;
+  RECS_ASSERT(q->capacity != 0);
+  return event_queue_drain(q, events, max_events);
+}
+
+uint32_t recs_component_events_count(struct recs *ecs, recs_component c) {
+  return ecs->recs_component_stores[c].events.count;
+}
+
+uint32_t recs_component_events_num_dropped(struct recs *ecs, recs_component c) {
+  return ecs->recs_component_stores[c].events.num_dropped;
+}
+
+void recs_system_run(struct recs *ecs, recs_system_group type) {
+  uint32_t system_group_start_index = ecs->system_group_mappers[type].starting_index;
+  uint32_t num_systems = ecs->system_group_mappers[type].num_systems;
+  for(uint32_t i = 0; i < num_systems; i++) {
+    struct recs_system *s = ecs->systems + system_group_start_index + i;
+
+    //the system's own writes get a tick of their own, so it only sees them again if something else changes them afterwards
+    ecs->system_last_run_tick = s->last_run_tick;
+    s->last_run_tick = ++ecs->change_tick;
+    s->func(ecs);
+    ecs->change_tick++;
+  }
+}
+
+//shared by every thread while running a group of systems in parallel
+struct system_schedule {
+  struct recs *ecs;
+  struct recs_workers *workers;
+  uint32_t num_systems;
+  uint32_t num_finished;
+
+  //systems between queue_start and queue_end inside ecs->system_ready_queue are ready to run
+  uint32_t queue_start;
+  uint32_t queue_end;
+};
+
+static void recs_system_schedule_job(void *arg, uint32_t thread_index) {
+  (void)thread_index;
+  struct system_schedule *sched = (struct system_schedule*)arg;
+  struct recs *ecs = sched->ecs;
+
+  workers_lock(sched->workers);
+  while(sched->num_finished < sched->num_systems) {
+    if(sched->queue_start == sched->queue_end) {
+      workers_wait(sched->workers);
+      continue;
+    }
+
+    struct recs_system *s = ecs->systems + ecs->system_ready_queue[sched->queue_start++];
+
+    workers_unlock(sched->workers);
+    s->func(ecs);
+    workers_lock(sched->workers);
+
+    sched->num_finished++;
+
+    //any system that was only waiting on this one can run now
+    for(uint32_t i = 0; i < s->num_dependents; i++) {
+      uint32_t d = s->dependents[i];
+      if(--ecs->system_dependencies_left[d] == 0) {
+        ecs->system_ready_queue[sched->queue_end++] = d;
+      }
+    }
+    workers_wake_all(sched->workers);
+  }
+  workers_unlock(sched->workers);
+}
+
+void recs_system_run_parallel(struct recs *ecs, recs_workers workers, recs_system_group type) {
+  struct system_group_mapper *m = ecs->system_group_mappers + type;
+  if(workers == NULL || recs_workers_num_threads(workers) == 1 || m->num_systems <= 1) {
+    recs_system_run(ecs, type);
+    return;
+  }
+
+  struct system_schedule sched = {
+    .ecs = ecs,
+    .workers = workers,
+    .num_systems = m->num_systems,
+    .num_finished = 0,
+    .queue_start = 0,
+    .queue_end = 0
+  };
+
+  //every system in the group shares one tick, since the tick cannot change while they are running
+  uint32_t last_run_tick = UINT32_MAX;
+  uint32_t tick = ++ecs->change_tick;
+  for(uint32_t i = m->starting_index; i < m->starting_index + m->num_systems; i++) {
+    ecs->system_dependencies_left[i] = ecs->systems[i].num_dependencies;
+    if(ecs->systems[i].num_dependencies == 0) {
+      ecs->system_ready_queue[sched.queue_end++] = i;
+    }
+
+    last_run_tick = ecs->systems[i].last_run_tick < last_run_tick ? ecs->systems[i].last_run_tick : last_run_tick;
+    ecs->systems[i].last_run_tick = tick;
+  }
+  ecs->system_last_run_tick = last_run_tick;
+
+  workers_run(workers, recs_system_schedule_job, &sched);
+  ecs->change_tick++;
+}
+
+
+recs_entity recs_entity_add(struct recs *ecs) {
+  recs_entities_reserve(ecs, 1);
+
+  recs_entity e = entity_manager_add(&ecs->ent_man, recs_dirty(ecs));
+  recs_entity_activate(ecs, RECS_ENT_ID(e));
+
+  //queries that only exclude components may already match this entity
+  recs_queries_update(ecs, RECS_ENT_ID(e), QUERY_ALL_BITS_CHANGED);
+  return e;
+  
+}
+
+void recs_entity_add_bulk(struct recs *ecs, uint32_t n, recs_entity *out_entities, uint8_t *signature_mask, const void * const *component_arrays) {
+  if(n == 0) return;
+  recs_entities_reserve(ecs, n);
+
+  entity_manager_add_bulk(&ecs->ent_man, n, out_entities, recs_dirty(ecs));
+  for(uint32_t i = 0; i < n; i++) {
+    recs_entity_activate(ecs, RECS_ENT_ID(out_entities[i]));
+  }
+
+  if(signature_mask != NULL) {
+    for(recs_component c = 0; c < ecs->max_registered_components; c++) {
+      if(!bitmask_test(signature_mask, c)) continue;
+
+      RECS_ASSERT(component_arrays != NULL && component_arrays[c] != NULL);
+      struct component_pool *ca = ecs->recs_component_stores + c;
+
+      if(ecs->storage == RECS_STORAGE_ARCHETYPE) {
+        //entities move through archetypes one component at a time, so there is no contiguous range to copy into
+        RECS_ASSERT(n <= ca->max_components - ca->num_components);
+        ca->num_components += n;
+        const uint8_t *data = component_arrays[c];
+        for(uint32_t i = 0; i < n; i++) {
+          archetype_storage_add_component(&ecs->archetypes, RECS_ENT_ID(out_entities[i]), c, data + (size_t)ca->component_size * i);
+        }
+      } else {
+        component_pool_add_bulk(ca, out_entities, n, component_arrays[c], ecs->change_tick, recs_dirty(ecs));
+      }
+    }
+
+    //new entities having every component of a group move to the front of the group's pools
+    for(recs_component c = 0; c < ecs->max_registered_components && ecs->num_groups > 0; c++) {
+      if(!bitmask_test(signature_mask, c)) continue;
+
+      for(uint32_t i = 0; i < n; i++) {
+        recs_group_on_add(ecs, RECS_ENT_ID(out_entities[i]), c);
+      }
+    }
+
+    //every new entity gets the same bitmask row, since their rows were cleared when they were last removed
+    for(uint32_t i = 0; i < n; i++) {
+      memcpy(recs_entity_mask_for_write(ecs, RECS_ENT_ID(out_entities[i])), signature_mask, ecs->comp_bitmask_size);
+    }
+    for(uint32_t bit = 0; bit < ecs->max_registered_components + ecs->max_tags; bit++) {
+      if(!bitmask_test(signature_mask, bit)) continue;
+
+      for(uint32_t i = 0; i < n; i++) {
+        column_index_set(&ecs->columns, bit, RECS_ENT_ID(out_entities[i]), 1, recs_dirty(ecs));
+      }
+    }
+  }
+
+  for(uint32_t i = 0; i < n; i++) {
+    recs_queries_update(ecs, RECS_ENT_ID(out_entities[i]), QUERY_ALL_BITS_CHANGED);
+  }
+}
+
+void recs_entity_remove(struct recs *ecs, recs_entity e) {
+  if(RECS_ENT_ID(e) == RECS_NO_ENTITY_ID) return;
+
+  //update version number
+  if(RECS_ENT_VERSION(e) == ecs->ent_man.ent_versions_list[RECS_ENT_ID(e)]) {
+    recs_entity_version_bump(ecs, RECS_ENT_ID(e));
+  }
+
+
+
+  //delete components
   recs_entity_remove_all_components(ecs, e);
 
   //remove from active entity pool
-  entity_manager_remove(&ecs->ent_man, e);
+  entity_manager_remove(&ecs->ent_man, e, recs_dirty(ecs));
+
+  //a queued entity removed directly no longer needs to be removed by recs_entity_remove_queued()
+  uint32_t id = RECS_ENT_ID(e);
+  if(column_index_test(&ecs->columns, ecs->columns.queued_column, id) && ecs->ent_man.active_index[id] >= ecs->ent_man.num_active_entities) {
+    column_index_set(&ecs->columns, ecs->columns.queued_column, id, 0, recs_dirty(ecs));
+  }
+}
 
+void recs_entity_remove_bulk(struct recs *ecs, uint32_t n, const recs_entity *entities) {
+  //each removal already runs in constant time, so there is nothing to gain from grouping them
+  for(uint32_t i = 0; i < n; i++) {
+    if(recs_entity_active(ecs, entities[i])) {
+      recs_entity_remove(ecs, entities[i]);
+    }
+  }
 }
 
 void recs_entity_queue_remove(struct recs *ecs, recs_entity e) {
-  ecs->ent_man.ent_versions_list[RECS_ENT_ID(e)]++;
+  recs_entity_version_bump(ecs, RECS_ENT_ID(e));
+
+  //remember the entity, so that recs_entity_remove_queued() does not need to look through every active entity
+  if(ecs->ent_man.active_index[RECS_ENT_ID(e)] < ecs->ent_man.num_active_entities) {
+    column_index_set(&ecs->columns, ecs->columns.queued_column, RECS_ENT_ID(e), 1, recs_dirty(ecs));
+  }
+
+  //queued entities are no longer found by queries
+  recs_queries_update(ecs, RECS_ENT_ID(e), QUERY_ALL_BITS_CHANGED);
 }
 
 void recs_entity_remove_queued(struct recs *ecs) {
-  if(ecs->ent_man.num_active_entities == 0) return;
+  struct entity_manager *em = &ecs->ent_man;
+  struct column_index *ci = &ecs->columns;
+  const uint32_t end_id = em->num_used_ids;
+
+  //only visit the queued entities, skipping each range of 4096 entity IDs without any at once
+  for(uint32_t id = column_index_find(ci, ci->queued_column, 0, end_id); id < end_id; id = column_index_find(ci, ci->queued_column, id + 1, end_id)) {
+    column_index_set(ci, ci->queued_column, id, 0, recs_dirty(ecs));
 
-  //move in reversed order since the index does not need to be modified when removing entities
-  for(uint32_t i = ecs->ent_man.num_active_entities; i > 0; i--) {
-    recs_entity e = ecs->ent_man.entity_pool[i-1];
-    if(recs_entity_active(ecs, e)) continue;
+    uint32_t index = em->active_index[id];
+    if(index >= em->num_active_entities || recs_entity_active(ecs, em->entity_pool[index])) continue;
 
     //delete components
-    recs_entity_remove_all_components(ecs, e);
+    recs_entity_remove_all_components(ecs, em->entity_pool[index]);
 
     //remove from active entity pool
-    entity_manager_remove_at_index(&ecs->ent_man, i-1);
-
-
+    entity_manager_remove_at_index(em, index, recs_dirty(ecs));
   }
 }
 
@@ -486,41 +2415,86 @@ void recs_entity_remove_queued(struct recs *ecs) {
 void recs_entity_add_component(struct recs *ecs, recs_entity e, recs_component comp_type, void *component) {
 
   struct component_pool *ca = ecs->recs_component_stores + comp_type;
-  component_pool_add(ca, e, component);
+  if(ecs->storage == RECS_STORAGE_ARCHETYPE) {
+    if(!recs_entity_has_component(ecs, e, comp_type)) {
+      RECS_ASSERT(ca->num_components < ca->max_components);
+      ca->num_components++;
+    }
+    archetype_storage_add_component(&ecs->archetypes, RECS_ENT_ID(e), comp_type, component);
+  } else {
+    component_pool_add(ca, e, component, ecs->change_tick, recs_dirty(ecs));
+    recs_group_on_add(ecs, RECS_ENT_ID(e), comp_type);
+  }
 
   //set bit
-  bitmask_set(bitmask_list_get(&ecs->comp_bitmask_list, e), comp_type, 1);
+  recs_entity_mask_set(ecs, RECS_ENT_ID(e), comp_type, 1);
+  recs_queries_update(ecs, RECS_ENT_ID(e), comp_type);
 }
 
 void recs_entity_add_tag(struct recs *ecs, recs_entity e, recs_tag tag) {
-  bitmask_set(bitmask_list_get(&ecs->comp_bitmask_list, RECS_ENT_ID(e)), recs_tag_id_to_comp_id(ecs, tag), 1);
+  uint32_t bit = recs_tag_id_to_comp_id(ecs, tag);
+  recs_entity_mask_set(ecs, RECS_ENT_ID(e), bit, 1);
+  recs_queries_update(ecs, RECS_ENT_ID(e), bit);
 }
 
 void recs_entity_remove_component(struct recs *ecs, recs_entity e, recs_component comp_type) {
   struct component_pool *ca =  ecs->recs_component_stores + comp_type;
-  component_pool_remove(ca, e);
+  if(ecs->storage == RECS_STORAGE_ARCHETYPE) {
+    if(recs_entity_has_component(ecs, e, comp_type)) {
+      ca->num_components--;
+    }
+    archetype_storage_remove_component(&ecs->archetypes, RECS_ENT_ID(e), comp_type);
+  } else {
+    recs_group_on_remove(ecs, RECS_ENT_ID(e), comp_type);
+    component_pool_remove(ca, e, recs_dirty(ecs));
+  }
 
   //clear bit
-  bitmask_set(bitmask_list_get(&ecs->comp_bitmask_list, RECS_ENT_ID(e)), comp_type, 0);
+  recs_entity_mask_set(ecs, RECS_ENT_ID(e), comp_type, 0);
+  recs_queries_update(ecs, RECS_ENT_ID(e), comp_type);
 
 }
 
 void recs_entity_remove_tag(struct recs *ecs, recs_entity e, recs_tag tag) {
-  bitmask_set(bitmask_list_get(&ecs->comp_bitmask_list, RECS_ENT_ID(e)), recs_tag_id_to_comp_id(ecs, tag), 0);
+  uint32_t bit = recs_tag_id_to_comp_id(ecs, tag);
+  recs_entity_mask_set(ecs, RECS_ENT_ID(e), bit, 0);
+  recs_queries_update(ecs, RECS_ENT_ID(e), bit);
 }
 
 void recs_entity_remove_all_components(struct recs *ecs, recs_entity e) {
-
-  //remove components from component arrays
-  for(recs_component t = 0; t < ecs->max_registered_components; t++) {
-    if(bitmask_test(bitmask_list_get(&ecs->comp_bitmask_list, RECS_ENT_ID(e)), t)) {
-      recs_entity_remove_component(ecs, e, t);
-
+  uint8_t *mask = recs_entity_mask_for_write(ecs, RECS_ENT_ID(e));
+
+  //entities usually only have a few components and tags, so skip over whole words with no bits set, then
+  //visit each set bit. Every column is cleared here, while the bitmask (tags included) is cleared below.
+  const uint32_t num_words = ecs->comp_bitmask_size / sizeof(uint64_t);
+  for(uint32_t w = 0; w < num_words; w++) {
+    if(bitmask_load_word(mask, w) == 0) continue;
+
+    for(uint32_t byte = 0; byte < sizeof(uint64_t); byte++) {
+      uint8_t bits = mask[(w * sizeof(uint64_t)) + byte];
+      for(; bits != 0; bits &= (uint8_t)(bits - 1)) {
+        uint32_t t = (w * 64) + (byte * 8) + bitmask_ctz64(bits);
+        column_index_set(&ecs->columns, t, RECS_ENT_ID(e), 0, recs_dirty(ecs));
+        if(t >= ecs->max_registered_components) continue;
+
+        if(ecs->storage == RECS_STORAGE_ARCHETYPE) {
+          ecs->recs_component_stores[t].num_components--;
+        } else {
+          recs_group_on_remove(ecs, RECS_ENT_ID(e), t);
+          component_pool_remove(ecs->recs_component_stores + t, e, recs_dirty(ecs));
+        }
+      }
     }
   }
 
+  //in archetype mode, move straight to the empty archetype rather than moving through an archetype for each component
+  if(ecs->storage == RECS_STORAGE_ARCHETYPE) {
+    archetype_storage_clear(&ecs->archetypes, RECS_ENT_ID(e));
+  }
+
   //mark entity as having no components to clear tags
-  bitmask_clear(bitmask_list_get(&ecs->comp_bitmask_list, e), 0, ecs->comp_bitmask_size);
+  bitmask_clear(mask, 0, ecs->comp_bitmask_size);
+  recs_queries_update(ecs, RECS_ENT_ID(e), QUERY_ALL_BITS_CHANGED);
 
 }
 
@@ -532,88 +2506,128 @@ int recs_entity_has_tag(struct recs *ecs, recs_entity e, recs_tag tag) {
   return bitmask_test(bitmask_list_get(&ecs->comp_bitmask_list, RECS_ENT_ID(e)), recs_tag_id_to_comp_id(ecs, tag));
 }
 
-void* recs_entity_get_component(struct recs *ecs, recs_entity e, recs_component c) {
+static inline void* recs_component_lookup(struct recs *ecs, recs_entity e, recs_component c) {
+  if(ecs->storage == RECS_STORAGE_ARCHETYPE) {
+    return archetype_storage_get(&ecs->archetypes, RECS_ENT_ID(e), c);
+  }
   return component_pool_get(ecs->recs_component_stores + c, e);
 }
 
-//components are densely packed, so you can retrieve them using an index
-//if desired. Note that components will not stay at the same index when removing
-//components, so make sure not to remove components when using this function
-void* recs_component_get(struct recs *recs, recs_component c, uint32_t index) {
-  struct component_pool *p = recs->recs_component_stores + c;
-  return p->buffer + (index * p->component_size);
+void* recs_entity_get_component(struct recs *ecs, recs_entity e, recs_component c) {
+  return recs_component_lookup(ecs, e, c);
 }
 
+void* recs_entity_get_component_mut(struct recs *ecs, recs_entity e, recs_component c) {
+  if(ecs->storage == RECS_STORAGE_SPARSE_SET) {
+    return component_pool_get_mut(ecs->recs_component_stores + c, e, ecs->change_tick, recs_dirty(ecs));
+  }
 
+  void *component = recs_component_lookup(ecs, e, c);
+  if(component != NULL) {
+    dirty_mark(recs_dirty(ecs), component, ecs->recs_component_stores[c].component_size);
+  }
+  return component;
+}
 
-int recs_entity_matches_component_mask(struct recs *ecs, recs_entity e, uint8_t *mask, enum recs_ent_match_op match_op) {
+int recs_entity_gather_component(struct recs *ecs, recs_entity e, recs_component c, void *component) {
+  if(ecs->storage == RECS_STORAGE_ARCHETYPE) {
+    void *found = recs_component_lookup(ecs, e, c);
+    if(found == NULL) {
+      return 0;
+    }
+    memcpy(component, found, ecs->recs_component_stores[c].component_size);
+    return 1;
+  }
 
-  uint8_t *mask_for_entity = bitmask_list_get(&ecs->comp_bitmask_list, RECS_ENT_ID(e));
+  struct component_pool *p = ecs->recs_component_stores + c;
+  uint32_t component_index = sparse_map_get(&p->entity_to_comp, RECS_ENT_ID(e));
+  if(component_index == NO_COMP_ID) {
+    return 0;
+  }
+  component_pool_gather(p, component_index, component);
+  return 1;
+}
 
-  //check all bytes except last one
-  for(uint32_t i = 0; i < ecs->comp_bitmask_size - 1; i++) {
-    uint8_t res = mask_for_entity[i] & mask[i];
-    switch(match_op) {
-      case RECS_ENT_MATCH_ALL: {
-        if(res != mask[i]) {
-          return 0;
-        }
-        break;
-      }
-      case RECS_ENT_MATCH_ANY: {
-        if(res != 0) {
-          return 1;
-        }
-        break;
-      }
+int recs_entity_scatter_component(struct recs *ecs, recs_entity e, recs_component c, const void *component) {
+  if(ecs->storage == RECS_STORAGE_ARCHETYPE) {
+    void *found = recs_entity_get_component_mut(ecs, e, c);
+    if(found == NULL) {
+      return 0;
     }
-    
+    memcpy(found, component, ecs->recs_component_stores[c].component_size);
+    return 1;
+  }
+
+  struct component_pool *p = ecs->recs_component_stores + c;
+  uint32_t component_index = sparse_map_get(&p->entity_to_comp, RECS_ENT_ID(e));
+  if(component_index == NO_COMP_ID) {
+    return 0;
   }
+  component_pool_scatter(p, component_index, component, recs_dirty(ecs));
+  component_pool_touch(p, component_index, ecs->change_tick, recs_dirty(ecs));
+  return 1;
+}
 
-  //only check the LSB on the last byte
+int recs_entity_component_changed(struct recs *ecs, recs_entity e, recs_component c, enum recs_change_filter filter, uint32_t since_tick) {
+  struct component_pool *p = ecs->recs_component_stores + c;
+  RECS_ASSERT(p->changed_ticks != NULL);
 
-  //get number of bits (starting from MSB) that we are setting to 0 so that we can check the equality of the LSB bits.
-  
-  //do not account for when mask_bits == 0, as this should not be possible
-  //when mask_bits = 1, num_unused_bits = 7
-  //when mask_bits = 2, num_unused_bits = 6
-  //when mask_bits = 3, num_unused_bits = 5
-  //when mask_bits = 4, num_unused_bits = 4
-  //when mask_bits = 7, num_unused_bits = 1
-  //when mask_bits = 8, num_unused_bits = 0
-  //when mask_bits = 9, num_unused_bits = 7
-  
-  // if mask_bits % 8 != 0
-    //num_unused_bits == 8 - (mask_bits % 8) == 8 - (mask_bits & 7)
-  // else
-  // num_unused_bits = 0
-  
-  const uint32_t mask_bits = ecs->max_registered_components + ecs->max_tags;
-  const uint8_t num_unused_bits = (mask_bits & 7) == 0 ? 0 : 8 - (mask_bits & 7);
+  uint32_t component_index = sparse_map_get(&p->entity_to_comp, RECS_ENT_ID(e));
+  if(component_index == NO_COMP_ID) {
+    return 0;
+  }
+  return filter == RECS_CHANGE_NONE || component_pool_changed_since(p, component_index, filter == RECS_CHANGE_ADDED, since_tick);
+}
 
-  
+//components are densely packed, so you can retrieve them using an index
+//if desired. Note that components will not stay at the same index when removing
+//components, so make sure not to remove components when using this function
+//(unless the component type uses RECS_REMOVAL_STABLE, whose free slots return NULL)
+void* recs_component_get(struct recs *recs, recs_component c, uint32_t index) {
+  if(recs->storage == RECS_STORAGE_ARCHETYPE) {
+    return archetype_storage_get_instance(&recs->archetypes, c, index, NULL);
+  }
 
+  //pools split into fields hold no whole components
+  struct component_pool *p = recs->recs_component_stores + c;
+  if(p->num_fields != 0 || (p->occupancy != NULL && !component_pool_slot_used(p, index))) {
+    return NULL;
+  }
+  return component_pool_at(p, index);
+}
 
 
 
+static inline int recs_mask_matches(struct recs *ecs, uint8_t *mask_for_entity, uint8_t *mask, enum recs_ent_match_op match_op) {
 
+  //bitmasks are padded to whole 64-bit words, and every bit past the last tag is always 0,
+  //so we can compare entire words without masking off the unused bits.
+  const uint32_t num_words = ecs->comp_bitmask_size / sizeof(uint64_t);
 
-  //grab the last byte and AND with (0xFF >> num_unused_bits) to set all unused MSB bits to 0
-  uint8_t last_byte1 = mask_for_entity[ecs->comp_bitmask_size-1] & ((uint8_t)0xFF >> num_unused_bits);
-  uint8_t last_byte2 = mask[ecs->comp_bitmask_size-1] & ((uint8_t)0xFF >> num_unused_bits);
+  //with 64 or less components and tags, the mask fits inside a single word, 
+  //so skip calling the matching kernel.
+  if(num_words == 1) {
+    uint64_t entity_word = bitmask_load_word(mask_for_entity, 0);
+    uint64_t mask_word = bitmask_load_word(mask, 0);
 
-  switch(match_op) {
-    case RECS_ENT_MATCH_ALL: {
-      return (last_byte1 & last_byte2) == last_byte2;
-    }
-    case RECS_ENT_MATCH_ANY: {
-      return (last_byte1 & last_byte2) != 0;
+    switch(match_op) {
+      case RECS_ENT_MATCH_ALL: return (entity_word & mask_word) == mask_word;
+      case RECS_ENT_MATCH_ANY: return (entity_word & mask_word) != 0;
     }
+    return 0;
+  }
 
+  switch(match_op) {
+    case RECS_ENT_MATCH_ALL: return ecs->mask_kernels.match_all(mask_for_entity, mask, num_words);
+    case RECS_ENT_MATCH_ANY: return ecs->mask_kernels.match_any(mask_for_entity, mask, num_words);
   }
   return 0;
 }
 
+int recs_entity_matches_component_mask(struct recs *ecs, recs_entity e, uint8_t *mask, enum recs_ent_match_op match_op) {
+  return recs_mask_matches(ecs, bitmask_list_get(&ecs->comp_bitmask_list, RECS_ENT_ID(e)), mask, match_op);
+}
+
 
 
 int recs_entity_has_components(struct recs *ecs, recs_entity e, uint8_t *mask) {
@@ -642,37 +2656,296 @@ void recs_bitmask_create(struct recs *ecs, uint8_t *mask, const uint32_t num_com
 }
 
 
-static recs_entity recs_ent_iter_find(struct recs *ecs, recs_ent_iter *iter) {
-  //assert that at least one of the 2 bitmasks are non-null
-  RECS_ASSERT(!(iter->include_bitmask == NULL && iter->exclude_bitmask == NULL));
+static inline uint8_t recs_ent_iter_matches(struct recs *ecs, recs_ent_iter *iter, recs_entity e) {
+  //skip over recently deleted entities that have not been removed from the
+  //active pool yet.
+  if(!recs_entity_active(ecs, e)) return 0;
 
+  uint8_t *mask_for_entity = bitmask_list_get(&ecs->comp_bitmask_list, RECS_ENT_ID(e));
 
-  for(; iter->index < ecs->ent_man.num_active_entities; iter->index++) {
-    recs_entity e = ecs->ent_man.entity_pool[iter->index];
+  uint8_t has_comps =    iter->include_bitmask == NULL || recs_mask_matches(ecs, mask_for_entity, iter->include_bitmask, iter->include_op);
+  uint8_t has_ex_comps = iter->exclude_bitmask == NULL || !recs_mask_matches(ecs, mask_for_entity, iter->exclude_bitmask, iter->exclude_op);
 
-    //skip over recently deleted entities that have not been removed from the
-    //active pool yet.
-    if(!recs_entity_active(ecs, e)) continue;
+  return has_comps && has_ex_comps;
+}
+
+//results of recs_archetype_matches()
+#define ARCHETYPE_SKIP 0
+#define ARCHETYPE_MATCH_ALL_ROWS 1
+#define ARCHETYPE_MATCH_EACH_ROW 2
+
+//check if the entities inside an archetype can match the iterator. Since tags are not part of 
+//an archetype, each entity still needs to be checked when the iterator's masks contain tags.
+static int recs_archetype_matches(struct recs *ecs, recs_ent_iter *iter, struct archetype *a) {
+  const uint8_t *component_bits = ecs->archetypes.component_bits;
+
+  uint8_t has_tags = 0;
+  for(uint32_t i = 0; i < ecs->comp_bitmask_size; i++) {
+    has_tags |= iter->include_bitmask[i] & ~component_bits[i];
+    if(iter->exclude_bitmask != NULL) {
+      has_tags |= iter->exclude_bitmask[i] & ~component_bits[i];
+    }
+  }
+
+  //every entity in this archetype has the exact same components
+  if(!has_tags) {
+    uint8_t has_comps = recs_mask_matches(ecs, a->signature, iter->include_bitmask, iter->include_op);
+    uint8_t has_ex_comps = iter->exclude_bitmask == NULL || !recs_mask_matches(ecs, a->signature, iter->exclude_bitmask, iter->exclude_op);
+    return has_comps && has_ex_comps ? ARCHETYPE_MATCH_ALL_ROWS : ARCHETYPE_SKIP;
+  }
+
+  //the archetype must contain all included components (archetypes are only searched 
+  //when using RECS_ENT_MATCH_ALL), and none of the excluded ones when using RECS_ENT_MATCH_ANY.
+  for(uint32_t i = 0; i < ecs->comp_bitmask_size; i++) {
+    if(iter->include_bitmask[i] & component_bits[i] & ~a->signature[i]) {
+      return ARCHETYPE_SKIP;
+    }
+    if(iter->exclude_bitmask != NULL && iter->exclude_op == RECS_ENT_MATCH_ANY && (iter->exclude_bitmask[i] & a->signature[i])) {
+      return ARCHETYPE_SKIP;
+    }
+  }
+
+  return ARCHETYPE_MATCH_EACH_ROW;
+}
+
+//search the column index for up to max_entities entities that match the iterator, in order of entity ID
+static uint32_t recs_ent_iter_fill_columns(struct recs *ecs, recs_ent_iter *iter, recs_entity *out_entities, uint32_t max_entities) {
+  //the masks are only decoded once a word needs to be matched, since most calls just take the next match left over from the last one
+  struct column_query q;
+  uint8_t decoded = 0;
+
+  const uint32_t num_words = column_index_num_words(ecs->ent_man.num_used_ids);
+  uint32_t group = UINT32_MAX;
+  uint64_t candidates = 0;
+  uint32_t count = 0;
+
+  //the matches left over from the last search are out of date if any bit changed since, so their word is matched again
+  if(iter->column_bits != 0 && iter->column_changes != ecs->columns.num_changes) {
+    column_query_init(&q, iter->include_bitmask, iter->include_op, iter->exclude_bitmask, iter->exclude_op, (uint32_t)ecs->comp_bitmask_size);
+    decoded = 1;
+    iter->column_bits &= column_index_match_word(&ecs->columns, &q, iter->index - 1);
+  }
+  iter->column_changes = ecs->columns.num_changes;
+
+  for(;;) {
+    for(; iter->column_bits != 0 && count < max_entities; iter->column_bits &= iter->column_bits - 1) {
+      uint32_t id = ((iter->index - 1) << 6) + bitmask_ctz64(iter->column_bits);
+      out_entities[count++] = entity_manager_get(&ecs->ent_man, id);
+    }
+    if(count == max_entities || iter->index >= num_words) {
+      return count;
+    }
+
+    if(!decoded) {
+      column_query_init(&q, iter->include_bitmask, iter->include_op, iter->exclude_bitmask, iter->exclude_op, (uint32_t)ecs->comp_bitmask_size);
+      decoded = 1;
+    }
+
+    //find the next word that may hold a match, skipping whole groups of words that the summaries rule out
+    if(iter->index / COLUMN_INDEX_BLOCK_WORDS != group) {
+      group = iter->index / COLUMN_INDEX_BLOCK_WORDS;
+      candidates = column_index_candidates(&ecs->columns, &q, group);
+    }
+    uint64_t left = candidates & (~(uint64_t)0 << (iter->index % COLUMN_INDEX_BLOCK_WORDS));
+    if(left == 0) {
+      iter->index = (group + 1) * COLUMN_INDEX_BLOCK_WORDS;
+      continue;
+    }
+
+    uint32_t word = (group * COLUMN_INDEX_BLOCK_WORDS) + bitmask_ctz64(left);
+    iter->column_bits = column_index_match_word(&ecs->columns, &q, word);
+    iter->index = word + 1;
+  }
+}
+
+//search for up to max_entities entities that match the iterator, storing them inside out_entities. 
+//Returns the number of entities found.
+static inline uint32_t recs_ent_iter_fill(struct recs *ecs, recs_ent_iter *iter, recs_entity *out_entities, uint32_t max_entities) {
+  //assert that at least one of the 2 bitmasks are non-null, unless the iterator filters by changes instead
+  RECS_ASSERT(!(iter->include_bitmask == NULL && iter->exclude_bitmask == NULL) || iter->change_filter != RECS_CHANGE_NONE);
+
+  if(iter->use_columns) {
+    return recs_ent_iter_fill_columns(ecs, iter, out_entities, max_entities);
+  }
+
+  uint32_t count = 0;
+
+  //only go through the archetypes containing every required component
+  if(iter->archetype != NO_ARCHETYPE) {
+    struct archetype_storage *s = &ecs->archetypes;
+
+    while(iter->archetype < s->num_archetypes && count < max_entities) {
+      struct archetype *a = s->archetypes + iter->archetype;
+
+      //just started searching this archetype
+      if(iter->chunk == NO_CHUNK) {
+        int match = recs_archetype_matches(ecs, iter, a);
+        if(match == ARCHETYPE_SKIP || a->first_chunk == NO_CHUNK) {
+          iter->archetype++;
+          continue;
+        }
+        iter->check_each_row = match == ARCHETYPE_MATCH_EACH_ROW;
+        iter->chunk = a->first_chunk;
+        iter->index = 0;
+      }
+
+      uint32_t *ids = archetype_storage_chunk_ids(s, iter->chunk);
+      uint32_t num_rows = s->chunk_count[iter->chunk];
+
+      for(; iter->index < num_rows && count < max_entities; iter->index++) {
+        recs_entity e = entity_manager_get(&ecs->ent_man, ids[iter->index]);
+
+        if(iter->check_each_row ? recs_ent_iter_matches(ecs, iter, e) : recs_entity_active(ecs, e)) {
+          out_entities[count++] = e;
+        }
+      }
+
+      //move to the next chunk, or the next archetype once we run out of chunks
+      if(iter->index >= num_rows) {
+        iter->chunk = s->chunk_next[iter->chunk];
+        iter->index = 0;
+        if(iter->chunk == NO_CHUNK) {
+          iter->archetype++;
+        }
+      }
+    }
+    return count;
+  }
+
+  //only go through the entities that own the rarest required component
+  if(iter->driving_component != RECS_NO_ENTITY_ID) {
+    struct component_pool *p = ecs->recs_component_stores + iter->driving_component;
+    uint8_t added_only = iter->change_filter == RECS_CHANGE_ADDED;
+
+    for(; iter->index < p->num_slots && count < max_entities; iter->index++) {
+      //skip the free slots of RECS_REMOVAL_STABLE pools, 64 at a time when possible
+      if(p->occupancy != NULL && !component_pool_slot_used(p, iter->index)) {
+        if(p->occupancy[iter->index >> 6] == 0) {
+          iter->index |= 63;
+        }
+        continue;
+      }
+
+      if(iter->change_filter != RECS_CHANGE_NONE && !component_pool_changed_since(p, iter->index, added_only, iter->change_since)) {
+        //skip to the end of the block when nothing inside it changed
+        if(!component_pool_block_changed_since(p, iter->index, iter->change_since)) {
+          iter->index |= COMPONENT_POOL_TICK_BLOCK_MASK;
+        }
+        continue;
+      }
 
-    //uint8_t has_comps =    iter->include_bitmask == NULL || (iter->include_bitmask != NULL && recs_entity_has_components(ecs, e, iter->include_bitmask));
-    //uint8_t has_ex_comps = iter->exclude_bitmask == NULL || (iter->exclude_bitmask != NULL && recs_entity_has_excluded_components(ecs, e, iter->exclude_bitmask));
+      recs_entity e = entity_manager_get(&ecs->ent_man, p->comp_to_entity[iter->index]);
 
-    uint8_t has_comps =    iter->include_bitmask == NULL || (iter->include_bitmask != NULL && recs_entity_matches_component_mask(ecs, e, iter->include_bitmask, iter->include_op));
-    uint8_t has_ex_comps = iter->exclude_bitmask == NULL || (iter->exclude_bitmask != NULL && !recs_entity_matches_component_mask(ecs, e, iter->exclude_bitmask, iter->exclude_op));
+      if(recs_ent_iter_matches(ecs, iter, e)) {
+        out_entities[count++] = e;
+      }
+    }
+    return count;
+  }
+
+  for(; iter->index < ecs->ent_man.num_active_entities && count < max_entities; iter->index++) {
+    recs_entity e = ecs->ent_man.entity_pool[iter->index];
 
-    if(has_comps && has_ex_comps) {
-      iter->index++;
-      return e;
+    if(recs_ent_iter_matches(ecs, iter, e)) {
+      out_entities[count++] = e;
     }
   }
   
-  return RECS_NO_ENTITY;
+  return count;
+}
+
+static recs_entity recs_ent_iter_find(struct recs *ecs, recs_ent_iter *iter) {
+  recs_entity e;
+  if(recs_ent_iter_fill(ecs, iter, &e, 1) == 0) {
+    return RECS_NO_ENTITY;
+  }
+  return e;
+}
+
+//pick the smallest component pool out of all components that an entity is required to have.
+//Returns RECS_NO_ENTITY_ID if the iterator has no required components, meaning that we need to
+//search through every active entity.
+static recs_component recs_ent_iter_pick_driver(struct recs *ecs, uint8_t *include_mask, enum recs_ent_match_op include_op) {
+  if(include_mask == NULL || include_op != RECS_ENT_MATCH_ALL) {
+    return RECS_NO_ENTITY_ID;
+  }
+
+  recs_component driver = RECS_NO_ENTITY_ID;
+  uint32_t smallest = UINT32_MAX;
+
+  //tags appear after components in the mask, so we only need to check the first max_registered_components bits
+  for(recs_component c = 0; c < ecs->max_registered_components; c++) {
+    //skip whole bytes with no components set
+    if(include_mask[BYTE_INDEX(c)] == 0) {
+      c |= 7;
+      continue;
+    }
+
+    if(!bitmask_test(include_mask, c)) continue;
+
+    //the iterator walks every slot of the pool, including free ones
+    uint32_t num_slots = ecs->recs_component_stores[c].num_slots;
+    if(num_slots < smallest) {
+      smallest = num_slots;
+      driver = c;
+    }
+  }
+
+  return driver;
+}
+
+//check if scanning the column index reads less memory than checking the bitmask row of each entity
+//inside the list of entities the iterator would otherwise go through
+static uint8_t recs_ent_iter_prefers_columns(struct recs *ecs, recs_ent_iter *iter) {
+  struct column_query q;
+  if(!column_query_init(&q, iter->include_bitmask, iter->include_op, iter->exclude_bitmask, iter->exclude_op, (uint32_t)ecs->comp_bitmask_size)) {
+    return 0;
+  }
+
+  uint64_t num_rows = iter->driving_component != RECS_NO_ENTITY_ID
+    ? ecs->recs_component_stores[iter->driving_component].num_slots
+    : ecs->ent_man.num_active_entities;
+
+  //each word the summaries cannot rule out reads one word from every column in the query, plus the active entities
+  uint64_t num_words = (uint64_t)column_index_num_candidates(&ecs->columns, &q, ecs->ent_man.num_used_ids) * (q.num_include + q.num_exclude + 1);
+  return num_words < num_rows * COLUMN_INDEX_WORDS_PER_ROW;
+}
+
+//decide which entities an iterator needs to search through
+static void recs_ent_iter_plan(struct recs *ecs, recs_ent_iter *iter) {
+  iter->driving_component = RECS_NO_ENTITY_ID;
+  iter->archetype = NO_ARCHETYPE;
+  iter->chunk = NO_CHUNK;
+  iter->check_each_row = 1;
+  iter->use_columns = 0;
+  iter->column_bits = 0;
+
+  if(ecs->storage != RECS_STORAGE_ARCHETYPE) {
+    iter->driving_component = recs_ent_iter_pick_driver(ecs, iter->include_bitmask, iter->include_op);
+    iter->use_columns = recs_ent_iter_prefers_columns(ecs, iter);
+    return;
+  }
+
+  //entities that are required to have a component are always stored inside an archetype
+  //(other than the empty one), so only archetypes need to be searched.
+  if(iter->include_bitmask != NULL && iter->include_op == RECS_ENT_MATCH_ALL) {
+    for(uint32_t i = 0; i < ecs->comp_bitmask_size; i++) {
+      if(iter->include_bitmask[i] & ecs->archetypes.component_bits[i]) {
+        iter->archetype = 1;
+        return;
+      }
+    }
+  }
+
+  //otherwise every active entity would be checked
+  iter->use_columns = recs_ent_iter_prefers_columns(ecs, iter);
 }
 
 recs_ent_iter recs_ent_iter_init(struct recs *ecs, uint8_t *mask) {
   recs_ent_iter iter = {
     .next_entity = RECS_NO_ENTITY,
     .index = 0,
+    .driving_component = RECS_NO_ENTITY_ID,
     .include_bitmask = mask,
     .include_op = RECS_ENT_MATCH_ALL,
     .exclude_bitmask = NULL,
@@ -680,6 +2953,8 @@ recs_ent_iter recs_ent_iter_init(struct recs *ecs, uint8_t *mask) {
   };
 
 
+  recs_ent_iter_plan(ecs, &iter);
+
   //we need to find the 1st element such that when we call next(), we can obtain the next element.
   iter.next_entity = recs_ent_iter_find(ecs, &iter);
 
@@ -693,6 +2968,7 @@ recs_ent_iter recs_ent_iter_init_with_match(struct recs *ecs, uint8_t *mask, enu
   recs_ent_iter iter = {
     .next_entity = RECS_NO_ENTITY,
     .index = 0,
+    .driving_component = RECS_NO_ENTITY_ID,
     .include_op = match_op,
     .include_bitmask = mask,
     .exclude_op = RECS_ENT_MATCH_ANY,
@@ -700,6 +2976,8 @@ recs_ent_iter recs_ent_iter_init_with_match(struct recs *ecs, uint8_t *mask, enu
   };
 
 
+  recs_ent_iter_plan(ecs, &iter);
+
   //we need to find the 1st element such that when we call next(), we can obtain the next element.
   iter.next_entity = recs_ent_iter_find(ecs, &iter);
 
@@ -720,6 +2998,7 @@ recs_ent_iter recs_ent_iter_init_with_exclude(struct recs *ecs, uint8_t *include
   recs_ent_iter iter = {
     .next_entity = RECS_NO_ENTITY,
     .index = 0,
+    .driving_component = RECS_NO_ENTITY_ID,
     .include_bitmask = include_mask,
     .include_op = RECS_ENT_MATCH_ALL,
     .exclude_bitmask = exclude_mask,
@@ -727,7 +3006,8 @@ recs_ent_iter recs_ent_iter_init_with_exclude(struct recs *ecs, uint8_t *include
 
   };
 
-  //we need to find the 1st element such that when we call next(), we can obtain the next element.
+  recs_ent_iter_plan(ecs, &iter);
+
   //we need to find the 1st element such that when we call next(), we can obtain the next element.
   iter.next_entity = recs_ent_iter_find(ecs, &iter);
 
@@ -737,17 +3017,45 @@ recs_ent_iter recs_ent_iter_init_with_exclude(struct recs *ecs, uint8_t *include
   return iter;
 }
 
+recs_ent_iter recs_ent_iter_init_changed(struct recs *ecs, uint8_t *include_mask, uint8_t *exclude_mask, recs_component c, enum recs_change_filter filter, uint32_t since_tick) {
+  RECS_ASSERT(ecs->storage == RECS_STORAGE_SPARSE_SET && ecs->recs_component_stores[c].changed_ticks != NULL);
+
+  recs_ent_iter iter = {
+    .next_entity = RECS_NO_ENTITY,
+    .index = 0,
+    .driving_component = c,
+    .archetype = NO_ARCHETYPE,
+    .chunk = NO_CHUNK,
+    .check_each_row = 1,
+    .change_filter = filter,
+    .change_since = since_tick,
+    .include_bitmask = include_mask,
+    .include_op = RECS_ENT_MATCH_ALL,
+    .exclude_bitmask = exclude_mask,
+    .exclude_op = RECS_ENT_MATCH_ANY
+  };
+
+  //only entities with c can match, so c's pool is always searched, even if another required component is rarer,
+  //since its ticks let us skip the blocks that did not change
+
+  //we need to find the 1st element such that when we call next(), we can obtain the next element.
+  iter.next_entity = recs_ent_iter_find(ecs, &iter);
+  return iter;
+}
+
 recs_ent_iter recs_ent_iter_init_with_exclude_and_match_op(struct recs *ecs, uint8_t *include_mask, enum recs_ent_match_op include_match_op, uint8_t *exclude_mask, enum recs_ent_match_op exclude_match_op) {
    recs_ent_iter iter = {
     .next_entity = RECS_NO_ENTITY,
     .index = 0,
+    .driving_component = RECS_NO_ENTITY_ID,
     .include_bitmask = include_mask,
     .include_op = include_match_op,
     .exclude_bitmask = exclude_mask,
     .exclude_op = exclude_match_op
   };
 
-  //we need to find the 1st element such that when we call next(), we can obtain the next element.
+  recs_ent_iter_plan(ecs, &iter);
+
   //we need to find the 1st element such that when we call next(), we can obtain the next element.
   iter.next_entity = recs_ent_iter_find(ecs, &iter);
 
@@ -772,3 +3080,179 @@ recs_entity recs_ent_iter_next(struct recs *ecs, recs_ent_iter *iter) {
   
   return rtn;
 }
+
+uint32_t recs_ent_iter_next_batch(struct recs *ecs, recs_ent_iter *iter, recs_entity *out_entities, uint32_t max_entities, const recs_component *comps, uint32_t num_comps, void **out_comps) {
+  if(max_entities == 0 || !recs_ent_iter_has_next(iter)) {
+    return 0;
+  }
+
+  //the first entity was already found by the previous search
+  out_entities[0] = iter->next_entity;
+  uint32_t count = 1 + recs_ent_iter_fill(ecs, iter, out_entities + 1, max_entities - 1);
+
+  //search for next entity so that the has_next function works correctly
+  iter->next_entity = recs_ent_iter_find(ecs, iter);
+
+  //resolve each requested component one column at a time
+  for(uint32_t c = 0; c < num_comps; c++) {
+    void **column = out_comps + ((size_t)c * max_entities);
+
+    for(uint32_t i = 0; i < count; i++) {
+      column[i] = recs_component_lookup(ecs, out_entities[i], comps[c]);
+    }
+  }
+
+  return count;
+}
+
+
+
+recs_query recs_query_register(struct recs *ecs, uint8_t *include_mask, enum recs_ent_match_op include_op, uint8_t *exclude_mask, enum recs_ent_match_op exclude_op) {
+  RECS_ASSERT(ecs->num_queries < ecs->max_queries);
+  RECS_ASSERT(!(include_mask == NULL && exclude_mask == NULL));
+
+  recs_query id = ecs->num_queries;
+  struct query_cache *q = ecs->queries + id;
+
+  //store copies of the masks inside the space reserved for this query
+  dirty_mark(recs_dirty(ecs), q->include_bitmask, ecs->comp_bitmask_size);
+  dirty_mark(recs_dirty(ecs), q->exclude_bitmask, ecs->comp_bitmask_size);
+  if(include_mask != NULL) {
+    memcpy(q->include_bitmask, include_mask, ecs->comp_bitmask_size);
+  } else {
+    q->include_bitmask = NULL;
+  }
+
+  if(exclude_mask != NULL) {
+    memcpy(q->exclude_bitmask, exclude_mask, ecs->comp_bitmask_size);
+  } else {
+    q->exclude_bitmask = NULL;
+  }
+
+  q->include_op = include_op;
+  q->exclude_op = exclude_op;
+  q->num_entities = 0;
+  for(uint32_t i = 0; i < ecs->ent_man.max_entities; i++) {
+    q->entity_to_index[i] = NO_COMP_ID;
+  }
+  dirty_mark(recs_dirty(ecs), q->entity_to_index, sizeof(uint32_t) * ecs->ent_man.max_entities);
+
+  ecs->num_queries++;
+
+  //add every entity that already matches this query
+  for(uint32_t i = 0; i < ecs->ent_man.num_active_entities; i++) {
+    uint32_t entity_id = RECS_ENT_ID(ecs->ent_man.entity_pool[i]);
+    query_cache_update(ecs, q, entity_id, recs_entity_id_active(ecs, entity_id), bitmask_list_get(&ecs->comp_bitmask_list, entity_id));
+  }
+
+  return id;
+}
+
+uint32_t recs_query_num_entities(struct recs *ecs, recs_query query) {
+  RECS_ASSERT(query < ecs->num_queries);
+  return ecs->queries[query].num_entities;
+}
+
+recs_entity *recs_query_entities(struct recs *ecs, recs_query query) {
+  RECS_ASSERT(query < ecs->num_queries);
+  return ecs->queries[query].entities;
+}
+
+//shared by every thread during recs_query_par_each()
+struct query_par_each_job {
+  struct recs *ecs;
+  recs_entity *entities;
+  recs_query_each_func callback;
+  void *userdata;
+};
+
+static void recs_query_par_each_range(void *arg, uint32_t begin, uint32_t end, uint32_t thread_index) {
+  struct query_par_each_job *job = (struct query_par_each_job*)arg;
+  for(uint32_t i = begin; i < end; i++) {
+    job->callback(job->ecs, job->entities[i], job->userdata, thread_index);
+  }
+}
+
+void recs_query_par_each(struct recs *ecs, recs_workers workers, recs_query query, recs_query_each_func callback, void *userdata, uint32_t grain) {
+  RECS_ASSERT(query < ecs->num_queries);
+  struct query_cache *q = ecs->queries + query;
+
+  if(workers == NULL) {
+    for(uint32_t i = 0; i < q->num_entities; i++) {
+      callback(ecs, q->entities[i], userdata, 0);
+    }
+    return;
+  }
+
+  struct query_par_each_job job = {
+    .ecs = ecs,
+    .entities = q->entities,
+    .callback = callback,
+    .userdata = userdata
+  };
+
+  workers_parallel_for(workers, q->num_entities, grain, recs_query_par_each_range, &job);
+}
+
+
+
+recs_group recs_group_register(struct recs *ecs, const recs_component *comps, uint32_t num_comps) {
+  RECS_ASSERT(ecs->num_groups < ecs->max_groups);
+  RECS_ASSERT(ecs->storage == RECS_STORAGE_SPARSE_SET && num_comps > 0);
+
+  recs_group id = ecs->num_groups;
+  struct component_group *g = ecs->groups + id;
+  dirty_mark(recs_dirty(ecs), g->comps, sizeof(recs_component) * num_comps);
+
+  //the entities of the group are found through its smallest pool
+  recs_component smallest = comps[0];
+  for(uint32_t i = 0; i < num_comps; i++) {
+    RECS_ASSERT(comps[i] < ecs->max_registered_components);
+    struct component_pool *p = ecs->recs_component_stores + comps[i];
+
+    //each pool can only be owned by one group, and its components must be allowed to move and be walked as whole components
+    RECS_ASSERT(p->group == NO_GROUP_ID && p->removal_policy == RECS_REMOVAL_SWAP && p->num_fields == 0);
+    p->group = id;
+    g->comps[i] = comps[i];
+
+    if(p->num_components < ecs->recs_component_stores[smallest].num_components) {
+      smallest = comps[i];
+    }
+  }
+  g->num_comps = num_comps;
+  g->num_entities = 0;
+  ecs->num_groups++;
+
+  //add every entity that already has all of the group's components. Entities moved into the group only
+  //swap places with entities that were already checked.
+  struct component_pool *p = ecs->recs_component_stores + smallest;
+  for(uint32_t i = 0; i < p->num_slots; i++) {
+    recs_group_on_add(ecs, p->comp_to_entity[i], smallest);
+  }
+
+  return id;
+}
+
+uint32_t recs_group_num_entities(struct recs *ecs, recs_group group) {
+  RECS_ASSERT(group < ecs->num_groups);
+  return ecs->groups[group].num_entities;
+}
+
+void *recs_group_components(struct recs *ecs, recs_group group, recs_component c, uint32_t index, uint32_t *count) {
+  RECS_ASSERT(group < ecs->num_groups);
+  struct component_group *g = ecs->groups + group;
+  struct component_pool *p = ecs->recs_component_stores + c;
+  RECS_ASSERT(p->group == group);
+
+  if(index >= g->num_entities) {
+    if(count != NULL) *count = 0;
+    return NULL;
+  }
+
+  //fixed-size pools have a single page, while growable pools only keep the components of each page together
+  if(count != NULL) {
+    uint64_t page_end = (((uint64_t)index >> p->page_shift) + 1) << p->page_shift;
+    *count = (uint32_t)(page_end < g->num_entities ? page_end - index : g->num_entities - index);
+  }
+  return component_pool_at(p, index);
+}
@@ -1,3 +1,4 @@
+#include <string.h>
 #include "entity_manager.h"
 
 /*
@@ -44,26 +45,68 @@
 
 
 */
-void entity_manager_init(struct entity_manager *em, uint8_t *id_buffer, uint8_t *version_buffer, uint32_t max_entities) {
-  em->num_active_entities = 0;
-  em->max_entities = max_entities;
-  em->entity_pool = (recs_entity*)id_buffer;
-  em->ent_versions_list = (uint32_t*) version_buffer;
-
-  for(uint32_t i = 0; i < em->max_entities; i++) {
+//add the IDs from first_id up to end_id to the inactive part of the pool
+static void entity_manager_fill(struct entity_manager *em, uint32_t first_id, uint32_t end_id) {
+  for(uint32_t i = first_id; i < end_id; i++) {
     //add initial entity IDs to set. 
     em->entity_pool[i] = RECS_ENT_FROM(i, 0); //note that version number is unused here, so any value is valid
 
     //set all versions to 0
     em->ent_versions_list[i] = 0;
+
+    em->active_index[i] = i;
   }
+}
 
-  
+void entity_manager_init(struct entity_manager *em, uint8_t *id_buffer, uint8_t *version_buffer, uint8_t *index_buffer, uint32_t max_entities) {
+  em->num_active_entities = 0;
+  em->num_used_ids = 0;
+  em->max_entities = max_entities;
+  em->entity_pool = (recs_entity*)id_buffer;
+  em->ent_versions_list = (uint32_t*) version_buffer;
+  em->active_index = (uint32_t*) index_buffer;
 
+  entity_manager_fill(em, 0, max_entities);
 }
 
+void entity_manager_grow(struct entity_manager *em, uint8_t *id_buffer, uint8_t *version_buffer, uint8_t *index_buffer, uint32_t max_entities) {
+  RECS_ASSERT(max_entities >= em->max_entities);
+
+  //the pool keeps its order, so every ID keeps its index and the new IDs are added after the inactive ones
+  memcpy(id_buffer, em->entity_pool, sizeof(recs_entity) * em->max_entities);
+  memcpy(version_buffer, em->ent_versions_list, sizeof(uint32_t) * em->max_entities);
+  memcpy(index_buffer, em->active_index, sizeof(uint32_t) * em->max_entities);
+
+  uint32_t first_new_id = em->max_entities;
+  em->max_entities = max_entities;
+  em->entity_pool = (recs_entity*)id_buffer;
+  em->ent_versions_list = (uint32_t*) version_buffer;
+  em->active_index = (uint32_t*) index_buffer;
+
+  entity_manager_fill(em, first_new_id, max_entities);
+}
+
+
+void entity_manager_relocate(struct entity_manager *em, const void *old_base, void *new_base) {
+  em->entity_pool = memory_relocate(em->entity_pool, old_base, new_base);
+  em->ent_versions_list = memory_relocate(em->ent_versions_list, old_base, new_base);
+  em->active_index = memory_relocate(em->active_index, old_base, new_base);
+}
+
+void entity_manager_ranges(const struct entity_manager *em, uint32_t num_ids, memory_range_func func, void *userdata) {
+  RECS_ASSERT(num_ids <= em->max_entities);
+  func(userdata, em->entity_pool, sizeof(recs_entity) * num_ids);
+  func(userdata, em->ent_versions_list, sizeof(uint32_t) * num_ids);
+  func(userdata, em->active_index, sizeof(uint32_t) * num_ids);
+}
 
-recs_entity entity_manager_add(struct entity_manager *em) {
+void entity_manager_reset_ids(struct entity_manager *em, uint32_t first_id, uint32_t end_id) {
+  RECS_ASSERT(first_id >= em->num_active_entities && end_id <= em->max_entities);
+  entity_manager_fill(em, first_id, end_id);
+}
+
+
+recs_entity entity_manager_add(struct entity_manager *em, struct dirty_tracker *dirty) {
   RECS_ASSERT(em->num_active_entities < em->max_entities);
 
   uint32_t id = RECS_ENT_ID(em->entity_pool[em->num_active_entities]);
@@ -73,9 +116,13 @@ recs_entity entity_manager_add(struct entity_manager *em) {
   //Thus, we update the version number here
   recs_entity e = RECS_ENT_FROM(id, version);
   em->entity_pool[em->num_active_entities] = e;
+  dirty_mark(dirty, em->entity_pool + em->num_active_entities, sizeof(recs_entity));
 
 
   em->num_active_entities++;
+  if(em->num_active_entities > em->num_used_ids) {
+    em->num_used_ids = em->num_active_entities;
+  }
 
 
   return e;
@@ -83,27 +130,86 @@ recs_entity entity_manager_add(struct entity_manager *em) {
 }
 
 
+void entity_manager_add_bulk(struct entity_manager *em, uint32_t n, recs_entity *out_entities, struct dirty_tracker *dirty) {
+  RECS_ASSERT(n <= em->max_entities - em->num_active_entities);
+
+  //the IDs after the active part of the pool are free, and active_index already points to them
+  recs_entity *pool = em->entity_pool + em->num_active_entities;
+  for(uint32_t i = 0; i < n; i++) {
+    uint32_t id = RECS_ENT_ID(pool[i]);
+    pool[i] = RECS_ENT_FROM(id, em->ent_versions_list[id]);
+    out_entities[i] = pool[i];
+  }
+  dirty_mark(dirty, pool, sizeof(recs_entity) * n);
+
+  em->num_active_entities += n;
+  if(em->num_active_entities > em->num_used_ids) {
+    em->num_used_ids = em->num_active_entities;
+  }
+}
+
+recs_entity entity_manager_add_id(struct entity_manager *em, uint32_t id, uint32_t version, struct dirty_tracker *dirty) {
+  RECS_ASSERT(id < em->max_entities && em->active_index[id] >= em->num_active_entities);
+
+  //swap the ID with the first inactive ID, then grow the active part of the pool over it
+  uint32_t i = em->active_index[id];
+  uint32_t first = em->num_active_entities;
+  recs_entity swapped = em->entity_pool[first];
+  em->entity_pool[i] = swapped;
+  em->active_index[RECS_ENT_ID(swapped)] = i;
 
-void entity_manager_remove_at_index(struct entity_manager *em, uint32_t active_entity_index) {
+  recs_entity e = RECS_ENT_FROM(id, version);
+  em->entity_pool[first] = e;
+  em->active_index[id] = first;
+  em->ent_versions_list[id] = version;
+
+  dirty_mark(dirty, em->entity_pool + i, sizeof(recs_entity));
+  dirty_mark(dirty, em->entity_pool + first, sizeof(recs_entity));
+  dirty_mark(dirty, em->active_index + RECS_ENT_ID(swapped), sizeof(uint32_t));
+  dirty_mark(dirty, em->active_index + id, sizeof(uint32_t));
+  dirty_mark(dirty, em->ent_versions_list + id, sizeof(uint32_t));
+
+  em->num_active_entities++;
+
+  //IDs past num_used_ids sit at their own index, so the swap only touched entries below id + 1
+  uint32_t num_used = id + 1 > em->num_active_entities ? id + 1 : em->num_active_entities;
+  if(num_used > em->num_used_ids) {
+    em->num_used_ids = num_used;
+  }
+
+  return e;
+}
+
+void entity_manager_remove_at_index(struct entity_manager *em, uint32_t active_entity_index, struct dirty_tracker *dirty) {
   uint32_t i = active_entity_index;
 
   //swap last ACTIVE ID with removed ID.
 
+  uint32_t last = em->num_active_entities-1;
   recs_entity removed = em->entity_pool[i];
-  em->entity_pool[i] = em->entity_pool[em->num_active_entities-1];
-  em->entity_pool[em->num_active_entities-1] = removed;
+  em->entity_pool[i] = em->entity_pool[last];
+  em->entity_pool[last] = removed;
+
+  //keep the ID->index mapping in sync with the swap
+  em->active_index[RECS_ENT_ID(em->entity_pool[i])] = i;
+  em->active_index[RECS_ENT_ID(removed)] = last;
+
+  dirty_mark(dirty, em->entity_pool + i, sizeof(recs_entity));
+  dirty_mark(dirty, em->entity_pool + last, sizeof(recs_entity));
+  dirty_mark(dirty, em->active_index + RECS_ENT_ID(em->entity_pool[i]), sizeof(uint32_t));
+  dirty_mark(dirty, em->active_index + RECS_ENT_ID(removed), sizeof(uint32_t));
 
   em->num_active_entities--;
 
   
 }
 
-void entity_manager_remove(struct entity_manager *em, recs_entity e) {
-  for(uint32_t i = 0; i < em->num_active_entities; i++) {
-    if(em->entity_pool[i] == e) {
-      entity_manager_remove_at_index(em, i);
-      break;
-    }
+void entity_manager_remove(struct entity_manager *em, recs_entity e, struct dirty_tracker *dirty) {
+  //active_index tells us where the entity sits inside the pool, so no search is needed.
+  //The handle is still compared to make sure stale handles and inactive IDs are ignored.
+  uint32_t i = em->active_index[RECS_ENT_ID(e)];
+  if(i < em->num_active_entities && em->entity_pool[i] == e) {
+    entity_manager_remove_at_index(em, i, dirty);
   }
 }
 
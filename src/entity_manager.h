@@ -2,6 +2,8 @@
 #define ENTITY_MANAGER_H
 
 #include "recs.h"
+#include "memory.h"
+#include "dirty.h"
 /*
   Entity Manager Section:
 
@@ -16,19 +18,58 @@ struct entity_manager {
   //store current version numbers for all entity IDs
   uint32_t *ent_versions_list;
 
+  //maps each entity ID to its index within the entity_pool. This lets us 
+  //look up the handle stored in the active pool when all we have is an ID
+  //(such as the IDs stored inside a component pool).
+  uint32_t *active_index;
+
   uint32_t num_active_entities;
   uint32_t max_entities;
+
+  //the most entities that were ever active at once. Entities only ever swap places within the active part
+  //of the pool, so IDs from num_used_ids onward were never handed out and their entries still hold their initial values.
+  uint32_t num_used_ids;
 };
 
 
-void entity_manager_init(struct entity_manager *em, uint8_t *id_buffer, uint8_t *version_buffer, uint32_t max_entities);
+void entity_manager_init(struct entity_manager *em, uint8_t *id_buffer, uint8_t *version_buffer, uint8_t *index_buffer, uint32_t max_entities);
+
+//move the entity manager into bigger buffers able to hold max_entities, adding the new IDs to the inactive part of the pool.
+//The old buffers are left untouched.
+void entity_manager_grow(struct entity_manager *em, uint8_t *id_buffer, uint8_t *version_buffer, uint8_t *index_buffer, uint32_t max_entities);
+
+//get the entity handle stored in the entity pool for a specific ID. Note that this
+//handle may be inactive if it was queued for removal.
+static inline recs_entity entity_manager_get(struct entity_manager *em, uint32_t id) {
+  return em->entity_pool[em->active_index[id]];
+}
+
+
+
+//move all of the entity manager's pointers from one copy of the RECS buffer to another
+void entity_manager_relocate(struct entity_manager *em, const void *old_base, void *new_base);
+
+//report the entries of the first num_ids IDs. The entity_manager struct itself is not reported.
+void entity_manager_ranges(const struct entity_manager *em, uint32_t num_ids, memory_range_func func, void *userdata);
+
+//give the IDs from first_id up to end_id their initial entries. None of them may be active.
+void entity_manager_reset_ids(struct entity_manager *em, uint32_t first_id, uint32_t end_id);
+
+//the following functions mark the memory they write to inside dirty (which may be NULL).
+//The entity_manager struct itself is not marked.
+
+recs_entity entity_manager_add(struct entity_manager *em, struct dirty_tracker *dirty);
 
+//add n entities at once. The new entities take up a contiguous range at the end of the active part of the pool.
+void entity_manager_add_bulk(struct entity_manager *em, uint32_t n, recs_entity *out_entities, struct dirty_tracker *dirty);
 
-recs_entity entity_manager_add(struct entity_manager *em);
+//activate a specific inactive ID with the given version, such as an entity created by another RECS instance
+recs_entity entity_manager_add_id(struct entity_manager *em, uint32_t id, uint32_t version, struct dirty_tracker *dirty);
 
-void entity_manager_remove_at_index(struct entity_manager *em, uint32_t active_entity_index);
+void entity_manager_remove_at_index(struct entity_manager *em, uint32_t active_entity_index, struct dirty_tracker *dirty);
 
-void entity_manager_remove(struct entity_manager *em, recs_entity e);
+//remove an entity in constant time. Does nothing if the handle is not in the active part of the pool.
+void entity_manager_remove(struct entity_manager *em, recs_entity e, struct dirty_tracker *dirty);
 
 #endif// ENTITY_MANAGER_H
 
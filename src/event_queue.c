@@ -0,0 +1,93 @@
+#include "event_queue.h"
+
+
+//the copy of the component starts right after the header, at an aligned offset
+static inline size_t event_queue_data_offset(void) {
+  return memory_align(sizeof(struct event_queue_header));
+}
+
+static inline uint8_t *event_queue_slot(const struct event_queue *q, uint32_t index) {
+  return q->slots + ((size_t)q->slot_size * index);
+}
+
+size_t event_queue_buffer_size(uint32_t capacity, uint32_t data_size) {
+  if(capacity == 0) {
+    return 0;
+  }
+  return (event_queue_data_offset() + memory_align(data_size)) * capacity;
+}
+
+void event_queue_init(struct event_queue *q, uint8_t *buffer, uint32_t capacity, uint32_t data_size) {
+  q->slots = capacity == 0 ? NULL : buffer;
+  q->slot_size = (uint32_t)(event_queue_data_offset() + memory_align(data_size));
+  q->data_size = data_size;
+  q->capacity = capacity;
+  q->head = 0;
+  q->count = 0;
+  q->num_dropped = 0;
+}
+
+void *event_queue_push(struct event_queue *q, recs_entity e, uint32_t type, const void *data, struct dirty_tracker *dirty) {
+  if(q->capacity == 0) {
+    return NULL;
+  }
+
+  //a full queue overwrites its oldest event
+  if(q->count == q->capacity) {
+    q->head = q->head + 1 == q->capacity ? 0 : q->head + 1;
+    q->count--;
+    q->num_dropped++;
+  }
+
+  uint32_t tail = q->head + q->count;
+  if(tail >= q->capacity) {
+    tail -= q->capacity;
+  }
+
+  uint8_t *slot = event_queue_slot(q, tail);
+  struct event_queue_header *header = (struct event_queue_header*)slot;
+  header->entity = e;
+  header->type = type;
+  if(data != NULL) {
+    memcpy(slot + event_queue_data_offset(), data, q->data_size);
+  }
+  dirty_mark(dirty, slot, data != NULL ? event_queue_data_offset() + q->data_size : sizeof(struct event_queue_header));
+
+  q->count++;
+  return slot + event_queue_data_offset();
+}
+
+uint32_t event_queue_drain(struct event_queue *q, struct recs_component_event *events, uint32_t max_events) {
+  uint32_t n = q->count < max_events ? q->count : max_events;
+
+  for(uint32_t i = 0; i < n; i++) {
+    uint8_t *slot = event_queue_slot(q, q->head);
+    const struct event_queue_header *header = (const struct event_queue_header*)slot;
+
+    events[i].entity = header->entity;
+    events[i].type = (enum recs_component_event_type)header->type;
+    events[i].component = header->type == RECS_COMPONENT_REMOVED ? slot + event_queue_data_offset() : NULL;
+
+    q->head = q->head + 1 == q->capacity ? 0 : q->head + 1;
+  }
+
+  q->count -= n;
+  return n;
+}
+
+void event_queue_relocate(struct event_queue *q, const void *old_base, void *new_base) {
+  q->slots = memory_relocate(q->slots, old_base, new_base);
+}
+
+void event_queue_ranges(const struct event_queue *q, memory_range_func func, void *userdata) {
+  if(q->count == 0) {
+    return;
+  }
+
+  //the events wrap around to the start of the buffer once they reach its end
+  uint32_t first = q->capacity - q->head < q->count ? q->capacity - q->head : q->count;
+  func(userdata, event_queue_slot(q, q->head), (size_t)q->slot_size * first);
+  if(first < q->count) {
+    func(userdata, q->slots, (size_t)q->slot_size * (q->count - first));
+  }
+}
@@ -0,0 +1,58 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "recs.h"
+#include "memory.h"
+#include "dirty.h"
+
+/*
+  Event Queue Section
+
+  A bounded ring buffer of component events (see recs_component_events_drain()). Every slot has room for
+  an event and a copy of a component, so pushing and draining events never allocates.
+  Once the queue is full, pushing an event drops the oldest one.
+*/
+
+//stored at the start of every slot, followed by the copy of the component
+struct event_queue_header {
+  recs_entity entity;
+  uint32_t type;
+};
+
+struct event_queue {
+  uint8_t *slots;
+  uint32_t slot_size;
+  uint32_t data_size;
+  uint32_t capacity;
+
+  //index of the oldest event and the number of events waiting to be drained
+  uint32_t head;
+  uint32_t count;
+
+  //number of events dropped because the queue was full
+  uint32_t num_dropped;
+};
+
+//get the number of bytes a queue of capacity events, each with room for data_size bytes, needs
+size_t event_queue_buffer_size(uint32_t capacity, uint32_t data_size);
+
+//point the queue at its slots inside buffer. A queue with a capacity of 0 is disabled, and buffer may be NULL.
+void event_queue_init(struct event_queue *q, uint8_t *buffer, uint32_t capacity, uint32_t data_size);
+
+//add an event to the back of the queue. data (data_size bytes) is copied into the event if not NULL.
+//The slot written to is marked inside dirty (which may be NULL). Returns where the event's data is stored
+//(which is left for the caller to fill in if data is NULL), or NULL if the queue is disabled.
+void *event_queue_push(struct event_queue *q, recs_entity e, uint32_t type, const void *data, struct dirty_tracker *dirty);
+
+//move up to max_events events from the front of the queue into events. Returns the number of events moved.
+uint32_t event_queue_drain(struct event_queue *q, struct recs_component_event *events, uint32_t max_events);
+
+//move the queue's slots from one copy of the RECS buffer to another
+void event_queue_relocate(struct event_queue *q, const void *old_base, void *new_base);
+
+//report the slots holding events that have not been drained yet
+void event_queue_ranges(const struct event_queue *q, memory_range_func func, void *userdata);
+
+#endif// EVENT_QUEUE_H
@@ -0,0 +1,39 @@
+//mmap() is part of POSIX rather than C99
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "file_map.h"
+
+const void *file_map_open(const char *path, size_t *out_size) {
+  int fd = open(path, O_RDONLY);
+  if(fd < 0) {
+    return NULL;
+  }
+
+  struct stat st;
+  if(fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return NULL;
+  }
+
+  //the mapping stays valid after the file is closed
+  size_t size = (size_t)st.st_size;
+  void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(data == MAP_FAILED) {
+    return NULL;
+  }
+
+  //a saved RECS instance is read from front to back
+  posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+
+  *out_size = size;
+  return data;
+}
+
+void file_map_close(const void *data, size_t size) {
+  munmap((void*)data, size);
+}
@@ -0,0 +1,19 @@
+#ifndef FILE_MAP_H
+#define FILE_MAP_H
+
+#include <stddef.h>
+
+/*
+  File Map Section
+
+  Maps a whole file into memory for reading, so that loading a saved RECS instance only reads
+  the parts of the file it copies, straight out of the OS's page cache.
+*/
+
+//map the file at path into memory, storing its size inside out_size.
+//Returns NULL if the file could not be opened or mapped, or is empty.
+const void *file_map_open(const char *path, size_t *out_size);
+
+void file_map_close(const void *data, size_t size);
+
+#endif// FILE_MAP_H
@@ -0,0 +1,33 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stddef.h>
+
+/*
+  Memory Layout Section.
+
+  Every buffer used by a RECS instance is placed inside one big allocation. 
+  The size of each buffer is rounded up so that the buffer placed after it 
+  stays aligned for any type we store (including 128-bit SIMD loads), 
+  no matter what component sizes the user registered.
+*/
+
+#define MEMORY_ALIGNMENT 16
+
+static inline size_t memory_align(size_t size) {
+  return (size + (MEMORY_ALIGNMENT - 1)) & ~(size_t)(MEMORY_ALIGNMENT - 1);
+}
+
+//move a pointer that points inside the old buffer so that it points to the same offset inside the new buffer.
+//NULL pointers are left untouched.
+static inline void *memory_relocate(void *ptr, const void *old_base, void *new_base) {
+  if(ptr == NULL) {
+    return NULL;
+  }
+  return (unsigned char*)new_base + ((const unsigned char*)ptr - (const unsigned char*)old_base);
+}
+
+//called with each range of memory holding part of a RECS instance's state (see recs_state_ranges())
+typedef void (*memory_range_func)(void *userdata, const void *ptr, size_t size);
+
+#endif// MEMORY_H
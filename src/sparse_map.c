@@ -0,0 +1,107 @@
+#include "sparse_map.h"
+
+
+size_t sparse_map_buffer_size(uint32_t max_ids, uint32_t max_pages) {
+  size_t pages_size = memory_align(sizeof(uint32_t) * ((size_t)max_pages + 1) * SPARSE_MAP_PAGE_SIZE);
+  size_t page_table_size = memory_align(sizeof(uint32_t) * sparse_map_num_id_pages(max_ids));
+  size_t page_counts_size = memory_align(sizeof(uint32_t) * ((size_t)max_pages + 1));
+
+  return pages_size + page_table_size + page_counts_size;
+}
+
+//point the map at its arrays inside buffer, without initializing them
+static void sparse_map_place(struct sparse_map *m, uint8_t *buffer, uint32_t max_ids, uint32_t max_pages) {
+  size_t pages_size = memory_align(sizeof(uint32_t) * ((size_t)max_pages + 1) * SPARSE_MAP_PAGE_SIZE);
+  size_t page_table_size = memory_align(sizeof(uint32_t) * sparse_map_num_id_pages(max_ids));
+
+  m->pages = (uint32_t*)buffer;
+  m->page_table = (uint32_t*)(buffer + pages_size);
+  m->page_counts = (uint32_t*)(buffer + pages_size + page_table_size);
+  m->max_ids = max_ids;
+  m->max_pages = max_pages;
+}
+
+void sparse_map_init(struct sparse_map *m, uint8_t *buffer, uint32_t max_ids, uint32_t max_pages) {
+  sparse_map_place(m, buffer, max_ids, max_pages);
+
+  //every page of IDs starts out using the empty page
+  memset(m->page_table, 0, sizeof(uint32_t) * sparse_map_num_id_pages(max_ids));
+  memset(m->pages, 0xFF, sizeof(uint32_t) * SPARSE_MAP_PAGE_SIZE);
+  m->page_counts[0] = 0;
+
+  m->num_pages = 1;
+  m->num_used_pages = 0;
+  m->free_pages = 0;
+}
+
+void sparse_map_grow(struct sparse_map *m, uint8_t *buffer, uint32_t max_ids, uint32_t max_pages) {
+  struct sparse_map old = *m;
+  RECS_ASSERT(max_ids >= old.max_ids && max_pages >= old.max_pages);
+
+  sparse_map_place(m, buffer, max_ids, max_pages);
+
+  //only the pages that were written to need to be copied
+  uint32_t old_id_pages = sparse_map_num_id_pages(old.max_ids);
+  memcpy(m->pages, old.pages, sizeof(uint32_t) * ((size_t)old.num_pages << SPARSE_MAP_PAGE_SHIFT));
+  memcpy(m->page_table, old.page_table, sizeof(uint32_t) * old_id_pages);
+  memset(m->page_table + old_id_pages, 0, sizeof(uint32_t) * (sparse_map_num_id_pages(max_ids) - old_id_pages));
+  memcpy(m->page_counts, old.page_counts, sizeof(uint32_t) * old.num_pages);
+}
+
+void sparse_map_relocate(struct sparse_map *m, const void *old_base, void *new_base) {
+  m->pages = memory_relocate(m->pages, old_base, new_base);
+  m->page_table = memory_relocate(m->page_table, old_base, new_base);
+  m->page_counts = memory_relocate(m->page_counts, old_base, new_base);
+}
+
+void sparse_map_ranges(const struct sparse_map *m, uint32_t num_ids, memory_range_func func, void *userdata) {
+  RECS_ASSERT(num_ids <= m->max_ids);
+  func(userdata, m->pages, sizeof(uint32_t) * ((size_t)m->num_pages << SPARSE_MAP_PAGE_SHIFT));
+  func(userdata, m->page_table, sizeof(uint32_t) * sparse_map_num_id_pages(num_ids));
+  func(userdata, m->page_counts, sizeof(uint32_t) * m->num_pages);
+}
+
+void sparse_map_reset_ids(struct sparse_map *m, uint32_t first_id, uint32_t end_id) {
+  uint32_t first_page = sparse_map_num_id_pages(first_id);
+  uint32_t end_page = sparse_map_num_id_pages(end_id);
+  if(end_page > first_page) {
+    memset(m->page_table + first_page, 0, sizeof(uint32_t) * (end_page - first_page));
+  }
+}
+
+size_t sparse_map_used_size(const struct sparse_map *m) {
+  size_t page_table_size = sizeof(uint32_t) * sparse_map_num_id_pages(m->max_ids);
+  return page_table_size + (sizeof(uint32_t) * ((size_t)m->num_used_pages + 1) * SPARSE_MAP_PAGE_SIZE);
+}
+
+uint32_t sparse_map_take_page(struct sparse_map *m, struct dirty_tracker *dirty) {
+  uint32_t page = m->free_pages;
+  if(page != 0) {
+    //free pages are empty, except for the link to the next free page
+    uint32_t *first = sparse_map_slot(m, page, 0);
+    m->free_pages = *first;
+    *first = SPARSE_MAP_NO_VALUE;
+    dirty_mark(dirty, first, sizeof(uint32_t));
+  } else {
+    //a map can never need more pages than it has values
+    RECS_ASSERT(m->num_pages <= m->max_pages);
+    page = m->num_pages++;
+    memset(sparse_map_slot(m, page, 0), 0xFF, sizeof(uint32_t) * SPARSE_MAP_PAGE_SIZE);
+    dirty_mark(dirty, sparse_map_slot(m, page, 0), sizeof(uint32_t) * SPARSE_MAP_PAGE_SIZE);
+  }
+
+  m->page_counts[page] = 0;
+  dirty_mark(dirty, m->page_counts + page, sizeof(uint32_t));
+  m->num_used_pages++;
+  return page;
+}
+
+void sparse_map_release_page(struct sparse_map *m, uint32_t id_page, struct dirty_tracker *dirty) {
+  uint32_t page = m->page_table[id_page];
+  *sparse_map_slot(m, page, 0) = m->free_pages;
+  m->free_pages = page;
+  m->page_table[id_page] = 0;
+  dirty_mark(dirty, sparse_map_slot(m, page, 0), sizeof(uint32_t));
+  dirty_mark(dirty, m->page_table + id_page, sizeof(uint32_t));
+  m->num_used_pages--;
+}
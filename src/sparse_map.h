@@ -0,0 +1,122 @@
+#ifndef SPARSE_MAP_H
+#define SPARSE_MAP_H
+
+#include <stdint.h>
+#include <string.h>
+#include "recs.h"
+#include "memory.h"
+#include "dirty.h"
+
+//number of IDs inside each page (1 << SPARSE_MAP_PAGE_SHIFT)
+#define SPARSE_MAP_PAGE_SHIFT 6
+#define SPARSE_MAP_PAGE_SIZE ((uint32_t)1 << SPARSE_MAP_PAGE_SHIFT)
+#define SPARSE_MAP_PAGE_MASK (SPARSE_MAP_PAGE_SIZE - 1)
+
+#define SPARSE_MAP_NO_VALUE RECS_NO_ENTITY_ID
+
+/*
+  Sparse Map Section
+
+  Maps IDs to values (such as an entity ID to the index of its component) in O(1), without
+  storing a value for every possible ID. IDs are split into pages of SPARSE_MAP_PAGE_SIZE IDs,
+  and only pages holding at least 1 value use one of the map's value pages. Every other page of
+  IDs points to page 0, which never holds any values, so lookups never need to check for a missing page.
+
+  Value pages are handed out from a buffer reserved up front, in the order they are first needed.
+  Pages past num_pages are never written to, so the OS does not need to back them with memory.
+*/
+
+struct sparse_map {
+  //index of the value page used by each page of IDs
+  uint32_t *page_table;
+
+  //number of values stored inside each value page
+  uint32_t *page_counts;
+
+  //(max_pages + 1) value pages, including the empty page 0
+  uint32_t *pages;
+
+  uint32_t max_ids;
+  uint32_t max_pages;
+
+  //number of value pages that have been written to, including page 0
+  uint32_t num_pages;
+
+  //number of value pages holding at least 1 value
+  uint32_t num_used_pages;
+
+  //first value page that was emptied and can be used again (0 if none).
+  //Each free page stores the index of the next free page in its first entry.
+  uint32_t free_pages;
+};
+
+static inline uint32_t sparse_map_num_id_pages(uint32_t max_ids) {
+  return (uint32_t)(((uint64_t)max_ids + SPARSE_MAP_PAGE_MASK) >> SPARSE_MAP_PAGE_SHIFT);
+}
+
+//get the number of bytes a map needs for max_ids IDs, with room for max_pages value pages
+size_t sparse_map_buffer_size(uint32_t max_ids, uint32_t max_pages);
+
+void sparse_map_init(struct sparse_map *m, uint8_t *buffer, uint32_t max_ids, uint32_t max_pages);
+
+//move the map into a bigger buffer, copying every value. The old buffer is left untouched.
+void sparse_map_grow(struct sparse_map *m, uint8_t *buffer, uint32_t max_ids, uint32_t max_pages);
+
+void sparse_map_relocate(struct sparse_map *m, const void *old_base, void *new_base);
+
+//report the value pages in use, and the page table entries of the first num_ids IDs. Pages past num_pages never
+//need to be copied, since they are cleared once they are taken.
+void sparse_map_ranges(const struct sparse_map *m, uint32_t num_ids, memory_range_func func, void *userdata);
+
+//point every page of IDs from first_id up to end_id back at the empty page. None of those IDs may have a value,
+//except for the ones sharing a page with first_id - 1, whose page is left alone.
+void sparse_map_reset_ids(struct sparse_map *m, uint32_t first_id, uint32_t end_id);
+
+//get the number of bytes of the map's buffer that are in use (the page table, and each page that holds values)
+size_t sparse_map_used_size(const struct sparse_map *m);
+
+//used by sparse_map_set() when an ID is added to a page of IDs without any values
+uint32_t sparse_map_take_page(struct sparse_map *m, struct dirty_tracker *dirty);
+void sparse_map_release_page(struct sparse_map *m, uint32_t id_page, struct dirty_tracker *dirty);
+
+static inline uint32_t *sparse_map_slot(const struct sparse_map *m, uint32_t page, uint32_t id) {
+  return m->pages + (((size_t)page << SPARSE_MAP_PAGE_SHIFT) | (id & SPARSE_MAP_PAGE_MASK));
+}
+
+//get the value of an ID, or SPARSE_MAP_NO_VALUE if it has none
+static inline uint32_t sparse_map_get(const struct sparse_map *m, uint32_t id) {
+  return *sparse_map_slot(m, m->page_table[id >> SPARSE_MAP_PAGE_SHIFT], id);
+}
+
+static inline void sparse_map_set(struct sparse_map *m, uint32_t id, uint32_t value, struct dirty_tracker *dirty) {
+  uint32_t *page = m->page_table + (id >> SPARSE_MAP_PAGE_SHIFT);
+  if(*page == 0) {
+    *page = sparse_map_take_page(m, dirty);
+    dirty_mark(dirty, page, sizeof(uint32_t));
+  }
+
+  uint32_t *slot = sparse_map_slot(m, *page, id);
+  if(*slot == SPARSE_MAP_NO_VALUE) {
+    m->page_counts[*page]++;
+    dirty_mark(dirty, m->page_counts + *page, sizeof(uint32_t));
+  }
+  *slot = value;
+  dirty_mark(dirty, slot, sizeof(uint32_t));
+}
+
+static inline void sparse_map_remove(struct sparse_map *m, uint32_t id, struct dirty_tracker *dirty) {
+  uint32_t page = m->page_table[id >> SPARSE_MAP_PAGE_SHIFT];
+  uint32_t *slot = sparse_map_slot(m, page, id);
+  if(page == 0 || *slot == SPARSE_MAP_NO_VALUE) {
+    return;
+  }
+
+  *slot = SPARSE_MAP_NO_VALUE;
+  dirty_mark(dirty, slot, sizeof(uint32_t));
+  dirty_mark(dirty, m->page_counts + page, sizeof(uint32_t));
+  if(--m->page_counts[page] == 0) {
+    sparse_map_release_page(m, id >> SPARSE_MAP_PAGE_SHIFT, dirty);
+  }
+}
+
+#endif// SPARSE_MAP_H
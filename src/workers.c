@@ -0,0 +1,293 @@
+//pthreads is part of POSIX rather than C99
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include "workers.h"
+#include "memory.h"
+
+//the items a thread still has to process during workers_parallel_for().
+//Each range sits on its own cache line so that threads do not slow each other down.
+struct worker_range {
+  pthread_mutex_t lock;
+  uint32_t begin;
+  uint32_t end;
+} __attribute__((aligned(64)));
+
+struct recs_workers {
+  uint32_t num_threads;
+
+  //one range per thread, including the calling thread
+  struct worker_range *ranges;
+
+  //the threads besides the one that creates the pool. Thread i+1 is stored at index i.
+  pthread_t *threads;
+
+  pthread_mutex_t lock;
+
+  //signaled when a new job starts or when the pool shuts down
+  pthread_cond_t start_cond;
+
+  //signaled when the last thread finishes the current job
+  pthread_cond_t done_cond;
+
+  //used by jobs to wait on each other
+  pthread_cond_t job_cond;
+
+  workers_job_func job;
+  void *job_arg;
+
+  //incremented each time a job starts, so that threads know when they have a new job
+  uint64_t generation;
+  uint32_t num_running;
+  uint8_t shutdown;
+};
+
+//passed to each thread when it starts
+struct worker_start_info {
+  struct recs_workers *workers;
+  uint32_t thread_index;
+};
+
+static void *worker_main(void *arg) {
+  struct recs_workers *w = ((struct worker_start_info*)arg)->workers;
+  uint32_t thread_index = ((struct worker_start_info*)arg)->thread_index;
+  RECS_FREE(arg);
+
+  uint64_t seen_generation = 0;
+
+  pthread_mutex_lock(&w->lock);
+  while(1) {
+    while(w->generation == seen_generation && !w->shutdown) {
+      pthread_cond_wait(&w->start_cond, &w->lock);
+    }
+    if(w->shutdown) break;
+
+    seen_generation = w->generation;
+    workers_job_func job = w->job;
+    void *job_arg = w->job_arg;
+    pthread_mutex_unlock(&w->lock);
+
+    job(job_arg, thread_index);
+
+    pthread_mutex_lock(&w->lock);
+    w->num_running--;
+    if(w->num_running == 0) {
+      pthread_cond_signal(&w->done_cond);
+    }
+  }
+  pthread_mutex_unlock(&w->lock);
+
+  return NULL;
+}
+
+//stop and join the first num_started threads of the pool, then free it
+static void workers_destroy(struct recs_workers *w, uint32_t num_started) {
+  pthread_mutex_lock(&w->lock);
+  w->shutdown = 1;
+  pthread_cond_broadcast(&w->start_cond);
+  pthread_mutex_unlock(&w->lock);
+
+  for(uint32_t i = 0; i < num_started; i++) {
+    pthread_join(w->threads[i], NULL);
+  }
+
+  for(uint32_t i = 0; i < w->num_threads; i++) {
+    pthread_mutex_destroy(&w->ranges[i].lock);
+  }
+  pthread_cond_destroy(&w->job_cond);
+  pthread_cond_destroy(&w->done_cond);
+  pthread_cond_destroy(&w->start_cond);
+  pthread_mutex_destroy(&w->lock);
+  RECS_FREE(w);
+}
+
+
+recs_workers recs_workers_create(uint32_t num_threads) {
+  RECS_ASSERT(num_threads > 0);
+
+  //store the ranges and thread handles right after the struct inside the same allocation.
+  //Ranges are aligned to their own cache lines, so leave enough space to align them.
+  size_t struct_size = memory_align(sizeof(struct recs_workers));
+  size_t range_buffer_size = sizeof(struct worker_range) * (num_threads + 1);
+  struct recs_workers *w = (struct recs_workers*)RECS_MALLOC(struct_size + range_buffer_size + sizeof(pthread_t) * (num_threads - 1));
+  if(w == NULL) {
+    return NULL;
+  }
+
+  uintptr_t range_address = (uintptr_t)w + struct_size;
+  range_address = (range_address + sizeof(struct worker_range) - 1) / sizeof(struct worker_range) * sizeof(struct worker_range);
+
+  w->num_threads = num_threads;
+  w->ranges = (struct worker_range*)range_address;
+  w->threads = (pthread_t*)((uint8_t*)w + struct_size + range_buffer_size);
+  for(uint32_t i = 0; i < num_threads; i++) {
+    pthread_mutex_init(&w->ranges[i].lock, NULL);
+  }
+  w->job = NULL;
+  w->job_arg = NULL;
+  w->generation = 0;
+  w->num_running = 0;
+  w->shutdown = 0;
+
+  pthread_mutex_init(&w->lock, NULL);
+  pthread_cond_init(&w->start_cond, NULL);
+  pthread_cond_init(&w->done_cond, NULL);
+  pthread_cond_init(&w->job_cond, NULL);
+
+  for(uint32_t i = 0; i < num_threads - 1; i++) {
+    struct worker_start_info *info = (struct worker_start_info*)RECS_MALLOC(sizeof(struct worker_start_info));
+    if(info == NULL) {
+      workers_destroy(w, i);
+      return NULL;
+    }
+    info->workers = w;
+    info->thread_index = i + 1;
+
+    if(pthread_create(w->threads + i, NULL, worker_main, info) != 0) {
+      RECS_FREE(info);
+      workers_destroy(w, i);
+      return NULL;
+    }
+  }
+
+  return w;
+}
+
+void recs_workers_free(recs_workers workers) {
+  if(workers == NULL) {
+    return;
+  }
+  workers_destroy(workers, workers->num_threads - 1);
+}
+
+uint32_t recs_workers_num_threads(recs_workers workers) {
+  return workers->num_threads;
+}
+
+void workers_run(struct recs_workers *w, workers_job_func job, void *arg) {
+  if(w->num_threads > 1) {
+    pthread_mutex_lock(&w->lock);
+    RECS_ASSERT(w->num_running == 0);
+    w->job = job;
+    w->job_arg = arg;
+    w->num_running = w->num_threads - 1;
+    w->generation++;
+    pthread_cond_broadcast(&w->start_cond);
+    pthread_mutex_unlock(&w->lock);
+  }
+
+  //the calling thread helps out too
+  job(arg, 0);
+
+  if(w->num_threads > 1) {
+    pthread_mutex_lock(&w->lock);
+    while(w->num_running > 0) {
+      pthread_cond_wait(&w->done_cond, &w->lock);
+    }
+    pthread_mutex_unlock(&w->lock);
+  }
+}
+
+void workers_lock(struct recs_workers *w) {
+  pthread_mutex_lock(&w->lock);
+}
+
+void workers_unlock(struct recs_workers *w) {
+  pthread_mutex_unlock(&w->lock);
+}
+
+void workers_wait(struct recs_workers *w) {
+  pthread_cond_wait(&w->job_cond, &w->lock);
+}
+
+void workers_wake_all(struct recs_workers *w) {
+  pthread_cond_broadcast(&w->job_cond);
+}
+
+
+//shared by every thread during workers_parallel_for()
+struct parallel_for_job {
+  struct recs_workers *workers;
+  uint32_t grain;
+  workers_range_func func;
+  void *arg;
+};
+
+//take up to half of the items left inside another thread's range, from the end of that range.
+//Returns 0 if every other thread has run out of items.
+static uint8_t workers_steal(struct recs_workers *w, uint32_t thief, uint32_t grain, uint32_t *out_begin, uint32_t *out_end) {
+  for(uint32_t i = 1; i < w->num_threads; i++) {
+    struct worker_range *victim = w->ranges + ((thief + i) % w->num_threads);
+
+    pthread_mutex_lock(&victim->lock);
+    uint32_t remaining = victim->end - victim->begin;
+    if(remaining > 0) {
+      //leave small ranges alone besides taking all of them, since splitting them costs more than it saves
+      uint32_t stolen = remaining > grain ? remaining / 2 : remaining;
+      *out_end = victim->end;
+      *out_begin = victim->end - stolen;
+      victim->end -= stolen;
+      pthread_mutex_unlock(&victim->lock);
+      return 1;
+    }
+    pthread_mutex_unlock(&victim->lock);
+  }
+  return 0;
+}
+
+static void workers_parallel_for_job(void *arg, uint32_t thread_index) {
+  struct parallel_for_job *job = (struct parallel_for_job*)arg;
+  struct recs_workers *w = job->workers;
+  struct worker_range *own = w->ranges + thread_index;
+
+  while(1) {
+    pthread_mutex_lock(&own->lock);
+    if(own->begin < own->end) {
+      uint32_t begin = own->begin;
+      uint32_t end = own->end - begin > job->grain ? begin + job->grain : own->end;
+      own->begin = end;
+      pthread_mutex_unlock(&own->lock);
+
+      job->func(job->arg, begin, end, thread_index);
+      continue;
+    }
+    pthread_mutex_unlock(&own->lock);
+
+    uint32_t begin, end;
+    if(!workers_steal(w, thread_index, job->grain, &begin, &end)) {
+      return;
+    }
+
+    pthread_mutex_lock(&own->lock);
+    own->begin = begin;
+    own->end = end;
+    pthread_mutex_unlock(&own->lock);
+  }
+}
+
+void workers_parallel_for(struct recs_workers *w, uint32_t count, uint32_t grain, workers_range_func func, void *arg) {
+  if(count == 0) {
+    return;
+  }
+
+  //aim for several pieces of work per thread so that there is something left to steal
+  if(grain == 0) {
+    grain = count / (w->num_threads * 8);
+    if(grain == 0) grain = 1;
+  }
+
+  //start each thread with an equal share. Nothing else can touch the ranges until the job starts.
+  for(uint32_t i = 0; i < w->num_threads; i++) {
+    w->ranges[i].begin = (uint32_t)(((uint64_t)count * i) / w->num_threads);
+    w->ranges[i].end = (uint32_t)(((uint64_t)count * (i + 1)) / w->num_threads);
+  }
+
+  struct parallel_for_job job = {
+    .workers = w,
+    .grain = grain,
+    .func = func,
+    .arg = arg
+  };
+
+  workers_run(w, workers_parallel_for_job, &job);
+}
@@ -0,0 +1,38 @@
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include <stdint.h>
+#include "recs.h"
+
+/*
+  Worker Pool Section
+
+  A fixed set of threads that sleep until they are handed a job. Every job is run by all threads 
+  at the same time (including the thread that started it), and the thread starting the job waits 
+  until every thread returns from it. Jobs decide how to split up their own work.
+*/
+
+//a job run by every thread in the pool. thread_index is 0 for the thread that called workers_run().
+typedef void (*workers_job_func)(void *arg, uint32_t thread_index);
+
+//run a job on every thread and wait for all of them to finish it.
+//Only one job can run at a time, so this must not be called from within a job.
+void workers_run(struct recs_workers *workers, workers_job_func job, void *arg);
+
+//called on a range of items [begin, end) by recs_workers_parallel_for()
+typedef void (*workers_range_func)(void *arg, uint32_t begin, uint32_t end, uint32_t thread_index);
+
+//split the items [0, count) between every thread, handing out up to grain items at a time.
+//Each thread starts with an equal share, and steals half of another thread's remaining items once it runs out.
+//Returns once every item has been processed. If grain is 0, a grain is picked based on the number of threads.
+void workers_parallel_for(struct recs_workers *workers, uint32_t count, uint32_t grain, workers_range_func func, void *arg);
+
+//threads running a job can use the pool's lock to share state with each other.
+void workers_lock(struct recs_workers *workers);
+void workers_unlock(struct recs_workers *workers);
+
+//must hold the lock. Sleep until another thread running the job calls workers_wake_all().
+void workers_wait(struct recs_workers *workers);
+void workers_wake_all(struct recs_workers *workers);
+
+#endif// WORKERS_H
@@ -0,0 +1,160 @@
+#include <stdio.h>
+
+#define RECS_MAX_COMPONENTS 3
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 100
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+
+#include "recs.h"
+
+struct position_component {
+  float x, y;
+};
+
+struct velocity_component {
+  float dx, dy;
+};
+
+struct health_component {
+  int hp;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_POSITION, COMPONENT_VELOCITY, COMPONENT_HEALTH);
+RECS_INIT_TAG_IDS(tag, TAG_FROZEN);
+
+#define FREE_AND_FAIL(ecs, message) do {printf("%s", message); recs_free(ecs); return 1;} while(0)
+
+
+//count the entities found by an iterator, making sure each one really has a position and velocity
+static int count_moving(recs ecs, uint8_t *mask, uint8_t *exclude_mask, uint32_t *out_count) {
+  uint32_t count = 0;
+  recs_ent_iter iter = recs_ent_iter_init_with_exclude(ecs, mask, exclude_mask);
+  while(recs_ent_iter_has_next(&iter)) {
+    recs_entity e = recs_ent_iter_next(ecs, &iter);
+    struct position_component *p = recs_entity_get_component(ecs, e, COMPONENT_POSITION);
+    struct velocity_component *v = recs_entity_get_component(ecs, e, COMPONENT_VELOCITY);
+    if(p == NULL || v == NULL || v->dy != p->x || recs_entity_has_tag(ecs, e, TAG_FROZEN)) {
+      return 0;
+    }
+    count++;
+  }
+  *out_count = count;
+  return 1;
+}
+
+int main(void) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {
+      .type = COMPONENT_POSITION,
+      .max_components = RECS_MAX_ENTITIES,
+      .comp_size = sizeof(struct position_component)
+    },
+    {
+      .type = COMPONENT_VELOCITY,
+      .max_components = RECS_MAX_ENTITIES,
+      .comp_size = sizeof(struct velocity_component)
+    },
+    {
+      .type = COMPONENT_HEALTH,
+      .max_components = RECS_MAX_ENTITIES,
+      .comp_size = sizeof(struct health_component)
+    }
+  };
+
+  struct recs_init_config config = {
+    .max_entities = RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .context = NULL,
+    .storage = RECS_STORAGE_ARCHETYPE,
+
+    //use tiny chunks so that each archetype needs several of them
+    .archetype_chunk_size = 128,
+    .components = comps,
+    .systems = NULL
+  };
+
+  recs ecs = recs_init(config);
+  if(ecs == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+
+  //every entity gets a position, every 2nd entity gets a velocity, and every 3rd entity is frozen.
+  recs_entity entities[RECS_MAX_ENTITIES];
+  for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i++) {
+    recs_entity e = recs_entity_add(ecs);
+    entities[i] = e;
+
+    struct health_component h = {.hp = (int)i};
+    recs_entity_add_component(ecs, e, COMPONENT_HEALTH, &h);
+
+    struct position_component p = {.x = (float)i, .y = 0};
+    recs_entity_add_component(ecs, e, COMPONENT_POSITION, &p);
+
+    if(i % 2 == 0) {
+      struct velocity_component v = {.dx = 1, .dy = (float)i};
+      recs_entity_add_component(ecs, e, COMPONENT_VELOCITY, &v);
+    }
+    if(i % 3 == 0) {
+      recs_entity_add_tag(ecs, e, TAG_FROZEN);
+    }
+  }
+
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(2, COMPONENT_POSITION, COMPONENT_VELOCITY), 0, NULL);
+
+  uint8_t exclude_mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, exclude_mask, 0, NULL, RECS_BITMASK_CREATE_TAG_ARG(1, TAG_FROZEN));
+
+  //even entities that are not a multiple of 3
+  uint32_t count = 0;
+  if(!count_moving(ecs, mask, exclude_mask, &count) || count != 33) {
+    FREE_AND_FAIL(ecs, "Test Failed, iterator did not find the correct entities!\n");
+  }
+
+  //moving entities between archetypes must keep the components they still have
+  for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i += 4) {
+    recs_entity_remove_component(ecs, entities[i], COMPONENT_VELOCITY);
+  }
+  for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i++) {
+    struct position_component *p = recs_entity_get_component(ecs, entities[i], COMPONENT_POSITION);
+    struct health_component *h = recs_entity_get_component(ecs, entities[i], COMPONENT_HEALTH);
+    if(p == NULL || h == NULL || p->x != (float)i || h->hp != (int)i) {
+      FREE_AND_FAIL(ecs, "Test Failed, component data was lost when moving between archetypes!\n");
+    }
+    if(!!recs_entity_has_component(ecs, entities[i], COMPONENT_VELOCITY) != (recs_entity_get_component(ecs, entities[i], COMPONENT_VELOCITY) != NULL)) {
+      FREE_AND_FAIL(ecs, "Test Failed, entity bitmask does not match its archetype!\n");
+    }
+  }
+
+  if(recs_component_num_instances(ecs, COMPONENT_VELOCITY) != 25) {
+    FREE_AND_FAIL(ecs, "Test Failed, wrong number of velocity components!\n");
+  }
+
+  //entities 2, 6, 10, ... that are not a multiple of 3
+  if(!count_moving(ecs, mask, exclude_mask, &count) || count != 17) {
+    FREE_AND_FAIL(ecs, "Test Failed, iterator did not find the correct entities after removing components!\n");
+  }
+
+  //copies must contain the same tables
+  recs copy = recs_copy(ecs);
+  recs_free(ecs);
+  ecs = copy;
+
+  for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i += 2) {
+    recs_entity_remove(ecs, entities[i]);
+  }
+  if(!count_moving(ecs, mask, exclude_mask, &count) || count != 0) {
+    FREE_AND_FAIL(ecs, "Test Failed, removed entities were still found!\n");
+  }
+  if(recs_component_num_instances(ecs, COMPONENT_POSITION) != RECS_MAX_ENTITIES / 2) {
+    FREE_AND_FAIL(ecs, "Test Failed, wrong number of position components after removing entities!\n");
+  }
+
+  recs_free(ecs);
+  return 0;
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+
+#define RECS_MAX_COMPONENTS 3
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 1000
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+#define RECS_MAX_QUERIES 1
+
+#define NUM_BULK 400
+
+#include "recs.h"
+
+struct position_component {
+  float x, y;
+};
+
+struct velocity_component {
+  float dx, dy;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_POSITION, COMPONENT_VELOCITY, COMPONENT_HEALTH);
+RECS_INIT_TAG_IDS(tag, TAG_PROJECTILE);
+
+#define FREE_AND_FAIL(ecs, message) do {printf("%s", message); recs_free(ecs); return 1;} while(0)
+
+static struct position_component positions[NUM_BULK];
+static struct velocity_component velocities[NUM_BULK];
+static recs_entity entities[NUM_BULK];
+
+//run the test with both storage backends
+static int run(enum recs_storage_type storage) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {.type = COMPONENT_POSITION, .max_components = RECS_MAX_ENTITIES, .comp_size = sizeof(struct position_component)},
+    {.type = COMPONENT_VELOCITY, .max_components = RECS_MAX_ENTITIES, .comp_size = sizeof(struct velocity_component)},
+    {.type = COMPONENT_HEALTH, .max_components = RECS_MAX_ENTITIES, .comp_size = sizeof(int)}
+  };
+
+  struct recs_init_config config = {
+    .max_entities = RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = RECS_MAX_QUERIES,
+    .context = NULL,
+    .storage = storage,
+    .components = comps,
+    .systems = NULL
+  };
+
+  recs ecs = recs_init(config);
+  if(ecs == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+
+  //entities added one at a time, so the bulk entities do not start at the beginning of the pools
+  for(int i = 0; i < 10; i++) {
+    recs_entity e = recs_entity_add(ecs);
+    struct position_component p = {.x = -1, .y = -1};
+    recs_entity_add_component(ecs, e, COMPONENT_POSITION, &p);
+    if(i % 2 == 0) {
+      recs_entity_remove(ecs, e);
+    }
+  }
+
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(2, COMPONENT_POSITION, COMPONENT_VELOCITY), RECS_BITMASK_CREATE_TAG_ARG(1, TAG_PROJECTILE));
+  recs_query projectiles = recs_query_register(ecs, mask, RECS_ENT_MATCH_ALL, NULL, RECS_ENT_MATCH_ANY);
+
+  for(int i = 0; i < NUM_BULK; i++) {
+    positions[i] = (struct position_component){.x = (float)i, .y = 0};
+    velocities[i] = (struct velocity_component){.dx = 0, .dy = (float)i};
+  }
+
+  const void *arrays[2] = {positions, velocities};
+  recs_entity_add_bulk(ecs, NUM_BULK, entities, mask, arrays);
+
+  if(recs_num_active_entities(ecs) != NUM_BULK + 5 || recs_query_num_entities(ecs, projectiles) != NUM_BULK) {
+    FREE_AND_FAIL(ecs, "Test Failed, bulk entities were not added!\n");
+  }
+
+  for(int i = 0; i < NUM_BULK; i++) {
+    struct position_component *p = recs_entity_get_component(ecs, entities[i], COMPONENT_POSITION);
+    struct velocity_component *v = recs_entity_get_component(ecs, entities[i], COMPONENT_VELOCITY);
+    if(!recs_entity_active(ecs, entities[i]) || p == NULL || v == NULL || p->x != (float)i || v->dy != (float)i) {
+      FREE_AND_FAIL(ecs, "Test Failed, bulk entities have the wrong components!\n");
+    }
+    if(!recs_entity_has_tag(ecs, entities[i], TAG_PROJECTILE) || recs_entity_has_component(ecs, entities[i], COMPONENT_HEALTH)) {
+      FREE_AND_FAIL(ecs, "Test Failed, bulk entities have the wrong bitmask!\n");
+    }
+  }
+
+  //remove every other bulk entity, with one entity listed twice
+  recs_entity removed[NUM_BULK / 2 + 1];
+  for(int i = 0; i < NUM_BULK / 2; i++) {
+    removed[i] = entities[i * 2];
+  }
+  removed[NUM_BULK / 2] = entities[0];
+  recs_entity_remove_bulk(ecs, NUM_BULK / 2 + 1, removed);
+
+  if(recs_num_active_entities(ecs) != NUM_BULK / 2 + 5 || recs_query_num_entities(ecs, projectiles) != NUM_BULK / 2) {
+    FREE_AND_FAIL(ecs, "Test Failed, bulk entities were not removed!\n");
+  }
+  if(recs_component_num_instances(ecs, COMPONENT_VELOCITY) != NUM_BULK / 2) {
+    FREE_AND_FAIL(ecs, "Test Failed, components of removed entities were not removed!\n");
+  }
+  for(int i = 1; i < NUM_BULK; i += 2) {
+    struct position_component *p = recs_entity_get_component(ecs, entities[i], COMPONENT_POSITION);
+    if(p == NULL || p->x != (float)i) {
+      FREE_AND_FAIL(ecs, "Test Failed, removing entities changed the components of other entities!\n");
+    }
+  }
+
+  //entities without any components reuse the IDs freed above
+  recs_entity_add_bulk(ecs, NUM_BULK / 2, entities, NULL, NULL);
+  for(int i = 0; i < NUM_BULK / 2; i++) {
+    if(!recs_entity_active(ecs, entities[i]) || recs_entity_has_component(ecs, entities[i], COMPONENT_POSITION)) {
+      FREE_AND_FAIL(ecs, "Test Failed, reused entity IDs still have old components!\n");
+    }
+  }
+
+  recs_free(ecs);
+  return 0;
+}
+
+int main(void) {
+  if(run(RECS_STORAGE_SPARSE_SET) != 0) return 1;
+  return run(RECS_STORAGE_ARCHETYPE);
+}
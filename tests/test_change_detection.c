@@ -0,0 +1,185 @@
+#include <stdio.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 1000
+#define RECS_MAX_SYSTEMS 2
+#define RECS_MAX_SYS_GROUPS 1
+
+#define NUM_START 500
+
+#include "recs.h"
+
+struct position_component {
+  float x, y;
+};
+
+struct velocity_component {
+  float dx, dy;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_POSITION, COMPONENT_VELOCITY);
+RECS_INIT_TAG_IDS(tag, TAG_FROZEN);
+RECS_INIT_SYS_GRP_IDS(system_group, SYSTEM_GROUP_UPDATE);
+
+//what each system saw the last time it ran
+struct test_context {
+  uint32_t num_added;
+  uint32_t num_changed;
+  uint32_t num_moved;
+};
+
+static recs_entity entities[NUM_START];
+
+static uint32_t count_changes(recs ecs, enum recs_change_filter filter, uint32_t since_tick, uint8_t *exclude_mask) {
+  uint32_t count = 0;
+  recs_ent_iter iter = recs_ent_iter_init_changed(ecs, NULL, exclude_mask, COMPONENT_POSITION, filter, since_tick);
+  while(recs_ent_iter_has_next(&iter)) {
+    recs_entity e = recs_ent_iter_next(ecs, &iter);
+    if(!recs_entity_component_changed(ecs, e, COMPONENT_POSITION, filter, since_tick)) {
+      return RECS_NO_ENTITY_ID;
+    }
+    count++;
+  }
+  return count;
+}
+
+//reports what changed since it last ran
+static void system_sync(struct recs *ecs) {
+  struct test_context *ctx = recs_system_get_context(ecs);
+  ctx->num_added = count_changes(ecs, RECS_CHANGE_ADDED, recs_system_last_run_tick(ecs), NULL);
+  ctx->num_changed = count_changes(ecs, RECS_CHANGE_CHANGED, recs_system_last_run_tick(ecs), NULL);
+}
+
+//moves the first 10 entities (that are still around) every time it runs. Its own changes are never reported back to it.
+static void system_move(struct recs *ecs) {
+  struct test_context *ctx = recs_system_get_context(ecs);
+  ctx->num_moved = count_changes(ecs, RECS_CHANGE_CHANGED, recs_system_last_run_tick(ecs), NULL);
+  for(uint32_t i = 0; i < 10; i++) {
+    struct position_component *p = recs_entity_get_component_mut(ecs, entities[i], COMPONENT_POSITION);
+    if(p != NULL) {
+      p->x += 1;
+    }
+  }
+}
+
+static recs create(uint8_t growable, struct test_context *ctx) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {.type = COMPONENT_POSITION, .max_components = growable ? 16 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct position_component), .track_changes = 1},
+    {.type = COMPONENT_VELOCITY, .max_components = growable ? 16 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct velocity_component)}
+  };
+
+  struct recs_init_config_system systems[RECS_MAX_SYSTEMS] = {
+    {.func = system_sync, .group = SYSTEM_GROUP_UPDATE},
+    {.func = system_move, .group = SYSTEM_GROUP_UPDATE}
+  };
+
+  struct recs_init_config config = {
+    .max_entities = growable ? 16 : RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = 0,
+    .context = ctx,
+    .growable = growable,
+    .components = comps,
+    .systems = systems
+  };
+
+  return recs_init(config);
+}
+
+//run the test with fixed-size and growable RECS instances
+static int run(uint8_t growable) {
+  struct test_context ctx = {0};
+  recs ecs = create(growable, &ctx);
+  if(ecs == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+
+  struct position_component p = {.x = 0, .y = 0};
+  for(uint32_t i = 0; i < NUM_START; i++) {
+    entities[i] = recs_entity_add(ecs);
+    recs_entity_add_component(ecs, entities[i], COMPONENT_POSITION, &p);
+  }
+
+  //the first run sees every component as added
+  recs_system_run(ecs, SYSTEM_GROUP_UPDATE);
+  int first_ok = ctx.num_added == NUM_START && ctx.num_changed == NUM_START && ctx.num_moved == NUM_START;
+
+  //a change made between runs, far from the entities moved by system_move, plus one new component.
+  //The sync system also sees the 10 entities moved by system_move after it last ran.
+  uint32_t tick = recs_next_change_tick(ecs);
+  ((struct position_component*)recs_entity_get_component_mut(ecs, entities[400], COMPONENT_POSITION))->y = 5;
+  recs_entity e = recs_entity_add(ecs);
+  recs_entity_add_component(ecs, e, COMPONENT_POSITION, &p);
+  int outside_ok = count_changes(ecs, RECS_CHANGE_CHANGED, tick, NULL) == 2 && count_changes(ecs, RECS_CHANGE_ADDED, tick, NULL) == 1;
+
+  recs_system_run(ecs, SYSTEM_GROUP_UPDATE);
+  int second_ok = ctx.num_added == 1 && ctx.num_changed == 12 && ctx.num_moved == 2;
+
+  //reading a component, or changing an untracked one, is not a change
+  recs_entity_get_component(ecs, entities[300], COMPONENT_POSITION);
+  struct velocity_component v = {1, 1};
+  recs_entity_add_component(ecs, entities[300], COMPONENT_VELOCITY, &v);
+  recs_system_run(ecs, SYSTEM_GROUP_UPDATE);
+  int untouched_ok = ctx.num_added == 0 && ctx.num_changed == 10 && ctx.num_moved == 0;
+
+  //removing a component moves the last one into its slot, which must keep its ticks,
+  //and the iterator's masks still apply
+  tick = recs_next_change_tick(ecs);
+  recs_entity_add_tag(ecs, entities[1], TAG_FROZEN);
+  ((struct position_component*)recs_entity_get_component_mut(ecs, e, COMPONENT_POSITION))->x = 1;
+  ((struct position_component*)recs_entity_get_component_mut(ecs, entities[1], COMPONENT_POSITION))->x = 1;
+  recs_entity_remove(ecs, entities[0]);
+  uint8_t frozen[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, frozen, 0, NULL, RECS_BITMASK_CREATE_TAG_ARG(1, TAG_FROZEN));
+  int moved_ok = count_changes(ecs, RECS_CHANGE_CHANGED, tick, NULL) == 2 && count_changes(ecs, RECS_CHANGE_CHANGED, tick, frozen) == 1 &&
+    recs_entity_component_changed(ecs, e, COMPONENT_POSITION, RECS_CHANGE_CHANGED, tick) &&
+    !recs_entity_component_changed(ecs, e, COMPONENT_POSITION, RECS_CHANGE_ADDED, tick);
+
+  //rolling back to an older copy never moves the tick backwards, so the systems keep seeing later changes.
+  //entities[0] was removed, so only 9 entities are moved from now on.
+  int copy_ok = 1;
+  if(!growable) {
+    recs old = recs_copy(ecs);
+    recs_system_run(ecs, SYSTEM_GROUP_UPDATE);
+    recs_copy_into(ecs, old);
+    recs_system_run(ecs, SYSTEM_GROUP_UPDATE);
+    ((struct position_component*)recs_entity_get_component_mut(ecs, entities[400], COMPONENT_POSITION))->y = 6;
+    recs_system_run(ecs, SYSTEM_GROUP_UPDATE);
+    copy_ok = ctx.num_changed == 10 && ctx.num_moved == 1;
+    recs_free(old);
+  }
+
+  recs_free(ecs);
+
+  if(!first_ok) {
+    printf("Test Failed, the first run did not see every component as added!\n");
+    return 1;
+  }
+  if(!outside_ok || !second_ok) {
+    printf("Test Failed, systems did not see the changes made since they last ran!\n");
+    return 1;
+  }
+  if(!untouched_ok) {
+    printf("Test Failed, components that were not changed were reported as changed!\n");
+    return 1;
+  }
+  if(!moved_ok) {
+    printf("Test Failed, components lost their ticks after being moved!\n");
+    return 1;
+  }
+  if(!copy_ok) {
+    printf("Test Failed, changes were missed after rolling back!\n");
+    return 1;
+  }
+  return 0;
+}
+
+int main(void) {
+  if(run(0) != 0) return 1;
+  return run(1);
+}
@@ -0,0 +1,158 @@
+#include <stdio.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 1000
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+#define RECS_MAX_QUERIES 1
+
+#define NUM_THREADS 4
+#define ARENA_SIZE (64 * 1024)
+
+#include "recs.h"
+
+struct position_component {
+  float x, y;
+};
+
+struct health_component {
+  int hp;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_POSITION, COMPONENT_HEALTH);
+RECS_INIT_TAG_IDS(tag, TAG_DEAD);
+
+//each thread records into its own command buffer
+static void spawn_children(struct recs *ecs, recs_entity e, void *userdata, uint32_t thread_index) {
+  recs_cmd_buffer *cmds = userdata;
+  struct health_component *h = recs_entity_get_component(ecs, e, COMPONENT_HEALTH);
+  if(h->hp % 10 != 0) {
+    return;
+  }
+
+  recs_entity child = recs_cmd_entity_add(cmds[thread_index]);
+  struct position_component p = {.x = (float)h->hp, .y = 1};
+  recs_cmd_entity_add_component(cmds[thread_index], child, COMPONENT_POSITION, &p);
+}
+
+#define FREE_AND_FAIL(ecs, message) do {printf("%s", message); recs_free(ecs); return 1;} while(0)
+
+
+int main(void) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {
+      .type = COMPONENT_POSITION,
+      .max_components = RECS_MAX_ENTITIES,
+      .comp_size = sizeof(struct position_component)
+    },
+    {
+      .type = COMPONENT_HEALTH,
+      .max_components = RECS_MAX_ENTITIES,
+      .comp_size = sizeof(struct health_component)
+    }
+  };
+
+  struct recs_init_config config = {
+    .max_entities = RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = RECS_MAX_QUERIES,
+    .context = NULL,
+    .components = comps,
+    .systems = NULL
+  };
+
+  recs ecs = recs_init(config);
+  recs_cmd_buffer cmd = recs_cmd_buffer_create(ecs, ARENA_SIZE);
+  if(ecs == NULL || cmd == NULL) {
+    FREE_AND_FAIL(ecs, "Failed to initialize!\n");
+  }
+
+  //placeholders can be used by later commands within the same command buffer
+  recs_entity placeholders[100];
+  for(int i = 0; i < 100; i++) {
+    placeholders[i] = recs_cmd_entity_add(cmd);
+    struct health_component h = {.hp = i};
+    recs_cmd_entity_add_component(cmd, placeholders[i], COMPONENT_HEALTH, &h);
+    if(i % 2 == 0) {
+      recs_cmd_entity_add_tag(cmd, placeholders[i], TAG_DEAD);
+    }
+  }
+
+  if(recs_num_active_entities(ecs) != 0) {
+    FREE_AND_FAIL(ecs, "Test Failed, commands were applied before playback!\n");
+  }
+
+  recs_cmd_buffer_playback(ecs, cmd);
+  if(recs_num_active_entities(ecs) != 100 || recs_component_num_instances(ecs, COMPONENT_HEALTH) != 100) {
+    FREE_AND_FAIL(ecs, "Test Failed, playback did not create every entity!\n");
+  }
+  if(recs_cmd_buffer_size(cmd) != 0) {
+    FREE_AND_FAIL(ecs, "Test Failed, playback did not clear the command buffer!\n");
+  }
+
+  //remove dead entities while iterating over them, making sure none are skipped
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(1, COMPONENT_HEALTH), 0, NULL);
+
+  uint32_t num_visited = 0;
+  recs_ent_iter iter = recs_ent_iter_init(ecs, mask);
+  while(recs_ent_iter_has_next(&iter)) {
+    recs_entity e = recs_ent_iter_next(ecs, &iter);
+    num_visited++;
+    if(recs_entity_has_tag(ecs, e, TAG_DEAD)) {
+      recs_cmd_entity_remove(cmd, e);
+
+      //commands on entities removed earlier in the command buffer are skipped
+      struct health_component h = {.hp = -1};
+      recs_cmd_entity_add_component(cmd, e, COMPONENT_HEALTH, &h);
+    } else {
+      //replaces the component's data, since the entity already has one
+      struct health_component *old = recs_entity_get_component(ecs, e, COMPONENT_HEALTH);
+      struct health_component h = {.hp = old->hp * 10};
+      recs_cmd_entity_add_component(cmd, e, COMPONENT_HEALTH, &h);
+    }
+  }
+  recs_cmd_buffer_playback(ecs, cmd);
+
+  if(num_visited != 100 || recs_num_active_entities(ecs) != 50) {
+    FREE_AND_FAIL(ecs, "Test Failed, entities were skipped while removing them!\n");
+  }
+
+  iter = recs_ent_iter_init(ecs, mask);
+  while(recs_ent_iter_has_next(&iter)) {
+    recs_entity e = recs_ent_iter_next(ecs, &iter);
+    struct health_component *h = recs_entity_get_component(ecs, e, COMPONENT_HEALTH);
+    if(h->hp < 0 || h->hp % 10 != 0 || (h->hp / 10) % 2 != 1 || recs_entity_has_tag(ecs, e, TAG_DEAD)) {
+      FREE_AND_FAIL(ecs, "Test Failed, wrong component data after playback!\n");
+    }
+  }
+
+  //record from several threads at once, then play each command buffer back at a sync point
+  recs_workers workers = recs_workers_create(NUM_THREADS);
+  recs_cmd_buffer thread_cmds[NUM_THREADS];
+  for(uint32_t t = 0; t < NUM_THREADS; t++) {
+    thread_cmds[t] = recs_cmd_buffer_create(ecs, ARENA_SIZE);
+  }
+
+  recs_query alive = recs_query_register(ecs, mask, RECS_ENT_MATCH_ALL, NULL, RECS_ENT_MATCH_ANY);
+  recs_query_par_each(ecs, workers, alive, spawn_children, thread_cmds, 1);
+
+  for(uint32_t t = 0; t < NUM_THREADS; t++) {
+    recs_cmd_buffer_playback(ecs, thread_cmds[t]);
+    recs_cmd_buffer_free(thread_cmds[t]);
+  }
+  recs_workers_free(workers);
+
+  //every alive entity has a multiple of 10 as health
+  if(recs_num_active_entities(ecs) != 100 || recs_component_num_instances(ecs, COMPONENT_POSITION) != 50) {
+    FREE_AND_FAIL(ecs, "Test Failed, commands recorded by several threads were lost!\n");
+  }
+
+  recs_cmd_buffer_free(cmd);
+  recs_free(ecs);
+  return 0;
+}
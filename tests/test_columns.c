@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <string.h>
+
+#define RECS_MAX_COMPONENTS 3
+#define RECS_MAX_TAGS 20
+#define RECS_MAX_ENTITIES 1000
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+
+#define NUM_ROUNDS 20
+#define OPS_PER_ROUND 400
+#define NUM_QUERIES 5
+
+#include "recs.h"
+
+struct value_component {
+  uint32_t value;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_A, COMPONENT_B, COMPONENT_C);
+
+#define MASK_SIZE RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)
+
+struct query {
+  uint8_t include[MASK_SIZE];
+  uint8_t exclude[MASK_SIZE];
+  uint8_t has_include;
+  uint8_t has_exclude;
+  enum recs_ent_match_op include_op;
+  enum recs_ent_match_op exclude_op;
+};
+
+static struct query queries[NUM_QUERIES];
+
+//the latest handle given to each entity ID
+static recs_entity handles[RECS_MAX_ENTITIES];
+static uint8_t used[RECS_MAX_ENTITIES];
+static uint8_t seen[RECS_MAX_ENTITIES];
+
+static uint32_t rng_state = 12345;
+static uint32_t rng(void) {
+  rng_state = rng_state * 1664525u + 1013904223u;
+  return rng_state >> 8;
+}
+
+static recs create(uint8_t growable, enum recs_storage_type storage) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {.type = COMPONENT_A, .max_components = growable ? 8 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct value_component)},
+    {.type = COMPONENT_B, .max_components = growable ? 8 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct value_component)},
+    {.type = COMPONENT_C, .max_components = growable ? 8 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct value_component)}
+  };
+
+  struct recs_init_config config = {
+    .max_entities = growable ? 8 : RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = 0,
+    .storage = storage,
+    .growable = growable,
+    .components = comps,
+    .systems = NULL
+  };
+
+  return recs_init(config);
+}
+
+static void create_queries(recs ecs) {
+  //rare components picked through the smallest pool
+  recs_bitmask_create(ecs, queries[0].include, RECS_BITMASK_CREATE_COMP_ARG(2, COMPONENT_A, COMPONENT_B), 0, NULL);
+  queries[0].has_include = 1;
+  queries[0].include_op = RECS_ENT_MATCH_ALL;
+
+  //a mix of components and tags on both sides
+  recs_bitmask_create(ecs, queries[1].include, RECS_BITMASK_CREATE_COMP_ARG(1, COMPONENT_B), RECS_BITMASK_CREATE_TAG_ARG(1, 0));
+  recs_bitmask_create(ecs, queries[1].exclude, RECS_BITMASK_CREATE_COMP_ARG(1, COMPONENT_C), 0, NULL);
+  queries[1].has_include = queries[1].has_exclude = 1;
+  queries[1].include_op = RECS_ENT_MATCH_ANY;
+  queries[1].exclude_op = RECS_ENT_MATCH_ANY;
+
+  //only excluding, which would otherwise check every active entity
+  recs_bitmask_create(ecs, queries[2].exclude, RECS_BITMASK_CREATE_COMP_ARG(1, COMPONENT_A), 0, NULL);
+  queries[2].has_exclude = 1;
+  queries[2].exclude_op = RECS_ENT_MATCH_ANY;
+
+  //excluding entities that have all of several components
+  recs_bitmask_create(ecs, queries[3].include, 0, NULL, RECS_BITMASK_CREATE_TAG_ARG(1, 1));
+  recs_bitmask_create(ecs, queries[3].exclude, RECS_BITMASK_CREATE_COMP_ARG(2, COMPONENT_A, COMPONENT_B), 0, NULL);
+  queries[3].has_include = queries[3].has_exclude = 1;
+  queries[3].include_op = RECS_ENT_MATCH_ALL;
+  queries[3].exclude_op = RECS_ENT_MATCH_ALL;
+
+  //too many tags to combine their columns, so entities are checked one at a time
+  recs_bitmask_create(ecs, queries[4].include, 0, NULL, RECS_BITMASK_CREATE_TAG_ARG(17, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16));
+  queries[4].has_include = 1;
+  queries[4].include_op = RECS_ENT_MATCH_ANY;
+}
+
+static uint8_t *query_include(struct query *q) {
+  return q->has_include ? q->include : NULL;
+}
+
+static uint8_t *query_exclude(struct query *q) {
+  return q->has_exclude ? q->exclude : NULL;
+}
+
+static uint8_t query_matches(recs ecs, struct query *q, recs_entity e) {
+  return recs_entity_active(ecs, e)
+    && (!q->has_include || recs_entity_matches_component_mask(ecs, e, q->include, q->include_op))
+    && (!q->has_exclude || !recs_entity_matches_component_mask(ecs, e, q->exclude, q->exclude_op));
+}
+
+//make sure an iterator finds each matching entity exactly once, and that counting finds the same number
+static int check_query(recs ecs, struct query *q) {
+  uint32_t expected = 0;
+  for(uint32_t id = 0; id < RECS_MAX_ENTITIES; id++) {
+    expected += used[id] && query_matches(ecs, q, handles[id]);
+  }
+
+  memset(seen, 0, sizeof(seen));
+  uint32_t count = 0;
+  recs_ent_iter iter = recs_ent_iter_init_with_exclude_and_match_op(ecs, query_include(q), q->include_op, query_exclude(q), q->exclude_op);
+  while(recs_ent_iter_has_next(&iter)) {
+    recs_entity e = recs_ent_iter_next(ecs, &iter);
+    if(!query_matches(ecs, q, e) || seen[RECS_ENT_ID(e)]) {
+      return 0;
+    }
+    seen[RECS_ENT_ID(e)] = 1;
+    count++;
+  }
+
+  return count == expected && recs_num_matching_entities(ecs, query_include(q), q->include_op, query_exclude(q), q->exclude_op) == expected;
+}
+
+static int check_queries(recs ecs) {
+  for(uint32_t i = 0; i < NUM_QUERIES; i++) {
+    if(!check_query(ecs, queries + i)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void random_op(recs ecs) {
+  uint32_t id = rng() % RECS_MAX_ENTITIES;
+  recs_entity e = handles[id];
+  uint8_t active = used[id] && recs_entity_active(ecs, e);
+  uint32_t op = rng() % 8;
+
+  if(!active || op == 0) {
+    if(recs_num_active_entities(ecs) < RECS_MAX_ENTITIES - 1) {
+      recs_entity added = recs_entity_add(ecs);
+      handles[RECS_ENT_ID(added)] = added;
+      used[RECS_ENT_ID(added)] = 1;
+    }
+    return;
+  }
+
+  struct value_component v = {id};
+  recs_component c = rng() % RECS_MAX_COMPONENTS;
+  recs_tag tag = rng() % RECS_MAX_TAGS;
+  switch(op) {
+    case 1: recs_entity_remove(ecs, e); break;
+    case 2: recs_entity_queue_remove(ecs, e); break;
+    case 3: case 4:
+      if(!recs_entity_has_component(ecs, e, c)) {
+        recs_entity_add_component(ecs, e, c, &v);
+      }
+      break;
+    case 5:
+      if(recs_entity_has_component(ecs, e, c)) {
+        recs_entity_remove_component(ecs, e, c);
+      }
+      break;
+    case 6: recs_entity_add_tag(ecs, e, tag); break;
+    case 7: recs_entity_remove_tag(ecs, e, tag); break;
+  }
+}
+
+//run the test with fixed-size, growable, and archetype RECS instances
+static int run(uint8_t growable, enum recs_storage_type storage) {
+  recs ecs = create(growable, storage);
+  if(ecs == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+  memset(used, 0, sizeof(used));
+  create_queries(ecs);
+
+  int match_ok = 1;
+  for(uint32_t round = 0; round < NUM_ROUNDS && match_ok; round++) {
+    for(uint32_t i = 0; i < OPS_PER_ROUND; i++) {
+      random_op(ecs);
+    }
+    match_ok = check_queries(ecs);
+    recs_entity_remove_queued(ecs);
+    match_ok = match_ok && check_queries(ecs);
+  }
+
+  //copies hold their own columns
+  int copy_ok = 1;
+  if(!growable) {
+    recs copy = recs_copy(ecs);
+    copy_ok = copy != NULL && check_queries(copy);
+    recs_free(copy);
+  }
+
+  //entities queued for removal while iterating are not found again
+  struct query *q = queries + 2;
+  uint32_t expected = recs_num_matching_entities(ecs, NULL, RECS_ENT_MATCH_ALL, q->exclude, q->exclude_op);
+  uint32_t found = 0;
+  recs_ent_iter iter = recs_ent_iter_init_with_exclude(ecs, NULL, q->exclude);
+  while(recs_ent_iter_has_next(&iter)) {
+    recs_entity_queue_remove(ecs, recs_ent_iter_next(ecs, &iter));
+    found++;
+  }
+  int queued_ok = found == expected && recs_num_matching_entities(ecs, NULL, RECS_ENT_MATCH_ALL, q->exclude, q->exclude_op) == 0 && check_queries(ecs);
+  recs_entity_remove_queued(ecs);
+  queued_ok = queued_ok && check_queries(ecs);
+
+  recs_free(ecs);
+
+  if(!match_ok) {
+    printf("Test Failed, the columns did not match the entities!\n");
+    return 1;
+  }
+  if(!copy_ok) {
+    printf("Test Failed, the copy did not hold the same columns!\n");
+    return 1;
+  }
+  if(!queued_ok) {
+    printf("Test Failed, entities queued for removal were still found!\n");
+    return 1;
+  }
+  return 0;
+}
+
+int main(void) {
+  if(run(0, RECS_STORAGE_SPARSE_SET) != 0) return 1;
+  if(run(1, RECS_STORAGE_SPARSE_SET) != 0) return 1;
+  return run(0, RECS_STORAGE_ARCHETYPE);
+}
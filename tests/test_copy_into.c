@@ -0,0 +1,169 @@
+#include <stdio.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 1000
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+#define RECS_MAX_QUERIES 1
+
+#define NUM_START 300
+
+#include "recs.h"
+
+struct position_component {
+  float x, y;
+};
+
+struct velocity_component {
+  float dx, dy;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_POSITION, COMPONENT_VELOCITY);
+RECS_INIT_TAG_IDS(tag, TAG_MOVING);
+
+static recs_entity entities[NUM_START];
+
+//what copying a RECS instance is expected to bring over
+struct world_state {
+  uint32_t num_active;
+  uint32_t num_moving;
+  uint8_t active[NUM_START];
+  float x[NUM_START];
+};
+
+static void save_state(recs ecs, recs_query moving, struct world_state *state) {
+  state->num_active = recs_num_active_entities(ecs);
+  state->num_moving = recs_query_num_entities(ecs, moving);
+  for(uint32_t i = 0; i < NUM_START; i++) {
+    state->active[i] = recs_entity_active(ecs, entities[i]);
+    state->x[i] = state->active[i] ? ((struct position_component*)recs_entity_get_component(ecs, entities[i], COMPONENT_POSITION))->x : 0;
+  }
+}
+
+static int same_state(recs ecs, recs_query moving, const struct world_state *state) {
+  struct world_state now;
+  save_state(ecs, moving, &now);
+  if(now.num_active != state->num_active || now.num_moving != state->num_moving) {
+    return 0;
+  }
+  for(uint32_t i = 0; i < NUM_START; i++) {
+    if(now.active[i] != state->active[i] || now.x[i] != state->x[i]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static recs_entity add_moving(recs ecs) {
+  recs_entity e = recs_entity_add(ecs);
+  struct position_component p = {.x = -1, .y = 0};
+  struct velocity_component v = {.dx = 1, .dy = 1};
+  recs_entity_add_component(ecs, e, COMPONENT_POSITION, &p);
+  recs_entity_add_component(ecs, e, COMPONENT_VELOCITY, &v);
+  recs_entity_add_tag(ecs, e, TAG_MOVING);
+  return e;
+}
+
+static recs create(enum recs_storage_type storage, recs_query *moving) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {.type = COMPONENT_POSITION, .max_components = RECS_MAX_ENTITIES, .comp_size = sizeof(struct position_component)},
+    {.type = COMPONENT_VELOCITY, .max_components = RECS_MAX_ENTITIES, .comp_size = sizeof(struct velocity_component)}
+  };
+
+  struct recs_init_config config = {
+    .max_entities = RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = RECS_MAX_QUERIES,
+    .context = NULL,
+    .storage = storage,
+    .components = comps,
+    .systems = NULL
+  };
+
+  recs ecs = recs_init(config);
+  if(ecs == NULL) {
+    return NULL;
+  }
+
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(2, COMPONENT_POSITION, COMPONENT_VELOCITY), RECS_BITMASK_CREATE_TAG_ARG(1, TAG_MOVING));
+  *moving = recs_query_register(ecs, mask, RECS_ENT_MATCH_ALL, NULL, RECS_ENT_MATCH_ANY);
+  return ecs;
+}
+
+//run the test with both storage backends
+static int run(enum recs_storage_type storage) {
+  recs_query moving, fresh_moving;
+  recs live = create(storage, &moving);
+  recs fresh = create(storage, &fresh_moving);
+  if(live == NULL || fresh == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+
+  for(uint32_t i = 0; i < NUM_START; i++) {
+    entities[i] = recs_entity_add(live);
+    struct position_component p = {.x = (float)i, .y = 0};
+    recs_entity_add_component(live, entities[i], COMPONENT_POSITION, &p);
+    if(i % 3 == 0) {
+      struct velocity_component v = {.dx = 1, .dy = 1};
+      recs_entity_add_component(live, entities[i], COMPONENT_VELOCITY, &v);
+      recs_entity_add_tag(live, entities[i], TAG_MOVING);
+    }
+  }
+
+  recs saved = recs_copy(live);
+  if(saved == NULL) {
+    printf("Failed to copy!\n");
+    return 1;
+  }
+  struct world_state saved_state;
+  save_state(saved, moving, &saved_state);
+
+  //change components, remove entities, and use entity IDs that were never used when the copy was made
+  for(uint32_t i = 0; i < NUM_START; i += 7) {
+    ((struct position_component*)recs_entity_get_component(live, entities[i], COMPONENT_POSITION))->x += 1000;
+  }
+  for(uint32_t i = 1; i < NUM_START; i += 5) {
+    recs_entity_remove(live, entities[i]);
+  }
+  for(uint32_t i = 0; i < 400; i++) {
+    add_moving(live);
+  }
+
+  //rolling back keeps the same handle, and matches the copy exactly, down to the next entity handed out
+  recs_copy_into(live, saved);
+  int rollback_ok = same_state(live, moving, &saved_state) && add_moving(live) == add_moving(saved) &&
+    recs_query_num_entities(live, moving) == saved_state.num_moving + 1;
+
+  //copying into a RECS instance that used fewer entity IDs than the source
+  struct world_state live_state;
+  save_state(live, moving, &live_state);
+  recs_copy_into(fresh, live);
+  int fresh_ok = same_state(fresh, fresh_moving, &live_state);
+  recs_entity_remove(fresh, entities[0]);
+  fresh_ok = fresh_ok && recs_query_num_entities(fresh, fresh_moving) == live_state.num_moving - 1;
+
+  recs_free(saved);
+  recs_free(fresh);
+  recs_free(live);
+
+  if(!rollback_ok) {
+    printf("Test Failed, copying into a RECS instance did not roll it back!\n");
+    return 1;
+  }
+  if(!fresh_ok) {
+    printf("Test Failed, copying into a new RECS instance did not match the source!\n");
+    return 1;
+  }
+  return 0;
+}
+
+int main(void) {
+  if(run(RECS_STORAGE_SPARSE_SET) != 0) return 1;
+  return run(RECS_STORAGE_ARCHETYPE);
+}
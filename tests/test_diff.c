@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <string.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 1000
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+#define RECS_MAX_QUERIES 1
+
+#define NUM_START 300
+#define STREAM_SIZE (1 << 16)
+
+#include "recs.h"
+
+struct position_component {
+  float x, y;
+};
+
+struct velocity_component {
+  float dx, dy;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_POSITION, COMPONENT_VELOCITY);
+RECS_INIT_TAG_IDS(tag, TAG_MOVING);
+
+static recs_entity entities[NUM_START];
+
+//a stream that diffs are written to and read back from, one after another
+struct stream {
+  uint8_t data[STREAM_SIZE];
+  size_t size;
+  size_t pos;
+};
+
+static struct stream stream;
+
+static int stream_write(void *userdata, const void *data, size_t size) {
+  struct stream *s = userdata;
+  if(size > STREAM_SIZE - s->size) return 0;
+  memcpy(s->data + s->size, data, size);
+  s->size += size;
+  return 1;
+}
+
+static int stream_read(void *userdata, void *data, size_t size) {
+  struct stream *s = userdata;
+  if(size > s->size - s->pos) return 0;
+  memcpy(data, s->data + s->pos, size);
+  s->pos += size;
+  return 1;
+}
+
+//what applying a diff is expected to bring over
+struct world_state {
+  uint32_t num_active;
+  uint32_t num_moving;
+  uint8_t active[NUM_START];
+  float x[NUM_START];
+  float dx[NUM_START];
+};
+
+static void save_state(recs ecs, struct world_state *state) {
+  state->num_active = recs_num_active_entities(ecs);
+  state->num_moving = recs_query_num_entities(ecs, 0);
+  for(uint32_t i = 0; i < NUM_START; i++) {
+    state->active[i] = recs_entity_active(ecs, entities[i]);
+    state->x[i] = state->active[i] ? ((struct position_component*)recs_entity_get_component(ecs, entities[i], COMPONENT_POSITION))->x : 0;
+    struct velocity_component *v = state->active[i] ? recs_entity_get_component(ecs, entities[i], COMPONENT_VELOCITY) : NULL;
+    state->dx[i] = v != NULL ? v->dx : 0;
+  }
+}
+
+static int same_state(recs a, recs b) {
+  struct world_state sa, sb;
+  save_state(a, &sa);
+  save_state(b, &sb);
+  return memcmp(&sa, &sb, sizeof(sa)) == 0;
+}
+
+//max_velocities is how many velocities the RECS instance holds, since pools of fixed-size RECS instances can not grow
+static recs create(enum recs_storage_type storage, uint32_t max_velocities) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {.type = COMPONENT_POSITION, .max_components = RECS_MAX_ENTITIES, .comp_size = sizeof(struct position_component), .track_changes = storage == RECS_STORAGE_SPARSE_SET},
+    {.type = COMPONENT_VELOCITY, .max_components = max_velocities, .comp_size = sizeof(struct velocity_component), .track_changes = storage == RECS_STORAGE_SPARSE_SET}
+  };
+
+  struct recs_init_config config = {
+    .max_entities = RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = RECS_MAX_QUERIES,
+    .context = NULL,
+    .storage = storage,
+    .components = comps,
+    .systems = NULL
+  };
+
+  recs ecs = recs_init(config);
+  if(ecs == NULL) {
+    return NULL;
+  }
+
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(2, COMPONENT_POSITION, COMPONENT_VELOCITY), RECS_BITMASK_CREATE_TAG_ARG(1, TAG_MOVING));
+  recs_query_register(ecs, mask, RECS_ENT_MATCH_ALL, NULL, RECS_ENT_MATCH_ANY);
+  return ecs;
+}
+
+//send the changes made to server since old, then bring old up to date
+static size_t sync(recs old, recs server, recs client) {
+  size_t start = stream.size;
+  if(recs_diff(old, server, stream_write, &stream) != stream.size - start || !recs_patch(client, stream_read, &stream) || stream.pos != stream.size) {
+    return 0;
+  }
+  recs_copy_into(old, server);
+  return stream.size - start;
+}
+
+//run the test with both storage backends
+static int run(enum recs_storage_type storage) {
+  recs server = create(storage, RECS_MAX_ENTITIES);
+  recs old = create(storage, RECS_MAX_ENTITIES);
+  recs client = create(storage, RECS_MAX_ENTITIES);
+  recs small = create(storage, NUM_START / 6);
+  if(server == NULL || old == NULL || client == NULL || small == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+  memset(&stream, 0, sizeof(stream));
+
+  for(uint32_t i = 0; i < NUM_START; i++) {
+    entities[i] = recs_entity_add(server);
+    struct position_component p = {.x = (float)i, .y = 0};
+    recs_entity_add_component(server, entities[i], COMPONENT_POSITION, &p);
+    if(i % 3 == 0) {
+      struct velocity_component v = {.dx = 1, .dy = 1};
+      recs_entity_add_component(server, entities[i], COMPONENT_VELOCITY, &v);
+      recs_entity_add_tag(server, entities[i], TAG_MOVING);
+    }
+  }
+  size_t first_size = sync(old, server, client);
+  int first_ok = first_size != 0 && same_state(server, client);
+
+  //the first diff adds more velocities than a RECS instance holding fewer of them has room for
+  size_t first_end = stream.pos;
+  stream.pos = 0;
+  int rejected = !recs_patch(small, stream_read, &stream);
+  stream.pos = first_end;
+
+  //change a few components and tags, and remove a few entities so that new entities reuse their IDs
+  for(uint32_t i = 0; i < NUM_START; i += 30) {
+    ((struct position_component*)recs_entity_get_component_mut(server, entities[i], COMPONENT_POSITION))->x += 1000;
+  }
+  for(uint32_t i = 6; i < NUM_START; i += 45) {
+    ((struct velocity_component*)recs_entity_get_component_mut(server, entities[i], COMPONENT_VELOCITY))->dx += 1;
+  }
+  for(uint32_t i = 3; i < NUM_START; i += 60) {
+    recs_entity_remove_tag(server, entities[i], TAG_MOVING);
+    recs_entity_remove_component(server, entities[i], COMPONENT_VELOCITY);
+  }
+  for(uint32_t i = 1; i < NUM_START; i += 50) {
+    recs_entity_remove(server, entities[i]);
+    entities[i] = recs_entity_add(server);
+    struct position_component p = {.x = -1, .y = 0};
+    recs_entity_add_component(server, entities[i], COMPONENT_POSITION, &p);
+    recs_entity_add_tag(server, entities[i], TAG_MOVING);
+  }
+  size_t second_size = sync(old, server, client);
+  int second_ok = second_size != 0 && second_size < first_size / 10 && same_state(server, client);
+
+  //nothing changed, so there is nothing to send
+  size_t empty_size = sync(old, server, client);
+  second_ok = second_ok && empty_size != 0 && empty_size < 32 && same_state(server, client);
+
+  //diffs that are invalid, or that do not match the RECS instance, are rejected
+  size_t start = stream.size;
+  recs_entity_remove(server, entities[0]);
+  recs_diff(old, server, stream_write, &stream);
+  stream.data[start + 2] = 'X';
+  rejected = rejected && !recs_patch(client, stream_read, &stream);
+  stream.data[start + 2] = 'R';
+  stream.pos = start;
+  rejected = rejected && recs_patch(client, stream_read, &stream) && same_state(server, client);
+  stream.pos = start;
+  rejected = rejected && !recs_patch(client, stream_read, &stream);
+
+  recs_free(small);
+  recs_free(client);
+  recs_free(old);
+  recs_free(server);
+
+  if(!first_ok || !second_ok) {
+    printf("Test Failed, applying a diff did not bring over the changes!\n");
+    return 1;
+  }
+  if(!rejected) {
+    printf("Test Failed, an invalid diff was applied!\n");
+    return 1;
+  }
+  return 0;
+}
+
+int main(void) {
+  if(run(RECS_STORAGE_SPARSE_SET) != 0) return 1;
+  return run(RECS_STORAGE_ARCHETYPE);
+}
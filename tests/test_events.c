@@ -0,0 +1,182 @@
+#include <stdio.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 100
+#define RECS_MAX_SYSTEMS 1
+#define RECS_MAX_SYS_GROUPS 1
+
+#define MAX_EVENTS 8
+#define NUM_BODIES 5
+
+#include "recs.h"
+
+//refers to a body owned by some external physics engine, which must be freed once the component is removed
+struct physics_body_component {
+  uint32_t handle;
+};
+
+struct position_component {
+  float x, y;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_PHYSICS_BODY, COMPONENT_POSITION);
+RECS_INIT_TAG_IDS(tag, TAG_UNUSED);
+RECS_INIT_SYS_GRP_IDS(system_group, SYSTEM_GROUP_CLEANUP);
+
+//stands in for the physics engine
+struct test_context {
+  uint8_t allocated[RECS_MAX_ENTITIES];
+  uint32_t num_added;
+  uint32_t num_freed;
+  uint8_t bad_event;
+};
+
+//frees the physics body of every removed component, without looking at any other entity
+static void system_cleanup(struct recs *ecs) {
+  struct test_context *ctx = recs_system_get_context(ecs);
+
+  struct recs_component_event events[4];
+  uint32_t n;
+  while((n = recs_component_events_drain(ecs, COMPONENT_PHYSICS_BODY, events, 4)) > 0) {
+    for(uint32_t i = 0; i < n; i++) {
+      if(events[i].type == RECS_COMPONENT_ADDED) {
+        ctx->num_added++;
+        ctx->bad_event |= events[i].component != NULL;
+        continue;
+      }
+
+      const struct physics_body_component *body = events[i].component;
+      ctx->bad_event |= body == NULL || body->handle != RECS_ENT_ID(events[i].entity) || !ctx->allocated[body->handle];
+      if(body != NULL && body->handle < RECS_MAX_ENTITIES) {
+        ctx->allocated[body->handle] = 0;
+      }
+      ctx->num_freed++;
+    }
+  }
+}
+
+static recs create(uint8_t growable, struct test_context *ctx) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {.type = COMPONENT_PHYSICS_BODY, .max_components = growable ? 4 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct physics_body_component), .max_events = MAX_EVENTS},
+    {.type = COMPONENT_POSITION, .max_components = growable ? 4 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct position_component)}
+  };
+
+  struct recs_init_config_system systems[RECS_MAX_SYSTEMS] = {
+    {.func = system_cleanup, .group = SYSTEM_GROUP_CLEANUP}
+  };
+
+  struct recs_init_config config = {
+    .max_entities = growable ? 4 : RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = 0,
+    .context = ctx,
+    .growable = growable,
+    .components = comps,
+    .systems = systems
+  };
+
+  return recs_init(config);
+}
+
+static recs_entity add_body(recs ecs, struct test_context *ctx) {
+  recs_entity e = recs_entity_add(ecs);
+  struct physics_body_component body = {.handle = RECS_ENT_ID(e)};
+  ctx->allocated[body.handle] = 1;
+  recs_entity_add_component(ecs, e, COMPONENT_PHYSICS_BODY, &body);
+  return e;
+}
+
+static uint32_t num_allocated(const struct test_context *ctx) {
+  uint32_t count = 0;
+  for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i++) {
+    count += ctx->allocated[i];
+  }
+  return count;
+}
+
+//run the test with fixed-size and growable RECS instances
+static int run(uint8_t growable) {
+  struct test_context ctx = {0};
+  recs ecs = create(growable, &ctx);
+  if(ecs == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+
+  recs_entity bodies[NUM_BODIES];
+  for(uint32_t i = 0; i < NUM_BODIES; i++) {
+    bodies[i] = add_body(ecs, &ctx);
+  }
+
+  //components without a queue are not reported
+  struct position_component p = {0, 0};
+  recs_entity_add_component(ecs, bodies[0], COMPONENT_POSITION, &p);
+  recs_entity_remove_component(ecs, bodies[0], COMPONENT_POSITION);
+
+  int added_ok = recs_component_events_count(ecs, COMPONENT_PHYSICS_BODY) == NUM_BODIES;
+  recs_system_run(ecs, SYSTEM_GROUP_CLEANUP);
+  added_ok = added_ok && ctx.num_added == NUM_BODIES && recs_component_events_count(ecs, COMPONENT_PHYSICS_BODY) == 0;
+
+  //every way a component can be removed is reported, along with a copy of the component.
+  //Removing bodies[1] moves the last component into its slot, which must not be reported.
+  recs_entity_remove_component(ecs, bodies[1], COMPONENT_PHYSICS_BODY);
+  recs_entity_remove(ecs, bodies[2]);
+  recs_entity_queue_remove(ecs, bodies[3]);
+  recs_entity_remove_queued(ecs);
+  recs_system_run(ecs, SYSTEM_GROUP_CLEANUP);
+  int removed_ok = ctx.num_freed == 3 && num_allocated(&ctx) == 2 && !ctx.bad_event;
+
+  //copies hold their own queue
+  int copy_ok = 1;
+  recs_entity_remove(ecs, bodies[4]);
+  recs copy = recs_copy(ecs);
+  if(copy == NULL) {
+    copy_ok = 0;
+  } else {
+    struct recs_component_event event;
+    copy_ok = recs_component_events_drain(copy, COMPONENT_PHYSICS_BODY, &event, 1) == 1 &&
+      event.entity == bodies[4] && ((const struct physics_body_component*)event.component)->handle == RECS_ENT_ID(bodies[4]) &&
+      recs_component_events_count(ecs, COMPONENT_PHYSICS_BODY) == 1;
+    recs_free(copy);
+  }
+  recs_system_run(ecs, SYSTEM_GROUP_CLEANUP);
+
+  //a full queue drops its oldest events
+  recs_entity more[MAX_EVENTS + 2];
+  for(uint32_t i = 0; i < MAX_EVENTS + 2; i++) {
+    more[i] = add_body(ecs, &ctx);
+  }
+  struct recs_component_event events[MAX_EVENTS + 2];
+  uint32_t n = recs_component_events_drain(ecs, COMPONENT_PHYSICS_BODY, events, MAX_EVENTS + 2);
+  int overflow_ok = n == MAX_EVENTS && recs_component_events_num_dropped(ecs, COMPONENT_PHYSICS_BODY) == 2 &&
+    events[0].entity == more[2] && events[MAX_EVENTS - 1].entity == more[MAX_EVENTS + 1];
+
+  recs_free(ecs);
+
+  if(!added_ok) {
+    printf("Test Failed, added components were not reported!\n");
+    return 1;
+  }
+  if(!removed_ok) {
+    printf("Test Failed, removed components were not reported correctly!\n");
+    return 1;
+  }
+  if(!copy_ok) {
+    printf("Test Failed, the copy did not hold its own events!\n");
+    return 1;
+  }
+  if(!overflow_ok) {
+    printf("Test Failed, the full queue did not drop its oldest events!\n");
+    return 1;
+  }
+  return 0;
+}
+
+int main(void) {
+  if(run(0) != 0) return 1;
+  return run(1);
+}
@@ -0,0 +1,390 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 999
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+
+#define NUM_OPS 3000
+#define NUM_BULK 40
+#define MAX_EVENTS 64
+#define NUM_BATCH 16
+#define STREAM_SIZE (1 << 18)
+
+#include "recs.h"
+
+//bytes of unused are not inside any field, so they are never stored
+struct body {
+  float x, y, z;
+  uint32_t id;
+  float velocity[3];
+  uint32_t flags;
+  uint8_t unused[8];
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_BODY, COMPONENT_STABLE_BODY);
+
+static const struct recs_component_field body_fields[] = {
+  {offsetof(struct body, x), sizeof(float)},
+  {offsetof(struct body, y), sizeof(float)},
+  {offsetof(struct body, z), sizeof(float)},
+  {offsetof(struct body, id), sizeof(uint32_t)},
+  {offsetof(struct body, velocity), sizeof(float) * 3},
+  {offsetof(struct body, flags), sizeof(uint32_t)}
+};
+#define NUM_BODY_FIELDS (sizeof(body_fields) / sizeof(body_fields[0]))
+#define FIELD_X 0
+#define FIELD_ID 3
+#define FIELD_VELOCITY 4
+
+//the latest handle given to each entity ID, and the body each of its component types should hold
+static recs_entity handles[RECS_MAX_ENTITIES];
+static uint8_t used[RECS_MAX_ENTITIES];
+static struct body expected[RECS_MAX_COMPONENTS][RECS_MAX_ENTITIES];
+
+static uint32_t rng_state = 31337;
+static uint32_t rng(void) {
+  rng_state = rng_state * 1664525u + 1013904223u;
+  return rng_state >> 8;
+}
+
+static recs create(uint8_t growable, uint32_t block_size) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {.type = COMPONENT_BODY, .max_components = growable ? 8 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct body), .track_changes = 1,
+      .max_events = MAX_EVENTS, .fields = body_fields, .num_fields = NUM_BODY_FIELDS, .field_block_size = block_size},
+    {.type = COMPONENT_STABLE_BODY, .max_components = growable ? 8 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct body),
+      .removal_policy = RECS_REMOVAL_STABLE, .fields = body_fields, .num_fields = NUM_BODY_FIELDS, .field_block_size = block_size}
+  };
+
+  struct recs_init_config config = {
+    .max_entities = growable ? 8 : RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = 0,
+    .growable = growable,
+    .component_page_size = 2048,
+    .components = comps,
+    .systems = NULL
+  };
+
+  return recs_init(config);
+}
+
+static struct body make_body(uint32_t id) {
+  struct body b = {(float)(rng() % 1000), (float)(rng() % 1000), (float)(rng() % 1000), id, {(float)(rng() % 10), 1, 2}, rng(), {0}};
+  memset(b.unused, 0xAB, sizeof(b.unused));
+  return b;
+}
+
+//compare every field of 2 bodies, leaving out the bytes that are not stored
+static int same_body(const struct body *a, const struct body *b) {
+  return a->x == b->x && a->y == b->y && a->z == b->z && a->id == b->id && a->flags == b->flags &&
+    memcmp(a->velocity, b->velocity, sizeof(a->velocity)) == 0;
+}
+
+static void add_component(recs ecs, recs_entity e, recs_component c) {
+  struct body b = make_body(RECS_ENT_ID(e));
+  recs_entity_add_component(ecs, e, c, &b);
+  expected[c][RECS_ENT_ID(e)] = b;
+}
+
+static void random_op(recs ecs) {
+  uint32_t id = rng() % RECS_MAX_ENTITIES;
+  recs_entity e = handles[id];
+  recs_component c = rng() % RECS_MAX_COMPONENTS;
+  if(!used[id] || !recs_entity_active(ecs, e)) {
+    if(recs_num_active_entities(ecs) < RECS_MAX_ENTITIES - NUM_BULK) {
+      recs_entity added = recs_entity_add(ecs);
+      handles[RECS_ENT_ID(added)] = added;
+      used[RECS_ENT_ID(added)] = 1;
+      add_component(ecs, added, c);
+    }
+    return;
+  }
+
+  switch(rng() % 4) {
+    case 0: recs_entity_remove(ecs, e); break;
+    case 1:
+      if(recs_entity_has_component(ecs, e, c)) {
+        recs_entity_remove_component(ecs, e, c);
+      } else {
+        add_component(ecs, e, c);
+      }
+      break;
+    default:
+      if(recs_entity_has_component(ecs, e, c)) {
+        struct body b = make_body(id);
+        recs_entity_scatter_component(ecs, e, c, &b);
+        expected[c][id] = b;
+      }
+      break;
+  }
+}
+
+//add entities with both bodies at once
+static void add_bulk(recs ecs) {
+  recs_entity added[NUM_BULK];
+  static struct body bodies[NUM_BULK];
+  for(uint32_t i = 0; i < NUM_BULK; i++) {
+    bodies[i] = make_body(0);
+  }
+
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(2, COMPONENT_BODY, COMPONENT_STABLE_BODY), 0, NULL);
+  const void *arrays[RECS_MAX_COMPONENTS] = {bodies, bodies};
+  recs_entity_add_bulk(ecs, NUM_BULK, added, mask, arrays);
+
+  //the IDs of the new entities were not known yet, so they are filled in now
+  for(uint32_t i = 0; i < NUM_BULK; i++) {
+    uint32_t id = RECS_ENT_ID(added[i]);
+    handles[id] = added[i];
+    used[id] = 1;
+    for(recs_component c = 0; c < RECS_MAX_COMPONENTS; c++) {
+      struct body b = bodies[i];
+      b.id = id;
+      recs_entity_scatter_component(ecs, added[i], c, &b);
+      expected[c][id] = b;
+    }
+  }
+}
+
+//make sure every entity's components can be gathered, and that the columns hold the same fields
+static int check_bodies(recs ecs) {
+  for(recs_component c = 0; c < RECS_MAX_COMPONENTS; c++) {
+    for(uint32_t i = 0; i < recs_component_num_slots(ecs, c);) {
+      uint32_t count = 0;
+      const uint32_t *ids = recs_component_field(ecs, c, FIELD_ID, i, &count);
+      const float *velocities = recs_component_field(ecs, c, FIELD_VELOCITY, i, NULL);
+      if(ids == NULL || count == 0) {
+        return 0;
+      }
+
+      for(uint32_t j = 0; j < count; j++) {
+        recs_entity e = recs_component_get_entity(ecs, c, i + j);
+        if(e == RECS_NO_ENTITY) continue;
+
+        struct body gathered;
+        memset(&gathered, 0, sizeof(gathered));
+        const struct body *b = &expected[c][RECS_ENT_ID(e)];
+        if(!recs_entity_gather_component(ecs, e, c, &gathered) || !same_body(&gathered, b) || gathered.unused[0] != 0) {
+          return 0;
+        }
+        if(ids[j] != RECS_ENT_ID(e) || memcmp(velocities + (j * 3), b->velocity, sizeof(b->velocity)) != 0) {
+          return 0;
+        }
+      }
+      i += count;
+    }
+  }
+  return recs_component_field(ecs, COMPONENT_BODY, FIELD_X, recs_component_num_slots(ecs, COMPONENT_BODY), NULL) == NULL;
+}
+
+//move every body along its velocity, one column at a time
+static void move_bodies(recs ecs) {
+  for(uint32_t i = 0; i < recs_component_num_slots(ecs, COMPONENT_BODY);) {
+    uint32_t count = 0;
+    float *x = recs_component_field(ecs, COMPONENT_BODY, FIELD_X, i, &count);
+    const float *velocities = recs_component_field(ecs, COMPONENT_BODY, FIELD_VELOCITY, i, NULL);
+    for(uint32_t j = 0; j < count; j++) {
+      x[j] += velocities[j * 3];
+      expected[COMPONENT_BODY][RECS_ENT_ID(recs_component_get_entity(ecs, COMPONENT_BODY, i + j))].x = x[j];
+    }
+    i += count;
+  }
+}
+
+//no component pointers are given out for component types split into fields, since their pools hold no whole components
+static int check_no_pointers(recs ecs) {
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(1, COMPONENT_BODY), 0, NULL);
+  recs_ent_iter iter = recs_ent_iter_init(ecs, mask);
+
+  recs_entity entities[NUM_BATCH];
+  void *components[NUM_BATCH];
+  const recs_component comps[1] = {COMPONENT_BODY};
+  uint32_t n = recs_ent_iter_next_batch(ecs, &iter, entities, NUM_BATCH, comps, 1, components);
+  if(n == 0 || recs_component_get(ecs, COMPONENT_BODY, 0) != NULL) {
+    return 0;
+  }
+  for(uint32_t i = 0; i < n; i++) {
+    if(components[i] != NULL || recs_entity_get_component(ecs, entities[i], COMPONENT_BODY) != NULL || recs_entity_get_component_mut(ecs, entities[i], COMPONENT_BODY) != NULL) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+//removal events hold the whole removed component
+static int check_events(recs ecs) {
+  struct recs_component_event events[MAX_EVENTS];
+  uint32_t n = recs_component_events_drain(ecs, COMPONENT_BODY, events, MAX_EVENTS);
+  for(uint32_t i = 0; i < n; i++) {
+    const struct body *b = (const struct body*)events[i].component;
+    if(events[i].type == RECS_COMPONENT_REMOVED && (b == NULL || b->id != RECS_ENT_ID(events[i].entity))) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+//playing back a command buffer overwrites components entities already have, and adds the others
+static int check_cmd_buffer(recs ecs) {
+  recs_cmd_buffer cmd = recs_cmd_buffer_create(ecs, 4096);
+  if(cmd == NULL) {
+    return 0;
+  }
+
+  uint32_t num_queued = 0;
+  for(uint32_t id = 0; id < RECS_MAX_ENTITIES && num_queued < 20; id++) {
+    if(!used[id] || !recs_entity_active(ecs, handles[id])) continue;
+
+    recs_component c = num_queued % RECS_MAX_COMPONENTS;
+    struct body b = make_body(id);
+    recs_cmd_entity_add_component(cmd, handles[id], c, &b);
+    expected[c][id] = b;
+    num_queued++;
+  }
+  recs_cmd_buffer_playback(ecs, cmd);
+  recs_cmd_buffer_free(cmd);
+  return check_bodies(ecs);
+}
+
+//a stream that a diff is written to and read back from
+struct stream {
+  uint8_t data[STREAM_SIZE];
+  size_t size;
+  size_t pos;
+};
+
+static struct stream stream;
+
+static int stream_write(void *userdata, const void *data, size_t size) {
+  struct stream *s = userdata;
+  if(size > STREAM_SIZE - s->size) return 0;
+  memcpy(s->data + s->size, data, size);
+  s->size += size;
+  return 1;
+}
+
+static int stream_read(void *userdata, void *data, size_t size) {
+  struct stream *s = userdata;
+  if(size > s->size - s->pos) return 0;
+  memcpy(data, s->data + s->pos, size);
+  s->pos += size;
+  return 1;
+}
+
+//applying the diff between an old copy and the current state brings the copy up to date
+static int check_diff(recs old, recs ecs) {
+  stream.size = 0;
+  stream.pos = 0;
+  return old != NULL && recs_diff(old, ecs, stream_write, &stream) != 0 && recs_patch(old, stream_read, &stream) && check_bodies(old);
+}
+
+//run the test with fixed-size and growable RECS instances, storing each field across whole pages or inside small blocks
+static int run(uint8_t growable, uint32_t block_size) {
+  recs ecs = create(growable, block_size);
+  if(ecs == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+  memset(used, 0, sizeof(used));
+
+  int update_ok = 1, events_ok = 1;
+  for(uint32_t i = 0; i < NUM_OPS && update_ok && events_ok; i++) {
+    random_op(ecs);
+    if(i % 500 == 0) {
+      add_bulk(ecs);
+      update_ok = check_bodies(ecs);
+    }
+    events_ok = recs_component_events_count(ecs, COMPONENT_BODY) < MAX_EVENTS || check_events(ecs);
+  }
+  update_ok = update_ok && check_bodies(ecs);
+  events_ok = events_ok && check_events(ecs);
+
+  //the copy misses the changes made from here on
+  recs old = recs_copy(ecs);
+
+  move_bodies(ecs);
+  int column_ok = check_bodies(ecs);
+
+  //scattering a component counts as a change
+  int change_ok = 1;
+  uint32_t tick = recs_next_change_tick(ecs);
+  for(uint32_t id = 0; id < RECS_MAX_ENTITIES; id++) {
+    if(used[id] && recs_entity_active(ecs, handles[id]) && recs_entity_has_component(ecs, handles[id], COMPONENT_BODY)) {
+      recs_entity_scatter_component(ecs, handles[id], COMPONENT_BODY, &expected[COMPONENT_BODY][id]);
+      change_ok = recs_entity_component_changed(ecs, handles[id], COMPONENT_BODY, RECS_CHANGE_CHANGED, tick);
+      break;
+    }
+  }
+
+  int pointers_ok = check_no_pointers(ecs);
+  int cmd_ok = check_cmd_buffer(ecs);
+  int diff_ok = check_diff(old, ecs);
+  recs_free(old);
+
+  //saves keep the fields of each component
+  int save_ok = 1;
+  if(!growable) {
+    size_t size = recs_save_size(ecs);
+    void *data = malloc(size);
+    recs loaded = create(growable, block_size);
+    save_ok = data != NULL && loaded != NULL && recs_save(ecs, data, size) == size && recs_load(loaded, data, size) && check_bodies(loaded);
+    recs_free(loaded);
+
+    //saves of pools with other blocks do not load
+    loaded = create(growable, block_size == 0 ? 8 : 0);
+    save_ok = save_ok && loaded != NULL && !recs_load(loaded, data, size);
+    recs_free(loaded);
+    free(data);
+  }
+
+  recs_free(ecs);
+
+  if(!update_ok) {
+    printf("Test Failed, components did not keep their fields!\n");
+    return 1;
+  }
+  if(!events_ok) {
+    printf("Test Failed, removal events did not hold the removed component!\n");
+    return 1;
+  }
+  if(!column_ok) {
+    printf("Test Failed, writing to a column did not change the components!\n");
+    return 1;
+  }
+  if(!change_ok) {
+    printf("Test Failed, scattering a component was not seen as a change!\n");
+    return 1;
+  }
+  if(!pointers_ok) {
+    printf("Test Failed, a pointer was given out to a component split into fields!\n");
+    return 1;
+  }
+  if(!cmd_ok) {
+    printf("Test Failed, playing back a command buffer did not write the components!\n");
+    return 1;
+  }
+  if(!diff_ok) {
+    printf("Test Failed, applying a diff did not bring over the changed fields!\n");
+    return 1;
+  }
+  if(!save_ok) {
+    printf("Test Failed, loading a save lost the fields of the components!\n");
+    return 1;
+  }
+  return 0;
+}
+
+int main(void) {
+  if(run(0, 0) != 0) return 1;
+  if(run(0, 8) != 0) return 1;
+  if(run(1, 0) != 0) return 1;
+  return run(1, 16);
+}
@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <string.h>
+
+#define RECS_MAX_COMPONENTS 3
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 1000
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+
+#define NUM_ROUNDS 20
+#define OPS_PER_ROUND 400
+
+#include "recs.h"
+
+//every component stores the ID of its entity, so that we can tell if components of different entities got mixed up
+struct id_component {
+  uint32_t id;
+  uint32_t padding[3];
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_POSITION, COMPONENT_VELOCITY, COMPONENT_HEALTH);
+
+//the latest handle given to each entity ID, and the tick at which it was given its velocity
+static recs_entity handles[RECS_MAX_ENTITIES];
+static uint8_t used[RECS_MAX_ENTITIES];
+static uint32_t velocity_ticks[RECS_MAX_ENTITIES];
+
+static uint32_t rng_state = 6789;
+static uint32_t rng(void) {
+  rng_state = rng_state * 1664525u + 1013904223u;
+  return rng_state >> 8;
+}
+
+static recs create(uint8_t growable) {
+  //tiny pages, so that growable pools split the group across many pages
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {.type = COMPONENT_POSITION, .max_components = growable ? 8 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct id_component)},
+    {.type = COMPONENT_VELOCITY, .max_components = growable ? 8 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct id_component), .track_changes = 1},
+    {.type = COMPONENT_HEALTH, .max_components = growable ? 8 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct id_component)}
+  };
+
+  struct recs_init_config config = {
+    .max_entities = growable ? 8 : RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = 0,
+    .max_groups = 1,
+    .growable = growable,
+    .component_page_size = 128,
+    .components = comps,
+    .systems = NULL
+  };
+
+  return recs_init(config);
+}
+
+static void add_component(recs ecs, recs_entity e, recs_component c) {
+  struct id_component comp = {RECS_ENT_ID(e), {0}};
+  recs_entity_add_component(ecs, e, c, &comp);
+  if(c == COMPONENT_VELOCITY) {
+    velocity_ticks[RECS_ENT_ID(e)] = recs_next_change_tick(ecs);
+  }
+}
+
+static uint8_t in_group(recs ecs, recs_entity e) {
+  return recs_entity_has_component(ecs, e, COMPONENT_POSITION) && recs_entity_has_component(ecs, e, COMPONENT_VELOCITY);
+}
+
+//make sure the group holds exactly the entities with both components, in the same order within both pools
+static int check_group(recs ecs, recs_group group) {
+  uint32_t expected = 0;
+  for(uint32_t i = 0; i < recs_component_num_instances(ecs, COMPONENT_POSITION); i++) {
+    expected += in_group(ecs, recs_component_get_entity(ecs, COMPONENT_POSITION, i));
+  }
+
+  uint32_t num = recs_group_num_entities(ecs, group);
+  if(num != expected) {
+    return 0;
+  }
+
+  //walk the group one run of contiguous components at a time
+  for(uint32_t i = 0; i < num;) {
+    uint32_t num_positions = 0, num_velocities = 0;
+    struct id_component *positions = recs_group_components(ecs, group, COMPONENT_POSITION, i, &num_positions);
+    struct id_component *velocities = recs_group_components(ecs, group, COMPONENT_VELOCITY, i, &num_velocities);
+    uint32_t count = num_positions < num_velocities ? num_positions : num_velocities;
+    if(count == 0 || count > num - i) {
+      return 0;
+    }
+
+    for(uint32_t j = 0; j < count; j++) {
+      recs_entity e = recs_component_get_entity(ecs, COMPONENT_POSITION, i + j);
+      if(e != recs_component_get_entity(ecs, COMPONENT_VELOCITY, i + j) || !in_group(ecs, e)) {
+        return 0;
+      }
+      if(positions[j].id != RECS_ENT_ID(e) || velocities[j].id != RECS_ENT_ID(e)) {
+        return 0;
+      }
+
+      //ticks move along with their components
+      uint32_t tick = velocity_ticks[RECS_ENT_ID(e)];
+      if(!recs_entity_component_changed(ecs, e, COMPONENT_VELOCITY, RECS_CHANGE_ADDED, tick - 1) || recs_entity_component_changed(ecs, e, COMPONENT_VELOCITY, RECS_CHANGE_ADDED, tick)) {
+        return 0;
+      }
+    }
+    i += count;
+  }
+
+  return recs_group_components(ecs, group, COMPONENT_POSITION, num, NULL) == NULL;
+}
+
+static void random_op(recs ecs) {
+  uint32_t id = rng() % RECS_MAX_ENTITIES;
+  recs_entity e = handles[id];
+  uint8_t active = used[id] && recs_entity_active(ecs, e);
+  uint32_t op = rng() % 8;
+
+  if(!active || op == 0) {
+    if(recs_num_active_entities(ecs) < RECS_MAX_ENTITIES - 1) {
+      recs_entity added = recs_entity_add(ecs);
+      handles[RECS_ENT_ID(added)] = added;
+      used[RECS_ENT_ID(added)] = 1;
+    }
+    return;
+  }
+
+  recs_component c = rng() % RECS_MAX_COMPONENTS;
+  switch(op) {
+    case 1: recs_entity_remove(ecs, e); break;
+    case 2: recs_entity_queue_remove(ecs, e); break;
+    case 3: case 4: case 5:
+      if(!recs_entity_has_component(ecs, e, c)) {
+        add_component(ecs, e, c);
+      }
+      break;
+    case 6:
+      if(recs_entity_has_component(ecs, e, c)) {
+        recs_entity_remove_component(ecs, e, c);
+      }
+      break;
+    case 7: recs_entity_remove_all_components(ecs, e); break;
+  }
+}
+
+//add entities with both components at once
+static void add_bulk(recs ecs) {
+  recs_entity added[16];
+  struct id_component comps[16];
+  memset(comps, 0, sizeof(comps));
+  if(recs_num_active_entities(ecs) >= RECS_MAX_ENTITIES - 16) {
+    return;
+  }
+
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(2, COMPONENT_POSITION, COMPONENT_VELOCITY), 0, NULL);
+  const void *arrays[RECS_MAX_COMPONENTS] = {comps, comps, NULL};
+  recs_entity_add_bulk(ecs, 16, added, mask, arrays);
+
+  //the IDs of the new entities were not known yet, so they are filled in now
+  uint32_t tick = recs_next_change_tick(ecs);
+  for(uint32_t i = 0; i < 16; i++) {
+    uint32_t id = RECS_ENT_ID(added[i]);
+    handles[id] = added[i];
+    used[id] = 1;
+    velocity_ticks[id] = tick;
+    ((struct id_component*)recs_entity_get_component(ecs, added[i], COMPONENT_POSITION))->id = id;
+    ((struct id_component*)recs_entity_get_component(ecs, added[i], COMPONENT_VELOCITY))->id = id;
+  }
+}
+
+//run the test with fixed-size and growable RECS instances
+static int run(uint8_t growable) {
+  recs ecs = create(growable);
+  if(ecs == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+  memset(used, 0, sizeof(used));
+
+  //entities that already have both components join the group when it is registered
+  for(uint32_t i = 0; i < OPS_PER_ROUND; i++) {
+    random_op(ecs);
+  }
+  recs_component comps[2] = {COMPONENT_VELOCITY, COMPONENT_POSITION};
+  recs_group group = recs_group_register(ecs, comps, 2);
+  int register_ok = check_group(ecs, group);
+
+  int update_ok = 1;
+  for(uint32_t round = 0; round < NUM_ROUNDS && update_ok; round++) {
+    for(uint32_t i = 0; i < OPS_PER_ROUND; i++) {
+      random_op(ecs);
+    }
+    add_bulk(ecs);
+    update_ok = check_group(ecs, group);
+    recs_entity_remove_queued(ecs);
+    update_ok = update_ok && check_group(ecs, group);
+  }
+
+  //copies keep the group's order
+  int copy_ok = 1;
+  if(!growable) {
+    recs copy = recs_copy(ecs);
+    copy_ok = copy != NULL && check_group(copy, group);
+    recs_free(copy);
+  }
+
+  recs_free(ecs);
+
+  if(!register_ok) {
+    printf("Test Failed, the group did not gather the entities that already had its components!\n");
+    return 1;
+  }
+  if(!update_ok) {
+    printf("Test Failed, the group did not match the entities having its components!\n");
+    return 1;
+  }
+  if(!copy_ok) {
+    printf("Test Failed, the copy did not keep the group!\n");
+    return 1;
+  }
+  return 0;
+}
+
+int main(void) {
+  if(run(0) != 0) return 1;
+  return run(1);
+}
@@ -0,0 +1,179 @@
+#include <stdio.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+#define RECS_MAX_QUERIES 1
+
+//the RECS instance starts out with room for a handful of entities, and grows to fit NUM_ENTITIES
+#define START_ENTITIES 4
+#define NUM_ENTITIES 1000
+
+#include "recs.h"
+
+struct position_component {
+  float x, y;
+};
+
+struct velocity_component {
+  float dx, dy;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_POSITION, COMPONENT_VELOCITY);
+RECS_INIT_TAG_IDS(tag, TAG_MOVING);
+
+#define FREE_AND_FAIL(ecs, message) do {printf("%s", message); recs_free(ecs); return 1;} while(0)
+
+static recs_entity entities[NUM_ENTITIES * 2];
+
+//make sure every entity still has the components it was given
+static int check_entities(recs ecs, uint32_t first, uint32_t count) {
+  for(uint32_t i = first; i < first + count; i++) {
+    struct position_component *p = recs_entity_get_component(ecs, entities[i], COMPONENT_POSITION);
+    struct velocity_component *v = recs_entity_get_component(ecs, entities[i], COMPONENT_VELOCITY);
+    if(!recs_entity_active(ecs, entities[i]) || p == NULL || p->x != (float)i) {
+      return 0;
+    }
+    if((i % 3 == 0) != (v != NULL) || (v != NULL && v->dy != (float)i) || (i % 3 == 0) != !!recs_entity_has_tag(ecs, entities[i], TAG_MOVING)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int main(void) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {
+      .type = COMPONENT_POSITION,
+      .max_components = START_ENTITIES,
+      .comp_size = sizeof(struct position_component)
+    },
+    {
+      .type = COMPONENT_VELOCITY,
+      .max_components = 0,
+      .comp_size = sizeof(struct velocity_component)
+    }
+  };
+
+  struct recs_init_config config = {
+    .max_entities = START_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = RECS_MAX_QUERIES,
+    .context = NULL,
+    .growable = 1,
+
+    //tiny pages, so that each pool needs many of them
+    .component_page_size = 64,
+    .components = comps,
+    .systems = NULL
+  };
+
+  recs ecs = recs_init(config);
+  if(ecs == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(2, COMPONENT_POSITION, COMPONENT_VELOCITY), RECS_BITMASK_CREATE_TAG_ARG(1, TAG_MOVING));
+  recs_query moving = recs_query_register(ecs, mask, RECS_ENT_MATCH_ALL, NULL, RECS_ENT_MATCH_ANY);
+
+  struct position_component *first_position = NULL;
+  for(uint32_t i = 0; i < NUM_ENTITIES; i++) {
+    recs_entity e = recs_entity_add(ecs);
+    entities[i] = e;
+
+    struct position_component p = {.x = (float)i, .y = 0};
+    recs_entity_add_component(ecs, e, COMPONENT_POSITION, &p);
+    if(i % 3 == 0) {
+      struct velocity_component v = {.dx = 0, .dy = (float)i};
+      recs_entity_add_component(ecs, e, COMPONENT_VELOCITY, &v);
+      recs_entity_add_tag(ecs, e, TAG_MOVING);
+    }
+
+    if(i == 0) {
+      first_position = recs_entity_get_component(ecs, e, COMPONENT_POSITION);
+    }
+  }
+
+  if(recs_num_active_entities(ecs) != NUM_ENTITIES || !check_entities(ecs, 0, NUM_ENTITIES)) {
+    FREE_AND_FAIL(ecs, "Test Failed, entities lost their components while growing!\n");
+  }
+  if(recs_query_num_entities(ecs, moving) != (NUM_ENTITIES + 2) / 3) {
+    FREE_AND_FAIL(ecs, "Test Failed, query lost entities while growing!\n");
+  }
+
+  //growing must not move components that were already added
+  if(first_position != recs_entity_get_component(ecs, entities[0], COMPONENT_POSITION)) {
+    FREE_AND_FAIL(ecs, "Test Failed, growing moved an existing component!\n");
+  }
+
+  //iterators must find every entity
+  uint32_t count = 0;
+  recs_ent_iter iter = recs_ent_iter_init(ecs, mask);
+  while(recs_ent_iter_has_next(&iter)) {
+    recs_ent_iter_next(ecs, &iter);
+    count++;
+  }
+  if(count != (NUM_ENTITIES + 2) / 3) {
+    FREE_AND_FAIL(ecs, "Test Failed, iterator did not find every entity after growing!\n");
+  }
+
+  //removed IDs are reused before growing again
+  for(uint32_t i = 0; i < NUM_ENTITIES; i += 2) {
+    recs_entity_remove(ecs, entities[i]);
+  }
+  for(uint32_t i = 0; i < NUM_ENTITIES; i += 2) {
+    entities[i] = recs_entity_add(ecs);
+    struct position_component p = {.x = (float)i, .y = 0};
+    recs_entity_add_component(ecs, entities[i], COMPONENT_POSITION, &p);
+    if(i % 3 == 0) {
+      struct velocity_component v = {.dx = 0, .dy = (float)i};
+      recs_entity_add_component(ecs, entities[i], COMPONENT_VELOCITY, &v);
+      recs_entity_add_tag(ecs, entities[i], TAG_MOVING);
+    }
+  }
+
+  //bulk adding grows the RECS instance too
+  static struct position_component positions[NUM_ENTITIES];
+  static struct velocity_component velocities[NUM_ENTITIES];
+  for(uint32_t i = 0; i < NUM_ENTITIES; i++) {
+    positions[i] = (struct position_component){.x = (float)(NUM_ENTITIES + i), .y = 0};
+    velocities[i] = (struct velocity_component){.dx = 0, .dy = (float)(NUM_ENTITIES + i)};
+  }
+  const void *arrays[2] = {positions, velocities};
+  recs_entity_add_bulk(ecs, NUM_ENTITIES, entities + NUM_ENTITIES, mask, arrays);
+
+  if(recs_num_active_entities(ecs) != NUM_ENTITIES * 2 || !check_entities(ecs, 0, NUM_ENTITIES)) {
+    FREE_AND_FAIL(ecs, "Test Failed, entities lost their components after reusing IDs!\n");
+  }
+  for(uint32_t i = NUM_ENTITIES; i < NUM_ENTITIES * 2; i++) {
+    struct velocity_component *v = recs_entity_get_component(ecs, entities[i], COMPONENT_VELOCITY);
+    if(v == NULL || v->dy != (float)i) {
+      FREE_AND_FAIL(ecs, "Test Failed, bulk entities have the wrong components after growing!\n");
+    }
+  }
+
+  //copies own their pages, so changing a copy must not change the original
+  recs copy = recs_copy(ecs);
+  if(copy == NULL) {
+    FREE_AND_FAIL(ecs, "Failed to copy!\n");
+  }
+  struct position_component *p = recs_entity_get_component(copy, entities[1], COMPONENT_POSITION);
+  p->x = -1;
+  recs_entity_remove(copy, entities[3]);
+  recs_entity_add(copy);
+
+  if(!check_entities(ecs, 0, NUM_ENTITIES) || recs_query_num_entities(ecs, moving) != recs_query_num_entities(copy, moving) + 1) {
+    recs_free(copy);
+    FREE_AND_FAIL(ecs, "Test Failed, changing a copy changed the original!\n");
+  }
+
+  recs_free(copy);
+  recs_free(ecs);
+  return 0;
+}
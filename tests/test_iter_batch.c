@@ -0,0 +1,133 @@
+#include <stdio.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 20
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+
+#define BATCH_SIZE 4
+
+#include "recs.h"
+
+struct position_component {
+  float x, y;
+};
+
+struct velocity_component {
+  float dx, dy;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_POSITION, COMPONENT_VELOCITY);
+RECS_INIT_TAG_IDS(tag, TAG_FROZEN);
+
+#define FREE_AND_FAIL(ecs, message) do {printf("%s", message); recs_free(ecs); return 1;} while(0) 
+
+
+int main(void) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {
+      .type = COMPONENT_POSITION,
+      .max_components = RECS_MAX_ENTITIES,
+      .comp_size = sizeof(struct position_component)
+    },
+    {
+      .type = COMPONENT_VELOCITY,
+      .max_components = RECS_MAX_ENTITIES,
+      .comp_size = sizeof(struct velocity_component)
+    }
+  };
+
+  struct recs_init_config config = {
+    .max_entities = RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .context = NULL,
+    .components = comps,
+    .systems = NULL
+  };
+
+  recs ecs = recs_init(config);
+  if(ecs == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+
+  //every entity gets a position, every 2nd entity gets a velocity, and every 3rd entity is frozen.
+  for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i++) {
+    recs_entity e = recs_entity_add(ecs);
+    struct position_component p = {.x = (float)i, .y = 0};
+    recs_entity_add_component(ecs, e, COMPONENT_POSITION, &p);
+
+    if(i % 2 == 0) {
+      struct velocity_component v = {.dx = 1, .dy = (float)i};
+      recs_entity_add_component(ecs, e, COMPONENT_VELOCITY, &v);
+    }
+    if(i % 3 == 0) {
+      recs_entity_add_tag(ecs, e, TAG_FROZEN);
+    }
+  }
+
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(2, COMPONENT_POSITION, COMPONENT_VELOCITY), 0, NULL);
+
+  uint8_t exclude_mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, exclude_mask, 0, NULL, RECS_BITMASK_CREATE_TAG_ARG(1, TAG_FROZEN));
+
+  //collect the expected entities one at a time
+  recs_entity expected[RECS_MAX_ENTITIES];
+  uint32_t num_expected = 0;
+  recs_ent_iter iter = recs_ent_iter_init_with_exclude(ecs, mask, exclude_mask);
+  while(recs_ent_iter_has_next(&iter)) {
+    expected[num_expected++] = recs_ent_iter_next(ecs, &iter);
+  }
+
+  //entities 2, 4, 8, 10, 14, 16 have both components and are not frozen
+  if(num_expected != 6) {
+    FREE_AND_FAIL(ecs, "Test Failed, iterator did not find the correct number of entities!\n");
+  }
+
+  //the batch iterator must find the same entities in the same order
+  recs_component batch_comps[2] = {COMPONENT_POSITION, COMPONENT_VELOCITY};
+  recs_entity batch[BATCH_SIZE];
+  void *batch_comp_ptrs[2 * BATCH_SIZE];
+  uint32_t num_found = 0;
+  uint32_t num_batches = 0;
+
+  iter = recs_ent_iter_init_with_exclude(ecs, mask, exclude_mask);
+
+  uint32_t count;
+  while((count = recs_ent_iter_next_batch(ecs, &iter, batch, BATCH_SIZE, batch_comps, 2, batch_comp_ptrs)) > 0) {
+    struct position_component **positions = (struct position_component **)batch_comp_ptrs;
+    struct velocity_component **velocities = (struct velocity_component **)(batch_comp_ptrs + BATCH_SIZE);
+
+    for(uint32_t i = 0; i < count; i++) {
+      recs_entity e = batch[i];
+      if(num_found >= num_expected || e != expected[num_found]) {
+        FREE_AND_FAIL(ecs, "Test Failed, batch iterator returned the wrong entity!\n");
+      }
+      if(positions[i] != recs_entity_get_component(ecs, e, COMPONENT_POSITION) || velocities[i] != recs_entity_get_component(ecs, e, COMPONENT_VELOCITY)) {
+        FREE_AND_FAIL(ecs, "Test Failed, batch iterator returned the wrong component pointer!\n");
+      }
+      if(velocities[i]->dy != positions[i]->x) {
+        FREE_AND_FAIL(ecs, "Test Failed, component pointers do not belong to the same entity!\n");
+      }
+      num_found++;
+    }
+    num_batches++;
+  }
+
+  if(num_found != num_expected) {
+    FREE_AND_FAIL(ecs, "Test Failed, batch iterator did not find every entity!\n");
+  }
+
+  //6 entities with a batch size of 4 should be split into 2 batches
+  if(num_batches != 2) {
+    FREE_AND_FAIL(ecs, "Test Failed, batch iterator did not fill each batch!\n");
+  }
+
+  recs_free(ecs);
+  return 0;
+}
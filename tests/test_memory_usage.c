@@ -0,0 +1,110 @@
+#include <stdio.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 4096
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+#define RECS_MAX_QUERIES 1
+
+//only a handful of entities ever have the rare component, and each of them is far away from the others
+#define NUM_RARE 8
+#define RARE_SPACING (RECS_MAX_ENTITIES / NUM_RARE)
+
+#include "recs.h"
+
+RECS_INIT_COMP_IDS(component, COMPONENT_COMMON, COMPONENT_RARE);
+RECS_INIT_TAG_IDS(tag, TAG_UNUSED);
+
+#define FREE_AND_FAIL(ecs, message) do {printf("%s", message); recs_free(ecs); return 1;} while(0)
+
+static recs_entity entities[RECS_MAX_ENTITIES];
+
+int main(void) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {.type = COMPONENT_COMMON, .max_components = RECS_MAX_ENTITIES, .comp_size = sizeof(uint32_t)},
+    {.type = COMPONENT_RARE, .max_components = NUM_RARE, .comp_size = sizeof(uint32_t)}
+  };
+
+  struct recs_init_config config = {
+    .max_entities = RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = RECS_MAX_QUERIES,
+    .context = NULL,
+    .components = comps,
+    .systems = NULL
+  };
+
+  recs ecs = recs_init(config);
+  if(ecs == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+
+  //one uint32_t per entity for each component type is what the maps would need without pages
+  size_t dense_bytes = sizeof(uint32_t) * RECS_MAX_ENTITIES * RECS_MAX_COMPONENTS;
+  struct recs_memory_usage empty;
+  recs_memory_usage(ecs, &empty);
+  if(empty.entity_to_comp_bytes >= dense_bytes || empty.entity_to_comp_used_bytes > empty.entity_to_comp_bytes || empty.total_bytes < empty.entity_to_comp_bytes) {
+    FREE_AND_FAIL(ecs, "Test Failed, the entity->component maps are not smaller than a dense array per component type!\n");
+  }
+
+  for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i++) {
+    entities[i] = recs_entity_add(ecs);
+    recs_entity_add_component(ecs, entities[i], COMPONENT_COMMON, &i);
+  }
+
+  struct recs_memory_usage common;
+  recs_memory_usage(ecs, &common);
+
+  for(uint32_t i = 0; i < NUM_RARE; i++) {
+    uint32_t value = i;
+    recs_entity_add_component(ecs, entities[i * RARE_SPACING], COMPONENT_RARE, &value);
+  }
+
+  struct recs_memory_usage rare;
+  recs_memory_usage(ecs, &rare);
+  if(rare.entity_to_comp_used_bytes <= common.entity_to_comp_used_bytes) {
+    FREE_AND_FAIL(ecs, "Test Failed, adding rare components did not use any pages!\n");
+  }
+
+  //removing a rare component moves the last one into its place, which lives inside another page
+  for(uint32_t i = 0; i < NUM_RARE; i += 2) {
+    recs_entity_remove_component(ecs, entities[i * RARE_SPACING], COMPONENT_RARE);
+  }
+  for(uint32_t i = 0; i < NUM_RARE; i++) {
+    uint32_t *value = recs_entity_get_component(ecs, entities[i * RARE_SPACING], COMPONENT_RARE);
+    if((i % 2 == 0) != (value == NULL) || (value != NULL && *value != i)) {
+      FREE_AND_FAIL(ecs, "Test Failed, removing a rare component changed another entity's component!\n");
+    }
+  }
+
+  //pages that no longer hold any entities are released, and reused by other pages of entities
+  for(uint32_t i = 1; i < NUM_RARE; i += 2) {
+    recs_entity_remove_component(ecs, entities[i * RARE_SPACING], COMPONENT_RARE);
+  }
+  struct recs_memory_usage removed;
+  recs_memory_usage(ecs, &removed);
+  if(removed.entity_to_comp_used_bytes != common.entity_to_comp_used_bytes) {
+    FREE_AND_FAIL(ecs, "Test Failed, empty pages were not released!\n");
+  }
+
+  for(uint32_t i = 0; i < NUM_RARE; i++) {
+    uint32_t value = i + 100;
+    recs_entity_add_component(ecs, entities[i * RARE_SPACING + 1], COMPONENT_RARE, &value);
+  }
+  for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i++) {
+    uint32_t *value = recs_entity_get_component(ecs, entities[i], COMPONENT_RARE);
+    uint32_t *common_value = recs_entity_get_component(ecs, entities[i], COMPONENT_COMMON);
+    uint8_t has_rare = i % RARE_SPACING == 1;
+    if(has_rare != (value != NULL) || (value != NULL && *value != i / RARE_SPACING + 100) || common_value == NULL || *common_value != i) {
+      FREE_AND_FAIL(ecs, "Test Failed, entities have the wrong components after reusing pages!\n");
+    }
+  }
+
+  recs_free(ecs);
+  return 0;
+}
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdatomic.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 10000
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+#define RECS_MAX_QUERIES 1
+
+#define NUM_THREADS 4
+
+#include "recs.h"
+
+struct position_component {
+  float x, y;
+};
+
+struct velocity_component {
+  float dx, dy;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_POSITION, COMPONENT_VELOCITY);
+
+//shared by every call to the callback
+struct visit_state {
+  atomic_uint visits[RECS_MAX_ENTITIES];
+
+  //per-thread scratch, indexed by the thread index passed to the callback
+  uint32_t visits_per_thread[NUM_THREADS];
+};
+
+static void visit(struct recs *ecs, recs_entity e, void *userdata, uint32_t thread_index) {
+  struct visit_state *state = userdata;
+  atomic_fetch_add(&state->visits[RECS_ENT_ID(e)], 1);
+  state->visits_per_thread[thread_index]++;
+
+  struct position_component *p = recs_entity_get_component(ecs, e, COMPONENT_POSITION);
+  struct velocity_component *v = recs_entity_get_component(ecs, e, COMPONENT_VELOCITY);
+  p->x += v->dx;
+}
+
+#define FREE_AND_FAIL(ecs, workers, message) do {printf("%s", message); recs_free(ecs); recs_workers_free(workers); return 1;} while(0)
+
+
+int main(void) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {
+      .type = COMPONENT_POSITION,
+      .max_components = RECS_MAX_ENTITIES,
+      .comp_size = sizeof(struct position_component)
+    },
+    {
+      .type = COMPONENT_VELOCITY,
+      .max_components = RECS_MAX_ENTITIES,
+      .comp_size = sizeof(struct velocity_component)
+    }
+  };
+
+  struct recs_init_config config = {
+    .max_entities = RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = RECS_MAX_QUERIES,
+    .context = NULL,
+    .components = comps,
+    .systems = NULL
+  };
+
+  recs ecs = recs_init(config);
+  recs_workers workers = recs_workers_create(NUM_THREADS);
+  if(ecs == NULL || workers == NULL) {
+    FREE_AND_FAIL(ecs, workers, "Failed to initialize!\n");
+  }
+
+  //every entity has a position, and every 3rd entity has a velocity
+  uint32_t num_moving = 0;
+  for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i++) {
+    recs_entity e = recs_entity_add(ecs);
+    struct position_component p = {.x = 0, .y = 0};
+    recs_entity_add_component(ecs, e, COMPONENT_POSITION, &p);
+
+    if(i % 3 == 0) {
+      struct velocity_component v = {.dx = 1, .dy = 0};
+      recs_entity_add_component(ecs, e, COMPONENT_VELOCITY, &v);
+      num_moving++;
+    }
+  }
+
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(2, COMPONENT_POSITION, COMPONENT_VELOCITY), 0, NULL);
+  recs_query moving = recs_query_register(ecs, mask, RECS_ENT_MATCH_ALL, NULL, RECS_ENT_MATCH_ANY);
+
+  static struct visit_state state;
+
+  //a grain of 1 forces a lot of stealing, while 0 picks the default grain
+  const uint32_t grains[3] = {1, 0, RECS_MAX_ENTITIES};
+  for(uint32_t g = 0; g < 3; g++) {
+    for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i++) {
+      atomic_store(&state.visits[i], 0);
+    }
+    for(uint32_t t = 0; t < NUM_THREADS; t++) {
+      state.visits_per_thread[t] = 0;
+    }
+
+    recs_query_par_each(ecs, workers, moving, visit, &state, grains[g]);
+
+    //the join barrier makes sure every visit is done by the time we get here
+    uint32_t total = 0;
+    for(uint32_t t = 0; t < NUM_THREADS; t++) {
+      total += state.visits_per_thread[t];
+    }
+    if(total != num_moving) {
+      FREE_AND_FAIL(ecs, workers, "Test Failed, wrong number of entities visited!\n");
+    }
+
+    for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i++) {
+      if(atomic_load(&state.visits[i]) != (i % 3 == 0 ? 1u : 0u)) {
+        FREE_AND_FAIL(ecs, workers, "Test Failed, an entity was not visited exactly once!\n");
+      }
+    }
+  }
+
+  //running without a worker pool visits everything on the calling thread
+  recs_query_par_each(ecs, NULL, moving, visit, &state, 0);
+
+  for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i += 3) {
+    struct position_component *p = recs_entity_get_component(ecs, RECS_ENT_FROM(i, 0), COMPONENT_POSITION);
+    if(p->x != 4) {
+      FREE_AND_FAIL(ecs, workers, "Test Failed, components were not updated by every pass!\n");
+    }
+  }
+
+  recs_free(ecs);
+  recs_workers_free(workers);
+  return 0;
+}
@@ -0,0 +1,152 @@
+#include <stdio.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 10
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+#define RECS_MAX_QUERIES 2
+
+#include "recs.h"
+
+struct position_component {
+  float x, y;
+};
+
+struct velocity_component {
+  float dx, dy;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_POSITION, COMPONENT_VELOCITY);
+RECS_INIT_TAG_IDS(tag, TAG_FROZEN);
+
+#define FREE_AND_FAIL(ecs, message) do {printf("%s", message); recs_free(ecs); return 1;} while(0) 
+
+
+//check that a query contains exactly the listed entities, in any order.
+static int query_contains_only(recs ecs, recs_query q, uint32_t num_entities, recs_entity *entities) {
+  if(recs_query_num_entities(ecs, q) != num_entities) {
+    return 0;
+  }
+
+  recs_entity *list = recs_query_entities(ecs, q);
+  for(uint32_t i = 0; i < num_entities; i++) {
+    int found = 0;
+    for(uint32_t j = 0; j < num_entities; j++) {
+      found |= list[j] == entities[i];
+    }
+    if(!found) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+
+int main(void) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {
+      .type = COMPONENT_POSITION,
+      .max_components = RECS_MAX_ENTITIES,
+      .comp_size = sizeof(struct position_component)
+    },
+    {
+      .type = COMPONENT_VELOCITY,
+      .max_components = RECS_MAX_ENTITIES,
+      .comp_size = sizeof(struct velocity_component)
+    }
+  };
+
+  struct recs_init_config config = {
+    .max_entities = RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = RECS_MAX_QUERIES,
+    .context = NULL,
+    .components = comps,
+    .systems = NULL
+  };
+
+  recs ecs = recs_init(config);
+  if(ecs == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+
+  struct position_component p = {0};
+  struct velocity_component v = {0};
+
+  //this entity exists before the queries are registered
+  recs_entity a = recs_entity_add(ecs);
+  recs_entity_add_component(ecs, a, COMPONENT_POSITION, &p);
+  recs_entity_add_component(ecs, a, COMPONENT_VELOCITY, &v);
+
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(2, COMPONENT_POSITION, COMPONENT_VELOCITY), 0, NULL);
+
+  uint8_t exclude_mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, exclude_mask, 0, NULL, RECS_BITMASK_CREATE_TAG_ARG(1, TAG_FROZEN));
+
+  recs_query moving = recs_query_register(ecs, mask, RECS_ENT_MATCH_ALL, exclude_mask, RECS_ENT_MATCH_ANY);
+  recs_query not_frozen = recs_query_register(ecs, NULL, RECS_ENT_MATCH_ALL, exclude_mask, RECS_ENT_MATCH_ANY);
+
+  if(!query_contains_only(ecs, moving, 1, (recs_entity[]){a})) {
+    FREE_AND_FAIL(ecs, "Test Failed, query did not find an entity that existed before it was registered!\n");
+  }
+
+  //entities without components still match queries that only exclude components
+  recs_entity b = recs_entity_add(ecs);
+  if(!query_contains_only(ecs, not_frozen, 2, (recs_entity[]){a, b})) {
+    FREE_AND_FAIL(ecs, "Test Failed, exclude-only query did not find a new entity!\n");
+  }
+
+  recs_entity_add_component(ecs, b, COMPONENT_POSITION, &p);
+  if(!query_contains_only(ecs, moving, 1, (recs_entity[]){a})) {
+    FREE_AND_FAIL(ecs, "Test Failed, query found an entity that is missing a component!\n");
+  }
+
+  recs_entity_add_component(ecs, b, COMPONENT_VELOCITY, &v);
+  if(!query_contains_only(ecs, moving, 2, (recs_entity[]){a, b})) {
+    FREE_AND_FAIL(ecs, "Test Failed, query did not find an entity after adding a component!\n");
+  }
+
+  //tags are excluded
+  recs_entity_add_tag(ecs, a, TAG_FROZEN);
+  if(!query_contains_only(ecs, moving, 1, (recs_entity[]){b}) || !query_contains_only(ecs, not_frozen, 1, (recs_entity[]){b})) {
+    FREE_AND_FAIL(ecs, "Test Failed, query found an entity with an excluded tag!\n");
+  }
+
+  recs_entity_remove_tag(ecs, a, TAG_FROZEN);
+  recs_entity_remove_component(ecs, b, COMPONENT_VELOCITY);
+  if(!query_contains_only(ecs, moving, 1, (recs_entity[]){a})) {
+    FREE_AND_FAIL(ecs, "Test Failed, query was not updated after removing a tag and a component!\n");
+  }
+
+  //queued entities leave every query right away
+  recs_entity_queue_remove(ecs, a);
+  if(!query_contains_only(ecs, moving, 0, NULL) || !query_contains_only(ecs, not_frozen, 1, (recs_entity[]){b})) {
+    FREE_AND_FAIL(ecs, "Test Failed, query still contains an entity queued for removal!\n");
+  }
+  recs_entity_remove_queued(ecs);
+
+  recs_entity_remove(ecs, b);
+  if(!query_contains_only(ecs, not_frozen, 0, NULL)) {
+    FREE_AND_FAIL(ecs, "Test Failed, query still contains a removed entity!\n");
+  }
+
+  //copies keep their own queries
+  recs_entity c = recs_entity_add(ecs);
+  recs ecs_copy = recs_copy(ecs);
+  recs_entity_remove(ecs, c);
+
+  if(ecs_copy == NULL || !query_contains_only(ecs_copy, not_frozen, 1, (recs_entity[]){c})) {
+    recs_free(ecs_copy);
+    FREE_AND_FAIL(ecs, "Test Failed, copied query does not contain the copied entity!\n");
+  }
+
+  recs_free(ecs_copy);
+  recs_free(ecs);
+  return 0;
+}
@@ -0,0 +1,175 @@
+#include <stdio.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 300
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+
+#define NUM_START 200
+
+#include "recs.h"
+
+//big enough that moving it on every removal costs something
+struct animation_component {
+  uint32_t owner;
+  float bones[255];
+};
+
+struct position_component {
+  float x, y;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_ANIMATION, COMPONENT_POSITION);
+RECS_INIT_TAG_IDS(tag, TAG_UNUSED);
+
+static recs_entity entities[NUM_START];
+static struct animation_component *pointers[NUM_START];
+
+static recs create(uint8_t growable) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {
+      .type = COMPONENT_ANIMATION,
+      .max_components = growable ? 8 : RECS_MAX_ENTITIES,
+      .comp_size = sizeof(struct animation_component),
+      .track_changes = 1,
+      .removal_policy = RECS_REMOVAL_STABLE
+    },
+    {.type = COMPONENT_POSITION, .max_components = growable ? 8 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct position_component)}
+  };
+
+  struct recs_init_config config = {
+    .max_entities = growable ? 8 : RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = 0,
+    .growable = growable,
+    .components = comps,
+    .systems = NULL
+  };
+
+  return recs_init(config);
+}
+
+//make sure every entity still owns its own animation, and that iterating over animations finds each of them once
+static int check_animations(recs ecs, uint8_t *mask, uint32_t expected) {
+  uint32_t count = 0;
+  recs_ent_iter iter = recs_ent_iter_init(ecs, mask);
+  while(recs_ent_iter_has_next(&iter)) {
+    recs_entity e = recs_ent_iter_next(ecs, &iter);
+    struct animation_component *a = recs_entity_get_component(ecs, e, COMPONENT_ANIMATION);
+    if(a == NULL || a->owner != RECS_ENT_ID(e) || a->bones[254] != (float)RECS_ENT_ID(e)) {
+      return 0;
+    }
+    count++;
+  }
+
+  //free slots hold no component
+  uint32_t used = 0;
+  for(uint32_t i = 0; i < recs_component_num_slots(ecs, COMPONENT_ANIMATION); i++) {
+    used += recs_component_get(ecs, COMPONENT_ANIMATION, i) != NULL;
+  }
+  return count == expected && used == expected && recs_component_num_instances(ecs, COMPONENT_ANIMATION) == expected;
+}
+
+static recs_entity add_animated(recs ecs) {
+  recs_entity e = recs_entity_add(ecs);
+  struct animation_component a = {.owner = RECS_ENT_ID(e)};
+  a.bones[254] = (float)RECS_ENT_ID(e);
+  recs_entity_add_component(ecs, e, COMPONENT_ANIMATION, &a);
+  return e;
+}
+
+//run the test with fixed-size and growable RECS instances
+static int run(uint8_t growable) {
+  recs ecs = create(growable);
+  if(ecs == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(1, COMPONENT_ANIMATION), 0, NULL);
+
+  for(uint32_t i = 0; i < NUM_START; i++) {
+    entities[i] = add_animated(ecs);
+  }
+  for(uint32_t i = 0; i < NUM_START; i++) {
+    pointers[i] = recs_entity_get_component(ecs, entities[i], COMPONENT_ANIMATION);
+  }
+
+  //removing every other animation (and whole runs of 64 slots) never moves the others
+  uint32_t tick = recs_next_change_tick(ecs);
+  uint32_t num_left = NUM_START;
+  for(uint32_t i = 0; i < NUM_START; i++) {
+    if(i % 2 == 0 || (i >= 64 && i < 192)) {
+      recs_entity_remove(ecs, entities[i]);
+      num_left--;
+    }
+  }
+  int stable_ok = check_animations(ecs, mask, num_left) && recs_component_num_slots(ecs, COMPONENT_ANIMATION) == NUM_START;
+  for(uint32_t i = 1; i < NUM_START && stable_ok; i += 2) {
+    if(i < 64 || i >= 192) {
+      stable_ok = recs_entity_get_component(ecs, entities[i], COMPONENT_ANIMATION) == pointers[i];
+    }
+  }
+
+  //new animations reuse the free slots, and change filters skip them
+  recs_entity added[10];
+  for(uint32_t i = 0; i < 10; i++) {
+    added[i] = add_animated(ecs);
+  }
+  num_left += 10;
+  uint32_t num_changed = 0;
+  recs_ent_iter iter = recs_ent_iter_init_changed(ecs, NULL, NULL, COMPONENT_ANIMATION, RECS_CHANGE_ADDED, tick);
+  while(recs_ent_iter_has_next(&iter)) {
+    recs_ent_iter_next(ecs, &iter);
+    num_changed++;
+  }
+  int reuse_ok = check_animations(ecs, mask, num_left) && recs_component_num_slots(ecs, COMPONENT_ANIMATION) == NUM_START && num_changed == 10;
+
+  //rolling back restores the free slots as well
+  int copy_ok = 1;
+  if(!growable) {
+    recs old = recs_copy(ecs);
+    recs_entity_remove(ecs, added[0]);
+    recs_entity_remove(ecs, entities[1]);
+    add_animated(ecs);
+    recs_copy_into(ecs, old);
+    copy_ok = check_animations(ecs, mask, num_left) && recs_entity_get_component(ecs, entities[1], COMPONENT_ANIMATION) == pointers[1];
+    recs_free(old);
+  }
+
+  //compacting packs every animation at the front of the pool
+  recs_component_pool_compact(ecs, COMPONENT_ANIMATION);
+  int compact_ok = check_animations(ecs, mask, num_left) && recs_component_num_slots(ecs, COMPONENT_ANIMATION) == num_left;
+  add_animated(ecs);
+  compact_ok = compact_ok && check_animations(ecs, mask, num_left + 1) && recs_component_num_slots(ecs, COMPONENT_ANIMATION) == num_left + 1;
+
+  recs_free(ecs);
+
+  if(!stable_ok) {
+    printf("Test Failed, removing components moved other components!\n");
+    return 1;
+  }
+  if(!reuse_ok) {
+    printf("Test Failed, free slots were not reused!\n");
+    return 1;
+  }
+  if(!copy_ok) {
+    printf("Test Failed, free slots were not rolled back!\n");
+    return 1;
+  }
+  if(!compact_ok) {
+    printf("Test Failed, compacting lost components!\n");
+    return 1;
+  }
+  return 0;
+}
+
+int main(void) {
+  if(run(0) != 0) return 1;
+  return run(1);
+}
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 1000
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+#define RECS_MAX_QUERIES 1
+
+#define NUM_START 300
+#define SAVE_PATH "test_save_load.bin"
+
+#include "recs.h"
+
+struct position_component {
+  float x, y;
+};
+
+struct velocity_component {
+  float dx, dy;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_POSITION, COMPONENT_VELOCITY);
+RECS_INIT_TAG_IDS(tag, TAG_MOVING);
+
+static recs_entity entities[NUM_START];
+
+//what loading a save is expected to bring back
+struct world_state {
+  uint32_t num_active;
+  uint32_t num_moving;
+  uint8_t active[NUM_START];
+  float x[NUM_START];
+};
+
+static void save_state(recs ecs, struct world_state *state) {
+  state->num_active = recs_num_active_entities(ecs);
+  state->num_moving = recs_query_num_entities(ecs, 0);
+  for(uint32_t i = 0; i < NUM_START; i++) {
+    state->active[i] = recs_entity_active(ecs, entities[i]);
+    state->x[i] = state->active[i] ? ((struct position_component*)recs_entity_get_component(ecs, entities[i], COMPONENT_POSITION))->x : 0;
+  }
+}
+
+static int same_state(recs ecs, const struct world_state *state) {
+  struct world_state now;
+  save_state(ecs, &now);
+  if(now.num_active != state->num_active || now.num_moving != state->num_moving) {
+    return 0;
+  }
+  for(uint32_t i = 0; i < NUM_START; i++) {
+    if(now.active[i] != state->active[i] || now.x[i] != state->x[i]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static recs_entity add_moving(recs ecs) {
+  recs_entity e = recs_entity_add(ecs);
+  struct position_component p = {.x = -1, .y = 0};
+  struct velocity_component v = {.dx = 1, .dy = 1};
+  recs_entity_add_component(ecs, e, COMPONENT_POSITION, &p);
+  recs_entity_add_component(ecs, e, COMPONENT_VELOCITY, &v);
+  recs_entity_add_tag(ecs, e, TAG_MOVING);
+  return e;
+}
+
+static recs create(enum recs_storage_type storage, uint32_t max_velocities) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {.type = COMPONENT_POSITION, .max_components = RECS_MAX_ENTITIES, .comp_size = sizeof(struct position_component)},
+    {.type = COMPONENT_VELOCITY, .max_components = max_velocities, .comp_size = sizeof(struct velocity_component)}
+  };
+
+  struct recs_init_config config = {
+    .max_entities = RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = RECS_MAX_QUERIES,
+    .context = NULL,
+    .storage = storage,
+    .components = comps,
+    .systems = NULL
+  };
+
+  return recs_init(config);
+}
+
+//run the test with both storage backends
+static int run(enum recs_storage_type storage) {
+  recs ecs = create(storage, RECS_MAX_ENTITIES);
+  recs loaded = create(storage, RECS_MAX_ENTITIES);
+  recs different = create(storage, RECS_MAX_ENTITIES / 2);
+  if(ecs == NULL || loaded == NULL || different == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+
+  //the query is part of the saved state, so it is only registered on the RECS instance being saved
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(2, COMPONENT_POSITION, COMPONENT_VELOCITY), RECS_BITMASK_CREATE_TAG_ARG(1, TAG_MOVING));
+  recs_query_register(ecs, mask, RECS_ENT_MATCH_ALL, NULL, RECS_ENT_MATCH_ANY);
+
+  for(uint32_t i = 0; i < NUM_START; i++) {
+    entities[i] = i % 3 == 0 ? add_moving(ecs) : recs_entity_add(ecs);
+    if(i % 3 != 0) {
+      struct position_component p = {.x = (float)i, .y = 0};
+      recs_entity_add_component(ecs, entities[i], COMPONENT_POSITION, &p);
+    }
+  }
+  for(uint32_t i = 1; i < NUM_START; i += 5) {
+    recs_entity_remove(ecs, entities[i]);
+  }
+
+  struct world_state state;
+  save_state(ecs, &state);
+
+  size_t size = recs_save_size(ecs);
+  uint8_t *buffer = malloc(size);
+  int saved = buffer != NULL && recs_save(ecs, buffer, size) == size && recs_save(ecs, buffer, size - 1) == 0 && recs_save_file(ecs, SAVE_PATH);
+
+  //load into a RECS instance that never had any entities
+  int loaded_ok = saved && recs_load(loaded, buffer, size) && same_state(loaded, &state);
+
+  //load from a file into a RECS instance that used more entity IDs than the saved one,
+  //which ends up exactly like the saved one, down to the entities handed out next
+  for(uint32_t i = 0; i < 500; i++) {
+    add_moving(ecs);
+  }
+  recs copy = recs_copy(loaded);
+  int file_ok = saved && recs_load_file(ecs, SAVE_PATH) && same_state(ecs, &state) && copy != NULL;
+  for(uint32_t i = 0; i < 200 && file_ok; i++) {
+    file_ok = add_moving(ecs) == add_moving(copy);
+  }
+  file_ok = file_ok && recs_query_num_entities(ecs, 0) == state.num_moving + 200;
+
+  //saves made with a different config are rejected without touching the RECS instance
+  buffer[0] = 'X';
+  int rejected = !recs_load(loaded, buffer, size) && !recs_load(loaded, buffer, sizeof(uint32_t));
+  buffer[0] = 'R';
+  rejected = rejected && !recs_load(different, buffer, size) && recs_num_active_entities(different) == 0;
+
+  remove(SAVE_PATH);
+  free(buffer);
+  recs_free(copy);
+  recs_free(different);
+  recs_free(loaded);
+  recs_free(ecs);
+
+  if(!saved) {
+    printf("Test Failed, could not save!\n");
+    return 1;
+  }
+  if(!loaded_ok || !file_ok) {
+    printf("Test Failed, loading a save did not bring back the state it was saved at!\n");
+    return 1;
+  }
+  if(!rejected) {
+    printf("Test Failed, an invalid save was loaded!\n");
+    return 1;
+  }
+  return 0;
+}
+
+int main(void) {
+  if(run(RECS_STORAGE_SPARSE_SET) != 0) return 1;
+  return run(RECS_STORAGE_ARCHETYPE);
+}
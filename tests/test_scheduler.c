@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 10
+#define RECS_MAX_SYSTEMS 7
+#define RECS_MAX_SYS_GROUPS 2
+
+#define NUM_THREADS 4
+#define NUM_RUNS 50
+
+#include "recs.h"
+
+RECS_INIT_COMP_IDS(component, COMPONENT_POSITION, COMPONENT_VELOCITY);
+RECS_INIT_TAG_IDS(tag, TAG_FROZEN);
+RECS_INIT_SYS_GRP_IDS(system_group, SYSTEM_GROUP_UPDATE, SYSTEM_GROUP_RENDER);
+
+//when each system started and finished during the last run
+struct run_log {
+  atomic_uint clock;
+  atomic_uint arrived;
+  atomic_int timed_out;
+  unsigned started[RECS_MAX_SYSTEMS];
+  unsigned finished[RECS_MAX_SYSTEMS];
+};
+
+static void log_system(struct recs *ecs, int id, int rendezvous) {
+  struct run_log *log = recs_system_get_context(ecs);
+  log->started[id] = atomic_fetch_add(&log->clock, 1);
+
+  //systems 0 and 1 do not conflict, so they must be able to wait for each other
+  if(rendezvous) {
+    atomic_fetch_add(&log->arrived, 1);
+    time_t start = time(NULL);
+    while(atomic_load(&log->arrived) < 2) {
+      if(time(NULL) - start > 5) {
+        atomic_store(&log->timed_out, 1);
+        break;
+      }
+    }
+  }
+
+  log->finished[id] = atomic_fetch_add(&log->clock, 1);
+}
+
+static void system_write_position(struct recs *ecs) { log_system(ecs, 0, 1); }
+static void system_write_velocity(struct recs *ecs) { log_system(ecs, 1, 1); }
+static void system_read_both(struct recs *ecs) { log_system(ecs, 2, 0); }
+static void system_undeclared(struct recs *ecs) { log_system(ecs, 3, 0); }
+static void system_read_position(struct recs *ecs) { log_system(ecs, 4, 0); }
+static void system_write_frozen(struct recs *ecs) { log_system(ecs, 5, 0); }
+static void system_render(struct recs *ecs) { log_system(ecs, 6, 0); }
+
+#define FREE_AND_FAIL(ecs, workers, message) do {printf("%s", message); recs_free(ecs); recs_workers_free(workers); return 1;} while(0)
+
+
+int main(void) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {.type = COMPONENT_POSITION, .max_components = RECS_MAX_ENTITIES, .comp_size = sizeof(float)},
+    {.type = COMPONENT_VELOCITY, .max_components = RECS_MAX_ENTITIES, .comp_size = sizeof(float)}
+  };
+
+  const recs_component position[1] = {COMPONENT_POSITION};
+  const recs_component velocity[1] = {COMPONENT_VELOCITY};
+  const recs_component both[2] = {COMPONENT_POSITION, COMPONENT_VELOCITY};
+  const recs_tag frozen[1] = {TAG_FROZEN};
+
+  //registered out of order on purpose, so that the render system sits between update systems in the config
+  struct recs_init_config_system systems[RECS_MAX_SYSTEMS] = {
+    {.func = system_write_position, .group = SYSTEM_GROUP_UPDATE, .write_comps = position, .num_write_comps = 1},
+    {.func = system_write_velocity, .group = SYSTEM_GROUP_UPDATE, .write_comps = velocity, .num_write_comps = 1},
+    {.func = system_render, .group = SYSTEM_GROUP_RENDER, .read_comps = position, .num_read_comps = 1},
+    {.func = system_read_both, .group = SYSTEM_GROUP_UPDATE, .read_comps = both, .num_read_comps = 2},
+    {.func = system_undeclared, .group = SYSTEM_GROUP_UPDATE},
+    {.func = system_read_position, .group = SYSTEM_GROUP_UPDATE, .read_comps = position, .num_read_comps = 1},
+    {.func = system_write_frozen, .group = SYSTEM_GROUP_UPDATE, .read_comps = position, .num_read_comps = 1, .write_tags = frozen, .num_write_tags = 1}
+  };
+
+  struct run_log log;
+
+  struct recs_init_config config = {
+    .max_entities = RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .context = &log,
+    .components = comps,
+    .systems = systems
+  };
+
+  recs ecs = recs_init(config);
+  recs_workers workers = recs_workers_create(NUM_THREADS);
+  if(ecs == NULL || workers == NULL) {
+    FREE_AND_FAIL(ecs, workers, "Failed to initialize!\n");
+  }
+
+  //pairs of systems that must run one after the other, in this order
+  const int ordered[][2] = {
+    {0, 2}, {1, 2},
+    {0, 3}, {1, 3}, {2, 3},
+    {3, 4}, {3, 5},
+    {0, 4}, {0, 5}
+  };
+  const int num_ordered = sizeof(ordered) / sizeof(ordered[0]);
+
+  for(int run = 0; run < NUM_RUNS; run++) {
+    atomic_store(&log.clock, 0);
+    atomic_store(&log.arrived, 0);
+    atomic_store(&log.timed_out, 0);
+
+    recs_system_run_parallel(ecs, workers, SYSTEM_GROUP_UPDATE);
+
+    if(atomic_load(&log.clock) != 12) {
+      FREE_AND_FAIL(ecs, workers, "Test Failed, every system in the group must run exactly once!\n");
+    }
+    if(atomic_load(&log.timed_out)) {
+      FREE_AND_FAIL(ecs, workers, "Test Failed, systems that do not conflict did not run at the same time!\n");
+    }
+    for(int i = 0; i < num_ordered; i++) {
+      if(log.finished[ordered[i][0]] > log.started[ordered[i][1]]) {
+        FREE_AND_FAIL(ecs, workers, "Test Failed, conflicting systems ran out of order!\n");
+      }
+    }
+  }
+
+  //copies must keep the dependency graph
+  recs copy = recs_copy(ecs);
+  recs_free(ecs);
+  ecs = copy;
+
+  atomic_store(&log.clock, 0);
+  atomic_store(&log.arrived, 0);
+  recs_system_run_parallel(ecs, workers, SYSTEM_GROUP_UPDATE);
+  if(atomic_load(&log.clock) != 12 || log.finished[3] > log.started[4]) {
+    FREE_AND_FAIL(ecs, workers, "Test Failed, copied RECS instance did not run its systems correctly!\n");
+  }
+
+  //a group with a single system
+  atomic_store(&log.clock, 0);
+  recs_system_run_parallel(ecs, workers, SYSTEM_GROUP_RENDER);
+  if(atomic_load(&log.clock) != 2) {
+    FREE_AND_FAIL(ecs, workers, "Test Failed, render group did not run!\n");
+  }
+
+  recs_free(ecs);
+  recs_workers_free(workers);
+  return 0;
+}
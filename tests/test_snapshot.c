@@ -0,0 +1,170 @@
+#include <stdio.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 1000
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+#define RECS_MAX_QUERIES 1
+
+#define NUM_START 500
+
+#include "recs.h"
+
+struct position_component {
+  float x, y;
+};
+
+struct velocity_component {
+  float dx, dy;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_POSITION, COMPONENT_VELOCITY);
+RECS_INIT_TAG_IDS(tag, TAG_MOVING);
+
+#define FREE_AND_FAIL(ecs, message) do {printf("%s", message); recs_free(ecs); return 1;} while(0)
+
+static recs_entity entities[RECS_MAX_ENTITIES];
+
+//what a snapshot is expected to bring back
+struct world_state {
+  uint32_t num_active;
+  uint32_t num_moving;
+  uint8_t active[NUM_START];
+  float x[NUM_START];
+};
+
+static void save_state(recs ecs, recs_query moving, struct world_state *state) {
+  state->num_active = recs_num_active_entities(ecs);
+  state->num_moving = recs_query_num_entities(ecs, moving);
+  for(uint32_t i = 0; i < NUM_START; i++) {
+    state->active[i] = recs_entity_active(ecs, entities[i]);
+    state->x[i] = state->active[i] ? ((struct position_component*)recs_entity_get_component(ecs, entities[i], COMPONENT_POSITION))->x : 0;
+  }
+}
+
+static int same_state(recs ecs, recs_query moving, const struct world_state *state) {
+  struct world_state now;
+  save_state(ecs, moving, &now);
+  if(now.num_active != state->num_active || now.num_moving != state->num_moving) {
+    return 0;
+  }
+  for(uint32_t i = 0; i < NUM_START; i++) {
+    if(now.active[i] != state->active[i] || now.x[i] != state->x[i]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+//change a few entities, remove a few others, and add a few new ones
+static void simulate(recs ecs, uint32_t step) {
+  for(uint32_t i = step; i < NUM_START; i += 50) {
+    struct position_component *p = recs_entity_get_component_mut(ecs, entities[i], COMPONENT_POSITION);
+    if(p != NULL) {
+      p->x += 1000;
+    }
+  }
+
+  recs_entity_remove(ecs, entities[step + 1]);
+  for(uint32_t i = 0; i < 3; i++) {
+    recs_entity e = recs_entity_add(ecs);
+    struct position_component p = {.x = -2, .y = 0};
+    struct velocity_component v = {.dx = 1, .dy = 1};
+    recs_entity_add_component(ecs, e, COMPONENT_POSITION, &p);
+    recs_entity_add_component(ecs, e, COMPONENT_VELOCITY, &v);
+    recs_entity_add_tag(ecs, e, TAG_MOVING);
+  }
+}
+
+//run the test with both storage backends
+static int run(enum recs_storage_type storage) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {.type = COMPONENT_POSITION, .max_components = RECS_MAX_ENTITIES, .comp_size = sizeof(struct position_component)},
+    {.type = COMPONENT_VELOCITY, .max_components = RECS_MAX_ENTITIES, .comp_size = sizeof(struct velocity_component)}
+  };
+
+  struct recs_init_config config = {
+    .max_entities = RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = RECS_MAX_QUERIES,
+    .context = NULL,
+    .storage = storage,
+    .snapshot_chunk_size = 256,
+    .components = comps,
+    .systems = NULL
+  };
+
+  recs ecs = recs_init(config);
+  if(ecs == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(2, COMPONENT_POSITION, COMPONENT_VELOCITY), RECS_BITMASK_CREATE_TAG_ARG(1, TAG_MOVING));
+  recs_query moving = recs_query_register(ecs, mask, RECS_ENT_MATCH_ALL, NULL, RECS_ENT_MATCH_ANY);
+
+  for(uint32_t i = 0; i < NUM_START; i++) {
+    entities[i] = recs_entity_add(ecs);
+    struct position_component p = {.x = (float)i, .y = 0};
+    recs_entity_add_component(ecs, entities[i], COMPONENT_POSITION, &p);
+  }
+
+  recs_snapshot first = recs_snapshot_create(ecs);
+  recs_snapshot second = recs_snapshot_create(ecs);
+  if(first == NULL || second == NULL) {
+    FREE_AND_FAIL(ecs, "Failed to create snapshots!\n");
+  }
+  size_t full_size = recs_snapshot_copy_size(first);
+
+  struct world_state first_state, second_state;
+  save_state(ecs, moving, &first_state);
+
+  simulate(ecs, 0);
+  recs_snapshot_take(ecs, second);
+  save_state(ecs, moving, &second_state);
+
+  //only the chunks that changed are copied (archetype storage always copies everything)
+  if(storage == RECS_STORAGE_SPARSE_SET && recs_snapshot_copy_size(second) >= full_size / 2) {
+    recs_snapshot_free(first);
+    recs_snapshot_free(second);
+    FREE_AND_FAIL(ecs, "Test Failed, taking a snapshot copied chunks that did not change!\n");
+  }
+
+  simulate(ecs, 10);
+  simulate(ecs, 20);
+
+  //restore in any order, any number of times
+  recs_snapshot_restore(ecs, first);
+  int first_ok = same_state(ecs, moving, &first_state);
+  recs_snapshot_restore(ecs, second);
+  int second_ok = same_state(ecs, moving, &second_state);
+  simulate(ecs, 30);
+  recs_snapshot_restore(ecs, first);
+  int first_again_ok = same_state(ecs, moving, &first_state);
+
+  recs_snapshot_free(first);
+  recs_snapshot_free(second);
+
+  if(!first_ok || !second_ok || !first_again_ok) {
+    FREE_AND_FAIL(ecs, "Test Failed, restoring a snapshot did not bring back the state it was taken at!\n");
+  }
+
+  //the restored RECS instance keeps working
+  simulate(ecs, 40);
+  if(recs_query_num_entities(ecs, moving) != first_state.num_moving + 3) {
+    FREE_AND_FAIL(ecs, "Test Failed, the query is wrong after restoring a snapshot!\n");
+  }
+
+  recs_free(ecs);
+  return 0;
+}
+
+int main(void) {
+  if(run(RECS_STORAGE_SPARSE_SET) != 0) return 1;
+  return run(RECS_STORAGE_ARCHETYPE);
+}
@@ -0,0 +1,169 @@
+#include <stdio.h>
+
+#define RECS_MAX_COMPONENTS 3
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 1000
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+
+//keys are picked among a few values, so that many components share a key
+#define NUM_KEYS 50
+#define NUM_MOVED 20
+
+#include "recs.h"
+
+struct keyed_component {
+  uint32_t id;
+  uint32_t key;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_TRANSFORM, COMPONENT_HEALTH, COMPONENT_MESH);
+
+static recs_entity entities[RECS_MAX_ENTITIES];
+
+static uint32_t rng_state = 4242;
+static uint32_t rng(void) {
+  rng_state = rng_state * 1664525u + 1013904223u;
+  return rng_state >> 8;
+}
+
+static uint64_t component_key(const void *component, recs_entity e, void *userdata) {
+  (void)userdata;
+  const struct keyed_component *k = (const struct keyed_component*)component;
+  return RECS_ENT_ID(e) == k->id ? k->key : UINT64_MAX;
+}
+
+static recs create(uint8_t growable) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {.type = COMPONENT_TRANSFORM, .max_components = growable ? 8 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct keyed_component), .track_changes = 1},
+    {.type = COMPONENT_HEALTH, .max_components = growable ? 8 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct keyed_component), .removal_policy = RECS_REMOVAL_STABLE},
+    {.type = COMPONENT_MESH, .max_components = growable ? 8 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct keyed_component)}
+  };
+
+  struct recs_init_config config = {
+    .max_entities = growable ? 8 : RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = 0,
+    .max_groups = 1,
+    .growable = growable,
+    .component_page_size = 128,
+    .components = comps,
+    .systems = NULL
+  };
+
+  return recs_init(config);
+}
+
+//make sure the components in slots [first, end) are sorted by key, and still belong to their entities.
+//If check_ties is set, components with equal keys must also be in order of their entity IDs.
+static int check_sorted(recs ecs, recs_component c, uint32_t first, uint32_t end, uint8_t check_ties) {
+  for(uint32_t i = first; i < end; i++) {
+    struct keyed_component *k = recs_component_get(ecs, c, i);
+    recs_entity e = recs_component_get_entity(ecs, c, i);
+    if(k == NULL || k->id != RECS_ENT_ID(e) || recs_entity_get_component(ecs, e, c) != k) {
+      return 0;
+    }
+    if(i == first) continue;
+
+    struct keyed_component *prev = recs_component_get(ecs, c, i - 1);
+    if(prev->key > k->key || (check_ties && prev->key == k->key && prev->id > k->id)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void move_some(recs ecs, recs_component c) {
+  for(uint32_t i = 0; i < NUM_MOVED; i++) {
+    struct keyed_component *k = recs_component_get(ecs, c, rng() % recs_component_num_slots(ecs, c));
+    if(k != NULL) {
+      k->key = rng() % NUM_KEYS;
+    }
+  }
+}
+
+//run the test with fixed-size and growable RECS instances
+static int run(uint8_t growable) {
+  recs ecs = create(growable);
+  if(ecs == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+
+  //every entity has a transform, half have health, and half have a mesh
+  for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i++) {
+    entities[i] = recs_entity_add(ecs);
+    struct keyed_component k = {RECS_ENT_ID(entities[i]), rng() % NUM_KEYS};
+    recs_entity_add_component(ecs, entities[i], COMPONENT_TRANSFORM, &k);
+    if(rng() % 2 == 0) recs_entity_add_component(ecs, entities[i], COMPONENT_HEALTH, &k);
+    if(rng() % 2 == 0) recs_entity_add_component(ecs, entities[i], COMPONENT_MESH, &k);
+  }
+  uint32_t tick = recs_next_change_tick(ecs);
+
+  //the transforms were added in order of entity ID, so equal keys must stay in that order
+  int full_ok = recs_component_pool_sort(ecs, COMPONENT_TRANSFORM, component_key, NULL) && check_sorted(ecs, COMPONENT_TRANSFORM, 0, RECS_MAX_ENTITIES, 1);
+
+  //sorting does not count as a change
+  for(uint32_t i = 0; i < RECS_MAX_ENTITIES && full_ok; i++) {
+    full_ok = !recs_entity_component_changed(ecs, entities[i], COMPONENT_TRANSFORM, RECS_CHANGE_CHANGED, tick);
+  }
+
+  int incremental_ok = 1;
+  for(uint32_t frame = 0; frame < 10 && incremental_ok; frame++) {
+    move_some(ecs, COMPONENT_TRANSFORM);
+    recs_component_pool_sort_incremental(ecs, COMPONENT_TRANSFORM, component_key, NULL);
+    incremental_ok = check_sorted(ecs, COMPONENT_TRANSFORM, 0, RECS_MAX_ENTITIES, 0);
+  }
+
+  //stable pools are compacted before being sorted
+  for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i += 3) {
+    recs_entity_remove_component(ecs, entities[i], COMPONENT_HEALTH);
+  }
+  uint32_t num_health = recs_component_num_instances(ecs, COMPONENT_HEALTH);
+  int stable_ok = recs_component_pool_sort(ecs, COMPONENT_HEALTH, component_key, NULL) && recs_component_num_slots(ecs, COMPONENT_HEALTH) == num_health &&
+    check_sorted(ecs, COMPONENT_HEALTH, 0, num_health, 0);
+
+  //sorting a pool owned by a group sorts the group's entities, moving them the same way in the group's other pool
+  recs_component owned[2] = {COMPONENT_TRANSFORM, COMPONENT_MESH};
+  recs_group group = recs_group_register(ecs, owned, 2);
+  uint32_t num_group = recs_group_num_entities(ecs, group);
+  uint32_t num_mesh = recs_component_num_instances(ecs, COMPONENT_MESH);
+  int group_ok = recs_component_pool_sort(ecs, COMPONENT_MESH, component_key, NULL) && check_sorted(ecs, COMPONENT_MESH, 0, num_group, 0) &&
+    check_sorted(ecs, COMPONENT_MESH, num_group, num_mesh, 0);
+  for(uint32_t frame = 0; frame < 10 && group_ok; frame++) {
+    move_some(ecs, COMPONENT_MESH);
+    recs_component_pool_sort_incremental(ecs, COMPONENT_MESH, component_key, NULL);
+    group_ok = check_sorted(ecs, COMPONENT_MESH, 0, num_group, 0) && check_sorted(ecs, COMPONENT_MESH, num_group, num_mesh, 0);
+  }
+  for(uint32_t i = 0; i < num_group && group_ok; i++) {
+    group_ok = recs_component_get_entity(ecs, COMPONENT_TRANSFORM, i) == recs_component_get_entity(ecs, COMPONENT_MESH, i);
+  }
+
+  recs_free(ecs);
+
+  if(!full_ok) {
+    printf("Test Failed, sorting did not order the components by key!\n");
+    return 1;
+  }
+  if(!incremental_ok) {
+    printf("Test Failed, sorting incrementally did not keep the components ordered by key!\n");
+    return 1;
+  }
+  if(!stable_ok) {
+    printf("Test Failed, a stable pool was not compacted and sorted!\n");
+    return 1;
+  }
+  if(!group_ok) {
+    printf("Test Failed, sorting a group's pool broke up the group!\n");
+    return 1;
+  }
+  return 0;
+}
+
+int main(void) {
+  if(run(0) != 0) return 1;
+  return run(1);
+}
@@ -0,0 +1,146 @@
+#include <stdio.h>
+
+#define RECS_MAX_COMPONENTS 2
+#define RECS_MAX_TAGS 1
+#define RECS_MAX_ENTITIES 20000
+#define RECS_MAX_SYSTEMS 0
+#define RECS_MAX_SYS_GROUPS 1
+
+//the entities left alive after removing the others, spread over several ranges of 4096 entity IDs
+#define FIRST_START 5000
+#define FIRST_END 5100
+#define SECOND_START 17000
+#define SECOND_END 17050
+#define NUM_LEFT ((FIRST_END - FIRST_START) + (SECOND_END - SECOND_START))
+
+#include "recs.h"
+
+struct position_component {
+  float x, y;
+};
+
+struct sprite_component {
+  uint32_t texture;
+};
+
+RECS_INIT_COMP_IDS(component, COMPONENT_POSITION, COMPONENT_SPRITE);
+RECS_INIT_TAG_IDS(tag, TAG_SELECTED);
+
+static recs_entity entities[RECS_MAX_ENTITIES];
+
+static recs create(uint8_t growable) {
+  struct recs_init_config_component comps[RECS_MAX_COMPONENTS] = {
+    {.type = COMPONENT_POSITION, .max_components = growable ? 8 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct position_component)},
+    {.type = COMPONENT_SPRITE, .max_components = growable ? 8 : RECS_MAX_ENTITIES, .comp_size = sizeof(struct sprite_component)}
+  };
+
+  struct recs_init_config config = {
+    .max_entities = growable ? 8 : RECS_MAX_ENTITIES,
+    .max_component_types = RECS_MAX_COMPONENTS,
+    .max_tags = RECS_MAX_TAGS,
+    .max_systems = RECS_MAX_SYSTEMS,
+    .max_system_groups = RECS_MAX_SYS_GROUPS,
+    .max_queries = 0,
+    .growable = growable,
+    .components = comps,
+    .systems = NULL
+  };
+
+  return recs_init(config);
+}
+
+static uint8_t alive(uint32_t i) {
+  return (i >= FIRST_START && i < FIRST_END) || (i >= SECOND_START && i < SECOND_END);
+}
+
+//make sure an iterator finds exactly the expected entities, and that counting agrees with it
+static int check_positions(recs ecs, uint8_t *mask, uint32_t expected) {
+  uint32_t count = 0;
+  recs_ent_iter iter = recs_ent_iter_init_with_match(ecs, mask, RECS_ENT_MATCH_ANY);
+  while(recs_ent_iter_has_next(&iter)) {
+    recs_entity e = recs_ent_iter_next(ecs, &iter);
+    struct position_component *p = recs_entity_get_component(ecs, e, COMPONENT_POSITION);
+    if(p == NULL || !alive((uint32_t)p->x)) {
+      return 0;
+    }
+    count++;
+  }
+  return count == expected && recs_num_matching_entities(ecs, mask, RECS_ENT_MATCH_ANY, NULL, RECS_ENT_MATCH_ANY) == expected;
+}
+
+//run the test with fixed-size and growable RECS instances
+static int run(uint8_t growable) {
+  recs ecs = create(growable);
+  if(ecs == NULL) {
+    printf("Failed to initialize!\n");
+    return 1;
+  }
+
+  uint8_t mask[RECS_GET_BITMASK_SIZE(RECS_MAX_COMPONENTS, RECS_MAX_TAGS)];
+  recs_bitmask_create(ecs, mask, RECS_BITMASK_CREATE_COMP_ARG(1, COMPONENT_POSITION), 0, NULL);
+
+  for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i++) {
+    entities[i] = recs_entity_add(ecs);
+    struct position_component p = {(float)i, 0};
+    recs_entity_add_component(ecs, entities[i], COMPONENT_POSITION, &p);
+  }
+
+  //rolling back to a copy taken before most entities were removed restores them
+  recs old = growable ? NULL : recs_copy(ecs);
+
+  //leave 2 small groups of entities, so that most ranges of entity IDs are empty
+  for(uint32_t i = 0; i < RECS_MAX_ENTITIES; i++) {
+    if(!alive(i)) {
+      recs_entity_remove(ecs, entities[i]);
+    }
+  }
+  int sparse_ok = check_positions(ecs, mask, NUM_LEFT);
+
+  //queued entities are removed from both groups, even when one of them was already removed directly
+  recs_entity_queue_remove(ecs, entities[FIRST_START]);
+  recs_entity_queue_remove(ecs, entities[SECOND_START]);
+  recs_entity_queue_remove(ecs, entities[SECOND_END - 1]);
+  recs_entity_remove(ecs, entities[SECOND_START]);
+  int queued_ok = check_positions(ecs, mask, NUM_LEFT - 3) && recs_num_active_entities(ecs) == NUM_LEFT - 1;
+  recs_entity_remove_queued(ecs);
+  queued_ok = queued_ok && check_positions(ecs, mask, NUM_LEFT - 3) && recs_num_active_entities(ecs) == NUM_LEFT - 3 &&
+    recs_component_num_instances(ecs, COMPONENT_POSITION) == NUM_LEFT - 3;
+
+  //a new entity is found along with the others, wherever its ID lies
+  recs_entity added = recs_entity_add(ecs);
+  struct position_component p = {(float)FIRST_START, 0};
+  recs_entity_add_component(ecs, added, COMPONENT_POSITION, &p);
+  int reuse_ok = check_positions(ecs, mask, NUM_LEFT - 2);
+
+  int rollback_ok = 1;
+  if(old != NULL) {
+    recs_copy_into(ecs, old);
+    rollback_ok = recs_num_matching_entities(ecs, mask, RECS_ENT_MATCH_ALL, NULL, RECS_ENT_MATCH_ANY) == RECS_MAX_ENTITIES;
+    recs_free(old);
+  }
+
+  recs_free(ecs);
+
+  if(!sparse_ok) {
+    printf("Test Failed, entities were lost across empty ranges of IDs!\n");
+    return 1;
+  }
+  if(!queued_ok) {
+    printf("Test Failed, queued entities were not removed!\n");
+    return 1;
+  }
+  if(!reuse_ok) {
+    printf("Test Failed, reused IDs were not found!\n");
+    return 1;
+  }
+  if(!rollback_ok) {
+    printf("Test Failed, rolling back did not restore the removed entities!\n");
+    return 1;
+  }
+  return 0;
+}
+
+int main(void) {
+  if(run(0) != 0) return 1;
+  return run(1);
+}